@@ -31,6 +31,15 @@ public:
 
 	// Array of neighbour indices
 	uint32 NeighbourIndices[ MaxNeighbours ];
+
+	friend FArchive& operator<<(FArchive& Ar, FTendrVertexConnectivityData& C)
+	{
+		for(uint32 i = 0; i < MaxNeighbours; ++i)
+		{
+			Ar << C.NeighbourIndices[ i ];
+		}
+		return Ar;
+	}
 };
 
 //
@@ -56,16 +65,62 @@ struct FTendrTangent
 //
 typedef TArray<uint32> FTendrIndexArray;
 typedef TArray<uint32> FTendrCoarseSparseMapping;
+typedef TArray<uint32> FTendrSurfaceCoarseMapping;
 typedef TArray<FVector4> FTendrVertexArray;
 typedef TArray<class FTendrVertexConnectivityData> FTendrConnectivityArray;
 typedef TArray<uint32> FTendrTetrahedronFaceIndexArray;
 typedef TArray<uint32> FTendrTetrahedronVertexIndexArray;
+typedef TArray<uint32> FTendrEdgeIndexArray;
+typedef TArray<float> FTendrEdgeLengthArray;
 typedef TArray<FVector2D> FTendrTexCoordArray;
 typedef TArray<FTendrTangent> FTendrTangentArray;
 typedef TArray<bool> FTendrSurfaceIndicatorArray;
 
 typedef uint32 FTendrModelGeneratorVersion;
 
+//
+// FTendrModelTopology
+//
+// Adjacency of the elements of FTendrModelData, for the local operations (see ITendrModelGenerator::Cut and ImproveQuality) to find the
+// elements they change without searching the entire model. It is built by the first local operation and kept up to date by the following
+// ones, and it is not serialized. Reset it when the model data is changed in any other way.
+//
+struct FTendrModelTopology
+{
+public:
+	FTendrModelTopology()
+		: NumTetrahedra( 0 )
+		, NumSurfaceTriangles( 0 )
+	{
+	}
+
+public:
+	/** Tetrahedra on either side of each face (2 per face, InvalidIndex on the boundary and for unused faces) **/
+	TArray<uint32> FaceTetrahedra;
+
+	/** Surface triangle of each face (InvalidIndex if the face is not on the surface) **/
+	TArray<uint32> FaceSurfaceTriangles;
+
+	/** A tetrahedron of each vertex (sparse) (InvalidIndex if the vertex is not used) **/
+	TArray<uint32> VertexTetrahedra;
+
+	/** First vertex (coarse) of each vertex (sparse) **/
+	TArray<uint32> SparseToCoarse;
+
+	/** Surface vertex of each vertex (coarse) (InvalidIndex if the vertex is not on the surface) **/
+	TArray<uint32> CoarseToSurface;
+
+	/** Number of tetrahedra and surface triangles of the model data the topology is up to date with **/
+	uint32 NumTetrahedra;
+	uint32 NumSurfaceTriangles;
+
+public:
+	void Reset()
+	{
+		*this = FTendrModelTopology();
+	}
+};
+
 //
 // FTendrModelData
 //
@@ -73,6 +128,10 @@ typedef uint32 FTendrModelGeneratorVersion;
 //
 struct FTendrModelData
 {
+public:
+	// Constant representing the bit set in a tetrahedron face index if the (shared) face is not wound inward for that tetrahedron (from generator version 8)
+	static const uint32 TetrahedronFaceOrientationBit = 1u << 31;
+
 public:
 	FTendrModelData()
 		: Valid( false )
@@ -88,6 +147,9 @@ public:
 
 	/** Indices for UE4 use (coarse) corresponding to the entire (internal) model **/
 	FTendrIndexArray Indices;
+
+	/** Indices for UE4 rendering (surface) corresponding to the boundary faces of the model only, indexing MappingSurfaceToCoarse (from generator version 7) **/
+	FTendrIndexArray SurfaceIndices;
 	
 	/** Texcoords for UE4 use (coarse) corresponding to the entire (internal) model **/
 	FTendrTexCoordArray TexCoords[ MAX_TEXCOORDS ];
@@ -98,24 +160,118 @@ public:
 	/** Boolean surface indicators for UE4 use (coarse) corresponding to the entire (internal) model **/
 	FTendrSurfaceIndicatorArray VerticesSurfaceIndicators;
 
-	/** Tetrahedron face indices (4 face indices per tetrahedron) for UE4 use (coarse) corresponding to the entire (internal) model **/
+	/** Tetrahedron face indices (4 face indices per tetrahedron, each face stored once, see TetrahedronFaceOrientationBit) for UE4 use (coarse) corresponding to the entire (internal) model **/
 	FTendrTetrahedronFaceIndexArray TetrahedronFaceIndices;
 
 	/** Tetrahedron vertex indices (4 vertex indices per tetrahedron) for UE4 use (coarse) corresponding to the entire (internal) model **/
 	FTendrTetrahedronVertexIndexArray TetrahedronVertexIndices;
 
+	/** Edge indices (2 sparse vertex indices per edge, lowest first) for physics use (sparse), unique and sorted by vertex indices (from generator version 9) **/
+	FTendrEdgeIndexArray EdgeIndices;
+
+	/** Edge rest lengths (1 per edge) for physics use (sparse) (from generator version 9) **/
+	FTendrEdgeLengthArray EdgeRestLengths;
+
 	/** Vertex connectivity data **/
 	FTendrConnectivityArray Connectivity;
 
 	/** Linear mapping from coarse to sparse vertices **/
 	FTendrCoarseSparseMapping MappingCoarseToSparse;
 
+	/** Linear mapping from surface to coarse vertices **/
+	FTendrSurfaceCoarseMapping MappingSurfaceToCoarse;
+
 	/** Indicator for valid model data **/
 	bool Valid;
 
+	/** Adjacency for the local operations, not serialized (from generator version 10) **/
+	FTendrModelTopology Topology;
+
 public:
 	bool IsValid() const
 	{
 		return Valid;
 	};
+
+	friend FArchive& operator<<(FArchive& Ar, FTendrModelData& D)
+	{
+		Ar << D.VerticesPhysics;
+		Ar << D.Vertices;
+		Ar << D.Indices;
+		Ar << D.SurfaceIndices;
+		for(int32 t = 0; t < MAX_TEXCOORDS; ++t)
+		{
+			Ar << D.TexCoords[ t ];
+		}
+		Ar << D.Tangents;
+		Ar << D.VerticesSurfaceIndicators;
+		Ar << D.TetrahedronFaceIndices;
+		Ar << D.TetrahedronVertexIndices;
+		Ar << D.EdgeIndices;
+		Ar << D.EdgeRestLengths;
+		Ar << D.Connectivity;
+		Ar << D.MappingCoarseToSparse;
+		Ar << D.MappingSurfaceToCoarse;
+		Ar << D.Valid;
+		return Ar;
+	}
+};
+
+//
+// FTendrModelDelta
+//
+// Structure that describes the changes made to FTendrModelData by a local operation (see ITendrModelGenerator::Cut and ImproveQuality), for
+// patching the data derived from it in place. Slots of removed elements are reused by the first added elements, the remaining ones are appended.
+// When fewer tetrahedra are added than removed, the last tetrahedra are moved into the slots left over (removed and added again) and
+// TetrahedronFaceIndices shrinks.
+//
+struct FTendrModelDelta
+{
+public:
+	FTendrModelDelta()
+		: FirstAddedVertex( 0 )
+		, FirstAddedCoarseVertex( 0 )
+		, FirstAddedSurfaceVertex( 0 )
+	{
+	}
+
+public:
+	/** First added vertex (sparse), the vertices from here to the end of VerticesPhysics were added **/
+	uint32 FirstAddedVertex;
+
+	/** First added vertex (coarse), the vertices from here to the end of Vertices were added **/
+	uint32 FirstAddedCoarseVertex;
+
+	/** First added surface vertex, the vertices from here to the end of MappingSurfaceToCoarse were added **/
+	uint32 FirstAddedSurfaceVertex;
+
+	/** Existing vertices (coarse) that are now on the surface, see VerticesSurfaceIndicators **/
+	TArray<uint32> ExposedVertices;
+
+	/** Removed tetrahedra (indices into TetrahedronFaceIndices / 4) **/
+	TArray<uint32> RemovedTetrahedra;
+
+	/** Added tetrahedra, the removed slots first **/
+	TArray<uint32> AddedTetrahedra;
+
+	/** Removed faces (indices into Indices / 3) **/
+	TArray<uint32> RemovedFaces;
+
+	/** Added faces, the removed slots first **/
+	TArray<uint32> AddedFaces;
+
+	/** Removed surface triangles (indices into SurfaceIndices / 3) **/
+	TArray<uint32> RemovedSurfaceTriangles;
+
+	/** Added surface triangles, the removed slots first **/
+	TArray<uint32> AddedSurfaceTriangles;
+
+	/** Removed edges (2 sparse vertex indices per edge, lowest first), sorted by vertex indices **/
+	TArray<uint32> RemovedEdges;
+
+	/** Added edges (2 sparse vertex indices per edge, lowest first), sorted by vertex indices **/
+	TArray<uint32> AddedEdges;
+
+	/** Vertices (sparse) of which the connectivity changed **/
+	TArray<uint32> ChangedConnectivity;
 };
@@ -20,6 +20,24 @@
 
 #include <Common/TendrCommon.h>
 
+//
+// Generator versions
+//
+// The layout of FTendrModelData and the functions of ITendrModelGenerator depend on the generator version (the TendrModelGeneratorVersion
+// property of the component), which consumers must check before using them:
+//
+//   4  Initial version
+//   5  Adds Cut
+//   6  Adds ImproveQuality
+//   7  Adds FTendrModelData::SurfaceIndices after Indices, the render indices of the boundary faces only
+//   8  Stores each face of FTendrModelData::Indices once, shared by the tetrahedra on either side of it. A tetrahedron face index has
+//      FTendrModelData::TetrahedronFaceOrientationBit set if the stored face is not wound inward for that tetrahedron, the bit must be
+//      masked off before indexing Indices (face F is Indices[ F * 3 ] to Indices[ F * 3 + 2 ])
+//   9  Stores each edge of FTendrModelData::EdgeIndices once (lowest sparse vertex first, sorted by vertex indices) and adds
+//      FTendrModelData::EdgeRestLengths after EdgeIndices, one per edge
+//  10  Adds FTendrModelData::Topology after Valid, the adjacency kept up to date by Cut and ImproveQuality (not serialized)
+//
+
 //
 // Public interface for TendrDynamics plugin
 //
@@ -37,6 +55,15 @@ public:
 
 	// Returns the last error that occurred during building
 	virtual FString GetLastError() = 0;
+
+	// Cuts model data in place along a plane (in model space) by splitting the tetrahedra it crosses, optionally separating the two sides,
+	// returns the changes for patching the simulation or false if the plane does not cut the model (available from generator version 5)
+	virtual bool Cut( FTendrModelData& ModelData, const FPlane& Plane, bool bSeparate, float SnapDistance, FTendrModelDelta& OutDelta ) = 0;
+
+	// Improves model data in place by flipping the tetrahedra whose minimum dihedral angle (in degrees) in the deformed shape, given by the
+	// positions of the vertices (sparse), is below MinimumQuality, keeping the surface and the vertices as they are, returns the changes for
+	// patching the simulation or false if no tetrahedron could be improved (available from generator version 6)
+	virtual bool ImproveQuality( FTendrModelData& ModelData, const TArray<FVector>& Positions, float MinimumQuality, FTendrModelDelta& OutDelta ) = 0;
 };
 
 //
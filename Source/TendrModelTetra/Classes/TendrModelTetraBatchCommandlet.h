@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TendrModelTetraPlugin                                                     //
+//                                                                           //
+// A Tendr model generator plugin for use with Unreal Engine in combination  //
+// with the Tendr Dynamics soft-body physics plugin.                         //
+//                                                                           //
+// Version 1.0                                                               //
+// January, 2015                                                             //
+//                                                                           //
+// Copyright (C) 2014-2015, Tendr Dynamics B.V.                              //
+//                                                                           //
+// Visit http://tendrdynamics.com for more information.                      //
+//                                                                           //
+// This file is governed by copyrights as described in the LICENSE file.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "TendrModelTetraBatchCommandlet.generated.h"
+
+//
+// UTendrModelTetraBatchCommandlet
+//
+// Headless generation of the Tendr models of all meshes in a directory, for offline pipelines on build machines.
+// The models are built in parallel by a pool of workers, each with its own generator component. Static meshes are loaded on the main
+// thread, mesh files are imported by the workers (see FTendrModelTetraImport).
+//
+// UE4Editor-Cmd <Project> -run=TendrModelTetraBatch -Input=<Directory> -Output=<Directory> [-Parameters=<File>] [-Workers=<Count>] [-Summary=<File>]
+//
+//   Input       Directory with the static mesh packages and binary STL, binary PLY or OBJ files (searched recursively)
+//   Output      Directory the models (.tendrmodel, a serialized FTendrModelData) are written to, with the same layout as the input
+//               (Mesh.uasset is built into Mesh.tendrmodel, mesh files keep their extension, Mesh.obj into Mesh.obj.tendrmodel)
+//   Parameters  JSON object with the generator component properties to build with, e.g. { "MinimumDihedralAngle": 12, "MaximumSteinerPoints": 50000 }
+//               (a TraceFilename only enables the traces, each model writes its own to <Model>.trace.json)
+//   Workers     Number of models built at the same time (the number of logical cores by default)
+//   Summary     JSON file with the progress and the statistics of each model, rewritten while building (Output/Summary.json by default)
+//
+UCLASS()
+class UTendrModelTetraBatchCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY( )
+
+public:
+
+	// Begin UCommandlet interface.
+	virtual int32 Main( const FString& Params ) override;
+	// End UCommandlet interface.
+};
@@ -51,6 +51,8 @@ public:
 	// Begin ITendrModelData interface.
 	virtual FTendrModelData Build( const FTendrVertexArray& InputVertices, const FTendrIndexArray& InputIndices, const FTendrTangentArray& InputTangents, const FTendrTexCoordArray( &InputTexCoords )[ MAX_TEXCOORDS ], bool bSilent ) override;
 	virtual FString GetLastError() override;
+	virtual bool Cut( FTendrModelData& ModelData, const FPlane& Plane, bool bSeparate, float SnapDistance, FTendrModelDelta& OutDelta ) override;
+	virtual bool ImproveQuality( FTendrModelData& ModelData, const TArray<FVector>& Positions, float MinimumQuality, FTendrModelDelta& OutDelta ) override;
 	// End ITendrModelData interface.
 
 	// Exposes the TendrModelGenerator version so the TendrDynamics plugin can detect this as a compatible class.
@@ -69,6 +71,93 @@ public:
 	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model", meta = ( UIMin = 0, ClampMin = 0 ) )
 	float MaximumTetraVolume;
 
+	// Target number of tetrahedra in the generated model (overrides MaximumTetraVolume and MaximumSteinerPoints) or 0 if disabled
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model", meta = ( UIMin = 0, ClampMin = 0 ) )
+	int32 TargetTetrahedronCount;
+
+	// Relative tolerance on TargetTetrahedronCount
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model", meta = ( UIMin = 0, ClampMin = 0, UIMax = 1 ) )
+	float TargetTetrahedronCountTolerance;
+
+	// Number of tetrahedra in the last generated model
+	UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Transient, Category = "Tendr Model" )
+	int32 AchievedTetrahedronCount;
+
+	// Merge input vertices with identical positions (e.g. on UV seams) before generating the model, the render vertices are restored from a render-to-merged vertex table
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model" )
+	bool bWeldInputVertices;
+
+	// Reorder the surface triangles and vertices for the GPU post-transform vertex cache and reduced overdraw
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model" )
+	bool bOptimizeVertexCache;
+
+	// Rebuild from the tetrahedral mesh of the previous build (kept in memory, not saved) when only input vertex positions have changed, refining only where needed
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model" )
+	bool bWarmStart;
+
+	// Target mesh size (edge length) for refinement per input vertex (e.g. painted), interpolated inside the model, or empty if unused (0 is unconstrained)
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	TArray<float> VertexMeshSizes;
+
+	// Target mesh size (edge length) for refinement on a grid of SizingGridResolution points over SizingGridBounds (X first), or empty if unused (0 is unconstrained)
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	TArray<float> SizingGrid;
+
+	// Number of grid points along each axis of SizingGrid
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	FIntVector SizingGridResolution;
+
+	// Bounds of SizingGrid in model space
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	FBox SizingGridBounds;
+
+	// Target mesh size (edge length) for refinement at a position in model space, or unbound if unused (0 is unconstrained), called from multiple threads
+	TFunction<float( const FVector& )> SizingFunction;
+
+	// Derive the target mesh size from the local thickness of the model (from a signed distance field of the input), so thin parts get small tetrahedra
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model" )
+	bool bAutomaticSizing;
+
+	// Number of cells of the automatic sizing signed distance field along the longest axis of the model
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model", meta = ( UIMin = 4, ClampMin = 1, UIMax = 256 ) )
+	int32 AutomaticSizingResolution;
+
+	// Target mesh size relative to the local thickness (radius) of the model for automatic sizing
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model", meta = ( UIMin = 0, ClampMin = 0 ) )
+	float AutomaticSizingScale;
+
+	// File to write a Chrome trace (chrome://tracing) of the stages of each build to, or empty if unused (requires a build with TENDR_TRACE)
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	FString TraceFilename;
+
+	// Log how the robust predicates of tetgen were resolved (static filter, dynamic filter, adaptive or exact arithmetic), for diagnosing slow builds
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	bool bLogPredicateStatistics;
+
+	// Log histograms of the topological operations of tetgen (flips and their link levels, cavity sizes, point location walks, Steiner point suppression and the refinement queue length), for tuning the meshing parameters
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Tendr Model" )
+	bool bLogOperationStatistics;
+
+	// Budget for the memory of the tetgen pools in megabytes (0 is unlimited), a build that exceeds it fails gracefully instead of exhausting memory (editor builds only)
+	UPROPERTY( EditAnywhere, NoClear, BlueprintReadWrite, Category = "Tendr Model", meta = ( UIMin = 0, ClampMin = 0 ) )
+	int32 MemoryBudgetMB;
+
+	// Peak memory of the tetgen pools in the last build in megabytes
+	UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Transient, Category = "Tendr Model" )
+	float PeakMemoryMB;
+
+	// Called from the building thread with the name of the current stage and the fraction of it that is done, returns false to cancel the build, or unbound if unused
+	TFunction<bool( const FString&, float )> ProgressFunction;
+
+	// Requests the running build to stop as soon as possible (from any thread), it then fails with an error
+	void CancelBuild();
+
+	// Reports the progress of the running build (to the slow task dialog and ProgressFunction), returns false if the build is to be cancelled
+	bool UpdateBuildProgress( const FString& Stage, float Fraction );
+
+	// Returns the target mesh size at a position in model space from SizingGrid, the automatic sizing and SizingFunction (the smallest of these), or 0 if unconstrained
+	float GetMeshSize( const FVector& Position ) const;
+
 private:
 	/** Sets the last error **/
 	void SetError( FString Text );
@@ -76,6 +165,42 @@ private:
 	/** Adds a neighbour to the connectivity structure **/
 	bool ConnectivityAddNeighbour( FTendrModelData& ModelData, uint32 Src, uint32 Dst, uint32& MaxNeighbours );
 
+	/** Removes a neighbour from the connectivity structure **/
+	void ConnectivityRemoveNeighbour( FTendrModelData& ModelData, uint32 Src, uint32 Dst );
+
+	/** Removes and adds edges (sorted, lowest vertex in the high bits) in the edge list and connectivity of model data and records them **/
+	void UpdateEdges( FTendrModelData& ModelData, const TArray<uint64>& RemovedEdges, const TArray<uint64>& AddedEdges, FTendrModelDelta& OutDelta );
+
+	/** Computes the automatic sizing grid from the local thickness of the input **/
+	void ComputeAutomaticSizing( const FTendrVertexArray& InputVertices, const FTendrIndexArray& InputIndices );
+
+	/** Reorders triangles for the post-transform vertex cache **/
+	void OptimizeVertexCache( TArray<uint32>& Indices, uint32 NumVertices );
+
+	/** Reorders clusters of triangles (keeping the vertex cache efficiency) so outward facing clusters are drawn first **/
+	void OptimizeOverdraw( TArray<uint32>& Indices, const FTendrModelData& ModelData );
+
+	/** Reorders the coarse vertices in order of first use by the surface triangles **/
+	void OptimizeVertexFetch( FTendrModelData& ModelData );
+
 	/** Last error **/
 	FString LastError;
+
+	/** Cancellation request for the running build, see CancelBuild **/
+	FThreadSafeBool bBuildCancelled;
+
+	/** Whether the running build shows a slow task dialog **/
+	bool bBuildSlowTask;
+
+	/** Automatic sizing grid of the last build, see SizingGrid **/
+	TArray<float> AutomaticSizingGrid;
+	FIntVector AutomaticSizingGridResolution;
+	FBox AutomaticSizingGridBounds;
+
+	/** Tetgen input points and triangles of the last build, its output points and tetrahedra and a checksum of its settings, see bWarmStart **/
+	TArray<double> WarmStartInputPoints;
+	TArray<uint32> WarmStartInputTriangles;
+	TArray<double> WarmStartPoints;
+	TArray<uint32> WarmStartTetrahedra;
+	uint32 WarmStartSettingsCrc;
 };
@@ -0,0 +1,555 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TendrModelTetraPlugin                                                     //
+//                                                                           //
+// A Tendr model generator plugin for use with Unreal Engine in combination  //
+// with the Tendr Dynamics soft-body physics plugin.                         //
+//                                                                           //
+// Version 1.0                                                               //
+// January, 2015                                                             //
+//                                                                           //
+// Copyright (C) 2014-2015, Tendr Dynamics B.V.                              //
+//                                                                           //
+// Visit http://tendrdynamics.com for more information.                      //
+//                                                                           //
+// This file is governed by copyrights as described in the LICENSE file.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TendrModelTetraPluginPrivatePCH.h"
+#include "TendrModelTetraBatchCommandlet.h"
+#include "TendrModelTetraImport.h"
+#include "Json.h"
+#include "JsonObjectConverter.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Configuration
+//
+
+//
+// Tag at the start of a model file ("TMDL"), followed by the generator version and the serialized FTendrModelData
+//
+#define BATCH_FILE_MAGIC 0x4C444D54
+
+//
+// Extension of the model files
+//
+#define BATCH_FILE_EXTENSION TEXT( ".tendrmodel" )
+
+//
+// Stack size of the worker threads (tetgen recurses deeply on large models)
+//
+#define BATCH_WORKER_STACK_SIZE ( 8 * 1024 * 1024 )
+
+//
+// Number of loaded meshes per worker waiting to be built, bounds the memory held by the input
+//
+#define BATCH_QUEUE_PER_WORKER 2
+
+//
+// Interval in seconds at which the summary is rewritten while building
+//
+#define BATCH_SUMMARY_INTERVAL 10.0
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Batch state
+//
+
+enum class ETendrBatchStatus
+{
+	Pending,
+	Queued,
+	Succeeded,
+	Failed,
+	Skipped
+};
+
+struct FTendrBatchItem
+{
+	FTendrBatchItem()
+		: Status( ETendrBatchStatus::Pending )
+		, NumInputVertices( 0 )
+		, NumInputTriangles( 0 )
+		, NumVertices( 0 )
+		, NumTetrahedra( 0 )
+		, NumEdges( 0 )
+		, PeakMemoryMB( 0 )
+		, Seconds( 0 )
+	{
+	}
+
+	// Package of the static mesh (or the name of the mesh file relative to the input), the mesh file to import (or empty) and the model file it is built into
+	FString Name;
+	FString SourceFilename;
+	FString OutputFilename;
+
+	ETendrBatchStatus Status;
+	FString Error;
+
+	// Input of the build, released once it is built
+	FTendrVertexArray Vertices;
+	FTendrIndexArray Indices;
+	FTendrTangentArray Tangents;
+	FTendrTexCoordArray TexCoords[ MAX_TEXCOORDS ];
+
+	// Statistics
+	int32 NumInputVertices;
+	int32 NumInputTriangles;
+	int32 NumVertices;
+	int32 NumTetrahedra;
+	int32 NumEdges;
+	float PeakMemoryMB;
+	double Seconds;
+};
+
+struct FTendrBatch
+{
+	// Items in order of the input files, the array is not resized while building
+	TArray<FTendrBatchItem> Items;
+
+	// Generator components that are not building, one per worker
+	TArray<UTendrModelTetraGeneratorComponent*> FreeComponents;
+
+	// Guards the components, the status and statistics of the items and the counters
+	FCriticalSection Lock;
+
+	int32 NumQueued;
+	int32 NumCompleted;
+	int32 NumFailed;
+
+	// Whether the parameters request a trace, each item then writes its own next to its model (the workers must not share one file)
+	bool bTrace;
+};
+
+//
+// Builds and writes the model of one item on a worker
+//
+class FTendrBatchWork : public IQueuedWork
+{
+public:
+	FTendrBatchWork( FTendrBatch& InBatch, FTendrBatchItem& InItem )
+		: Batch( InBatch )
+		, Item( InItem )
+	{
+	}
+
+	virtual void DoThreadedWork() override
+	{
+		UTendrModelTetraGeneratorComponent* Component;
+		{
+			FScopeLock ScopeLock( &Batch.Lock );
+			Component = Batch.FreeComponents.Pop();
+		}
+
+		const double StartSeconds = FPlatformTime::Seconds();
+		FString Error;
+
+		// Mesh files are imported here, they have no tangents or texture coordinates
+		if( !Item.SourceFilename.IsEmpty() && FTendrModelTetraImport::Import( Item.SourceFilename, Item.Vertices, Item.Indices, Error ) )
+		{
+			FTendrModelTetraImport::ComputeTangents( Item.Vertices, Item.Indices, Item.Tangents );
+			for(int32 t = 0; t < MAX_TEXCOORDS; ++t)
+			{
+				Item.TexCoords[ t ].SetNumZeroed( Item.Vertices.Num() );
+			}
+			Item.NumInputVertices = Item.Vertices.Num();
+			Item.NumInputTriangles = Item.Indices.Num() / 3;
+		}
+
+		FTendrModelData ModelData;
+		if( Error.IsEmpty() )
+		{
+			Component->TraceFilename = Batch.bTrace ? Item.OutputFilename + TEXT( ".trace.json" ) : FString();
+			ModelData = Component->Build( Item.Vertices, Item.Indices, Item.Tangents, Item.TexCoords, true );
+			Error = ModelData.IsValid() ? FString() : Component->GetLastError();
+		}
+		if( ModelData.IsValid() )
+		{
+			FArchive* Writer = IFileManager::Get().CreateFileWriter( *Item.OutputFilename );
+			if( Writer == nullptr )
+			{
+				Error = FString::Printf( TEXT( "Could not create %s" ), *Item.OutputFilename );
+			}
+			else
+			{
+				uint32 Magic = BATCH_FILE_MAGIC;
+				uint32 Version = PluginModelGeneratorVersion;
+				*Writer << Magic;
+				*Writer << Version;
+				*Writer << ModelData;
+				if( !Writer->Close() )
+				{
+					Error = FString::Printf( TEXT( "Could not write %s" ), *Item.OutputFilename );
+				}
+				delete Writer;
+			}
+		}
+
+		Item.Vertices.Empty();
+		Item.Indices.Empty();
+		Item.Tangents.Empty();
+		for(int32 t = 0; t < MAX_TEXCOORDS; ++t)
+		{
+			Item.TexCoords[ t ].Empty();
+		}
+
+		int32 NumCompleted;
+		{
+			FScopeLock ScopeLock( &Batch.Lock );
+			Item.Status = Error.IsEmpty() ? ETendrBatchStatus::Succeeded : ETendrBatchStatus::Failed;
+			Item.Error = Error;
+			Item.NumVertices = ModelData.VerticesPhysics.Num();
+			Item.NumTetrahedra = ModelData.TetrahedronFaceIndices.Num() / 4;
+			Item.NumEdges = ModelData.EdgeIndices.Num() / 2;
+			Item.PeakMemoryMB = Component->PeakMemoryMB;
+			Item.Seconds = FPlatformTime::Seconds() - StartSeconds;
+			Batch.FreeComponents.Push( Component );
+
+			NumCompleted = ++Batch.NumCompleted;
+			Batch.NumFailed += Error.IsEmpty() ? 0 : 1;
+		}
+
+		if( Error.IsEmpty() )
+		{
+			UE_LOG( TendrModelTetraLog, Display, TEXT( "[%d/%d] %s: %d vertices, %d tetrahedra in %.2f s" ),
+					NumCompleted, Batch.Items.Num(), *Item.Name, Item.NumVertices, Item.NumTetrahedra, Item.Seconds );
+		}
+		else
+		{
+			UE_LOG( TendrModelTetraLog, Error, TEXT( "[%d/%d] %s: %s" ), NumCompleted, Batch.Items.Num(), *Item.Name, *Error );
+		}
+
+		delete this;
+	}
+
+	virtual void Abandon() override
+	{
+		delete this;
+	}
+
+private:
+	FTendrBatch& Batch;
+	FTendrBatchItem& Item;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Helpers
+//
+
+//
+// Copies the build input of a static mesh (its first LOD) into an item
+//
+static bool GetStaticMeshInput( UStaticMesh* StaticMesh, FTendrBatchItem& Item )
+{
+	if( !StaticMesh->RenderData.IsValid() || StaticMesh->RenderData->LODResources.Num() == 0 )
+	{
+		return false;
+	}
+
+	const FStaticMeshLODResources& LOD = StaticMesh->RenderData->LODResources[ 0 ];
+	const int32 NumVertices = LOD.PositionVertexBuffer.GetNumVertices();
+	const int32 NumTexCoords = LOD.VertexBuffer.GetNumTexCoords();
+
+	Item.Vertices.SetNumUninitialized( NumVertices );
+	Item.Tangents.SetNumUninitialized( NumVertices );
+	for(int32 t = 0; t < MAX_TEXCOORDS; ++t)
+	{
+		Item.TexCoords[ t ].SetNumZeroed( NumVertices );
+	}
+	for(int32 i = 0; i < NumVertices; ++i)
+	{
+		Item.Vertices[ i ] = FVector4( LOD.PositionVertexBuffer.VertexPosition( i ), 0 );
+		Item.Tangents[ i ].TangentX = FPackedRGB10A2N( FVector4( LOD.VertexBuffer.VertexTangentX( i ) ) );
+		Item.Tangents[ i ].TangentZ = FPackedRGB10A2N( FVector4( LOD.VertexBuffer.VertexTangentZ( i ) ) );
+		for(int32 t = 0; t < FMath::Min( NumTexCoords, (int32)MAX_TEXCOORDS ); ++t)
+		{
+			Item.TexCoords[ t ][ i ] = LOD.VertexBuffer.GetVertexUV( i, t );
+		}
+	}
+	LOD.IndexBuffer.GetCopy( Item.Indices );
+
+	Item.NumInputVertices = NumVertices;
+	Item.NumInputTriangles = Item.Indices.Num() / 3;
+	return NumVertices > 0 && Item.Indices.Num() > 0;
+}
+
+//
+// Writes the progress and the statistics of the items
+//
+static void WriteSummary( FTendrBatch& Batch, const FString& Filename, int32 NumWorkers, double Seconds )
+{
+	static const TCHAR* StatusNames[] = { TEXT( "Pending" ), TEXT( "Queued" ), TEXT( "Succeeded" ), TEXT( "Failed" ), TEXT( "Skipped" ) };
+
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create( &Json );
+	{
+		FScopeLock ScopeLock( &Batch.Lock );
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue( TEXT( "Workers" ), NumWorkers );
+		Writer->WriteValue( TEXT( "Models" ), Batch.Items.Num() );
+		Writer->WriteValue( TEXT( "Queued" ), Batch.NumQueued );
+		Writer->WriteValue( TEXT( "Completed" ), Batch.NumCompleted );
+		Writer->WriteValue( TEXT( "Failed" ), Batch.NumFailed );
+		Writer->WriteValue( TEXT( "Seconds" ), Seconds );
+
+		Writer->WriteArrayStart( TEXT( "Items" ) );
+		for(const FTendrBatchItem& Item : Batch.Items)
+		{
+			Writer->WriteObjectStart();
+			Writer->WriteValue( TEXT( "Name" ), Item.Name );
+			Writer->WriteValue( TEXT( "Status" ), StatusNames[ (int32)Item.Status ] );
+			if( !Item.Error.IsEmpty() )
+			{
+				Writer->WriteValue( TEXT( "Error" ), Item.Error );
+			}
+			if( Item.Status == ETendrBatchStatus::Succeeded || Item.Status == ETendrBatchStatus::Failed )
+			{
+				Writer->WriteValue( TEXT( "File" ), Item.OutputFilename );
+				Writer->WriteValue( TEXT( "InputVertices" ), Item.NumInputVertices );
+				Writer->WriteValue( TEXT( "InputTriangles" ), Item.NumInputTriangles );
+				Writer->WriteValue( TEXT( "Vertices" ), Item.NumVertices );
+				Writer->WriteValue( TEXT( "Tetrahedra" ), Item.NumTetrahedra );
+				Writer->WriteValue( TEXT( "Edges" ), Item.NumEdges );
+				Writer->WriteValue( TEXT( "PeakMemoryMB" ), Item.PeakMemoryMB );
+				Writer->WriteValue( TEXT( "Seconds" ), Item.Seconds );
+			}
+			Writer->WriteObjectEnd();
+		}
+		Writer->WriteArrayEnd();
+
+		Writer->WriteObjectEnd();
+	}
+	Writer->Close();
+
+	if( !FFileHelper::SaveStringToFile( Json, *Filename ) )
+	{
+		UE_LOG( TendrModelTetraLog, Warning, TEXT( "Could not write the summary to %s" ), *Filename );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// UTendrModelTetraBatchCommandlet
+//
+
+UTendrModelTetraBatchCommandlet::UTendrModelTetraBatchCommandlet( const FObjectInitializer &ObjectInitializer )
+: Super( ObjectInitializer )
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTendrModelTetraBatchCommandlet::Main( const FString& Params )
+{
+	FString InputDirectory;
+	FString OutputDirectory;
+	FString ParametersFilename;
+	FString SummaryFilename;
+	int32 NumWorkers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	if( !FParse::Value( *Params, TEXT( "Input=" ), InputDirectory ) || !FParse::Value( *Params, TEXT( "Output=" ), OutputDirectory ) )
+	{
+		UE_LOG( TendrModelTetraLog, Error, TEXT( "Usage: -run=TendrModelTetraBatch -Input=<Directory> -Output=<Directory> [-Parameters=<File>] [-Workers=<Count>] [-Summary=<File>]" ) );
+		return 1;
+	}
+	FParse::Value( *Params, TEXT( "Parameters=" ), ParametersFilename );
+	FParse::Value( *Params, TEXT( "Workers=" ), NumWorkers );
+	NumWorkers = FMath::Max( NumWorkers, 1 );
+	if( !FParse::Value( *Params, TEXT( "Summary=" ), SummaryFilename ) )
+	{
+		SummaryFilename = OutputDirectory / TEXT( "Summary.json" );
+	}
+
+	InputDirectory = FPaths::ConvertRelativePathToFull( InputDirectory );
+	FPaths::NormalizeDirectoryName( InputDirectory );
+	InputDirectory /= TEXT( "" );
+
+	//
+	// Generator parameters
+	//
+	// The properties of the generator component are set from a JSON object with their names, they are the same for every model.
+	//
+	TSharedPtr<FJsonObject> Parameters;
+	if( !ParametersFilename.IsEmpty() )
+	{
+		FString Json;
+		if( !FFileHelper::LoadFileToString( Json, *ParametersFilename ) ||
+			!FJsonSerializer::Deserialize( TJsonReaderFactory<>::Create( Json ), Parameters ) || !Parameters.IsValid() )
+		{
+			UE_LOG( TendrModelTetraLog, Error, TEXT( "Could not read the parameters from %s" ), *ParametersFilename );
+			return 1;
+		}
+		for(const auto& Value : Parameters->Values)
+		{
+			UProperty* Property = FindField<UProperty>( UTendrModelTetraGeneratorComponent::StaticClass(), *Value.Key );
+			if( Property == nullptr || !Property->HasAnyPropertyFlags( CPF_Edit ) )
+			{
+				UE_LOG( TendrModelTetraLog, Warning, TEXT( "Parameter %s is not a property of the generator and is ignored" ), *Value.Key );
+			}
+		}
+	}
+
+	FTendrBatch Batch;
+	Batch.NumQueued = 0;
+	Batch.NumCompleted = 0;
+	Batch.NumFailed = 0;
+	Batch.bTrace = false;
+
+	// Each worker builds unrelated models, so there is nothing to warm start from
+	for(int32 i = 0; i < NumWorkers; ++i)
+	{
+		UTendrModelTetraGeneratorComponent* Component = NewObject<UTendrModelTetraGeneratorComponent>( GetTransientPackage() );
+		Component->AddToRoot();
+		Component->bWarmStart = false;
+		if( Parameters.IsValid() && !FJsonObjectConverter::JsonObjectToUStruct( Parameters.ToSharedRef(), UTendrModelTetraGeneratorComponent::StaticClass(), Component, CPF_Edit, 0 ) )
+		{
+			UE_LOG( TendrModelTetraLog, Error, TEXT( "Could not apply the parameters from %s" ), *ParametersFilename );
+			return 1;
+		}
+		Batch.bTrace |= !Component->TraceFilename.IsEmpty();
+		Batch.FreeComponents.Add( Component );
+	}
+
+	// Input meshes, static mesh packages and mesh files
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFilesRecursive( Filenames, *InputDirectory, *( FString( TEXT( "*" ) ) + FPackageName::GetAssetPackageExtension() ), true, false );
+	IFileManager::Get().FindFilesRecursive( Filenames, *InputDirectory, TEXT( "*.stl" ), true, false, false );
+	IFileManager::Get().FindFilesRecursive( Filenames, *InputDirectory, TEXT( "*.ply" ), true, false, false );
+	IFileManager::Get().FindFilesRecursive( Filenames, *InputDirectory, TEXT( "*.obj" ), true, false, false );
+	Filenames.Sort();
+
+	Batch.Items.SetNum( Filenames.Num() );
+	for(int32 i = 0; i < Filenames.Num(); ++i)
+	{
+		FString RelativeFilename = Filenames[ i ];
+		FPaths::MakePathRelativeTo( RelativeFilename, *InputDirectory );
+
+		FTendrBatchItem& Item = Batch.Items[ i ];
+		// Mesh files keep their extension, Foo.obj and Foo.stl must not be built into the same model
+		const bool bMeshFile = FTendrModelTetraImport::IsSupported( Filenames[ i ] );
+		Item.OutputFilename = FPaths::ConvertRelativePathToFull( OutputDirectory / ( bMeshFile ? RelativeFilename : FPaths::GetBaseFilename( RelativeFilename, false ) ) + BATCH_FILE_EXTENSION );
+		if( bMeshFile )
+		{
+			Item.Name = RelativeFilename;
+			Item.SourceFilename = Filenames[ i ];
+		}
+		else if( !FPackageName::TryConvertFilenameToLongPackageName( Filenames[ i ], Item.Name ) )
+		{
+			Item.Name = Filenames[ i ];
+			Item.Status = ETendrBatchStatus::Skipped;
+			Item.Error = TEXT( "Not in a content directory of the project" );
+		}
+	}
+
+	UE_LOG( TendrModelTetraLog, Display, TEXT( "Building %d models from %s with %d workers" ), Batch.Items.Num(), *InputDirectory, NumWorkers );
+
+	FQueuedThreadPool* Pool = FQueuedThreadPool::Allocate();
+	verify( Pool->Create( NumWorkers, BATCH_WORKER_STACK_SIZE ) );
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	double SummarySeconds = StartSeconds;
+
+	//
+	// Loading and building
+	//
+	// Static meshes are loaded on this thread (which owns the objects) ahead of the workers, as long as the queue of loaded meshes is short enough.
+	// Loaded meshes are released by garbage collection once their input has been copied. Mesh files are only queued, the workers import them.
+	//
+	int32 NumLoaded = 0;
+	for(int32 i = 0; i <= Batch.Items.Num(); ++i)
+	{
+		while( true )
+		{
+			int32 NumBuilding;
+			int32 NumCompleted;
+			{
+				FScopeLock ScopeLock( &Batch.Lock );
+				NumBuilding = Batch.NumQueued - Batch.NumCompleted;
+				NumCompleted = Batch.NumCompleted;
+			}
+
+			if( FPlatformTime::Seconds() - SummarySeconds >= BATCH_SUMMARY_INTERVAL )
+			{
+				WriteSummary( Batch, SummaryFilename, NumWorkers, FPlatformTime::Seconds() - StartSeconds );
+				SummarySeconds = FPlatformTime::Seconds();
+			}
+
+			// Wait for a slot in the queue, or for all models once every mesh is loaded
+			if( i < Batch.Items.Num() ? NumBuilding < NumWorkers * BATCH_QUEUE_PER_WORKER : NumBuilding == 0 )
+			{
+				break;
+			}
+			FPlatformProcess::Sleep( 0.01f );
+		}
+		if( i == Batch.Items.Num() )
+		{
+			break;
+		}
+
+		FTendrBatchItem& Item = Batch.Items[ i ];
+		if( Item.Status != ETendrBatchStatus::Pending )
+		{
+			continue;
+		}
+
+		UStaticMesh* StaticMesh = nullptr;
+		UPackage* Package = Item.SourceFilename.IsEmpty() ? LoadPackage( nullptr, *Item.Name, LOAD_None ) : nullptr;
+		if( Package != nullptr )
+		{
+			TArray<UObject*> Objects;
+			GetObjectsWithOuter( Package, Objects, false );
+			for(UObject* Object : Objects)
+			{
+				StaticMesh = StaticMesh ? StaticMesh : Cast<UStaticMesh>( Object );
+			}
+		}
+
+		bool bLoaded = !Item.SourceFilename.IsEmpty() || ( StaticMesh != nullptr && GetStaticMeshInput( StaticMesh, Item ) );
+		if( !bLoaded || !IFileManager::Get().MakeDirectory( *FPaths::GetPath( Item.OutputFilename ), true ) )
+		{
+			FScopeLock ScopeLock( &Batch.Lock );
+			Item.Status = ETendrBatchStatus::Skipped;
+			Item.Error = bLoaded ? TEXT( "Could not create the output directory" ) : TEXT( "Not a static mesh with render data" );
+		}
+		else
+		{
+			{
+				FScopeLock ScopeLock( &Batch.Lock );
+				Item.Status = ETendrBatchStatus::Queued;
+				++Batch.NumQueued;
+			}
+			Pool->AddQueuedWork( new FTendrBatchWork( Batch, Item ) );
+		}
+
+		if( ++NumLoaded % ( NumWorkers * BATCH_QUEUE_PER_WORKER ) == 0 )
+		{
+			CollectGarbage( RF_NoFlags );
+		}
+	}
+
+	Pool->Destroy();
+	delete Pool;
+
+	const double Seconds = FPlatformTime::Seconds() - StartSeconds;
+	WriteSummary( Batch, SummaryFilename, NumWorkers, Seconds );
+
+	for(UTendrModelTetraGeneratorComponent* Component : Batch.FreeComponents)
+	{
+		Component->RemoveFromRoot();
+	}
+
+	UE_LOG( TendrModelTetraLog, Display, TEXT( "Built %d of %d models (%d failed) in %.1f s, summary written to %s" ),
+			Batch.NumCompleted - Batch.NumFailed,
+			Batch.Items.Num(),
+			Batch.NumFailed,
+			Seconds,
+			*SummaryFilename
+			);
+
+	return Batch.NumFailed > 0 ? 1 : 0;
+}
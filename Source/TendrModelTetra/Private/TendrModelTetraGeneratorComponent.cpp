@@ -28,11 +28,39 @@
 //
 #define LOG_BUFFER_MAX 2048
 
+//
+// Maximum number of self-intersecting triangle pairs that are logged individually
+//
+#define SELF_INTERSECTION_LOG_MAX 16
+
+//
+// Size of the simulated post-transform vertex cache for surface optimization
+//
+#define VERTEX_CACHE_SIZE 32
+
+//
+// Maximum ratio of the cache miss rate of a surface triangle cluster to that of the unsplit triangles for overdraw optimization
+//
+#define OVERDRAW_CLUSTER_THRESHOLD 1.05f
+
+//
+// Maximum number of trial tetrahedralizations to reach the target tetrahedron count
+//
+#define TARGET_COUNT_ITERATIONS_MAX 8
+
+//
+// Maximum number of flips per low quality tetrahedron for local quality improvement
+//
+#define QUALITY_FLIPS_MAX 8
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Tetgen dependency, compiled inline for ease of use
 //
 #pragma warning( disable: 4701 )
+#if TENDR_TRACE
+#define TETGEN_TRACE
+#endif
 #include "tetgen/predicates.cxx"
 #include "tetgen/tetgen.cxx"
 
@@ -46,33 +74,417 @@
 //#define TETGEN_DEBUG
 
 //
-// Tetgen print callback
+// Tetgen print callback (formats nothing unless TETGEN_DEBUG is enabled, see TENDR_TRACE for timings)
 //
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <ostream>
-#include <vector>
-
 void myprintf( const char* format, ... )
 {
 #ifdef TETGEN_DEBUG
+	ANSICHAR Buffer[ LOG_BUFFER_MAX ];
+
 	va_list args;
 	va_start( args, format );
+	int32 Length = FCStringAnsi::GetVarArgs( Buffer, LOG_BUFFER_MAX, LOG_BUFFER_MAX - 1, format, args );
+	va_end( args );
+
+	// Truncate messages that do not fit
+	Buffer[ ( Length >= 0 && Length < LOG_BUFFER_MAX ) ? Length : LOG_BUFFER_MAX - 1 ] = 0;
+
+	// Tetgen messages are not format strings themselves
+	UE_LOG( TendrModelTetraLog, Log, TEXT( "%s" ), ANSI_TO_TCHAR( Buffer ) );
+#endif
+}
+
+//
+// Tetgen parallel loop callback
+//
+void TetgenParallelFor( int Count, tetgenbehavior::LoopBody Body, void* Context )
+{
+#if TENDR_TRACE
+	// Work items record their events in the session of the build running the loop
+	const uint32 TraceSession = FTendrTrace::GetSession();
+	ParallelFor( Count, [ Body, Context, TraceSession ]( int32 Index )
+	{
+		FTendrTraceSessionScope TraceSessionScope( TraceSession );
+		Body( Context, Index );
+	} );
+#else
+	ParallelFor( Count, [ Body, Context ]( int32 Index )
+	{
+		Body( Context, Index );
+	} );
+#endif
+}
+
+//
+// Tetgen progress callback, returns nonzero to cancel tetrahedralization
+//
+int TetgenProgress( void* Handle, const char* Stage, REAL Fraction )
+{
+	return ( (UTendrModelTetraGeneratorComponent*)Handle )->UpdateBuildProgress( ANSI_TO_TCHAR( Stage ), Fraction ) ? 0 : 1;
+}
+
+//
+// Tetgen output list callback, lets tetgen write its index lists directly into caller-owned arrays
+//
+struct FTetgenOutputLists
+{
+	TArray<uint32>* Lists[ tetgenio::NUMOUTPUTLISTS ];
+};
+
+int* TetgenOutputAlloc( void* Handle, int List, long Count )
+{
+	TArray<uint32>* Array = ( (FTetgenOutputLists*)Handle )->Lists[ List ];
+	if( Array == NULL || Count > MAX_int32 )
+	{
+		// Let tetgen allocate (and free) this list, also when it is too large for a TArray
+		return NULL;
+	}
+
+	Array->SetNumUninitialized( Count );
+	return (int*)Array->GetData();
+}
+
+//
+// Tetgen mesh size callback, evaluates the sizing field of the component
+//
+REAL TetgenMeshSize( void* Handle, REAL* Point )
+{
+	return ( (const UTendrModelTetraGeneratorComponent*)Handle )->GetMeshSize( FVector( Point[ 0 ], Point[ 1 ], Point[ 2 ] ) );
+}
+
+//
+// Trilinear interpolation of a sizing grid, clamped to its bounds
+//
+float SampleSizingGrid( const TArray<float>& Grid, const FIntVector& GridResolution, const FBox& Bounds, const FVector& Position )
+{
+	const int32 Resolution[ 3 ] = { GridResolution.X, GridResolution.Y, GridResolution.Z };
+	FVector Extent = Bounds.Max - Bounds.Min;
+	FVector Cell;
+	int32 Lower[ 3 ];
+	int32 Upper[ 3 ];
+	for(int k = 0; k < 3; ++k)
 	{
-		TCHAR pBufferWide[ LOG_BUFFER_MAX ] = { 0 };
-		char pBuffer[ LOG_BUFFER_MAX ] = { 0 };
+		float Coordinate = ( Extent[ k ] > 0 ) ? ( Position[ k ] - Bounds.Min[ k ] ) / Extent[ k ] * ( Resolution[ k ] - 1 ) : 0;
+		Coordinate = FMath::Clamp( Coordinate, 0.0f, (float)( Resolution[ k ] - 1 ) );
+		Lower[ k ] = FMath::Min( (int32)Coordinate, Resolution[ k ] - 1 );
+		Upper[ k ] = FMath::Min( Lower[ k ] + 1, Resolution[ k ] - 1 );
+		Cell[ k ] = Coordinate - Lower[ k ];
+	}
 
-		_vsnprintf( pBuffer, LOG_BUFFER_MAX - 1, format, args );
+	auto FnGrid = [ &Grid, &Resolution ]( int32 X, int32 Y, int32 Z )
+	{
+		return Grid[ ( Z * Resolution[ 1 ] + Y ) * Resolution[ 0 ] + X ];
+	};
 
-		MultiByteToWideChar( CP_ACP, 0, pBuffer, -1, pBufferWide, LOG_BUFFER_MAX - 1 );
-		pBufferWide[ LOG_BUFFER_MAX - 1 ] = 0;
+	float X00 = FMath::Lerp( FnGrid( Lower[ 0 ], Lower[ 1 ], Lower[ 2 ] ), FnGrid( Upper[ 0 ], Lower[ 1 ], Lower[ 2 ] ), Cell.X );
+	float X10 = FMath::Lerp( FnGrid( Lower[ 0 ], Upper[ 1 ], Lower[ 2 ] ), FnGrid( Upper[ 0 ], Upper[ 1 ], Lower[ 2 ] ), Cell.X );
+	float X01 = FMath::Lerp( FnGrid( Lower[ 0 ], Lower[ 1 ], Upper[ 2 ] ), FnGrid( Upper[ 0 ], Lower[ 1 ], Upper[ 2 ] ), Cell.X );
+	float X11 = FMath::Lerp( FnGrid( Lower[ 0 ], Upper[ 1 ], Upper[ 2 ] ), FnGrid( Upper[ 0 ], Upper[ 1 ], Upper[ 2 ] ), Cell.X );
+	return FMath::Lerp( FMath::Lerp( X00, X10, Cell.Y ), FMath::Lerp( X01, X11, Cell.Y ), Cell.Z );
+}
 
-		UE_LOG( TendrModelTetraLog, Log, pBufferWide );
+//
+// Vertex cache score of a vertex, by its position in the (LRU) cache and its number of triangles left to be drawn
+//
+float VertexCacheScore( int32 CachePosition, int32 NumLiveTriangles )
+{
+	if( NumLiveTriangles == 0 )
+	{
+		// No triangles left to be drawn
+		return -1.0f;
 	}
-	va_end( args );
-#endif
+
+	float Score = 0.0f;
+	if( CachePosition >= 0 )
+	{
+		// Vertices of the last triangle get a fixed score, so the next triangle does not simply reuse its edge
+		Score = ( CachePosition < 3 ) ? 0.75f : FMath::Pow( 1.0f - (float)( CachePosition - 3 ) / ( VERTEX_CACHE_SIZE - 3 ), 1.5f );
+	}
+
+	// Boost vertices with few triangles left, so they are not left behind
+	return Score + 2.0f * FMath::InvSqrt( (float)NumLiveTriangles );
+}
+
+//
+// Reorders the elements of an array, element i of the result is element Order[ i ] of the input
+//
+template< typename T >
+void PermuteArray( TArray<T>& Array, const TArray<uint32>& Order )
+{
+	TArray<T> Permuted;
+	Permuted.Reserve( Order.Num() );
+	for(int i = 0; i < Order.Num(); ++i)
+	{
+		Permuted.Add( Array[ Order[ i ] ] );
+	}
+	Array = MoveTemp( Permuted );
+}
+
+//
+// Corners of the face opposite each corner of a positively oriented tetrahedron, wound so its normal points into the tetrahedron (as tetgen stores them)
+//
+static const int32 TetrahedronFaceCorners[ 4 ][ 3 ] = { { 1, 3, 2 }, { 0, 2, 3 }, { 0, 3, 1 }, { 0, 1, 2 } };
+
+//
+// Key of a triangle of vertices, independent of the order of the vertices
+//
+static FIntVector TriangleKey( uint32 A, uint32 B, uint32 C )
+{
+	if( A > B ) Swap( A, B );
+	if( B > C ) Swap( B, C );
+	if( A > B ) Swap( A, B );
+	return FIntVector( (int32)A, (int32)B, (int32)C );
+}
+
+//
+// Whether two triangles of the same vertices have the same winding
+//
+static bool SameWinding( const uint32 ( &A )[ 3 ], const uint32 ( &B )[ 3 ] )
+{
+	return ( A[ 0 ] == B[ 0 ] && A[ 1 ] == B[ 1 ] ) || ( A[ 0 ] == B[ 1 ] && A[ 1 ] == B[ 2 ] ) || ( A[ 0 ] == B[ 2 ] && A[ 1 ] == B[ 0 ] );
+}
+
+//
+// Corners (sparse) of a tetrahedron, those of face 0 (wound inward) followed by the remaining corner of face 1, so they are positively oriented
+//
+static void GetTetrahedronCorners( const FTendrModelData& ModelData, int32 Tetrahedron, uint32 ( &Corners )[ 4 ] )
+{
+	const uint32 FaceIndexMask = ~FTendrModelData::TetrahedronFaceOrientationBit;
+	const uint32 Face0 = ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + 0 ] & FaceIndexMask;
+	const uint32 Face1 = ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + 1 ] & FaceIndexMask;
+	for(int k = 0; k < 3; ++k)
+	{
+		Corners[ k ] = ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face0 * 3 + k ] ];
+	}
+	if( ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + 0 ] & FTendrModelData::TetrahedronFaceOrientationBit )
+	{
+		Swap( Corners[ 1 ], Corners[ 2 ] );
+	}
+	for(int k = 0; k < 3; ++k)
+	{
+		Corners[ 3 ] = ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face1 * 3 + k ] ];
+		if( Corners[ 3 ] != Corners[ 0 ] && Corners[ 3 ] != Corners[ 1 ] && Corners[ 3 ] != Corners[ 2 ] )
+		{
+			break;
+		}
+	}
+}
+
+//
+// Quality of a tetrahedron as its minimum dihedral angle in degrees, or 0 if it is inverted or degenerate
+//
+static float TetrahedronQuality( const FVector ( &Corners )[ 4 ] )
+{
+	if( FVector::DotProduct( FVector::CrossProduct( Corners[ 1 ] - Corners[ 0 ], Corners[ 2 ] - Corners[ 0 ] ), Corners[ 3 ] - Corners[ 0 ] ) <= 0 )
+	{
+		return 0;
+	}
+
+	// Inward face normals, the dihedral angle between two faces is 180 degrees minus the angle between their normals
+	FVector Normals[ 4 ];
+	for(int k = 0; k < 4; ++k)
+	{
+		const FVector& A = Corners[ TetrahedronFaceCorners[ k ][ 0 ] ];
+		Normals[ k ] = FVector::CrossProduct( Corners[ TetrahedronFaceCorners[ k ][ 1 ] ] - A, Corners[ TetrahedronFaceCorners[ k ][ 2 ] ] - A ).GetSafeNormal();
+	}
+	float MaxCosine = -1;
+	for(int a = 0; a < 4; ++a)
+	{
+		for(int b = a + 1; b < 4; ++b)
+		{
+			MaxCosine = FMath::Max( MaxCosine, -FVector::DotProduct( Normals[ a ], Normals[ b ] ) );
+		}
+	}
+	return FMath::RadiansToDegrees( FMath::Acos( FMath::Clamp( MaxCosine, -1.0f, 1.0f ) ) );
+}
+
+//
+// Sets the faces of a new tetrahedron (sparse corners, positively oriented), keeping the faces that are still used, the removed faces are
+// replaced by new faces in the free slots or at the end
+//
+static void SetTetrahedron( FTendrModelData& ModelData, uint32 Tetrahedron, const uint32 ( &Corners )[ 4 ], const TArray<uint32>& SparseToCoarse,
+							TMap<FIntVector, uint32>& Faces, TSet<FIntVector>& RemovedFaces, const TArray<uint32>& FreeFaces, int32& NextFreeFace, FTendrModelDelta& OutDelta )
+{
+	for(int k = 0; k < 4; ++k)
+	{
+		const uint32 Inward[ 3 ] = { Corners[ TetrahedronFaceCorners[ k ][ 0 ] ], Corners[ TetrahedronFaceCorners[ k ][ 1 ] ], Corners[ TetrahedronFaceCorners[ k ][ 2 ] ] };
+		const FIntVector Key = TriangleKey( Inward[ 0 ], Inward[ 1 ], Inward[ 2 ] );
+
+		uint32 Face;
+		const uint32* Found = Faces.Find( Key );
+		if( Found && !RemovedFaces.Contains( Key ) )
+		{
+			Face = *Found;
+		}
+		else
+		{
+			// New face, wound inward for this tetrahedron
+			if( NextFreeFace < FreeFaces.Num() )
+			{
+				Face = FreeFaces[ NextFreeFace++ ];
+			}
+			else
+			{
+				Face = ModelData.Indices.AddUninitialized( 3 ) / 3;
+			}
+			for(int c = 0; c < 3; ++c)
+			{
+				ModelData.Indices[ Face * 3 + c ] = SparseToCoarse[ Inward[ c ] ];
+			}
+			Faces.Add( Key, Face );
+			RemovedFaces.Remove( Key );
+			OutDelta.AddedFaces.Add( Face );
+		}
+
+		const uint32 Stored[ 3 ] = {
+			ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 0 ] ],
+			ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 1 ] ],
+			ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 2 ] ] };
+		ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + k ] = Face | ( SameWinding( Inward, Stored ) ? 0 : FTendrModelData::TetrahedronFaceOrientationBit );
+		if( ModelData.TetrahedronVertexIndices.Num() == ModelData.TetrahedronFaceIndices.Num() )
+		{
+			ModelData.TetrahedronVertexIndices[ Tetrahedron * 4 + k ] = SparseToCoarse[ Corners[ k ] ];
+		}
+	}
+}
+
+//
+// Key of a face of model data, by its vertices (sparse)
+//
+static FIntVector FaceKey( const FTendrModelData& ModelData, uint32 Face )
+{
+	return TriangleKey( ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 0 ] ],
+						ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 1 ] ],
+						ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 2 ] ] );
+}
+
+//
+// Whether the topology of model data is up to date with it
+//
+static bool IsTopologyValid( const FTendrModelData& ModelData )
+{
+	const FTendrModelTopology& Topology = ModelData.Topology;
+	const int32 NumFaces = ModelData.Indices.Num() / 3;
+	return Topology.FaceTetrahedra.Num() == NumFaces * 2 &&
+		   Topology.FaceSurfaceTriangles.Num() == NumFaces &&
+		   Topology.VertexTetrahedra.Num() == ModelData.VerticesPhysics.Num() &&
+		   Topology.SparseToCoarse.Num() == ModelData.VerticesPhysics.Num() &&
+		   Topology.CoarseToSurface.Num() == ModelData.Vertices.Num() &&
+		   Topology.NumTetrahedra == (uint32)( ModelData.TetrahedronFaceIndices.Num() / 4 ) &&
+		   Topology.NumSurfaceTriangles == (uint32)( ModelData.SurfaceIndices.Num() / 3 );
+}
+
+//
+// Adds the entries of the faces and vertices added to model data to its topology, as unused
+//
+static void GrowTopology( FTendrModelData& ModelData )
+{
+	auto FnGrow = []( TArray<uint32>& Array, int32 Num )
+	{
+		while( Array.Num() < Num )
+		{
+			Array.Add( ITendrModelGenerator::InvalidIndex );
+		}
+	};
+
+	FTendrModelTopology& Topology = ModelData.Topology;
+	FnGrow( Topology.FaceTetrahedra, ModelData.Indices.Num() / 3 * 2 );
+	FnGrow( Topology.FaceSurfaceTriangles, ModelData.Indices.Num() / 3 );
+	FnGrow( Topology.VertexTetrahedra, ModelData.VerticesPhysics.Num() );
+	FnGrow( Topology.SparseToCoarse, ModelData.VerticesPhysics.Num() );
+	FnGrow( Topology.CoarseToSurface, ModelData.Vertices.Num() );
+}
+
+//
+// Adds a tetrahedron of model data to the topology, as a tetrahedron of its faces and of its corners
+//
+static void LinkTetrahedron( FTendrModelData& ModelData, uint32 Tetrahedron )
+{
+	const uint32 FaceIndexMask = ~FTendrModelData::TetrahedronFaceOrientationBit;
+	FTendrModelTopology& Topology = ModelData.Topology;
+	for(int k = 0; k < 4; ++k)
+	{
+		const uint32 Face = ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + k ] & FaceIndexMask;
+		Topology.FaceTetrahedra[ Face * 2 + ( ( Topology.FaceTetrahedra[ Face * 2 ] == ITendrModelGenerator::InvalidIndex ) ? 0 : 1 ) ] = Tetrahedron;
+	}
+
+	uint32 Corners[ 4 ];
+	GetTetrahedronCorners( ModelData, Tetrahedron, Corners );
+	for(int k = 0; k < 4; ++k)
+	{
+		Topology.VertexTetrahedra[ Corners[ k ] ] = Tetrahedron;
+	}
+}
+
+//
+// Removes a tetrahedron of model data from its faces in the topology, the first tetrahedron of a face that is still used is kept valid (the
+// corners are updated by linking the tetrahedra that replace it)
+//
+static void UnlinkTetrahedron( FTendrModelData& ModelData, uint32 Tetrahedron )
+{
+	const uint32 FaceIndexMask = ~FTendrModelData::TetrahedronFaceOrientationBit;
+	FTendrModelTopology& Topology = ModelData.Topology;
+	for(int k = 0; k < 4; ++k)
+	{
+		const uint32 Face = ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + k ] & FaceIndexMask;
+		if( Topology.FaceTetrahedra[ Face * 2 ] == Tetrahedron )
+		{
+			Topology.FaceTetrahedra[ Face * 2 ] = Topology.FaceTetrahedra[ Face * 2 + 1 ];
+		}
+		Topology.FaceTetrahedra[ Face * 2 + 1 ] = ITendrModelGenerator::InvalidIndex;
+	}
+}
+
+//
+// Builds the topology of model data from scratch
+//
+static void BuildTopology( FTendrModelData& ModelData )
+{
+	FTendrModelTopology& Topology = ModelData.Topology;
+	const int32 NumFaces = ModelData.Indices.Num() / 3;
+	const int32 NumTetrahedra = ModelData.TetrahedronFaceIndices.Num() / 4;
+
+	Topology.Reset();
+	GrowTopology( ModelData );
+	for(int32 i = 0; i < NumTetrahedra; ++i)
+	{
+		LinkTetrahedron( ModelData, i );
+	}
+	for(int i = ModelData.MappingCoarseToSparse.Num() - 1; i >= 0; --i)
+	{
+		Topology.SparseToCoarse[ ModelData.MappingCoarseToSparse[ i ] ] = i;
+	}
+	for(int i = 0; i < ModelData.MappingSurfaceToCoarse.Num(); ++i)
+	{
+		Topology.CoarseToSurface[ ModelData.MappingSurfaceToCoarse[ i ] ] = i;
+	}
+
+	// Surface triangles are matched to the used faces by their vertices (sparse)
+	TMap<FIntVector, uint32> Faces;
+	Faces.Reserve( NumFaces );
+	for(int32 i = 0; i < NumFaces; ++i)
+	{
+		if( Topology.FaceTetrahedra[ i * 2 ] != ITendrModelGenerator::InvalidIndex )
+		{
+			Faces.Add( FaceKey( ModelData, i ), i );
+		}
+	}
+	for(int i = 0; i < ModelData.SurfaceIndices.Num() / 3; ++i)
+	{
+		const FIntVector Key = TriangleKey(
+			ModelData.MappingCoarseToSparse[ ModelData.MappingSurfaceToCoarse[ ModelData.SurfaceIndices[ i * 3 + 0 ] ] ],
+			ModelData.MappingCoarseToSparse[ ModelData.MappingSurfaceToCoarse[ ModelData.SurfaceIndices[ i * 3 + 1 ] ] ],
+			ModelData.MappingCoarseToSparse[ ModelData.MappingSurfaceToCoarse[ ModelData.SurfaceIndices[ i * 3 + 2 ] ] ] );
+		if( const uint32* Face = Faces.Find( Key ) )
+		{
+			Topology.FaceSurfaceTriangles[ *Face ] = i;
+		}
+	}
+
+	Topology.NumTetrahedra = NumTetrahedra;
+	Topology.NumSurfaceTriangles = ModelData.SurfaceIndices.Num() / 3;
 }
+
 ///////////////////////////////////////////////////////////////////////////////
 
 UTendrModelTetraGeneratorComponent::UTendrModelTetraGeneratorComponent( const FObjectInitializer &ObjectInitializer )
@@ -82,6 +494,23 @@ UTendrModelTetraGeneratorComponent::UTendrModelTetraGeneratorComponent( const FO
 	MinimumDihedralAngle = 12;
 	MaximumSteinerPoints = 1000;
 	MaximumTetraVolume = 0;
+	bWeldInputVertices = true;
+	bOptimizeVertexCache = true;
+	bWarmStart = true;
+	SizingGridResolution = FIntVector( 0, 0, 0 );
+	SizingGridBounds = FBox( 0 );
+	TargetTetrahedronCount = 0;
+	TargetTetrahedronCountTolerance = 0.05f;
+	AchievedTetrahedronCount = 0;
+	bAutomaticSizing = false;
+	AutomaticSizingResolution = 32;
+	AutomaticSizingScale = 0.5f;
+	bLogPredicateStatistics = false;
+	bLogOperationStatistics = false;
+	MemoryBudgetMB = 0;
+	PeakMemoryMB = 0;
+	bBuildSlowTask = false;
+	WarmStartSettingsCrc = 0;
 }
 
 void UTendrModelTetraGeneratorComponent::OnRegister()
@@ -126,11 +555,21 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 {
 	FTendrModelData OutputModelData;
 
+#if TENDR_TRACE
+	// The events of this build are recorded in a session of their own, concurrent builds do not mix
+	const uint32 TraceSession = FTendrTrace::NewSession();
+	FTendrTraceSessionScope TraceSessionScope( TraceSession );
+#endif
+
 	if(InputVertices.Num() > 0 && InputIndices.Num() > 0)
 	{
+		TENDR_TRACE_SCOPE( "Build" );
+
+		bBuildCancelled = false;
+		bBuildSlowTask = !bSilent;
 		if(!bSilent)
 		{
-			GWarn->BeginSlowTask( FText::FromString( TEXT( "Building Tendr model" ) ), true );
+			GWarn->BeginSlowTask( FText::FromString( TEXT( "Building Tendr model" ) ), true, true );
 		}
 
 		// Generate model
@@ -141,22 +580,82 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 			// 1. Tetrahedralization
 			bool ValidModel = false;
 			tetgenio out;	// deinitialize (deallocator) is automatically called when these go out of scope
+
+			// Temporary indices and edges structures, tetgen writes the face, edge and tetrahedron-to-face lists directly into these arrays
+			// (the corresponding pointers in out are not owned by out and must not be used once the arrays are modified)
+			TArray<uint32> Indices;
+			TArray<uint32> Edges;
+			TArray<uint32> FaceMarkers;
+			FTetgenOutputLists OutputLists;
+			FMemory::Memzero( OutputLists );
+			OutputLists.Lists[ tetgenio::TRIFACELIST ] = &Indices;
+			OutputLists.Lists[ tetgenio::TET2FACELIST ] = &OutputModelData.TetrahedronFaceIndices;
+			OutputLists.Lists[ tetgenio::EDGELIST ] = &Edges;
+			OutputLists.Lists[ tetgenio::TRIFACEMARKERLIST ] = &FaceMarkers;
+			out.outputhandle = &OutputLists;
+			out.outputalloc = TetgenOutputAlloc;
+
+			//
+			// Welded input vertices
+			//
+			// Render vertices with identical positions (e.g. on UV seams) are merged into a single welded vertex, so tetgen only sees unique points.
+			// Tetgen keeps the input points in order, so welded vertex i is output point i, followed by any added (Steiner) points.
+			// Each input triangle is passed with marker (triangle index + 1), which tetgen copies to the output faces on the surface.
+			// The render indices, UVs and tangents are then restored exactly from these tables, without any position lookups.
+			//
+			TArray<int32> RenderToWelded;
+			TArray<int32> WeldedToRender;
+			TArray<uint32> WeldedIndices;
+			if( bWeldInputVertices )
+			{
+				TENDR_TRACE_SCOPE( "WeldInputVertices" );
+
+				TMap<FVector, int32> WeldMap;
+				WeldMap.Reserve( InputVertices.Num() );
+				RenderToWelded.SetNumUninitialized( InputVertices.Num() );
+				for(int i = 0; i < InputVertices.Num(); ++i)
+				{
+					FVector Vertex( InputVertices[ i ].X, InputVertices[ i ].Y, InputVertices[ i ].Z );
+					int32* pWelded = WeldMap.Find( Vertex );
+					if( pWelded == NULL )
+					{
+						RenderToWelded[ i ] = WeldedToRender.Add( i );
+						WeldMap.Add( Vertex, RenderToWelded[ i ] );
+					}
+					else
+					{
+						RenderToWelded[ i ] = *pWelded;
+					}
+				}
+
+				WeldedIndices.SetNumUninitialized( InputIndices.Num() );
+				for(int i = 0; i < InputIndices.Num(); ++i)
+				{
+					WeldedIndices[ i ] = RenderToWelded[ InputIndices[ i ] ];
+				}
+
+				UE_LOG( TendrModelTetraLog, Log, TEXT( "Welded %u input vertices into %u unique positions" ), InputVertices.Num(), WeldedToRender.Num() );
+			}
+
 			{
 				// Tetrahedral model generation
 				{
 					tetgenio in;	// deinitialize (deallocator) is automatically called when these go out of scope
 
 					in.firstnumber = 0;
-					in.numberofpoints = InputVertices.Num();
+					in.numberofpoints = bWeldInputVertices ? WeldedToRender.Num() : InputVertices.Num();
 
 					in.pointlist = new REAL[ in.numberofpoints * 3 ];
 					in.pointparamlist = new tetgenio::pointparam[ in.numberofpoints ];
-					for(int i = 0; i < in.numberofpoints; ++i)
+					for(int n = 0; n < in.numberofpoints; ++n)
 					{
+						// Render vertex of this point (the first one at this position if welded)
+						int i = bWeldInputVertices ? WeldedToRender[ n ] : n;
+
 						// Store vertices
-						in.pointlist[ i * 3 + 0 ] = InputVertices[ i ].X;
-						in.pointlist[ i * 3 + 1 ] = InputVertices[ i ].Y;
-						in.pointlist[ i * 3 + 2 ] = InputVertices[ i ].Z;
+						in.pointlist[ n * 3 + 0 ] = InputVertices[ i ].X;
+						in.pointlist[ n * 3 + 1 ] = InputVertices[ i ].Y;
+						in.pointlist[ n * 3 + 2 ] = InputVertices[ i ].Z;
 
 						// Store UVs
 						tetgenio::pointparam param;
@@ -178,37 +677,87 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 						param.uv[ MAX_TEXCOORDS * 2 + 4 ] = 0;
 						param.uv[ MAX_TEXCOORDS * 2 + 5 ] = 0;
 
-						in.pointparamlist[ i ] = param;
+						in.pointparamlist[ n ] = param;
 
 #ifdef TETRA_DEBUG
 						UE_LOG( TendrModelTetraLog, Log, TEXT( "Vertex %u: %.3f, %.3f, %.3f" ), i, InputVertices[ i ].X, InputVertices[ i ].Y, InputVertices[ i ].Z );
 #endif
 					}
 
-					in.numberoffacets = InputIndices.Num() / 3;
-					in.facetlist = new tetgenio::facet[ in.numberoffacets ];
-					in.facetmarkerlist = new int[ in.numberoffacets ];
-					for(int i = 0; i < in.numberoffacets; ++i)
+					// Pass the input triangles as a triangle soup, read in place by tetgen (no facet and polygon structures per triangle)
+					in.numberoftriangles = InputIndices.Num() / 3;
+					in.trianglelist = (const int*)( bWeldInputVertices ? WeldedIndices.GetData() : InputIndices.GetData() );
+
+					if( bWeldInputVertices )
+					{
+						// Mark each triangle to find it back in the output faces
+						in.facetmarkerlist = new int[ in.numberoftriangles ];
+						for(int i = 0; i < in.numberoftriangles; ++i)
+						{
+							in.facetmarkerlist[ i ] = i + 1;
+						}
+					}
+
+					//
+					// Sizing field
+					//
+					// Per-vertex sizes are passed as tetgen point metrics, which it interpolates for the points it adds.
+					// The sizing grids (including the automatic one) and function are evaluated by tetgen at the circumcenter of each tetrahedron during refinement.
+					//
+					if( VertexMeshSizes.Num() > 0 )
 					{
-						in.facetmarkerlist[ i ] = 1;
+						if( VertexMeshSizes.Num() != InputVertices.Num() )
+						{
+							SetError( FString::Printf( TEXT( "Number of vertex mesh sizes (%d) does not match the number of input vertices (%d)" ), VertexMeshSizes.Num(), InputVertices.Num() ) );
+							goto end;
+						}
 
-						tetgenio::facet& f = in.facetlist[ i ];
-						f.holelist = NULL;
-						f.numberofholes = 0;
-						f.numberofpolygons = 1;
-						f.polygonlist = new tetgenio::polygon[ f.numberofpolygons ];
+						in.numberofpointmtrs = 1;
+						in.pointmtrlist = new REAL[ in.numberofpoints ];
+						for(int n = 0; n < in.numberofpoints; ++n)
+						{
+							in.pointmtrlist[ n ] = VertexMeshSizes[ bWeldInputVertices ? WeldedToRender[ n ] : n ];
+						}
+					}
+					if( SizingGrid.Num() > 0 )
+					{
+						if( SizingGridResolution.X < 1 || SizingGridResolution.Y < 1 || SizingGridResolution.Z < 1 ||
+							SizingGrid.Num() != SizingGridResolution.X * SizingGridResolution.Y * SizingGridResolution.Z )
+						{
+							SetError( FString::Printf( TEXT( "Size of the sizing grid (%d) does not match its resolution (%d x %d x %d)" ),
+									SizingGrid.Num(),
+									SizingGridResolution.X,
+									SizingGridResolution.Y,
+									SizingGridResolution.Z
+									) );
+							goto end;
+						}
+					}
+					if( bAutomaticSizing )
+					{
+						ComputeAutomaticSizing( InputVertices, InputIndices );
 
-						tetgenio::polygon& p = f.polygonlist[ 0 ];
-						p.numberofvertices = 3;
-						p.vertexlist = new int[ p.numberofvertices ];
-						p.vertexlist[ 0 ] = InputIndices[ i * 3 + 0 ];
-						p.vertexlist[ 1 ] = InputIndices[ i * 3 + 1 ];
-						p.vertexlist[ 2 ] = InputIndices[ i * 3 + 2 ];
+						if( !UpdateBuildProgress( TEXT( "automaticsizing" ), 1.0f ) )
+						{
+							SetError( TEXT( "Model generation was cancelled" ) );
+							goto end;
+						}
+					}
+					else
+					{
+						AutomaticSizingGrid.Reset();
+					}
+					if( SizingGrid.Num() > 0 || AutomaticSizingGrid.Num() > 0 || SizingFunction )
+					{
+						in.sizehandle = this;
+						in.meshsize = TetgenMeshSize;
 					}
 
-					in.facetmarkerlist = NULL;
+					UE_LOG( TendrModelTetraLog, Log, TEXT( "Tetrahedralizing mesh (input vertices: %u, triangles: %u)" ), in.numberofpoints, in.numberoftriangles );
 
-					UE_LOG( TendrModelTetraLog, Log, TEXT( "Tetrahedralizing mesh (input vertices: %u, triangles: %u)" ), in.numberofpoints, in.numberoffacets );
+					predicatestats PredicateStats;
+					tetgenopstats OperationStats;
+					memorystats MemoryStats;
 
 					tetgenbehavior b;
 					{
@@ -230,6 +779,9 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 						//b.optlevel = 9;
 						//b.optscheme = 7;
 
+						// Start point location walks from a uniform grid of tets instead of random samples
+						b.gridlocate = 1;
+
 						// Constrain maximum number of added inner (Steiner) points
 						b.steinerleft = MaximumSteinerPoints;
 
@@ -255,6 +807,9 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 						b.minratio = 0;
 						b.mindihedral = MinimumDihedralAngle;
 
+						// Constrain mesh size by the per-vertex sizes
+						b.metric = ( in.numberofpointmtrs > 0 ) ? 1 : 0;
+
 						// Constrain volume
 						if(MaximumTetraVolume > 0)
 						{
@@ -266,15 +821,311 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 							// Must be explicitly set to 0
 							b.fixedvolume = 0;
 						}
+
+						// Run independent work items on the task graph, including the smoothing pass of the mesh optimization
+						b.parallelfor = TetgenParallelFor;
+						b.optparallel = 1;
+
+#if TENDR_TRACE
+						// Record the tetgen stages and its parallel work items
+						b.traceevent = FTendrTrace::TetgenEvent;
+#endif
+
+						// Write elements, faces, edges and neighbors in one pass over the tets
+						b.fuseoutput = 1;
+
+						// Count the predicate evaluations of all tetgen runs of this build (including self-intersection checks and trials)
+						if( bLogPredicateStatistics )
+						{
+							b.predstats = &PredicateStats;
+						}
+						if( bLogOperationStatistics )
+						{
+							b.opstats = &OperationStats;
+						}
+
+						// Account the memory of the tetgen pools of all runs of this build
+						b.memstats = &MemoryStats;
+#if UE_EDITOR
+						// Exceeding the budget cancels the run like a user cancellation, which unwinds through an exception
+						MemoryStats.limit = (unsigned long long)MemoryBudgetMB << 20;
+#endif
+
+#if UE_EDITOR
+						// Report progress from the main loops of tetgen, cancellation unwinds through an exception (only caught in editor builds)
+						b.progress = TetgenProgress;
+						b.progresshandle = this;
+#endif
 					}
 
 #if UE_EDITOR
 					try
 #endif
 					{
+						// Check for self-intersecting input before tetrahedralization, so we don't have to wait for boundary recovery to fail
+						{
+							TENDR_TRACE_SCOPE( "DetectSelfIntersections" );
+
+							int* IntersectingPairs = NULL;
+							int NumIntersectingPairs = detectselfintersections( &b, &in, &IntersectingPairs );
+
+							if( NumIntersectingPairs > 0 )
+							{
+								for(int i = 0; i < NumIntersectingPairs && i < SELF_INTERSECTION_LOG_MAX; ++i)
+								{
+									UE_LOG( TendrModelTetraLog, Log, TEXT( "Triangle %d intersects triangle %d" ), IntersectingPairs[ i * 2 + 0 ], IntersectingPairs[ i * 2 + 1 ] );
+								}
+
+								SetError( FString::Printf( TEXT( "Input contains self-intersecting triangles (%d pairs, e.g. triangles %d and %d)" ),
+										NumIntersectingPairs,
+										IntersectingPairs[ 0 ],
+										IntersectingPairs[ 1 ]
+										) );
+
+								delete[] IntersectingPairs;
+								goto end;
+							}
+						}
+
+						//
+						// Target tetrahedron count
+						//
+						// The number of tetrahedra is about N0 + k / V for a maximum volume V, where N0 is the number without a volume constraint.
+						// Trial tetrahedralizations (without face, edge and neighbour output) solve for V, starting from the volume of the input divided by
+						// the number of tetrahedra to add, until the count is within the tolerance. The best volume is then used for the actual output.
+						//
+						if( TargetTetrahedronCount > 0 )
+						{
+							TENDR_TRACE_SCOPE( "TargetTetrahedronCount" );
+
+							tetgenbehavior TrialBehavior = b;
+							TrialBehavior.facesout = 0;
+							TrialBehavior.edgesout = 0;
+							TrialBehavior.neighout = 0;
+							TrialBehavior.fixedvolume = 0;
+							TrialBehavior.steinerleft = -1;
+
+							int32 MinimumCount;
+							{
+								tetgenio Trial;
+								tetrahedralize( &TrialBehavior, &in, &Trial );
+								MinimumCount = Trial.numberoftetrahedra;
+							}
+
+							// Volume of the input (divergence theorem)
+							double InputVolume = 0;
+							for(int i = 0; i < InputIndices.Num() / 3; ++i)
+							{
+								FVector A( InputVertices[ InputIndices[ i * 3 + 0 ] ] );
+								FVector B( InputVertices[ InputIndices[ i * 3 + 1 ] ] );
+								FVector C( InputVertices[ InputIndices[ i * 3 + 2 ] ] );
+								InputVolume += ( A | ( B ^ C ) ) / 6.0;
+							}
+							InputVolume = FMath::Abs( InputVolume );
+
+							int32 BestCount = MinimumCount;
+							double BestVolume = 0;
+							if( MinimumCount < TargetTetrahedronCount && InputVolume > 0 )
+							{
+								const int32 Tolerance = FMath::Max( (int32)( TargetTetrahedronCount * TargetTetrahedronCountTolerance ), 1 );
+								double Volume = InputVolume / ( TargetTetrahedronCount - MinimumCount );
+								for(int i = 0; i < TARGET_COUNT_ITERATIONS_MAX; ++i)
+								{
+									TrialBehavior.fixedvolume = 1;
+									TrialBehavior.maxvolume = Volume;
+
+									tetgenio Trial;
+									tetrahedralize( &TrialBehavior, &in, &Trial );
+									int32 Count = Trial.numberoftetrahedra;
+
+									UE_LOG( TendrModelTetraLog, Log, TEXT( "Target tetrahedron count trial %d: maximum volume %f, %d tetrahedra" ), i, Volume, Count );
+
+									if( FMath::Abs( Count - TargetTetrahedronCount ) < FMath::Abs( BestCount - TargetTetrahedronCount ) )
+									{
+										BestCount = Count;
+										BestVolume = Volume;
+									}
+									if( FMath::Abs( Count - TargetTetrahedronCount ) <= Tolerance || Count <= MinimumCount )
+									{
+										break;
+									}
+
+									Volume *= (double)( Count - MinimumCount ) / ( TargetTetrahedronCount - MinimumCount );
+								}
+							}
+
+							// Output with the best volume (or none, if the target is below the minimum count)
+							b.steinerleft = -1;
+							b.fixedvolume = ( BestVolume > 0 ) ? 1 : 0;
+							b.maxvolume = BestVolume;
+
+							UE_LOG( TendrModelTetraLog, Log, TEXT( "Target tetrahedron count: %d, best: %d (maximum volume %f), minimum: %d" ), TargetTetrahedronCount, BestCount, BestVolume, MinimumCount );
+						}
+
+						//
+						// Warm start
+						//
+						// When only the positions of input vertices have changed since the last build (with the same settings), tetgen reconstructs the
+						// tetrahedra of the last build (-r) with the moved vertices relocated instead of meshing from scratch, and only refines where they
+						// are no longer good enough. This requires that no tetrahedron is inverted by the moved vertices and that refinement does not run
+						// out of Steiner points, the model is meshed from scratch otherwise (or with per-vertex sizes, a sizing function or a target
+						// tetrahedron count, which are not compared).
+						//
+						uint32 SettingsCrc = 0;
+						SettingsCrc = FCrc::MemCrc32( &MinimumDihedralAngle, sizeof( MinimumDihedralAngle ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &MaximumSteinerPoints, sizeof( MaximumSteinerPoints ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &MaximumTetraVolume, sizeof( MaximumTetraVolume ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &bWeldInputVertices, sizeof( bWeldInputVertices ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( SizingGrid.GetData(), SizingGrid.Num() * sizeof( float ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &SizingGridResolution, sizeof( SizingGridResolution ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &SizingGridBounds.Min, sizeof( FVector ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &SizingGridBounds.Max, sizeof( FVector ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &bAutomaticSizing, sizeof( bAutomaticSizing ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &AutomaticSizingResolution, sizeof( AutomaticSizingResolution ), SettingsCrc );
+						SettingsCrc = FCrc::MemCrc32( &AutomaticSizingScale, sizeof( AutomaticSizingScale ), SettingsCrc );
+
+						tetgenio WarmStartIn;	// deinitialize (deallocator) is automatically called when these go out of scope
+						tetgenbehavior WarmStartBehavior = b;
+						bool bWarmStarted = false;
+						if( bWarmStart && VertexMeshSizes.Num() == 0 && !SizingFunction && TargetTetrahedronCount == 0 &&
+							SettingsCrc == WarmStartSettingsCrc &&
+							WarmStartInputPoints.Num() == in.numberofpoints * 3 &&
+							WarmStartInputTriangles.Num() == in.numberoftriangles * 3 &&
+							FMemory::Memcmp( WarmStartInputTriangles.GetData(), in.trianglelist, in.numberoftriangles * 3 * sizeof( int ) ) == 0 )
+						{
+							TENDR_TRACE_SCOPE( "WarmStart" );
+
+							const int32 NumPoints = WarmStartPoints.Num() / 3;
+							const int32 NumTetrahedra = WarmStartTetrahedra.Num() / 4;
+
+							// Points of the last build with the input vertices at their current positions
+							TArray<bool> Moved;
+							Moved.Init( false, NumPoints );
+							int32 NumMoved = 0;
+							WarmStartIn.firstnumber = 0;
+							WarmStartIn.numberofpoints = NumPoints;
+							WarmStartIn.pointlist = new REAL[ NumPoints * 3 ];
+							FMemory::Memcpy( WarmStartIn.pointlist, WarmStartPoints.GetData(), NumPoints * 3 * sizeof( REAL ) );
+							for(int n = 0; n < in.numberofpoints; ++n)
+							{
+								if( FMemory::Memcmp( &in.pointlist[ n * 3 ], &WarmStartInputPoints[ n * 3 ], 3 * sizeof( REAL ) ) != 0 )
+								{
+									FMemory::Memcpy( &WarmStartIn.pointlist[ n * 3 ], &in.pointlist[ n * 3 ], 3 * sizeof( REAL ) );
+									Moved[ n ] = true;
+									++NumMoved;
+								}
+							}
+
+							// Tetrahedra around moved vertices that are inverted or degenerate now (tetgen would silently reorient them). The static
+							// filters of the predicates are those of the last mesh on this thread, so they are set for the bounding box of both point
+							// sets here (and restored afterwards).
+							predicatefiltersscope FiltersScope;
+							{
+								REAL Min[ 3 ] = { WarmStartIn.pointlist[ 0 ], WarmStartIn.pointlist[ 1 ], WarmStartIn.pointlist[ 2 ] };
+								REAL Max[ 3 ] = { Min[ 0 ], Min[ 1 ], Min[ 2 ] };
+								for(int n = 0; n < NumPoints * 3; ++n)
+								{
+									Min[ n % 3 ] = FMath::Min( Min[ n % 3 ], FMath::Min( WarmStartIn.pointlist[ n ], WarmStartPoints[ n ] ) );
+									Max[ n % 3 ] = FMath::Max( Max[ n % 3 ], FMath::Max( WarmStartIn.pointlist[ n ], WarmStartPoints[ n ] ) );
+								}
+								exactinit( 0, b.noexact, b.nostaticfilter, Max[ 0 ] - Min[ 0 ], Max[ 1 ] - Min[ 1 ], Max[ 2 ] - Min[ 2 ] );
+							}
+
+							int32 NumInverted = 0;
+							auto FnVolume = []( const REAL* Points, const uint32* Corners )
+							{
+								const REAL* A = &Points[ Corners[ 0 ] * 3 ];
+								const REAL* B = &Points[ Corners[ 1 ] * 3 ];
+								const REAL* C = &Points[ Corners[ 2 ] * 3 ];
+								const REAL* D = &Points[ Corners[ 3 ] * 3 ];
+								return orient3d( (REAL*)A, (REAL*)B, (REAL*)C, (REAL*)D );
+							};
+							for(int i = 0; i < NumTetrahedra; ++i)
+							{
+								const uint32* Corners = &WarmStartTetrahedra[ i * 4 ];
+								if( Moved[ Corners[ 0 ] ] || Moved[ Corners[ 1 ] ] || Moved[ Corners[ 2 ] ] || Moved[ Corners[ 3 ] ] )
+								{
+									if( !( FnVolume( WarmStartIn.pointlist, Corners ) * FnVolume( WarmStartPoints.GetData(), Corners ) > 0 ) )
+									{
+										++NumInverted;
+									}
+								}
+							}
+
+							// Steiner points left for refinement, those of the last build count towards the maximum (none left means no refinement at all)
+							const int32 SteinerPointsLeft = MaximumSteinerPoints - ( NumPoints - in.numberofpoints );
+
+							if( NumInverted == 0 && SteinerPointsLeft > 0 )
+							{
+								// Input vertices keep their (current) parameters, the added (Steiner) points are inside
+								WarmStartIn.pointparamlist = new tetgenio::pointparam[ NumPoints ];
+								FMemory::Memcpy( WarmStartIn.pointparamlist, in.pointparamlist, in.numberofpoints * sizeof( tetgenio::pointparam ) );
+								for(int n = in.numberofpoints; n < NumPoints; ++n)
+								{
+									FMemory::Memzero( WarmStartIn.pointparamlist[ n ] );
+									WarmStartIn.pointparamlist[ n ].type = 3;
+								}
+
+								WarmStartIn.numberofcorners = 4;
+								WarmStartIn.numberoftetrahedra = NumTetrahedra;
+								WarmStartIn.tetrahedronlist = new int[ NumTetrahedra * 4 ];
+								FMemory::Memcpy( WarmStartIn.tetrahedronlist, WarmStartTetrahedra.GetData(), NumTetrahedra * 4 * sizeof( int ) );
+
+								// The input triangles are the boundary faces, with their markers
+								WarmStartIn.numberoftrifaces = in.numberoftriangles;
+								WarmStartIn.trifacelist = new int[ in.numberoftriangles * 3 ];
+								FMemory::Memcpy( WarmStartIn.trifacelist, in.trianglelist, in.numberoftriangles * 3 * sizeof( int ) );
+								if( in.facetmarkerlist != NULL )
+								{
+									WarmStartIn.trifacemarkerlist = new int[ in.numberoftriangles ];
+									FMemory::Memcpy( WarmStartIn.trifacemarkerlist, in.facetmarkerlist, in.numberoftriangles * sizeof( int ) );
+								}
+
+								WarmStartIn.sizehandle = in.sizehandle;
+								WarmStartIn.meshsize = in.meshsize;
+
+								// Reconstruct and refine
+								WarmStartBehavior.refine = 1;
+								WarmStartBehavior.plc = 0;
+								WarmStartBehavior.steinerleft = SteinerPointsLeft;
+								bWarmStarted = true;
+							}
+
+							UE_LOG( TendrModelTetraLog, Log, TEXT( "Warm start: %d of %d input vertices moved, %d tetrahedra inverted, %d Steiner points left%s" ),
+									NumMoved,
+									in.numberofpoints,
+									NumInverted,
+									FMath::Max( SteinerPointsLeft, 0 ),
+									bWarmStarted ? TEXT( "" ) : TEXT( ", meshing from scratch" )
+									);
+						}
+
 						// Invoke tetgen
 						{
-							tetrahedralize( &b, &in, &out );
+							TENDR_TRACE_SCOPE( "Tetrahedralize" );
+
+							if( bWarmStarted )
+							{
+								tetrahedralize( &WarmStartBehavior, &WarmStartIn, &out );
+
+								// Refinement stops when it runs out of Steiner points, leaving tetrahedra worse than the settings, which a build from
+								// scratch (with the whole budget) may not
+								if( out.numberofpoints - in.numberofpoints >= MaximumSteinerPoints )
+								{
+									UE_LOG( TendrModelTetraLog, Log, TEXT( "Warm start used up the Steiner points (%d), meshing from scratch" ), MaximumSteinerPoints );
+
+									out.deinitialize();
+									out.initialize();
+									out.outputhandle = &OutputLists;
+									out.outputalloc = TetgenOutputAlloc;
+									bWarmStarted = false;
+								}
+							}
+							if( !bWarmStarted )
+							{
+								tetrahedralize( &b, &in, &out );
+							}
+							AchievedTetrahedronCount = out.numberoftetrahedra;
 
 							UE_LOG( TendrModelTetraLog, Log, TEXT( "Output mesh done, points: %u, tetras: %u, triangles: %u, edges: %u" ),
 									out.numberofpoints,
@@ -303,232 +1154,258 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 								SetError( TEXT( "Model generator output did not output any edges" ) );
 								goto end;
 							}
-						}
-
-						// Conversion to compatible structures
-						{
-							// Temporary indices structure
-							TArray<uint32> Indices;
-
-							// Iterate over generated triangles of model
-							for(int i = 0; i < out.numberoftrifaces; ++i)
+							const int ArrayOutputLists = ( 1 << tetgenio::TRIFACELIST ) | ( 1 << tetgenio::TET2FACELIST ) | ( 1 << tetgenio::EDGELIST ) | ( 1 << tetgenio::TRIFACEMARKERLIST );
+							if( ( out.outputowned & ArrayOutputLists ) != ArrayOutputLists )
 							{
-								int A = out.trifacelist[ i * 3 + 0 ];
-								int B = out.trifacelist[ i * 3 + 1 ];
-								int C = out.trifacelist[ i * 3 + 2 ];
-
-								// Add indices (coarse) to output data
-								Indices.Add( A );
-								Indices.Add( B );
-								Indices.Add( C );
+								// A list did not fit into its array and was left to tetgen (see TetgenOutputAlloc)
+								SetError( TEXT( "Not enough memory available or model excessively large" ) );
+								goto end;
 							}
 
-							//
-							// Face uniqueness
-							//
-							// This map is used to identify faces that are used multiple times, by counting their references.
-							// Since we only allow unique faces for tetrahedra, we use this map to identify and duplicate any non-unique faces.
-							//
-							// This array is initialized with N elements set to 0, where N is the current amount of faces in the tetgen output.
-							//
-							TArray< uint8 > TempFaceUniqueness;
-							TempFaceUniqueness.Init( 0, out.numberoftrifaces );
-							uint32 NonUniqueFaces = 0;
-
-							// Iterate over generated tetrahedra of model
+							// Keep the mesh for warm starting the next build, unless it has added points on the boundary (which would not move along)
+							WarmStartSettingsCrc = 0;
+							WarmStartInputPoints.Reset();
+							WarmStartInputTriangles.Reset();
+							WarmStartPoints.Reset();
+							WarmStartTetrahedra.Reset();
+							if( bWarmStart )
 							{
-								// Lambda function to make faces unique
-								auto FnFaceMakeUnique = [ &TempFaceUniqueness, &NonUniqueFaces, &Indices ]( int FaceIndex )
+								bool bBoundarySteinerPoints = false;
+								for(int i = 0; i < out.numberoftrifaces && !bBoundarySteinerPoints; ++i)
 								{
-									if(TempFaceUniqueness[ FaceIndex ] > 0)
+									if( out.face2tetlist[ i * 2 + 1 ] == -1 )
 									{
-										// Face is not unique, so duplicate by reinserting at the end
-										int A = Indices[ FaceIndex * 3 + 0 ];
-										int B = Indices[ FaceIndex * 3 + 1 ];
-										int C = Indices[ FaceIndex * 3 + 2 ];
-
-										int NewIndex = Indices.Add( A );
-										Indices.Add( B );
-										Indices.Add( C );
-										TempFaceUniqueness.Add( 0 );
-										++NonUniqueFaces;
-
-										// Update face index
-										FaceIndex = NewIndex / 3;
+										bBoundarySteinerPoints = ( Indices[ i * 3 + 0 ] >= (uint32)in.numberofpoints ||
+																   Indices[ i * 3 + 1 ] >= (uint32)in.numberofpoints ||
+																   Indices[ i * 3 + 2 ] >= (uint32)in.numberofpoints );
 									}
+								}
 
-									// Increment uniqueness counter
-									TempFaceUniqueness[ FaceIndex ] = TempFaceUniqueness[ FaceIndex ] + 1;
-									return FaceIndex;
-								};
-
-								for(int i = 0; i < out.numberoftetrahedra; ++i)
+								if( !bBoundarySteinerPoints )
 								{
-									// We assume first-order tetrahedra with 4 vertices
-
-									// For each face, ensure the uniqueness
-									int A = FnFaceMakeUnique( out.tet2facelist[ i * 4 + 0 ] );
-									int B = FnFaceMakeUnique( out.tet2facelist[ i * 4 + 1 ] );
-									int C = FnFaceMakeUnique( out.tet2facelist[ i * 4 + 2 ] );
-									int D = FnFaceMakeUnique( out.tet2facelist[ i * 4 + 3 ] );
-
-									// Store tetrahedron to face mapping
-									OutputModelData.TetrahedronFaceIndices.Add( A );
-									OutputModelData.TetrahedronFaceIndices.Add( B );
-									OutputModelData.TetrahedronFaceIndices.Add( C );
-									OutputModelData.TetrahedronFaceIndices.Add( D );
+									WarmStartSettingsCrc = SettingsCrc;
+									WarmStartInputPoints.Append( in.pointlist, in.numberofpoints * 3 );
+									WarmStartInputTriangles.Append( (const uint32*)in.trianglelist, in.numberoftriangles * 3 );
+									WarmStartPoints.Append( out.pointlist, out.numberofpoints * 3 );
+									WarmStartTetrahedra.Append( (const uint32*)out.tetrahedronlist, out.numberoftetrahedra * 4 );
 								}
-								UE_LOG( TendrModelTetraLog, Log, TEXT( "Face uniqueness pass: %u non unique faces have been found and duplicated" ), NonUniqueFaces );
 							}
+						}
 
-							//
-							// Construct a hash map that maps from vertex (coarse) to input index
-							//
+						// Conversion to compatible structures
+						{
+							// Generated triangles of model (coarse indices) have been written into Indices by tetgen
+							check( Indices.Num() == out.numberoftrifaces * 3 );
+							check( FaceMarkers.Num() == out.numberoftrifaces );
+							check( OutputModelData.TetrahedronFaceIndices.Num() == out.numberoftetrahedra * 4 );
+
+							// Number of render (input) vertices, welded vertices and added (Steiner) vertices
+							const int32 NumRender = InputVertices.Num();
+							const int32 NumWelded = WeldedToRender.Num();
+							const int32 NumCoarse = bWeldInputVertices ? NumRender + ( out.numberofpoints - NumWelded ) : out.numberofpoints;
+
+							// Map from vertex (coarse) to input index, only used without welded input vertices
 							TMap<FVector, uint32> InputToOutputMap;
-							for(int i = 0; i < in.numberofpoints; ++i)
+
+							if( bWeldInputVertices )
 							{
-								FVector Vertex( in.pointlist[ i * 3 + 0 ], in.pointlist[ i * 3 + 1 ], in.pointlist[ i * 3 + 2 ] );
-								InputToOutputMap.Add( Vertex, i );
-							}
+								TENDR_TRACE_SCOPE( "RestoreSurfaceIndices" );
 
-							//
-							// Tetgen regenerates the triangle faces from scratch, and excessively throws out any duplicate vertices on the way.
-							// Unfortunately, we need these duplicate vertices to be present in the faces,
-							// as they point to vertices which have an identical position but have different UV data.
-							//
-							// Therefore, we iterate over the generated face indices, and find any equivalent faces (e.g. matching positions) in the input face array.
-							// If a match is found, we know that tetgen has messed up the face indices, and we replace all indices with the original data.
-							//
-							// In the end, our original surface face indices are restored within tetgen's output, and our UV vertex data will still be useable.
-							//
-							// While a naive algorithm would simply iterate over all face indices to find any input face indices that match
-							// (thus iterating over all input indices), we use a much faster spatial hashing algorithm instead:
-							//
-							// 1. The min/max bounds of the output (and thus input) indices are calculated.
-							// 2. For each face, each of the 3 vertices is normalized into the min/max bounds, quantized using a fixed HashSize and converted into a 1D hash coordinate.
-							// 3. The 1D hash coordinates for all 3 vertices are then summed to create a single 64-bit "face hash".
-							// 4. Information about the face is stored using the 64-bit face hash in a FUniqueTriangle structure.
-							// 5. A new iteration over all output face indices is done, a 64-bit face hash is calculated, and any duplicate faces (with any vertex permutationS) are found.
-							//
-							UE_LOG( TendrModelTetraLog, Log, TEXT( "Starting duplicate face pass" ) );
+								//
+								// Restore the render indices of the surface faces
+								//
+								// A surface face carries the marker of its input triangle. If it has the same (welded) corners, it is the input triangle
+								// itself and its render indices are used. Any other face uses the first render vertex at each corner (or the added vertex).
+								//
+								auto FnWeldedToCoarse = [ &WeldedToRender, NumRender, NumWelded ]( int32 Point )
+								{
+									return ( Point < NumWelded ) ? (uint32)WeldedToRender[ Point ] : (uint32)( NumRender + ( Point - NumWelded ) );
+								};
+
+								OutputModelData.Indices.SetNumUninitialized( Indices.Num() );
+								for(int i = 0; i < Indices.Num() / 3; ++i)
+								{
+									uint32 A = Indices[ i * 3 + 0 ];
+									uint32 B = Indices[ i * 3 + 1 ];
+									uint32 C = Indices[ i * 3 + 2 ];
+
+									bool bInputFace = false;
+									int32 Triangle = (int32)FaceMarkers[ i ] - 1;
+									if( Triangle >= 0 && Triangle < InputIndices.Num() / 3 )
+									{
+										uint32 WA = WeldedIndices[ Triangle * 3 + 0 ];
+										uint32 WB = WeldedIndices[ Triangle * 3 + 1 ];
+										uint32 WC = WeldedIndices[ Triangle * 3 + 2 ];
+										bInputFace = ( A == WA || A == WB || A == WC ) && ( B == WA || B == WB || B == WC ) && ( C == WA || C == WB || C == WC );
+									}
+
+									if( bInputFace )
+									{
+										OutputModelData.Indices[ i * 3 + 0 ] = InputIndices[ Triangle * 3 + 0 ];
+										OutputModelData.Indices[ i * 3 + 1 ] = InputIndices[ Triangle * 3 + 1 ];
+										OutputModelData.Indices[ i * 3 + 2 ] = InputIndices[ Triangle * 3 + 2 ];
+									}
+									else
+									{
+										OutputModelData.Indices[ i * 3 + 0 ] = FnWeldedToCoarse( A );
+										OutputModelData.Indices[ i * 3 + 1 ] = FnWeldedToCoarse( B );
+										OutputModelData.Indices[ i * 3 + 2 ] = FnWeldedToCoarse( C );
+									}
+								}
+							}
+							else
 							{
-								struct FUniqueTriangle
+								TENDR_TRACE_SCOPE( "RestoreSurfaceIndices" );
+
+								//
+								// Construct a hash map that maps from vertex (coarse) to input index
+								//
+								for(int i = 0; i < in.numberofpoints; ++i)
+								{
+									FVector Vertex( in.pointlist[ i * 3 + 0 ], in.pointlist[ i * 3 + 1 ], in.pointlist[ i * 3 + 2 ] );
+									InputToOutputMap.Add( Vertex, i );
+								}
+
+								//
+								// Tetgen regenerates the triangle faces from scratch, and excessively throws out any duplicate vertices on the way.
+								// Unfortunately, we need these duplicate vertices to be present in the faces,
+								// as they point to vertices which have an identical position but have different UV data.
+								//
+								// Therefore, we iterate over the generated face indices, and find any equivalent faces (e.g. matching positions) in the input face array.
+								// If a match is found, we know that tetgen has messed up the face indices, and we replace all indices with the original data.
+								//
+								// In the end, our original surface face indices are restored within tetgen's output, and our UV vertex data will still be useable.
+								//
+								// While a naive algorithm would simply iterate over all face indices to find any input face indices that match
+								// (thus iterating over all input indices), we use a much faster spatial hashing algorithm instead:
+								//
+								// 1. The min/max bounds of the output (and thus input) indices are calculated.
+								// 2. For each face, each of the 3 vertices is normalized into the min/max bounds, quantized using a fixed HashSize and converted into a 1D hash coordinate.
+								// 3. The 1D hash coordinates for all 3 vertices are then summed to create a single 64-bit "face hash".
+								// 4. Information about the face is stored using the 64-bit face hash in a FUniqueTriangle structure.
+								// 5. A new iteration over all output face indices is done, a 64-bit face hash is calculated, and any duplicate faces (with any vertex permutationS) are found.
+								//
+								UE_LOG( TendrModelTetraLog, Log, TEXT( "Starting duplicate face pass" ) );
 								{
-									FUniqueTriangle( const FVector _VA, const FVector _VB, const FVector _VC )
+									struct FUniqueTriangle
+									{
+										FUniqueTriangle( const FVector _VA, const FVector _VB, const FVector _VC )
+											: VA(_VA)
+											, VB(_VB)
+											, VC(_VC)
+											, A(-1)
+											, B(-1)
+											, C(-1)
+										{}
+
+										FUniqueTriangle( const FVector _VA, const FVector _VB, const FVector _VC, const int _A, const int _B, const int _C )
 										: VA(_VA)
 										, VB(_VB)
 										, VC(_VC)
-										, A(-1)
-										, B(-1)
-										, C(-1)
-									{}
-
-									FUniqueTriangle( const FVector _VA, const FVector _VB, const FVector _VC, const int _A, const int _B, const int _C )
-									: VA(_VA)
-									, VB(_VB)
-									, VC(_VC)
-									, A(_A)
-									, B(_B)
-									, C(_C)
-									{}
-
-									FVector VA, VB, VC;
-									int A, B, C;
-								};
+										, A(_A)
+										, B(_B)
+										, C(_C)
+										{}
 
-								TMultiMap<uint64, FUniqueTriangle> UniqueNormMap;
+										FVector VA, VB, VC;
+										int A, B, C;
+									};
 
-								const int HashSize = 1 << 16;
+									TMultiMap<uint64, FUniqueTriangle> UniqueNormMap;
+									OutputModelData.Indices.Reserve( Indices.Num() );
 
-								FVector Min(1E6,1E6,1E6), Max(-1E6,-1E6,-1E6);
+									const int HashSize = 1 << 16;
 
-								// Iterate over output indices
-								for(int i = 0; i < Indices.Num() / 3; ++i)
-								{
-									int A = Indices[ i * 3 + 0 ];
-									int B = Indices[ i * 3 + 1 ];
-									int C = Indices[ i * 3 + 2 ];
+									FVector Min(1E6,1E6,1E6), Max(-1E6,-1E6,-1E6);
+
+									// Iterate over output indices
+									for(int i = 0; i < Indices.Num() / 3; ++i)
+									{
+										int A = Indices[ i * 3 + 0 ];
+										int B = Indices[ i * 3 + 1 ];
+										int C = Indices[ i * 3 + 2 ];
 
-									FVector VA = FVector( out.pointlist[ A * 3 + 0 ], out.pointlist[ A * 3 + 1 ], out.pointlist[ A * 3 + 2 ] );
-									FVector VB = FVector( out.pointlist[ B * 3 + 0 ], out.pointlist[ B * 3 + 1 ], out.pointlist[ B * 3 + 2 ] );
-									FVector VC = FVector( out.pointlist[ C * 3 + 0 ], out.pointlist[ C * 3 + 1 ], out.pointlist[ C * 3 + 2 ] );
+										FVector VA = FVector( out.pointlist[ A * 3 + 0 ], out.pointlist[ A * 3 + 1 ], out.pointlist[ A * 3 + 2 ] );
+										FVector VB = FVector( out.pointlist[ B * 3 + 0 ], out.pointlist[ B * 3 + 1 ], out.pointlist[ B * 3 + 2 ] );
+										FVector VC = FVector( out.pointlist[ C * 3 + 0 ], out.pointlist[ C * 3 + 1 ], out.pointlist[ C * 3 + 2 ] );
 
-									Min.X = VA.X < Min.X ? VA.X : Min.X;
-									Min.Y = VA.Y < Min.Y ? VA.Y : Min.Y;
-									Min.Z = VA.Z < Min.Z ? VA.Z : Min.Z;
+										Min.X = VA.X < Min.X ? VA.X : Min.X;
+										Min.Y = VA.Y < Min.Y ? VA.Y : Min.Y;
+										Min.Z = VA.Z < Min.Z ? VA.Z : Min.Z;
 
-									Max.X = VA.X > Max.X ? VA.X : Max.X;
-									Max.Y = VA.Y > Max.Y ? VA.Y : Max.Y;
-									Max.Z = VA.Z > Max.Z ? VA.Z : Max.Z;
-								}
+										Max.X = VA.X > Max.X ? VA.X : Max.X;
+										Max.Y = VA.Y > Max.Y ? VA.Y : Max.Y;
+										Max.Z = VA.Z > Max.Z ? VA.Z : Max.Z;
+									}
 
-								// Calculate spatial hash multiplier vector
-								FVector MinMaxMultiplier = Max - Min;
-								MinMaxMultiplier.X = 1.0 / MinMaxMultiplier.X * HashSize;
-								MinMaxMultiplier.Y = 1.0 / MinMaxMultiplier.Y * HashSize;
-								MinMaxMultiplier.Z = 1.0 / MinMaxMultiplier.Z * HashSize;
+									// Calculate spatial hash multiplier vector
+									FVector MinMaxMultiplier = Max - Min;
+									MinMaxMultiplier.X = 1.0 / MinMaxMultiplier.X * HashSize;
+									MinMaxMultiplier.Y = 1.0 / MinMaxMultiplier.Y * HashSize;
+									MinMaxMultiplier.Z = 1.0 / MinMaxMultiplier.Z * HashSize;
 
-								// Inline function to calculate spatial hash
-								auto FnFaceHash = [ &Min, &MinMaxMultiplier, &HashSize ]( const FVector &VA, const FVector &VB, const FVector &VC )
-								{
-									FVector GA = (VA - Min) * MinMaxMultiplier;
-									FVector GB = (VB - Min) * MinMaxMultiplier;
-									FVector GC = (VC - Min) * MinMaxMultiplier;
+									// Inline function to calculate spatial hash
+									auto FnFaceHash = [ &Min, &MinMaxMultiplier, &HashSize ]( const FVector &VA, const FVector &VB, const FVector &VC )
+									{
+										FVector GA = (VA - Min) * MinMaxMultiplier;
+										FVector GB = (VB - Min) * MinMaxMultiplier;
+										FVector GC = (VC - Min) * MinMaxMultiplier;
 
-									uint64 HA = (GA.Z * HashSize * HashSize) + (GA.Y * HashSize) + GA.X;
-									uint64 HB = (GB.Z * HashSize * HashSize) + (GB.Y * HashSize) + GB.X;
-									uint64 HC = (GC.Z * HashSize * HashSize) + (GC.Y * HashSize) + GC.X;
+										uint64 HA = (GA.Z * HashSize * HashSize) + (GA.Y * HashSize) + GA.X;
+										uint64 HB = (GB.Z * HashSize * HashSize) + (GB.Y * HashSize) + GB.X;
+										uint64 HC = (GC.Z * HashSize * HashSize) + (GC.Y * HashSize) + GC.X;
 
-									return (uint64)( HA + HB + HC );
-								};
+										return (uint64)( HA + HB + HC );
+									};
 								
-								// Iterate over input indices
-								for(int i = 0; i < InputIndices.Num() / 3; ++i)
-								{
-									int A = InputIndices[ i * 3 + 0 ];
-									int B = InputIndices[ i * 3 + 1 ];
-									int C = InputIndices[ i * 3 + 2 ];
+									// Iterate over input indices
+									for(int i = 0; i < InputIndices.Num() / 3; ++i)
+									{
+										int A = InputIndices[ i * 3 + 0 ];
+										int B = InputIndices[ i * 3 + 1 ];
+										int C = InputIndices[ i * 3 + 2 ];
 
-									FVector VA = FVector( out.pointlist[ A * 3 + 0 ], out.pointlist[ A * 3 + 1 ], out.pointlist[ A * 3 + 2 ] );
-									FVector VB = FVector( out.pointlist[ B * 3 + 0 ], out.pointlist[ B * 3 + 1 ], out.pointlist[ B * 3 + 2 ] );
-									FVector VC = FVector( out.pointlist[ C * 3 + 0 ], out.pointlist[ C * 3 + 1 ], out.pointlist[ C * 3 + 2 ] );
+										FVector VA = FVector( out.pointlist[ A * 3 + 0 ], out.pointlist[ A * 3 + 1 ], out.pointlist[ A * 3 + 2 ] );
+										FVector VB = FVector( out.pointlist[ B * 3 + 0 ], out.pointlist[ B * 3 + 1 ], out.pointlist[ B * 3 + 2 ] );
+										FVector VC = FVector( out.pointlist[ C * 3 + 0 ], out.pointlist[ C * 3 + 1 ], out.pointlist[ C * 3 + 2 ] );
 
-									UniqueNormMap.Add( FnFaceHash( VA, VB, VC ), FUniqueTriangle( VA, VB, VC, A, B, C ) );
-								}
+										UniqueNormMap.Add( FnFaceHash( VA, VB, VC ), FUniqueTriangle( VA, VB, VC, A, B, C ) );
+									}
 
-								// Iterate over output indices
-								for(int i = 0; i < Indices.Num() / 3; ++i)
-								{
-									int A = Indices[ i * 3 + 0 ];
-									int B = Indices[ i * 3 + 1 ];
-									int C = Indices[ i * 3 + 2 ];
-
-									FVector VA = FVector( out.pointlist[ A * 3 + 0 ], out.pointlist[ A * 3 + 1 ], out.pointlist[ A * 3 + 2 ] );
-									FVector VB = FVector( out.pointlist[ B * 3 + 0 ], out.pointlist[ B * 3 + 1 ], out.pointlist[ B * 3 + 2 ] );
-									FVector VC = FVector( out.pointlist[ C * 3 + 0 ], out.pointlist[ C * 3 + 1 ], out.pointlist[ C * 3 + 2 ] );
-
-									// Look for a matching face (with any vertex permutation) in UniqueNormMap
-									TArray<FUniqueTriangle> Array;
-									UniqueNormMap.MultiFind( FnFaceHash( VA, VB, VC ), Array );
-									if( Array.Num() > 0 )
+									// Iterate over output indices
+									for(int i = 0; i < Indices.Num() / 3; ++i)
 									{
-										for(int i = 0; i < Array.Num(); ++i)
+										int A = Indices[ i * 3 + 0 ];
+										int B = Indices[ i * 3 + 1 ];
+										int C = Indices[ i * 3 + 2 ];
+
+										FVector VA = FVector( out.pointlist[ A * 3 + 0 ], out.pointlist[ A * 3 + 1 ], out.pointlist[ A * 3 + 2 ] );
+										FVector VB = FVector( out.pointlist[ B * 3 + 0 ], out.pointlist[ B * 3 + 1 ], out.pointlist[ B * 3 + 2 ] );
+										FVector VC = FVector( out.pointlist[ C * 3 + 0 ], out.pointlist[ C * 3 + 1 ], out.pointlist[ C * 3 + 2 ] );
+
+										// Look for a matching face (with any vertex permutation) in UniqueNormMap
+										TArray<FUniqueTriangle> Array;
+										UniqueNormMap.MultiFind( FnFaceHash( VA, VB, VC ), Array );
+										if( Array.Num() > 0 )
 										{
-											FUniqueTriangle UT = Array[i];
-											if( (( VA == UT.VA || VA == UT.VB || VA == UT.VC ) && ( VB == UT.VA || VB == UT.VB || VB == UT.VC ) && ( VC == UT.VA || VC == UT.VB || VC == UT.VC ) ) )
+											for(int i = 0; i < Array.Num(); ++i)
 											{
-												A = UT.A;
-												B = UT.B;
-												C = UT.C;
+												FUniqueTriangle UT = Array[i];
+												if( (( VA == UT.VA || VA == UT.VB || VA == UT.VC ) && ( VB == UT.VA || VB == UT.VB || VB == UT.VC ) && ( VC == UT.VA || VC == UT.VB || VC == UT.VC ) ) )
+												{
+													A = UT.A;
+													B = UT.B;
+													C = UT.C;
+												}
 											}
 										}
+										OutputModelData.Indices.Add( A );
+										OutputModelData.Indices.Add( B );
+										OutputModelData.Indices.Add( C );
 									}
-									OutputModelData.Indices.Add( A );
-									OutputModelData.Indices.Add( B );
-									OutputModelData.Indices.Add( C );
 								}
+								UE_LOG( TendrModelTetraLog, Log, TEXT( "Finished duplicate face pass" ) );
 							}
-							UE_LOG( TendrModelTetraLog, Log, TEXT( "Finished duplicate face pass" ) );
 
 							//
 							// Coarse-to-sparse mapping
@@ -541,88 +1418,249 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 							//
 							TMap<FVector, uint32> TempMapCoarseToSparse;
 
-							// Iterate over generated points of model
-							for(int i = 0; i < out.numberofpoints; ++i)
+							// Size the per-vertex (coarse) arrays once
+							OutputModelData.Vertices.Reserve( NumCoarse );
+							for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
 							{
-								// Store vertex (coarse)
-								FVector Vertex( out.pointlist[ i * 3 + 0 ], out.pointlist[ i * 3 + 1 ], out.pointlist[ i * 3 + 2 ] );
-								OutputModelData.Vertices.Add( FVector4( Vertex, 0 ) );
+								OutputModelData.TexCoords[ t ].Reserve( NumCoarse );
+							}
+							OutputModelData.Tangents.Reserve( NumCoarse );
+							OutputModelData.VerticesSurfaceIndicators.Reserve( NumCoarse );
+							OutputModelData.MappingCoarseToSparse.Reserve( NumCoarse );
 
-								// Store UVs
-								for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
-								{
-									OutputModelData.TexCoords[ t ].Add( FVector2D( out.pointparamlist[ i ].uv[ t * 2 + 0 ], out.pointparamlist[ i ].uv[ t * 2 + 1 ] ) );
-								}
+							if( bWeldInputVertices )
+							{
+								TENDR_TRACE_SCOPE( "CoarseVertices" );
 
-								// Store tangents
+								// Render vertices (coarse) followed by the added vertices, the sparse vertices are the welded vertices followed by the added vertices
+								for(int i = 0; i < NumCoarse; ++i)
 								{
-									FTendrTangent Tangent;
+									bool bInterior = ( i >= NumRender );
+									int32 Point = bInterior ? NumWelded + ( i - NumRender ) : RenderToWelded[ i ];
 
-									Tangent.TangentX = FPackedRGB10A2N( *((uint32*)(&out.pointparamlist[ i ].uv[ MAX_TEXCOORDS * 2 + 0 ])) );
-									Tangent.TangentZ = FPackedRGB10A2N( *((uint32*)(&out.pointparamlist[ i ].uv[ MAX_TEXCOORDS * 2 + 1 ])) );
+									// Store vertex (coarse)
+									FVector Vertex( out.pointlist[ Point * 3 + 0 ], out.pointlist[ Point * 3 + 1 ], out.pointlist[ Point * 3 + 2 ] );
+									OutputModelData.Vertices.Add( FVector4( Vertex, 0 ) );
 
+									// Store UVs and tangents, render vertices take them from the input
+									FTendrTangent Tangent;
+									if( bInterior )
+									{
+										for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
+										{
+											OutputModelData.TexCoords[ t ].Add( FVector2D( out.pointparamlist[ Point ].uv[ t * 2 + 0 ], out.pointparamlist[ Point ].uv[ t * 2 + 1 ] ) );
+										}
+										Tangent.TangentX = FPackedRGB10A2N( *((uint32*)(&out.pointparamlist[ Point ].uv[ MAX_TEXCOORDS * 2 + 0 ])) );
+										Tangent.TangentZ = FPackedRGB10A2N( *((uint32*)(&out.pointparamlist[ Point ].uv[ MAX_TEXCOORDS * 2 + 1 ])) );
+									}
+									else
+									{
+										for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
+										{
+											OutputModelData.TexCoords[ t ].Add( InputTexCoords[ t ][ i ] );
+										}
+										Tangent = InputTangents[ i ];
+										++NumSurfaceVerts;
+									}
 									OutputModelData.Tangents.Add( Tangent );
+									OutputModelData.VerticesSurfaceIndicators.Add( bInterior );
+
+									// Coarse to sparse mapping
+									OutputModelData.MappingCoarseToSparse.Add( Point );
 								}
 
-								//
-								// Find any equivalent vertices (coarse) in the input data and determine which output vertices (coarse) are actually on the surface
-								//
-								bool bInterior = ( InputToOutputMap.Find( Vertex ) != NULL ) ? false : true;
-								if( !bInterior )
+								OutputModelData.VerticesPhysics.Reserve( out.numberofpoints );
+								OutputModelData.Connectivity.Reserve( out.numberofpoints );
+								for(int i = 0; i < out.numberofpoints; ++i)
 								{
-									++NumSurfaceVerts;
+									// Add vertex to sparse data structure
+									OutputModelData.VerticesPhysics.Add( FVector4( out.pointlist[ i * 3 + 0 ], out.pointlist[ i * 3 + 1 ], out.pointlist[ i * 3 + 2 ], 0 ) );
+
+									// Initialize dummy connectivity to InvalidIndex
+									FTendrVertexConnectivityData Dummy;
+									memset( Dummy.NeighbourIndices, 0xFF, sizeof( Dummy.NeighbourIndices ) );
+									OutputModelData.Connectivity.Add( Dummy );
 								}
-								OutputModelData.VerticesSurfaceIndicators.Add( bInterior );
+							}
+							else
+							{
+								TENDR_TRACE_SCOPE( "CoarseVertices" );
 
-								// Coarse to sparse mapping algorithm
+								// Iterate over generated points of model
+								for(int i = 0; i < out.numberofpoints; ++i)
 								{
-									uint32 IndexSparse = OutputModelData.VerticesPhysics.Num();
+									// Store vertex (coarse)
+									FVector Vertex( out.pointlist[ i * 3 + 0 ], out.pointlist[ i * 3 + 1 ], out.pointlist[ i * 3 + 2 ] );
+									OutputModelData.Vertices.Add( FVector4( Vertex, 0 ) );
 
-									// Check if duplicate vertex exists and insert if it doesn't
-									uint32 * pKey = TempMapCoarseToSparse.Find( Vertex );
-									if(pKey == NULL)
+									// Store UVs
+									for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
 									{
-										// No duplicate vertex exists
+										OutputModelData.TexCoords[ t ].Add( FVector2D( out.pointparamlist[ i ].uv[ t * 2 + 0 ], out.pointparamlist[ i ].uv[ t * 2 + 1 ] ) );
+									}
 
-										// Add to map
-										TempMapCoarseToSparse.Add( Vertex, IndexSparse );
+									// Store tangents
+									{
+										FTendrTangent Tangent;
 
-										// Initialize dummy connectivity to InvalidIndex
-										FTendrVertexConnectivityData Dummy;
-										memset( Dummy.NeighbourIndices, 0xFF, sizeof( Dummy.NeighbourIndices ) );
-										OutputModelData.Connectivity.Add( Dummy );
+										Tangent.TangentX = FPackedRGB10A2N( *((uint32*)(&out.pointparamlist[ i ].uv[ MAX_TEXCOORDS * 2 + 0 ])) );
+										Tangent.TangentZ = FPackedRGB10A2N( *((uint32*)(&out.pointparamlist[ i ].uv[ MAX_TEXCOORDS * 2 + 1 ])) );
 
-#ifdef TETRA_DEBUG
-										UE_LOG( TendrModelTetraLog, Log, TEXT( "Vertex %u (%.3f, %.3f, %.3f) ++ physics vertex %u" ),
-												i,
-												Vertex.X,
-												Vertex.Y,
-												Vertex.Z,
-												IndexSparse
-												);
-#endif
-										// Add vertex to sparse data structure
-										OutputModelData.VerticesPhysics.Add( FVector4( Vertex, 0 ) );
+										OutputModelData.Tangents.Add( Tangent );
+									}
 
+									//
+									// Find any equivalent vertices (coarse) in the input data and determine which output vertices (coarse) are actually on the surface
+									//
+									bool bInterior = ( InputToOutputMap.Find( Vertex ) != NULL ) ? false : true;
+									if( !bInterior )
+									{
+										++NumSurfaceVerts;
 									}
-									else
+									OutputModelData.VerticesSurfaceIndicators.Add( bInterior );
+
+									// Coarse to sparse mapping algorithm
 									{
+										uint32 IndexSparse = OutputModelData.VerticesPhysics.Num();
+
+										// Check if duplicate vertex exists and insert if it doesn't
+										uint32 * pKey = TempMapCoarseToSparse.Find( Vertex );
+										if(pKey == NULL)
+										{
+											// No duplicate vertex exists
+
+											// Add to map
+											TempMapCoarseToSparse.Add( Vertex, IndexSparse );
+
+											// Initialize dummy connectivity to InvalidIndex
+											FTendrVertexConnectivityData Dummy;
+											memset( Dummy.NeighbourIndices, 0xFF, sizeof( Dummy.NeighbourIndices ) );
+											OutputModelData.Connectivity.Add( Dummy );
+
+#ifdef TETRA_DEBUG
+											UE_LOG( TendrModelTetraLog, Log, TEXT( "Vertex %u (%.3f, %.3f, %.3f) ++ physics vertex %u" ),
+													i,
+													Vertex.X,
+													Vertex.Y,
+													Vertex.Z,
+													IndexSparse
+													);
+#endif
+											// Add vertex to sparse data structure
+											OutputModelData.VerticesPhysics.Add( FVector4( Vertex, 0 ) );
+
+										}
+										else
+										{
 #ifdef TETRA_DEBUG
-										UE_LOG( TendrModelTetraLog, Log, TEXT( "Vertex %u (%.3f, %.3f, %.3f) == physics vertex %u" ),
-												i,
-												Vertex.X,
-												Vertex.Y,
-												Vertex.Z,
-												*pKey
-												);
+											UE_LOG( TendrModelTetraLog, Log, TEXT( "Vertex %u (%.3f, %.3f, %.3f) == physics vertex %u" ),
+													i,
+													Vertex.X,
+													Vertex.Y,
+													Vertex.Z,
+													*pKey
+													);
 #endif
+										}
+
+										// In any case, add mapping
+										OutputModelData.MappingCoarseToSparse.Add( ( pKey == NULL ) ? IndexSparse : (*pKey) );
+									}
+								}
+							}
+
+							//
+							// Face orientation
+							//
+							// Each face is stored once and is shared by the (at most) two tetrahedra on either side. Tetgen winds a face inward for the first
+							// tetrahedron in its face-to-tetrahedra list, but the restored render indices of a surface face may be wound either way. The windings
+							// are compared (as sparse vertices), and FTendrModelData::TetrahedronFaceOrientationBit is set in the face index of each tetrahedron for
+							// which the stored face is not wound inward.
+							//
+							{
+								TENDR_TRACE_SCOPE( "FaceOrientation" );
+
+								check( out.face2tetlist != NULL );
+
+								TArray<bool> ReversedFaces;
+								ReversedFaces.SetNumUninitialized( out.numberoftrifaces );
+								for(int i = 0; i < out.numberoftrifaces; ++i)
+								{
+									uint32 Tetgen[ 3 ];
+									uint32 Stored[ 3 ];
+									for(int k = 0; k < 3; ++k)
+									{
+										// Tetgen's points are the sparse vertices when welding, otherwise they are the coarse vertices
+										Tetgen[ k ] = bWeldInputVertices ? Indices[ i * 3 + k ] : OutputModelData.MappingCoarseToSparse[ Indices[ i * 3 + k ] ];
+										Stored[ k ] = OutputModelData.MappingCoarseToSparse[ OutputModelData.Indices[ i * 3 + k ] ];
+									}
+									ReversedFaces[ i ] = !SameWinding( Stored, Tetgen );
+								}
+
+								uint32 NumSharedFaces = 0;
+								for(int i = 0; i < OutputModelData.TetrahedronFaceIndices.Num(); ++i)
+								{
+									uint32 FaceIndex = OutputModelData.TetrahedronFaceIndices[ i ];
+									bool bFirst = ( out.face2tetlist[ FaceIndex * 2 + 0 ] == i / 4 );
+									if( bFirst == ReversedFaces[ FaceIndex ] )
+									{
+										OutputModelData.TetrahedronFaceIndices[ i ] = FaceIndex | FTendrModelData::TetrahedronFaceOrientationBit;
+									}
+									NumSharedFaces += bFirst ? 0 : 1;
+								}
+								UE_LOG( TendrModelTetraLog, Log, TEXT( "Face orientation pass: %u faces are shared by two tetrahedra" ), NumSharedFaces );
+							}
+
+							//
+							// Surface index buffer
+							//
+							// Indices contains every face of every tetrahedron, which are needed for physics only.
+							// For rendering, only the boundary faces are emitted, i.e. the faces without a tetrahedron on their other side, with their restored
+							// render indices. These are remapped to a compact set of surface vertices in order of first use.
+							//
+							{
+								TENDR_TRACE_SCOPE( "SurfaceIndices" );
+
+								check( out.face2tetlist != NULL );
+
+								TArray<uint32> TempCoarseToSurface;
+								TempCoarseToSurface.Init( InvalidIndex, OutputModelData.Vertices.Num() );
+								OutputModelData.SurfaceIndices.Reserve( InputIndices.Num() );
+								OutputModelData.MappingSurfaceToCoarse.Reserve( NumSurfaceVerts );
+
+								for(int i = 0; i < out.numberoftrifaces; ++i)
+								{
+									// Skip interior faces
+									if( out.face2tetlist[ i * 2 + 1 ] != -1 )
+									{
+										continue;
 									}
 
-									// In any case, add mapping
-									OutputModelData.MappingCoarseToSparse.Add( ( pKey == NULL ) ? IndexSparse : (*pKey) );
+									for(int k = 0; k < 3; ++k)
+									{
+										uint32 Coarse = OutputModelData.Indices[ i * 3 + k ];
+										if( TempCoarseToSurface[ Coarse ] == InvalidIndex )
+										{
+											TempCoarseToSurface[ Coarse ] = OutputModelData.MappingSurfaceToCoarse.Add( Coarse );
+										}
+										OutputModelData.SurfaceIndices.Add( TempCoarseToSurface[ Coarse ] );
+									}
 								}
 							}
 
+							//
+							// Surface optimization
+							//
+							// Tetgen outputs the faces in its own traversal order, which is effectively random for the GPU vertex cache.
+							// The surface triangles are reordered for the vertex cache (Forsyth), then clusters of them are reordered for overdraw
+							// and finally the coarse vertices are reordered in order of first use.
+							//
+							if( bOptimizeVertexCache )
+							{
+								OptimizeVertexCache( OutputModelData.SurfaceIndices, OutputModelData.MappingSurfaceToCoarse.Num() );
+								OptimizeOverdraw( OutputModelData.SurfaceIndices, OutputModelData );
+							}
+
 							// Output some statistics
 							UE_LOG( TendrModelTetraLog, Log, TEXT( "Input  = Indices [%u], Vertices [%u]" ), InputIndices.Num(), InputVertices.Num() );
 							UE_LOG( TendrModelTetraLog, Log, TEXT( "Output = Indices [%u], Triangles [%u], Tetrahedra [%u], Vertices [%u surface, %u internal, %u physics]" ),
@@ -633,32 +1671,130 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 									OutputModelData.Vertices.Num(),
 									OutputModelData.VerticesPhysics.Num()
 									);
-
-							// Add connectivity based on edges
-							uint32 MaxNeighbours = 0;
-							for(int i = 0; i < out.numberofedges; ++i)
+							UE_LOG( TendrModelTetraLog, Log, TEXT( "Surface = Indices [%u], Triangles [%u], Vertices [%u]" ),
+									OutputModelData.SurfaceIndices.Num(),
+									OutputModelData.SurfaceIndices.Num() / 3,
+									OutputModelData.MappingSurfaceToCoarse.Num()
+									);
+							if( bLogPredicateStatistics )
 							{
-								int a, b;
+								static const TCHAR* PredicateNames[ predicatestats::NUMPREDICATES ] = { TEXT( "orient3d" ), TEXT( "insphere" ), TEXT( "orient4d" ) };
+								for(int i = 0; i < predicatestats::NUMPREDICATES; ++i)
 								{
-									// Retrieve edge indices (coarse)
-									int coarseA = out.edgelist[ i * 2 + 0 ];
-									int coarseB = out.edgelist[ i * 2 + 1 ];
-
-									// Get corresponding sparse index
-									a = OutputModelData.MappingCoarseToSparse[ coarseA ];
-									b = OutputModelData.MappingCoarseToSparse[ coarseB ];
-
-									// Check for consistency
-									check( a != InvalidIndex );
+									const unsigned long long* Resolved = PredicateStats.resolved[ i ];
+									const double Percent = 100.0 / FMath::Max( PredicateStats.calls( i ), 1ull );
+									UE_LOG( TendrModelTetraLog, Log, TEXT( "Predicate %s = Calls [%llu], Unfiltered [%.2f%%], Static filter [%.2f%%], Dynamic filter [%.2f%%], Adaptive B [%.2f%%], Adaptive C [%.2f%%], Exact [%llu]" ),
+											PredicateNames[ i ],
+											PredicateStats.calls( i ),
+											Resolved[ predicatestats::UNFILTERED ] * Percent,
+											Resolved[ predicatestats::STATICFILTER ] * Percent,
+											Resolved[ predicatestats::DYNAMICFILTER ] * Percent,
+											Resolved[ predicatestats::ADAPTB ] * Percent,
+											Resolved[ predicatestats::ADAPTC ] * Percent,
+											Resolved[ predicatestats::EXACT ]
+											);
+								}
+							}
+							if( bLogOperationStatistics )
+							{
+								static const TCHAR* HistogramNames[ tetgenopstats::NUMHISTOGRAMS ] = {
+									TEXT( "flip23 link level" ), TEXT( "flip32 link level" ), TEXT( "flip41 link level" ), TEXT( "flipnm link level" ), TEXT( "flipnm star size" ),
+									TEXT( "insertpoint cavity size" ), TEXT( "locate walk length" ), TEXT( "Steiner points inserted" ), TEXT( "Steiner points removed" ), TEXT( "bad tetrahedron queue length" ) };
+								for(int i = 0; i < tetgenopstats::NUMHISTOGRAMS; ++i)
+								{
+									// Non-empty buckets as lower bound: count
+									FString Buckets;
+									for(int k = 0; k < tetgenopstats::NUMBUCKETS; ++k)
+									{
+										if( OperationStats.counts[ i ][ k ] > 0 )
+										{
+											Buckets += FString::Printf( TEXT( "%s%ld: %llu" ), Buckets.IsEmpty() ? TEXT( "" ) : TEXT( ", " ), tetgenopstats::bucketmin( k ), OperationStats.counts[ i ][ k ] );
+										}
+									}
+									UE_LOG( TendrModelTetraLog, Log, TEXT( "Operation %s = Count [%llu], Mean [%.2f], Maximum [%ld], Histogram [%s]" ),
+											HistogramNames[ i ],
+											OperationStats.records[ i ],
+											(double)OperationStats.sums[ i ] / FMath::Max( OperationStats.records[ i ], 1ull ),
+											OperationStats.maximums[ i ],
+											*Buckets
+											);
+								}
+
+								FString Samples;
+								for(int i = 0; i < OperationStats.numsamples; ++i)
+								{
+									Samples += FString::Printf( TEXT( "%s%ld" ), Samples.IsEmpty() ? TEXT( "" ) : TEXT( ", " ), OperationStats.samples[ i ] );
+								}
+								UE_LOG( TendrModelTetraLog, Log, TEXT( "Bad tetrahedron queue length every %ld checks = [%s]" ), OperationStats.samplestride, *Samples );
+							}
+
+							// Add connectivity based on edges
+							uint32 MaxNeighbours = 0;
+							TArray<uint64> SortedEdges;
+							SortedEdges.Reserve( out.numberofedges );
+							for(int i = 0; i < out.numberofedges; ++i)
+							{
+								int a, b;
+								{
+									// Retrieve edge indices (coarse)
+									int coarseA = Edges[ i * 2 + 0 ];
+									int coarseB = Edges[ i * 2 + 1 ];
+
+									// Get corresponding sparse index (tetgen points are the sparse vertices if welded)
+									a = bWeldInputVertices ? coarseA : OutputModelData.MappingCoarseToSparse[ coarseA ];
+									b = bWeldInputVertices ? coarseB : OutputModelData.MappingCoarseToSparse[ coarseB ];
+
+									// Check for consistency
+									check( a != InvalidIndex );
 									check( b != InvalidIndex );
 
 									// Add to sparse connectivity data structure
 									ConnectivityAddNeighbour( OutputModelData, a, b, MaxNeighbours );
 									ConnectivityAddNeighbour( OutputModelData, b, a, MaxNeighbours );
+
+									// Add to sparse edge list, keyed by (lowest, highest) index
+									if( a != b )
+									{
+										SortedEdges.Add( ( (uint64)FMath::Min( a, b ) << 32 ) | (uint64)FMath::Max( a, b ) );
+									}
+								}
+							}
+
+							//
+							// Sparse edge list
+							//
+							// Edges are unique in sparse indices (duplicate vertices may map to the same sparse vertex) and sorted for linear access
+							// by the solver, with their rest lengths precomputed so its distance constraints can be set up directly.
+							//
+							{
+								TENDR_TRACE_SCOPE( "EdgeList" );
+
+								SortedEdges.Sort();
+
+								OutputModelData.EdgeIndices.Reserve( SortedEdges.Num() * 2 );
+								OutputModelData.EdgeRestLengths.Reserve( SortedEdges.Num() );
+								for(int i = 0; i < SortedEdges.Num(); ++i)
+								{
+									if( i > 0 && SortedEdges[ i ] == SortedEdges[ i - 1 ] )
+									{
+										continue;
+									}
+
+									uint32 a = (uint32)( SortedEdges[ i ] >> 32 );
+									uint32 b = (uint32)( SortedEdges[ i ] & 0xFFFFFFFF );
+									OutputModelData.EdgeIndices.Add( a );
+									OutputModelData.EdgeIndices.Add( b );
+									OutputModelData.EdgeRestLengths.Add( FVector::Dist( FVector( OutputModelData.VerticesPhysics[ a ] ), FVector( OutputModelData.VerticesPhysics[ b ] ) ) );
 								}
 							}
 
-							UE_LOG( TendrModelTetraLog, Log, TEXT( "Maximum neighbours in model: %u" ), MaxNeighbours );
+							UE_LOG( TendrModelTetraLog, Log, TEXT( "Maximum neighbours in model: %u, edges: %u" ), MaxNeighbours, OutputModelData.EdgeRestLengths.Num() );
+
+							// Reorder the coarse vertices once the tetgen point indices are no longer used
+							if( bOptimizeVertexCache )
+							{
+								OptimizeVertexFetch( OutputModelData );
+							}
 
 							// Mark as valid
 							OutputModelData.Valid = true;
@@ -691,6 +1827,13 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 						case 9:
 							SetError( TEXT( "Model generator output did not output any edges" ) );
 							break;
+						case 11:
+							SetError( TEXT( "Model generation was cancelled" ) );
+							break;
+						case 12:
+							SetError( FString::Printf( TEXT( "Memory budget of %d MB exceeded during %s (peak %.1f MB)" ),
+													   MemoryBudgetMB, ANSI_TO_TCHAR( MemoryStats.exceededstage ), MemoryStats.peak / ( 1024.0 * 1024.0 ) ) );
+							break;
 						case 9000:
 							SetError( TEXT( "Second-order tetrahedrons are not supported" ) );
 							break;
@@ -700,6 +1843,8 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 						}
 					}
 #endif
+
+					PeakMemoryMB = MemoryStats.peak / ( 1024.0f * 1024.0f );
 				}
 			}
 		}
@@ -709,11 +1854,441 @@ FTendrModelData UTendrModelTetraGeneratorComponent::Build( const FTendrVertexArr
 		{
 			GWarn->EndSlowTask();
 		}
+		bBuildSlowTask = false;
+	}
+
+#if TENDR_TRACE
+	// Export the events of this build (the build scope has ended)
+	if( !TraceFilename.IsEmpty() )
+	{
+		if( !FTendrTrace::ExportChromeJson( TraceFilename, TraceSession ) )
+		{
+			UE_LOG( TendrModelTetraLog, Warning, TEXT( "Could not write trace to %s" ), *TraceFilename );
+		}
 	}
+#endif
 
 	return OutputModelData;
 }
 
+float UTendrModelTetraGeneratorComponent::GetMeshSize( const FVector& Position ) const
+{
+	// The smallest (constrained) size of the grids and function
+	float Size = 0;
+	auto FnConstrain = [ &Size ]( float OtherSize )
+	{
+		if( OtherSize > 0 && ( Size <= 0 || OtherSize < Size ) )
+		{
+			Size = OtherSize;
+		}
+	};
+
+	if( SizingGrid.Num() > 0 )
+	{
+		FnConstrain( SampleSizingGrid( SizingGrid, SizingGridResolution, SizingGridBounds, Position ) );
+	}
+	if( AutomaticSizingGrid.Num() > 0 )
+	{
+		FnConstrain( SampleSizingGrid( AutomaticSizingGrid, AutomaticSizingGridResolution, AutomaticSizingGridBounds, Position ) );
+	}
+	if( SizingFunction )
+	{
+		FnConstrain( SizingFunction( Position ) );
+	}
+
+	return Size;
+}
+
+void UTendrModelTetraGeneratorComponent::ComputeAutomaticSizing( const FTendrVertexArray& InputVertices, const FTendrIndexArray& InputIndices )
+{
+	TENDR_TRACE_SCOPE( "AutomaticSizing" );
+
+	AutomaticSizingGrid.Reset();
+
+	//
+	// Grid points over the bounds of the input, padded by one and a half cell (so axis aligned faces of the input are not on grid planes)
+	//
+	FBox Bounds( 0 );
+	for(int i = 0; i < InputVertices.Num(); ++i)
+	{
+		Bounds += FVector( InputVertices[ i ] );
+	}
+
+	const float CellSize = Bounds.GetSize().GetMax() / FMath::Max( AutomaticSizingResolution, 1 );
+	if( CellSize <= 0 )
+	{
+		return;
+	}
+
+	Bounds = Bounds.ExpandBy( 1.5f * CellSize );
+	const int32 Resolution[ 3 ] =
+	{
+		FMath::CeilToInt( ( Bounds.Max.X - Bounds.Min.X ) / CellSize ) + 1,
+		FMath::CeilToInt( ( Bounds.Max.Y - Bounds.Min.Y ) / CellSize ) + 1,
+		FMath::CeilToInt( ( Bounds.Max.Z - Bounds.Min.Z ) / CellSize ) + 1
+	};
+	Bounds.Max = Bounds.Min + FVector( Resolution[ 0 ] - 1, Resolution[ 1 ] - 1, Resolution[ 2 ] - 1 ) * CellSize;
+
+	const int32 NumPoints = Resolution[ 0 ] * Resolution[ 1 ] * Resolution[ 2 ];
+	const int32 NumTriangles = InputIndices.Num() / 3;
+
+	auto FnIndex = [ &Resolution ]( int32 X, int32 Y, int32 Z )
+	{
+		return ( Z * Resolution[ 1 ] + Y ) * Resolution[ 0 ] + X;
+	};
+	auto FnPoint = [ &Resolution, &Bounds, CellSize ]( int32 Index )
+	{
+		int32 X = Index % Resolution[ 0 ];
+		int32 Y = ( Index / Resolution[ 0 ] ) % Resolution[ 1 ];
+		int32 Z = Index / ( Resolution[ 0 ] * Resolution[ 1 ] );
+		return Bounds.Min + FVector( X, Y, Z ) * CellSize;
+	};
+	auto FnVertex = [ &InputVertices, &InputIndices ]( int32 Triangle, int32 Corner )
+	{
+		return FVector( InputVertices[ InputIndices[ Triangle * 3 + Corner ] ] );
+	};
+
+	// Range of grid points around the bounds of a triangle (one cell beyond), along the given axes
+	auto FnTriangleRange = [ &Bounds, &Resolution, CellSize, &FnVertex ]( int32 Triangle, int32 Axis, int32& Lower, int32& Upper )
+	{
+		float Min = FMath::Min3( FnVertex( Triangle, 0 )[ Axis ], FnVertex( Triangle, 1 )[ Axis ], FnVertex( Triangle, 2 )[ Axis ] );
+		float Max = FMath::Max3( FnVertex( Triangle, 0 )[ Axis ], FnVertex( Triangle, 1 )[ Axis ], FnVertex( Triangle, 2 )[ Axis ] );
+		Lower = FMath::Clamp( FMath::FloorToInt( ( Min - Bounds.Min[ Axis ] ) / CellSize ), 0, Resolution[ Axis ] - 1 );
+		Upper = FMath::Clamp( FMath::CeilToInt( ( Max - Bounds.Min[ Axis ] ) / CellSize ), 0, Resolution[ Axis ] - 1 );
+	};
+
+	//
+	// Propagation of the nearest seed by two (forward and backward) sweeps over the grid
+	//
+	// Each grid point takes the seed of a neighbour if that has a lower value. A seed is a ball with a position and radius, and its value at a
+	// grid point is its radius inside the ball and the distance to its position outside of it (so the distance for a seed with radius 0).
+	//
+	auto FnSweep = [ NumPoints, &Resolution, &FnIndex, &FnPoint ]( TArray<float>& Values, TArray<FVector>& Seeds, TArray<float>& SeedValues )
+	{
+		for(int Pass = 0; Pass < 2; ++Pass)
+		{
+			const int32 Direction = ( Pass == 0 ) ? 1 : -1;
+			for(int n = 0; n < NumPoints; ++n)
+			{
+				const int32 Index = ( Pass == 0 ) ? n : NumPoints - 1 - n;
+				const int32 X = Index % Resolution[ 0 ];
+				const int32 Y = ( Index / Resolution[ 0 ] ) % Resolution[ 1 ];
+				const int32 Z = Index / ( Resolution[ 0 ] * Resolution[ 1 ] );
+				const FVector Point = FnPoint( Index );
+
+				// The 13 neighbours that precede this grid point in the sweep order
+				for(int Neighbour = 0; Neighbour < 13; ++Neighbour)
+				{
+					const int32 NX = X + Direction * ( Neighbour % 3 - 1 );
+					const int32 NY = Y + Direction * ( ( Neighbour / 3 ) % 3 - 1 );
+					const int32 NZ = Z + Direction * ( Neighbour / 9 - 1 );
+					if( NX < 0 || NY < 0 || NZ < 0 || NX >= Resolution[ 0 ] || NY >= Resolution[ 1 ] || NZ >= Resolution[ 2 ] )
+					{
+						continue;
+					}
+
+					const int32 NeighbourIndex = FnIndex( NX, NY, NZ );
+					if( Values[ NeighbourIndex ] == MAX_FLT )
+					{
+						continue;
+					}
+
+					float Value = FMath::Max( SeedValues[ NeighbourIndex ], FVector::Dist( Point, Seeds[ NeighbourIndex ] ) );
+					if( Value < Values[ Index ] )
+					{
+						Values[ Index ] = Value;
+						Seeds[ Index ] = Seeds[ NeighbourIndex ];
+						SeedValues[ Index ] = SeedValues[ NeighbourIndex ];
+					}
+				}
+			}
+		}
+	};
+
+	//
+	// 1. Unsigned distance to the surface
+	//
+	// The triangles are binned to the grid points around them, which get their exact distance (in parallel). This narrow band is then
+	// propagated to all grid points, which keep the nearest point on the surface as seed.
+	//
+	TArray<float> Distances;
+	TArray<FVector> SurfacePoints;
+	TArray<float> SurfaceValues;
+	Distances.Init( MAX_FLT, NumPoints );
+	SurfacePoints.SetNumUninitialized( NumPoints );
+	SurfaceValues.Init( 0, NumPoints );
+	{
+		TArray<int32> BinOffsets;
+		TArray<int32> Bins;
+		BinOffsets.Init( 0, NumPoints + 1 );
+		for(int Pass = 0; Pass < 2; ++Pass)
+		{
+			for(int t = 0; t < NumTriangles; ++t)
+			{
+				int32 Lower[ 3 ];
+				int32 Upper[ 3 ];
+				for(int Axis = 0; Axis < 3; ++Axis)
+				{
+					FnTriangleRange( t, Axis, Lower[ Axis ], Upper[ Axis ] );
+				}
+				for(int Z = Lower[ 2 ]; Z <= Upper[ 2 ]; ++Z)
+				{
+					for(int Y = Lower[ 1 ]; Y <= Upper[ 1 ]; ++Y)
+					{
+						for(int X = Lower[ 0 ]; X <= Upper[ 0 ]; ++X)
+						{
+							const int32 Index = FnIndex( X, Y, Z );
+							if( Pass == 0 )
+							{
+								++BinOffsets[ Index + 1 ];
+							}
+							else
+							{
+								Bins[ BinOffsets[ Index ]++ ] = t;
+							}
+						}
+					}
+				}
+			}
+
+			if( Pass == 0 )
+			{
+				for(int i = 0; i < NumPoints; ++i)
+				{
+					BinOffsets[ i + 1 ] += BinOffsets[ i ];
+				}
+				Bins.SetNumUninitialized( BinOffsets[ NumPoints ] );
+			}
+			else
+			{
+				// Filling has moved each offset to the start of the next bin
+				for(int i = NumPoints; i > 0; --i)
+				{
+					BinOffsets[ i ] = BinOffsets[ i - 1 ];
+				}
+				BinOffsets[ 0 ] = 0;
+			}
+		}
+
+		ParallelFor( NumPoints, [ & ]( int32 Index )
+		{
+			const FVector Point = FnPoint( Index );
+			for(int b = BinOffsets[ Index ]; b < BinOffsets[ Index + 1 ]; ++b)
+			{
+				const int32 t = Bins[ b ];
+				FVector Nearest = FMath::ClosestPointOnTriangleToPoint( Point, FnVertex( t, 0 ), FnVertex( t, 1 ), FnVertex( t, 2 ) );
+				float Distance = FVector::Dist( Point, Nearest );
+				if( Distance < Distances[ Index ] )
+				{
+					Distances[ Index ] = Distance;
+					SurfacePoints[ Index ] = Nearest;
+				}
+			}
+		} );
+
+		FnSweep( Distances, SurfacePoints, SurfaceValues );
+	}
+
+	//
+	// 2. Sign of the distance
+	//
+	// For each row of grid points along X (in parallel), the crossings of the row with the triangles are sorted by X,
+	// and the grid points between an odd and the next even crossing are inside. A row passing exactly through an edge or a vertex
+	// is counted by one of the triangles sharing it only (a top-left rule on the edges of the triangles projected on the YZ plane),
+	// so the parity is not flipped by grid points lying on edges.
+	//
+	TArray<bool> Inside;
+	Inside.Init( false, NumPoints );
+	{
+		const int32 NumRows = Resolution[ 1 ] * Resolution[ 2 ];
+
+		TArray<int32> RowOffsets;
+		TArray<int32> Rows;
+		RowOffsets.Init( 0, NumRows + 1 );
+		for(int Pass = 0; Pass < 2; ++Pass)
+		{
+			for(int t = 0; t < NumTriangles; ++t)
+			{
+				int32 LowerY, UpperY, LowerZ, UpperZ;
+				FnTriangleRange( t, 1, LowerY, UpperY );
+				FnTriangleRange( t, 2, LowerZ, UpperZ );
+				for(int Z = LowerZ; Z <= UpperZ; ++Z)
+				{
+					for(int Y = LowerY; Y <= UpperY; ++Y)
+					{
+						const int32 Row = Z * Resolution[ 1 ] + Y;
+						if( Pass == 0 )
+						{
+							++RowOffsets[ Row + 1 ];
+						}
+						else
+						{
+							Rows[ RowOffsets[ Row ]++ ] = t;
+						}
+					}
+				}
+			}
+
+			if( Pass == 0 )
+			{
+				for(int i = 0; i < NumRows; ++i)
+				{
+					RowOffsets[ i + 1 ] += RowOffsets[ i ];
+				}
+				Rows.SetNumUninitialized( RowOffsets[ NumRows ] );
+			}
+			else
+			{
+				for(int i = NumRows; i > 0; --i)
+				{
+					RowOffsets[ i ] = RowOffsets[ i - 1 ];
+				}
+				RowOffsets[ 0 ] = 0;
+			}
+		}
+
+		ParallelFor( NumRows, [ & ]( int32 Row )
+		{
+			const FVector Origin = FnPoint( FnIndex( 0, Row % Resolution[ 1 ], Row / Resolution[ 1 ] ) );
+
+			// Edge function of the row for the edge from P to Q projected on the YZ plane, evaluated from the lowest endpoint so the
+			// triangles on either side of an edge get exactly opposite values
+			auto FnEdge = [ &Origin ]( const FVector& P, const FVector& Q )
+			{
+				const bool bReversed = ( Q.Y < P.Y ) || ( Q.Y == P.Y && Q.Z < P.Z );
+				const FVector& L = bReversed ? Q : P;
+				const FVector& H = bReversed ? P : Q;
+				const double Edge = (double)( H.Y - L.Y ) * ( Origin.Z - L.Z ) - (double)( H.Z - L.Z ) * ( Origin.Y - L.Y );
+				return bReversed ? -Edge : Edge;
+			};
+
+			// Whether the row crosses the (positively wound) triangle at the edge from P to Q, a row on the edge only crosses if the edge
+			// is a top-left edge, which is the case for one direction of each edge
+			auto FnCrossesEdge = []( double Edge, const FVector& P, const FVector& Q )
+			{
+				return Edge > 0 || ( Edge == 0 && ( P.Y < Q.Y || ( P.Y == Q.Y && P.Z < Q.Z ) ) );
+			};
+
+			TArray<float> Crossings;
+			for(int r = RowOffsets[ Row ]; r < RowOffsets[ Row + 1 ]; ++r)
+			{
+				const int32 t = Rows[ r ];
+				const FVector A = FnVertex( t, 0 );
+				const FVector B = FnVertex( t, 1 );
+				const FVector C = FnVertex( t, 2 );
+
+				// Barycentric coordinates of the row in the triangle projected on the YZ plane, wound positively
+				double EdgeA = FnEdge( B, C );
+				double EdgeB = FnEdge( C, A );
+				double EdgeC = FnEdge( A, B );
+				double Area = EdgeA + EdgeB + EdgeC;
+				if( Area == 0 )
+				{
+					continue;
+				}
+				if( Area > 0 )
+				{
+					if( !FnCrossesEdge( EdgeA, B, C ) || !FnCrossesEdge( EdgeB, C, A ) || !FnCrossesEdge( EdgeC, A, B ) )
+					{
+						continue;
+					}
+				}
+				else
+				{
+					if( !FnCrossesEdge( -EdgeA, C, B ) || !FnCrossesEdge( -EdgeB, A, C ) || !FnCrossesEdge( -EdgeC, B, A ) )
+					{
+						continue;
+					}
+				}
+
+				Crossings.Add( (float)( ( EdgeA * A.X + EdgeB * B.X + EdgeC * C.X ) / Area ) );
+			}
+			Crossings.Sort();
+
+			for(int c = 0; c + 1 < Crossings.Num(); c += 2)
+			{
+				const int32 Lower = FMath::Max( FMath::CeilToInt( ( Crossings[ c ] - Origin.X ) / CellSize ), 0 );
+				const int32 Upper = FMath::Min( FMath::FloorToInt( ( Crossings[ c + 1 ] - Origin.X ) / CellSize ), Resolution[ 0 ] - 1 );
+				for(int X = Lower; X <= Upper; ++X)
+				{
+					Inside[ FnIndex( X, Row % Resolution[ 1 ], Row / Resolution[ 1 ] ) ] = true;
+				}
+			}
+		} );
+	}
+
+	//
+	// 3. Local thickness
+	//
+	// Grid points inside on the medial axis (where the directions to the nearest surface points of neighbouring grid points are opposite)
+	// are the centers of balls touching the surface on multiple sides. The local thickness (radius) of the model at any grid point is then
+	// the radius of the smallest of these balls containing it, or its distance to the center of the nearest ball otherwise.
+	//
+	TArray<float> Thickness;
+	TArray<FVector> MedialPoints;
+	TArray<float> MedialRadii;
+	uint32 NumMedialPoints = 0;
+	Thickness.Init( MAX_FLT, NumPoints );
+	MedialPoints.SetNumUninitialized( NumPoints );
+	MedialRadii.Init( 0, NumPoints );
+	{
+		ParallelFor( NumPoints, [ & ]( int32 Index )
+		{
+			if( !Inside[ Index ] )
+			{
+				return;
+			}
+
+			const int32 X = Index % Resolution[ 0 ];
+			const int32 Y = ( Index / Resolution[ 0 ] ) % Resolution[ 1 ];
+			const int32 Z = Index / ( Resolution[ 0 ] * Resolution[ 1 ] );
+			const int32 Neighbours[ 3 ] =
+			{
+				( X + 1 < Resolution[ 0 ] ) ? FnIndex( X + 1, Y, Z ) : INDEX_NONE,
+				( Y + 1 < Resolution[ 1 ] ) ? FnIndex( X, Y + 1, Z ) : INDEX_NONE,
+				( Z + 1 < Resolution[ 2 ] ) ? FnIndex( X, Y, Z + 1 ) : INDEX_NONE
+			};
+			for(int k = 0; k < 3; ++k)
+			{
+				if( Neighbours[ k ] == INDEX_NONE || !Inside[ Neighbours[ k ] ] )
+				{
+					continue;
+				}
+
+				const FVector Direction = FnPoint( Index ) - SurfacePoints[ Index ];
+				const FVector NeighbourDirection = FnPoint( Neighbours[ k ] ) - SurfacePoints[ Neighbours[ k ] ];
+				if( ( Direction | NeighbourDirection ) < 0 )
+				{
+					Thickness[ Index ] = Distances[ Index ];
+					MedialPoints[ Index ] = FnPoint( Index );
+					MedialRadii[ Index ] = Distances[ Index ];
+					break;
+				}
+			}
+		} );
+
+		for(int i = 0; i < NumPoints; ++i)
+		{
+			NumMedialPoints += ( Thickness[ i ] < MAX_FLT ) ? 1 : 0;
+		}
+
+		FnSweep( Thickness, MedialPoints, MedialRadii );
+	}
+
+	//
+	// 4. Mesh size from the local thickness
+	//
+	AutomaticSizingGrid.SetNumUninitialized( NumPoints );
+	for(int i = 0; i < NumPoints; ++i)
+	{
+		AutomaticSizingGrid[ i ] = ( Thickness[ i ] < MAX_FLT ) ? AutomaticSizingScale * Thickness[ i ] : 0;
+	}
+	AutomaticSizingGridResolution = FIntVector( Resolution[ 0 ], Resolution[ 1 ], Resolution[ 2 ] );
+	AutomaticSizingGridBounds = Bounds;
+
+	UE_LOG( TendrModelTetraLog, Log, TEXT( "Automatic sizing: %d x %d x %d grid points, %u on the medial axis" ), Resolution[ 0 ], Resolution[ 1 ], Resolution[ 2 ], NumMedialPoints );
+}
+
 void UTendrModelTetraGeneratorComponent::SetError( FString Text )
 {
 	// Write to log
@@ -728,28 +2303,2052 @@ FString UTendrModelTetraGeneratorComponent::GetLastError()
 	return LastError;
 }
 
-bool UTendrModelTetraGeneratorComponent::ConnectivityAddNeighbour( FTendrModelData& ModelData, uint32 Src, uint32 Dst, uint32& MaxNeighbours )
+bool UTendrModelTetraGeneratorComponent::Cut( FTendrModelData& ModelData, const FPlane& Plane, bool bSeparate, float SnapDistance, FTendrModelDelta& OutDelta )
 {
-	uint32 * SrcIndices = ModelData.Connectivity[ Src ].NeighbourIndices;
+	TENDR_TRACE_SCOPE( "Cut" );
 
-	// Ensure index is not already added
-	for(uint8 i = 0; i < FTendrVertexConnectivityData::MaxNeighbours; ++i)
+	OutDelta = FTendrModelDelta();
+	OutDelta.FirstAddedVertex = ModelData.VerticesPhysics.Num();
+	OutDelta.FirstAddedCoarseVertex = ModelData.Vertices.Num();
+	OutDelta.FirstAddedSurfaceVertex = ModelData.MappingSurfaceToCoarse.Num();
+
+	if( !ModelData.IsValid() )
 	{
-		if(SrcIndices[ i ] == Dst)
-		{
-			// Already added, return
-			return true;
-		}
-		else if(SrcIndices[ i ] == InvalidIndex)
+		SetError( TEXT( "Model data to cut is not valid" ) );
+		return false;
+	}
+
+	// The topology is built by the first local operation
+	if( !IsTopologyValid( ModelData ) )
+	{
+		BuildTopology( ModelData );
+	}
+	FTendrModelTopology& Topology = ModelData.Topology;
+
+	const uint32 FaceIndexMask = ~FTendrModelData::TetrahedronFaceOrientationBit;
+	const int32 NumTetrahedra = ModelData.TetrahedronFaceIndices.Num() / 4;
+	const bool bTetrahedronVertexIndices = ( ModelData.TetrahedronVertexIndices.Num() == NumTetrahedra * 4 );
+
+	//
+	// Vertex classification
+	//
+	// Every vertex (sparse) is on the negative side, on the positive side or on the plane, which includes the vertices within SnapDistance
+	// of it so no sliver tetrahedra are split off. Vertices are never moved, the rest shape of the model is unchanged.
+	//
+	TArray<float> Distances;
+	TArray<int8> Sides;
+	{
+		const float InvNormalSize = FMath::InvSqrt( FMath::Max( Plane.SizeSquared(), SMALL_NUMBER ) );
+		Distances.SetNumUninitialized( ModelData.VerticesPhysics.Num() );
+		Sides.SetNumUninitialized( ModelData.VerticesPhysics.Num() );
+		for(int i = 0; i < ModelData.VerticesPhysics.Num(); ++i)
 		{
-			// Reached the end, insert here
-			MaxNeighbours = MaxNeighbours > i ? MaxNeighbours : i;
-			SrcIndices[ i ] = Dst;
-			return true;
+			Distances[ i ] = Plane.PlaneDot( FVector( ModelData.VerticesPhysics[ i ] ) ) * InvNormalSize;
+			Sides[ i ] = ( Distances[ i ] > SnapDistance ) ? 1 : ( ( Distances[ i ] < -SnapDistance ) ? -1 : 0 );
 		}
 	}
 
-	// Could not add, neighbour array full
-	UE_LOG( TendrModelTetraLog, Log, TEXT( "FTendrVertexConnectivity: Neighbour overflow" ) );
-	return false;
+	//
+	// Affected tetrahedra
+	//
+	// The tetrahedra crossed by the plane are split. When separating, the tetrahedra on the positive side that touch the plane are detached from
+	// the negative side as well, while those on the negative side that touch it stay as they are. The faces in the plane are recreated for the
+	// side that keeps them, so those on the negative side with a face in the plane are rebuilt as they are.
+	//
+	// The candidates are the tetrahedra around the vertex on the negative side of each crossed edge and, when separating, around the vertices
+	// on the plane, walked through the faces they share. Where pieces only touch at a vertex (e.g. after separating) its tetrahedra are not all
+	// connected through faces, the other fans are found from the neighbours of the vertex (see Connectivity) that are not reached. If that
+	// fails, the candidates are all tetrahedra.
+	//
+	TArray<int32> Candidates;
+	{
+		TSet<int32> Affected;
+		TSet<uint32> Walked;
+		TSet<int32> Star;
+		TSet<int32> OtherStar;
+		TSet<uint32> Neighbours;
+		TArray<int32> Stack;
+		bool bComplete = true;
+
+		// Adds the tetrahedra around a vertex that are connected to a tetrahedron through faces to a star, and optionally their corners
+		auto FnFan = [ & ]( uint32 Vertex, int32 First, TSet<int32>& OutStar, TSet<uint32>* OutCorners )
+		{
+			OutStar.Add( First );
+			Stack.Add( First );
+			while( Stack.Num() > 0 )
+			{
+				const int32 Tetrahedron = Stack.Pop( false );
+				for(int k = 0; k < 4; ++k)
+				{
+					const uint32 Face = ModelData.TetrahedronFaceIndices[ Tetrahedron * 4 + k ] & FaceIndexMask;
+					const uint32 FaceCorners[ 3 ] = {
+						ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 0 ] ],
+						ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 1 ] ],
+						ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 2 ] ] };
+					if( OutCorners )
+					{
+						OutCorners->Add( FaceCorners[ 0 ] );
+						OutCorners->Add( FaceCorners[ 1 ] );
+						OutCorners->Add( FaceCorners[ 2 ] );
+					}
+					if( FaceCorners[ 0 ] != Vertex && FaceCorners[ 1 ] != Vertex && FaceCorners[ 2 ] != Vertex )
+					{
+						continue;
+					}
+
+					const uint32 Other = Topology.FaceTetrahedra[ Face * 2 + ( ( Topology.FaceTetrahedra[ Face * 2 ] == (uint32)Tetrahedron ) ? 1 : 0 ) ];
+					if( Other != InvalidIndex && !OutStar.Contains( Other ) )
+					{
+						OutStar.Add( Other );
+						Stack.Add( Other );
+					}
+				}
+			}
+		};
+
+		auto FnWalk = [ & ]( uint32 Vertex )
+		{
+			if( Walked.Contains( Vertex ) || Topology.VertexTetrahedra[ Vertex ] == InvalidIndex )
+			{
+				return;
+			}
+			Walked.Add( Vertex );
+
+			Star.Reset();
+			Neighbours.Reset();
+			FnFan( Vertex, Topology.VertexTetrahedra[ Vertex ], Star, &Neighbours );
+
+			const uint32* NeighbourIndices = ModelData.Connectivity[ Vertex ].NeighbourIndices;
+			for(int n = 0; n < FTendrVertexConnectivityData::MaxNeighbours && NeighbourIndices[ n ] != InvalidIndex; ++n)
+			{
+				if( Neighbours.Contains( NeighbourIndices[ n ] ) )
+				{
+					continue;
+				}
+
+				// A tetrahedron of the edge to the neighbour, around the neighbour
+				int32 Found = INDEX_NONE;
+				OtherStar.Reset();
+				if( Topology.VertexTetrahedra[ NeighbourIndices[ n ] ] != InvalidIndex )
+				{
+					FnFan( NeighbourIndices[ n ], Topology.VertexTetrahedra[ NeighbourIndices[ n ] ], OtherStar, nullptr );
+				}
+				for(auto It = OtherStar.CreateConstIterator(); It && Found == INDEX_NONE; ++It)
+				{
+					uint32 Corners[ 4 ];
+					GetTetrahedronCorners( ModelData, *It, Corners );
+					if( Corners[ 0 ] == Vertex || Corners[ 1 ] == Vertex || Corners[ 2 ] == Vertex || Corners[ 3 ] == Vertex )
+					{
+						Found = *It;
+					}
+				}
+
+				if( Found == INDEX_NONE )
+				{
+					bComplete = false;
+				}
+				else
+				{
+					FnFan( Vertex, Found, Star, &Neighbours );
+				}
+			}
+
+			for(auto It = Star.CreateConstIterator(); It; ++It)
+			{
+				Affected.Add( *It );
+			}
+		};
+
+		for(int i = 0; i < ModelData.EdgeIndices.Num() / 2; ++i)
+		{
+			const uint32 A = ModelData.EdgeIndices[ i * 2 + 0 ];
+			const uint32 B = ModelData.EdgeIndices[ i * 2 + 1 ];
+			if( Sides[ A ] * Sides[ B ] < 0 )
+			{
+				FnWalk( ( Sides[ A ] < 0 ) ? A : B );
+			}
+		}
+		if( bSeparate )
+		{
+			for(int i = 0; i < Sides.Num(); ++i)
+			{
+				if( Sides[ i ] == 0 )
+				{
+					FnWalk( i );
+				}
+			}
+		}
+
+		if( bComplete )
+		{
+			Candidates = Affected.Array();
+			Candidates.Sort();
+		}
+		else
+		{
+			Candidates.SetNumUninitialized( NumTetrahedra );
+			for(int32 i = 0; i < NumTetrahedra; ++i)
+			{
+				Candidates[ i ] = i;
+			}
+		}
+	}
+
+	TArray<int32> RemovedTetrahedra;
+	TArray<int32> KeptTetrahedra;
+	int32 NumCutTetrahedra = 0;
+	int32 NumDetachedTetrahedra = 0;
+	{
+		TArray<int32> DetachedTetrahedra;
+		TArray<int32> RebuiltTetrahedra;
+		for(int32 c = 0; c < Candidates.Num(); ++c)
+		{
+			const int32 i = Candidates[ c ];
+			uint32 Corners[ 4 ];
+			GetTetrahedronCorners( ModelData, i, Corners );
+
+			int32 NumPositive = 0;
+			int32 NumNegative = 0;
+			for(int k = 0; k < 4; ++k)
+			{
+				NumPositive += ( Sides[ Corners[ k ] ] > 0 ) ? 1 : 0;
+				NumNegative += ( Sides[ Corners[ k ] ] < 0 ) ? 1 : 0;
+			}
+
+			if( NumPositive > 0 && NumNegative > 0 )
+			{
+				RemovedTetrahedra.Add( i );
+			}
+			else if( bSeparate && NumPositive > 0 && NumPositive < 4 )
+			{
+				DetachedTetrahedra.Add( i );
+			}
+			else if( bSeparate && NumPositive == 0 && NumNegative < 4 )
+			{
+				// Tetrahedra with all corners on the plane stay on the negative side
+				( ( NumNegative <= 1 ) ? RebuiltTetrahedra : KeptTetrahedra ).Add( i );
+			}
+		}
+
+		NumCutTetrahedra = RemovedTetrahedra.Num();
+		NumDetachedTetrahedra = DetachedTetrahedra.Num();
+		RemovedTetrahedra.Append( DetachedTetrahedra );
+		RemovedTetrahedra.Append( RebuiltTetrahedra );
+	}
+
+	if( RemovedTetrahedra.Num() == 0 )
+	{
+		return false;
+	}
+
+	// First vertex (coarse) of every vertex (sparse), used for the faces that are not on the surface
+	TArray<uint32>& SparseToCoarse = Topology.SparseToCoarse;
+
+	// Adds a vertex (sparse) on the plane
+	auto FnAddVertex = [ &ModelData, &Distances, &Sides, &SparseToCoarse ]( FVector4 Position ) -> uint32
+	{
+		FTendrVertexConnectivityData Dummy;
+		memset( Dummy.NeighbourIndices, 0xFF, sizeof( Dummy.NeighbourIndices ) );
+		ModelData.Connectivity.Add( Dummy );
+		Distances.Add( 0 );
+		Sides.Add( 0 );
+		SparseToCoarse.Add( InvalidIndex );
+		return ModelData.VerticesPhysics.Add( Position );
+	};
+
+	// Adds a vertex (coarse) of a vertex (sparse) with the attributes of vertex A (coarse) interpolated towards those of vertex B
+	auto FnAddCoarseVertex = [ &ModelData, &SparseToCoarse ]( uint32 Sparse, uint32 A, uint32 B, float T ) -> uint32
+	{
+		const uint32 Vertex = ModelData.Vertices.Add( FVector4( FVector( ModelData.VerticesPhysics[ Sparse ] ), 0 ) );
+		for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
+		{
+			const FVector2D TexCoord = FMath::Lerp( ModelData.TexCoords[ t ][ A ], ModelData.TexCoords[ t ][ B ], T );
+			ModelData.TexCoords[ t ].Add( TexCoord );
+		}
+
+		// Tangent frames are interpolated and renormalized, keeping the binormal sign of A
+		FTendrTangent Tangent = ModelData.Tangents[ A ];
+		if( A != B )
+		{
+			const FVector4 TangentXA = ModelData.Tangents[ A ].TangentX;
+			const FVector4 TangentXB = ModelData.Tangents[ B ].TangentX;
+			const FVector4 TangentZA = ModelData.Tangents[ A ].TangentZ;
+			const FVector4 TangentZB = ModelData.Tangents[ B ].TangentZ;
+			Tangent.TangentX = FPackedRGB10A2N( FVector4( FMath::Lerp( FVector( TangentXA ), FVector( TangentXB ), T ).GetSafeNormal(), TangentXA.W ) );
+			Tangent.TangentZ = FPackedRGB10A2N( FVector4( FMath::Lerp( FVector( TangentZA ), FVector( TangentZB ), T ).GetSafeNormal(), TangentZA.W ) );
+		}
+		ModelData.Tangents.Add( Tangent );
+
+		// Interior until used by a surface triangle
+		ModelData.VerticesSurfaceIndicators.Add( true );
+		ModelData.MappingCoarseToSparse.Add( Sparse );
+		if( SparseToCoarse[ Sparse ] == InvalidIndex )
+		{
+			SparseToCoarse[ Sparse ] = Vertex;
+		}
+		return Vertex;
+	};
+
+	//
+	// Edge vertices
+	//
+	// A vertex (sparse) is added where the plane crosses an edge, shared by all tetrahedra and faces around the edge. Its vertices (coarse)
+	// are keyed by the coarse vertices of the edge, so the attributes of render vertices on either side of a UV seam are interpolated separately.
+	//
+	TMap<uint64, uint32> EdgeVertices;
+	TMap<uint64, uint32> EdgeCoarseVertices;
+	auto FnEdgeCoarseVertex = [ & ]( uint32 A, uint32 B ) -> uint32
+	{
+		if( A > B )
+		{
+			Swap( A, B );
+		}
+		const uint64 Key = ( (uint64)A << 32 ) | (uint64)B;
+		if( const uint32* Vertex = EdgeCoarseVertices.Find( Key ) )
+		{
+			return *Vertex;
+		}
+
+		const uint32 SparseA = ModelData.MappingCoarseToSparse[ A ];
+		const uint32 SparseB = ModelData.MappingCoarseToSparse[ B ];
+		const float T = Distances[ SparseA ] / ( Distances[ SparseA ] - Distances[ SparseB ] );
+
+		const uint64 SparseKey = ( (uint64)FMath::Min( SparseA, SparseB ) << 32 ) | (uint64)FMath::Max( SparseA, SparseB );
+		uint32 Sparse;
+		if( const uint32* Found = EdgeVertices.Find( SparseKey ) )
+		{
+			Sparse = *Found;
+		}
+		else
+		{
+			const FVector Position = FMath::Lerp( FVector( ModelData.VerticesPhysics[ SparseA ] ), FVector( ModelData.VerticesPhysics[ SparseB ] ), T );
+			Sparse = FnAddVertex( FVector4( Position, 0 ) );
+			EdgeVertices.Add( SparseKey, Sparse );
+		}
+
+		const uint32 Vertex = FnAddCoarseVertex( Sparse, A, B, T );
+		EdgeCoarseVertices.Add( Key, Vertex );
+		return Vertex;
+	};
+	auto FnEdgeVertex = [ & ]( uint32 A, uint32 B ) -> uint32
+	{
+		return ModelData.MappingCoarseToSparse[ FnEdgeCoarseVertex( SparseToCoarse[ A ], SparseToCoarse[ B ] ) ];
+	};
+
+	// Convex polygon of at most four vertices
+	struct FPolygon
+	{
+		uint32 Vertices[ 4 ];
+		int32 Num;
+
+		// Index of the lowest vertex (sparse) to fan from, so polygons shared by neighbouring pieces are split the same way
+		int32 FanVertex( const TArray<uint32>* CoarseToSparse ) const
+		{
+			int32 First = 0;
+			for(int32 i = 1; i < Num; ++i)
+			{
+				if( ( CoarseToSparse ? (*CoarseToSparse)[ Vertices[ i ] ] : Vertices[ i ] ) < ( CoarseToSparse ? (*CoarseToSparse)[ Vertices[ First ] ] : Vertices[ First ] ) )
+				{
+					First = i;
+				}
+			}
+			return First;
+		}
+	};
+
+	// Part of a triangle of vertices (sparse, or coarse if bCoarse) on one side of the plane, the vertices on the plane are on both sides
+	auto FnClip = [ & ]( const uint32 ( &Triangle )[ 3 ], int32 Side, bool bCoarse, FPolygon& Polygon )
+	{
+		Polygon.Num = 0;
+		for(int k = 0; k < 3; ++k)
+		{
+			const uint32 A = Triangle[ k ];
+			const uint32 B = Triangle[ ( k + 1 ) % 3 ];
+			const int32 SideA = Sides[ bCoarse ? ModelData.MappingCoarseToSparse[ A ] : A ];
+			const int32 SideB = Sides[ bCoarse ? ModelData.MappingCoarseToSparse[ B ] : B ];
+			if( SideA * Side >= 0 )
+			{
+				Polygon.Vertices[ Polygon.Num++ ] = A;
+			}
+			if( SideA * SideB < 0 )
+			{
+				Polygon.Vertices[ Polygon.Num++ ] = bCoarse ? FnEdgeCoarseVertex( A, B ) : FnEdgeVertex( A, B );
+			}
+		}
+	};
+
+	//
+	// Cavity re-tetrahedralization
+	//
+	// Each cut tetrahedron is split into the convex pieces on either side of the plane. A piece is bounded by the parts of the faces of the
+	// tetrahedron on its side and by its section in the plane, and is filled with tetrahedra from its lowest vertex to the triangles of the
+	// bounding polygons that do not contain that vertex. As every polygon is fanned from its lowest vertex, the pieces on either side of a
+	// face or section agree on its triangles and the new tetrahedra are conforming without any search.
+	//
+	struct FNewTetrahedron
+	{
+		uint32 Corners[ 4 ];
+		int32 Side;
+	};
+	TArray<FNewTetrahedron> NewTetrahedra;
+	NewTetrahedra.Reserve( RemovedTetrahedra.Num() * 3 );
+
+	auto FnAddTetrahedron = [ &ModelData, &NewTetrahedra ]( uint32 A, uint32 B, uint32 C, uint32 D, int32 Side )
+	{
+		FNewTetrahedron Tetrahedron = { { A, B, C, D }, Side };
+
+		// Orient positively, see TetrahedronFaceCorners
+		const FVector PA( ModelData.VerticesPhysics[ A ] );
+		const FVector PB( ModelData.VerticesPhysics[ B ] );
+		const FVector PC( ModelData.VerticesPhysics[ C ] );
+		const FVector PD( ModelData.VerticesPhysics[ D ] );
+		if( FVector::DotProduct( FVector::CrossProduct( PB - PA, PC - PA ), PD - PA ) < 0 )
+		{
+			Swap( Tetrahedron.Corners[ 1 ], Tetrahedron.Corners[ 2 ] );
+		}
+		NewTetrahedra.Add( Tetrahedron );
+	};
+
+	for(int i = 0; i < RemovedTetrahedra.Num(); ++i)
+	{
+		uint32 Corners[ 4 ];
+		GetTetrahedronCorners( ModelData, RemovedTetrahedra[ i ], Corners );
+
+		if( i >= NumCutTetrahedra )
+		{
+			// Detached or rebuilt tetrahedron
+			FnAddTetrahedron( Corners[ 0 ], Corners[ 1 ], Corners[ 2 ], Corners[ 3 ], ( i < NumCutTetrahedra + NumDetachedTetrahedra ) ? 1 : -1 );
+			continue;
+		}
+
+		for(int32 Side = -1; Side <= 1; Side += 2)
+		{
+			FPolygon Polygons[ 5 ];
+			int32 NumPolygons = 0;
+
+			// Parts of the faces on this side
+			for(int k = 0; k < 4; ++k)
+			{
+				const uint32 Triangle[ 3 ] = { Corners[ ( k + 1 ) % 4 ], Corners[ ( k + 2 ) % 4 ], Corners[ ( k + 3 ) % 4 ] };
+				FnClip( Triangle, Side, false, Polygons[ NumPolygons ] );
+				NumPolygons += ( Polygons[ NumPolygons ].Num >= 3 ) ? 1 : 0;
+			}
+
+			// Section, four vertices only occur with two corners on either side and their crossed edges form a cycle
+			{
+				FPolygon& Section = Polygons[ NumPolygons++ ];
+				Section.Num = 0;
+
+				uint32 Positive[ 3 ];
+				uint32 Negative[ 3 ];
+				int32 NumPositive = 0;
+				int32 NumNegative = 0;
+				for(int k = 0; k < 4; ++k)
+				{
+					const int32 CornerSide = Sides[ Corners[ k ] ];
+					if( CornerSide == 0 )
+					{
+						Section.Vertices[ Section.Num++ ] = Corners[ k ];
+					}
+					else if( CornerSide > 0 )
+					{
+						Positive[ NumPositive++ ] = Corners[ k ];
+					}
+					else
+					{
+						Negative[ NumNegative++ ] = Corners[ k ];
+					}
+				}
+
+				if( NumPositive == 2 && NumNegative == 2 )
+				{
+					Section.Vertices[ Section.Num++ ] = FnEdgeVertex( Positive[ 0 ], Negative[ 0 ] );
+					Section.Vertices[ Section.Num++ ] = FnEdgeVertex( Positive[ 0 ], Negative[ 1 ] );
+					Section.Vertices[ Section.Num++ ] = FnEdgeVertex( Positive[ 1 ], Negative[ 1 ] );
+					Section.Vertices[ Section.Num++ ] = FnEdgeVertex( Positive[ 1 ], Negative[ 0 ] );
+				}
+				else
+				{
+					for(int p = 0; p < NumPositive; ++p)
+					{
+						for(int n = 0; n < NumNegative; ++n)
+						{
+							Section.Vertices[ Section.Num++ ] = FnEdgeVertex( Positive[ p ], Negative[ n ] );
+						}
+					}
+				}
+			}
+
+			// Lowest vertex of the piece
+			uint32 Apex = InvalidIndex;
+			for(int p = 0; p < NumPolygons; ++p)
+			{
+				for(int k = 0; k < Polygons[ p ].Num; ++k)
+				{
+					Apex = FMath::Min( Apex, Polygons[ p ].Vertices[ k ] );
+				}
+			}
+
+			for(int p = 0; p < NumPolygons; ++p)
+			{
+				const FPolygon& Polygon = Polygons[ p ];
+
+				bool bContainsApex = false;
+				for(int k = 0; k < Polygon.Num; ++k)
+				{
+					bContainsApex |= ( Polygon.Vertices[ k ] == Apex );
+				}
+				if( bContainsApex )
+				{
+					continue;
+				}
+
+				const int32 First = Polygon.FanVertex( nullptr );
+				for(int k = 1; k < Polygon.Num - 1; ++k)
+				{
+					FnAddTetrahedron( Apex, Polygon.Vertices[ First ], Polygon.Vertices[ ( First + k ) % Polygon.Num ], Polygon.Vertices[ ( First + k + 1 ) % Polygon.Num ], Side );
+				}
+			}
+		}
+	}
+
+	//
+	// Separation
+	//
+	// The vertices on the plane that are used on both sides are duplicated, the tetrahedra on the positive side use the duplicates.
+	//
+	TMap<uint32, uint32> Duplicates;
+	TMap<uint32, uint32> Originals;
+	TMap<uint32, uint32> CoarseDuplicates;
+	auto FnDuplicateCoarse = [ & ]( uint32 Coarse ) -> uint32
+	{
+		const uint32* Duplicate = Duplicates.Find( ModelData.MappingCoarseToSparse[ Coarse ] );
+		if( Duplicate == nullptr )
+		{
+			return Coarse;
+		}
+		if( const uint32* Found = CoarseDuplicates.Find( Coarse ) )
+		{
+			return *Found;
+		}
+
+		const uint32 DuplicateCoarse = FnAddCoarseVertex( *Duplicate, Coarse, Coarse, 0.0f );
+		CoarseDuplicates.Add( Coarse, DuplicateCoarse );
+		return DuplicateCoarse;
+	};
+
+	if( bSeparate )
+	{
+		// Sides that use each vertex on the plane (bit 0 negative, bit 1 positive)
+		TMap<uint32, uint8> Usage;
+		for(int i = 0; i < NewTetrahedra.Num(); ++i)
+		{
+			for(int k = 0; k < 4; ++k)
+			{
+				if( Sides[ NewTetrahedra[ i ].Corners[ k ] ] == 0 )
+				{
+					Usage.FindOrAdd( NewTetrahedra[ i ].Corners[ k ] ) |= ( NewTetrahedra[ i ].Side < 0 ) ? 1 : 2;
+				}
+			}
+		}
+		for(int i = 0; i < KeptTetrahedra.Num(); ++i)
+		{
+			uint32 Corners[ 4 ];
+			GetTetrahedronCorners( ModelData, KeptTetrahedra[ i ], Corners );
+			for(int k = 0; k < 4; ++k)
+			{
+				if( Sides[ Corners[ k ] ] == 0 )
+				{
+					Usage.FindOrAdd( Corners[ k ] ) |= 1;
+				}
+			}
+		}
+
+		TArray<uint32> PlaneVertices;
+		Usage.GenerateKeyArray( PlaneVertices );
+		PlaneVertices.Sort();
+		for(int i = 0; i < PlaneVertices.Num(); ++i)
+		{
+			const uint32 Vertex = PlaneVertices[ i ];
+			if( Usage[ Vertex ] == 3 )
+			{
+				const uint32 Duplicate = FnAddVertex( ModelData.VerticesPhysics[ Vertex ] );
+				Duplicates.Add( Vertex, Duplicate );
+				Originals.Add( Duplicate, Vertex );
+				FnDuplicateCoarse( SparseToCoarse[ Vertex ] );
+			}
+		}
+
+		for(int i = 0; i < NewTetrahedra.Num(); ++i)
+		{
+			if( NewTetrahedra[ i ].Side > 0 )
+			{
+				for(int k = 0; k < 4; ++k)
+				{
+					uint32& Corner = NewTetrahedra[ i ].Corners[ k ];
+					const uint32* Duplicate = Duplicates.Find( Corner );
+					Corner = Duplicate ? *Duplicate : Corner;
+				}
+			}
+		}
+	}
+
+	//
+	// Faces
+	//
+	// The faces of the removed tetrahedra that are still used (e.g. on the boundary of the cavity) are kept, the slots of the others are
+	// reused for the new faces. A new face is wound so its normal points into the first tetrahedron that uses it, like the faces from tetgen,
+	// which is why the faces in the plane are always recreated when separating (the tetrahedron they were wound for may be detached).
+	//
+	TMap<FIntVector, uint32> Faces;
+	TSet<FIntVector> UsedFaces;
+	TSet<FIntVector> RemovedFaces;
+	TArray<uint32> FreeFaces;
+	{
+		for(int i = 0; i < RemovedTetrahedra.Num(); ++i)
+		{
+			for(int k = 0; k < 4; ++k)
+			{
+				const uint32 Face = ModelData.TetrahedronFaceIndices[ RemovedTetrahedra[ i ] * 4 + k ] & FaceIndexMask;
+				Faces.Add( TriangleKey( ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 0 ] ],
+										ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 1 ] ],
+										ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 2 ] ] ), Face );
+			}
+		}
+
+		for(int i = 0; i < NewTetrahedra.Num(); ++i)
+		{
+			const uint32* Corners = NewTetrahedra[ i ].Corners;
+			for(int k = 0; k < 4; ++k)
+			{
+				UsedFaces.Add( TriangleKey( Corners[ TetrahedronFaceCorners[ k ][ 0 ] ], Corners[ TetrahedronFaceCorners[ k ][ 1 ] ], Corners[ TetrahedronFaceCorners[ k ][ 2 ] ] ) );
+			}
+		}
+		for(int i = 0; i < KeptTetrahedra.Num(); ++i)
+		{
+			uint32 Corners[ 4 ];
+			GetTetrahedronCorners( ModelData, KeptTetrahedra[ i ], Corners );
+			for(int k = 0; k < 4; ++k)
+			{
+				UsedFaces.Add( TriangleKey( Corners[ ( k + 1 ) % 4 ], Corners[ ( k + 2 ) % 4 ], Corners[ ( k + 3 ) % 4 ] ) );
+			}
+		}
+
+		for(auto It = Faces.CreateConstIterator(); It; ++It)
+		{
+			const FIntVector& Key = It.Key();
+			const bool bInPlane = ( Sides[ Key.X ] == 0 && Sides[ Key.Y ] == 0 && Sides[ Key.Z ] == 0 );
+			if( !UsedFaces.Contains( Key ) || ( bSeparate && bInPlane ) )
+			{
+				RemovedFaces.Add( Key );
+				FreeFaces.Add( It.Value() );
+			}
+		}
+		FreeFaces.Sort();
+	}
+
+	//
+	// Surface triangles
+	//
+	// The surface triangles of removed faces are clipped like their faces and fanned the same way, keeping their render vertices (coarse) and
+	// winding. When separating, the sections become surface triangles on both sides, wound like the other surface triangles relative to the
+	// faces, as far as they show.
+	//
+	TArray<uint32> NewSurfaceTriangles;
+	TArray<uint32> FreeSurfaceTriangles;
+	bool bSurfaceWindingInward = true;
+	{
+		for(int i = 0; i < FreeFaces.Num(); ++i)
+		{
+			if( Topology.FaceSurfaceTriangles[ FreeFaces[ i ] ] != InvalidIndex )
+			{
+				FreeSurfaceTriangles.Add( Topology.FaceSurfaceTriangles[ FreeFaces[ i ] ] );
+			}
+		}
+		FreeSurfaceTriangles.Sort();
+
+		bool bSurfaceWindingKnown = false;
+		for(int t = 0; t < FreeSurfaceTriangles.Num(); ++t)
+		{
+			const int32 i = FreeSurfaceTriangles[ t ];
+			const uint32 Triangle[ 3 ] = {
+				ModelData.MappingSurfaceToCoarse[ ModelData.SurfaceIndices[ i * 3 + 0 ] ],
+				ModelData.MappingSurfaceToCoarse[ ModelData.SurfaceIndices[ i * 3 + 1 ] ],
+				ModelData.MappingSurfaceToCoarse[ ModelData.SurfaceIndices[ i * 3 + 2 ] ] };
+			const uint32 SparseTriangle[ 3 ] = {
+				ModelData.MappingCoarseToSparse[ Triangle[ 0 ] ],
+				ModelData.MappingCoarseToSparse[ Triangle[ 1 ] ],
+				ModelData.MappingCoarseToSparse[ Triangle[ 2 ] ] };
+			const FIntVector Key = TriangleKey( SparseTriangle[ 0 ], SparseTriangle[ 1 ], SparseTriangle[ 2 ] );
+
+			// The face of a surface triangle has a single tetrahedron, so its normal points inward
+			if( !bSurfaceWindingKnown )
+			{
+				const uint32 Face = Faces[ Key ];
+				const uint32 SparseFace[ 3 ] = {
+					ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 0 ] ],
+					ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 1 ] ],
+					ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 2 ] ] };
+				bSurfaceWindingInward = SameWinding( SparseTriangle, SparseFace );
+				bSurfaceWindingKnown = true;
+			}
+
+			int32 NumPositive = 0;
+			int32 NumNegative = 0;
+			for(int k = 0; k < 3; ++k)
+			{
+				NumPositive += ( Sides[ SparseTriangle[ k ] ] > 0 ) ? 1 : 0;
+				NumNegative += ( Sides[ SparseTriangle[ k ] ] < 0 ) ? 1 : 0;
+			}
+
+			// Triangles in the plane are on the positive side if their duplicate is used
+			int32 InPlaneSide = -1;
+			if( NumPositive == 0 && NumNegative == 0 && bSeparate )
+			{
+				uint32 Duplicate[ 3 ];
+				for(int k = 0; k < 3; ++k)
+				{
+					const uint32* Found = Duplicates.Find( SparseTriangle[ k ] );
+					Duplicate[ k ] = Found ? *Found : SparseTriangle[ k ];
+				}
+				InPlaneSide = UsedFaces.Contains( TriangleKey( Duplicate[ 0 ], Duplicate[ 1 ], Duplicate[ 2 ] ) ) ? 1 : -1;
+			}
+
+			for(int32 Side = -1; Side <= 1; Side += 2)
+			{
+				const bool bOnSide = ( Side < 0 ) ? ( NumNegative > 0 || ( NumPositive == 0 && InPlaneSide < 0 ) ) : ( NumPositive > 0 || ( NumNegative == 0 && InPlaneSide > 0 ) );
+				if( !bOnSide )
+				{
+					continue;
+				}
+
+				FPolygon Polygon;
+				FnClip( Triangle, Side, true, Polygon );
+
+				const int32 First = Polygon.FanVertex( &ModelData.MappingCoarseToSparse );
+				for(int k = 1; k < Polygon.Num - 1; ++k)
+				{
+					uint32 A = Polygon.Vertices[ First ];
+					uint32 B = Polygon.Vertices[ ( First + k ) % Polygon.Num ];
+					uint32 C = Polygon.Vertices[ ( First + k + 1 ) % Polygon.Num ];
+					if( Side > 0 && bSeparate )
+					{
+						A = FnDuplicateCoarse( A );
+						B = FnDuplicateCoarse( B );
+						C = FnDuplicateCoarse( C );
+					}
+					NewSurfaceTriangles.Add( A );
+					NewSurfaceTriangles.Add( B );
+					NewSurfaceTriangles.Add( C );
+				}
+			}
+		}
+
+		if( bSeparate )
+		{
+			// Faces in the plane on the positive side of which the face on the negative side is still used, the normal of the positive
+			// side face (inward) points to the positive side
+			for(int i = 0; i < NewTetrahedra.Num(); ++i)
+			{
+				if( NewTetrahedra[ i ].Side < 0 )
+				{
+					continue;
+				}
+
+				const uint32* Corners = NewTetrahedra[ i ].Corners;
+				for(int k = 0; k < 4; ++k)
+				{
+					uint32 Inward[ 3 ];
+					uint32 Original[ 3 ];
+					bool bSection = true;
+					for(int c = 0; c < 3; ++c)
+					{
+						Inward[ c ] = Corners[ TetrahedronFaceCorners[ k ][ c ] ];
+						const uint32* Found = Originals.Find( Inward[ c ] );
+						Original[ c ] = Found ? *Found : InvalidIndex;
+						bSection &= ( Found != nullptr );
+					}
+					if( !bSection || !UsedFaces.Contains( TriangleKey( Original[ 0 ], Original[ 1 ], Original[ 2 ] ) ) )
+					{
+						continue;
+					}
+
+					if( bSurfaceWindingInward )
+					{
+						Swap( Original[ 1 ], Original[ 2 ] );
+					}
+					else
+					{
+						Swap( Inward[ 1 ], Inward[ 2 ] );
+					}
+					for(int c = 0; c < 3; ++c)
+					{
+						NewSurfaceTriangles.Add( SparseToCoarse[ Original[ c ] ] );
+					}
+					for(int c = 0; c < 3; ++c)
+					{
+						NewSurfaceTriangles.Add( SparseToCoarse[ Inward[ c ] ] );
+					}
+				}
+			}
+		}
+	}
+
+	//
+	// Edges
+	//
+	// The edges of the removed tetrahedra that are no longer used are removed and those of the new tetrahedra are added, the kept tetrahedra
+	// hold on to the edges they share with removed ones.
+	//
+	TArray<uint64> RemovedEdges;
+	TArray<uint64> AddedEdges;
+	{
+		auto FnAddEdges = []( const uint32* Corners, TSet<uint64>& Edges )
+		{
+			for(int a = 0; a < 4; ++a)
+			{
+				for(int b = a + 1; b < 4; ++b)
+				{
+					Edges.Add( ( (uint64)FMath::Min( Corners[ a ], Corners[ b ] ) << 32 ) | (uint64)FMath::Max( Corners[ a ], Corners[ b ] ) );
+				}
+			}
+		};
+
+		TSet<uint64> OldEdges;
+		TSet<uint64> NewEdges;
+		for(int i = 0; i < RemovedTetrahedra.Num(); ++i)
+		{
+			uint32 Corners[ 4 ];
+			GetTetrahedronCorners( ModelData, RemovedTetrahedra[ i ], Corners );
+			FnAddEdges( Corners, OldEdges );
+		}
+		for(int i = 0; i < NewTetrahedra.Num(); ++i)
+		{
+			FnAddEdges( NewTetrahedra[ i ].Corners, NewEdges );
+		}
+		for(int i = 0; i < KeptTetrahedra.Num(); ++i)
+		{
+			uint32 Corners[ 4 ];
+			GetTetrahedronCorners( ModelData, KeptTetrahedra[ i ], Corners );
+			FnAddEdges( Corners, OldEdges );
+			FnAddEdges( Corners, NewEdges );
+		}
+
+		for(auto It = OldEdges.CreateConstIterator(); It; ++It)
+		{
+			if( !NewEdges.Contains( *It ) )
+			{
+				RemovedEdges.Add( *It );
+			}
+		}
+		for(auto It = NewEdges.CreateConstIterator(); It; ++It)
+		{
+			if( !OldEdges.Contains( *It ) )
+			{
+				AddedEdges.Add( *It );
+			}
+		}
+		RemovedEdges.Sort();
+		AddedEdges.Sort();
+	}
+
+	//
+	// Update
+	//
+	// Everything is known now, the model data is patched and the changes are recorded.
+	//
+
+	// Tetrahedra, reusing the slots of the removed ones
+	check( NewTetrahedra.Num() >= RemovedTetrahedra.Num() );
+	for(int i = 0; i < RemovedTetrahedra.Num(); ++i)
+	{
+		OutDelta.RemovedTetrahedra.Add( RemovedTetrahedra[ i ] );
+		UnlinkTetrahedron( ModelData, RemovedTetrahedra[ i ] );
+	}
+
+	int32 NextFreeFace = 0;
+	for(int i = 0; i < NewTetrahedra.Num(); ++i)
+	{
+		uint32 Tetrahedron;
+		if( i < RemovedTetrahedra.Num() )
+		{
+			Tetrahedron = RemovedTetrahedra[ i ];
+		}
+		else
+		{
+			Tetrahedron = ModelData.TetrahedronFaceIndices.AddUninitialized( 4 ) / 4;
+			if( bTetrahedronVertexIndices )
+			{
+				ModelData.TetrahedronVertexIndices.AddUninitialized( 4 );
+			}
+		}
+		OutDelta.AddedTetrahedra.Add( Tetrahedron );
+
+		SetTetrahedron( ModelData, Tetrahedron, NewTetrahedra[ i ].Corners, SparseToCoarse, Faces, RemovedFaces, FreeFaces, NextFreeFace, OutDelta );
+	}
+
+	GrowTopology( ModelData );
+	for(int i = 0; i < OutDelta.AddedTetrahedra.Num(); ++i)
+	{
+		LinkTetrahedron( ModelData, OutDelta.AddedTetrahedra[ i ] );
+	}
+
+	// Vertices on the plane that are only used on the negative side by the kept tetrahedra now
+	for(int i = 0; i < KeptTetrahedra.Num(); ++i)
+	{
+		uint32 Corners[ 4 ];
+		GetTetrahedronCorners( ModelData, KeptTetrahedra[ i ], Corners );
+		for(int k = 0; k < 4; ++k)
+		{
+			Topology.VertexTetrahedra[ Corners[ k ] ] = KeptTetrahedra[ i ];
+		}
+	}
+
+	// Faces, any slots left are made degenerate (each removed face is replaced by at least one new face, so this does not happen in practice)
+	OutDelta.RemovedFaces = FreeFaces;
+	for(int i = NextFreeFace; i < FreeFaces.Num(); ++i)
+	{
+		ModelData.Indices[ FreeFaces[ i ] * 3 + 1 ] = ModelData.Indices[ FreeFaces[ i ] * 3 + 0 ];
+		ModelData.Indices[ FreeFaces[ i ] * 3 + 2 ] = ModelData.Indices[ FreeFaces[ i ] * 3 + 0 ];
+	}
+
+	// Surface triangles, with a surface vertex for every vertex (coarse) that is new to the surface
+	{
+		TArray<uint32>& CoarseToSurface = Topology.CoarseToSurface;
+		for(int i = 0; i < FreeFaces.Num(); ++i)
+		{
+			Topology.FaceSurfaceTriangles[ FreeFaces[ i ] ] = InvalidIndex;
+		}
+
+		OutDelta.RemovedSurfaceTriangles = FreeSurfaceTriangles;
+		for(int i = 0; i < NewSurfaceTriangles.Num() / 3; ++i)
+		{
+			uint32 Triangle;
+			if( i < FreeSurfaceTriangles.Num() )
+			{
+				Triangle = FreeSurfaceTriangles[ i ];
+			}
+			else
+			{
+				Triangle = ModelData.SurfaceIndices.AddUninitialized( 3 ) / 3;
+			}
+			OutDelta.AddedSurfaceTriangles.Add( Triangle );
+
+			for(int k = 0; k < 3; ++k)
+			{
+				const uint32 Coarse = NewSurfaceTriangles[ i * 3 + k ];
+				if( CoarseToSurface[ Coarse ] == InvalidIndex )
+				{
+					CoarseToSurface[ Coarse ] = ModelData.MappingSurfaceToCoarse.Add( Coarse );
+				}
+				if( ModelData.VerticesSurfaceIndicators[ Coarse ] )
+				{
+					ModelData.VerticesSurfaceIndicators[ Coarse ] = false;
+					if( Coarse < OutDelta.FirstAddedCoarseVertex )
+					{
+						OutDelta.ExposedVertices.Add( Coarse );
+					}
+				}
+				ModelData.SurfaceIndices[ Triangle * 3 + k ] = CoarseToSurface[ Coarse ];
+			}
+
+			const FIntVector Key = TriangleKey( ModelData.MappingCoarseToSparse[ NewSurfaceTriangles[ i * 3 + 0 ] ],
+												ModelData.MappingCoarseToSparse[ NewSurfaceTriangles[ i * 3 + 1 ] ],
+												ModelData.MappingCoarseToSparse[ NewSurfaceTriangles[ i * 3 + 2 ] ] );
+			if( const uint32* Face = Faces.Find( Key ) )
+			{
+				Topology.FaceSurfaceTriangles[ *Face ] = Triangle;
+			}
+		}
+
+		for(int i = NewSurfaceTriangles.Num() / 3; i < FreeSurfaceTriangles.Num(); ++i)
+		{
+			ModelData.SurfaceIndices[ FreeSurfaceTriangles[ i ] * 3 + 1 ] = ModelData.SurfaceIndices[ FreeSurfaceTriangles[ i ] * 3 + 0 ];
+			ModelData.SurfaceIndices[ FreeSurfaceTriangles[ i ] * 3 + 2 ] = ModelData.SurfaceIndices[ FreeSurfaceTriangles[ i ] * 3 + 0 ];
+		}
+	}
+
+	// Edges and connectivity
+	UpdateEdges( ModelData, RemovedEdges, AddedEdges, OutDelta );
+
+	Topology.NumTetrahedra = ModelData.TetrahedronFaceIndices.Num() / 4;
+	Topology.NumSurfaceTriangles = ModelData.SurfaceIndices.Num() / 3;
+
+	UE_LOG( TendrModelTetraLog, Verbose, TEXT( "Cut = Tetrahedra [%d cut, %d removed, %d added], Vertices [%d physics, %d added], Edges [%d removed, %d added]" ),
+			NumCutTetrahedra,
+			OutDelta.RemovedTetrahedra.Num(),
+			OutDelta.AddedTetrahedra.Num(),
+			ModelData.VerticesPhysics.Num(),
+			ModelData.VerticesPhysics.Num() - OutDelta.FirstAddedVertex,
+			RemovedEdges.Num(),
+			AddedEdges.Num()
+			);
+
+	return true;
+}
+
+bool UTendrModelTetraGeneratorComponent::ImproveQuality( FTendrModelData& ModelData, const TArray<FVector>& Positions, float MinimumQuality, FTendrModelDelta& OutDelta )
+{
+	TENDR_TRACE_SCOPE( "ImproveQuality" );
+
+	OutDelta = FTendrModelDelta();
+	OutDelta.FirstAddedVertex = ModelData.VerticesPhysics.Num();
+	OutDelta.FirstAddedCoarseVertex = ModelData.Vertices.Num();
+	OutDelta.FirstAddedSurfaceVertex = ModelData.MappingSurfaceToCoarse.Num();
+
+	if( !ModelData.IsValid() || Positions.Num() != ModelData.VerticesPhysics.Num() )
+	{
+		SetError( TEXT( "Model data to improve is not valid or does not match the deformed positions" ) );
+		return false;
+	}
+
+	const uint32 FaceIndexMask = ~FTendrModelData::TetrahedronFaceOrientationBit;
+	const int32 NumTetrahedra = ModelData.TetrahedronFaceIndices.Num() / 4;
+	const bool bTetrahedronVertexIndices = ( ModelData.TetrahedronVertexIndices.Num() == NumTetrahedra * 4 );
+
+	// Quality of a tetrahedron in the deformed and in the rest shape
+	auto FnQuality = [ &Positions ]( const uint32 ( &Corners )[ 4 ] ) -> float
+	{
+		const FVector Points[ 4 ] = { Positions[ Corners[ 0 ] ], Positions[ Corners[ 1 ] ], Positions[ Corners[ 2 ] ], Positions[ Corners[ 3 ] ] };
+		return TetrahedronQuality( Points );
+	};
+	auto FnRestQuality = [ &ModelData ]( const uint32 ( &Corners )[ 4 ] ) -> float
+	{
+		const FVector Points[ 4 ] = {
+			FVector( ModelData.VerticesPhysics[ Corners[ 0 ] ] ),
+			FVector( ModelData.VerticesPhysics[ Corners[ 1 ] ] ),
+			FVector( ModelData.VerticesPhysics[ Corners[ 2 ] ] ),
+			FVector( ModelData.VerticesPhysics[ Corners[ 3 ] ] ) };
+		return TetrahedronQuality( Points );
+	};
+
+	// Signed volume (times 6) of a tetrahedron in the rest shape
+	auto FnRestVolume = [ &ModelData ]( uint32 A, uint32 B, uint32 C, uint32 D ) -> float
+	{
+		const FVector PointA( ModelData.VerticesPhysics[ A ] );
+		return FVector::DotProduct( FVector::CrossProduct( FVector( ModelData.VerticesPhysics[ B ] ) - PointA, FVector( ModelData.VerticesPhysics[ C ] ) - PointA ), FVector( ModelData.VerticesPhysics[ D ] ) - PointA );
+	};
+
+	//
+	// Tetrahedra
+	//
+	// The tetrahedra are flipped in a working copy with their face adjacency, the tetrahedra made by flips are appended to it and those
+	// replaced by flips are marked dead. Only the low quality tetrahedra (in the deformed shape) and the tetrahedra made from them are
+	// flipped, worst first.
+	//
+	// The working copy starts with the low quality tetrahedra of the model data, the tetrahedra next to them are loaded from the topology
+	// when a flip first looks across their face. Apart from the quality of every tetrahedron, the cost is in the flipped regions.
+	//
+	struct FFlipTetrahedron
+	{
+		uint32 Corners[ 4 ];
+		float Quality;
+		float RestQuality;
+		int32 Source;
+		bool bAlive;
+	};
+	TArray<int32> LowQualityTetrahedra;
+	float QualityBefore = 180;
+	for(int i = 0; i < NumTetrahedra; ++i)
+	{
+		uint32 Corners[ 4 ];
+		GetTetrahedronCorners( ModelData, i, Corners );
+		const float Quality = FnQuality( Corners );
+		if( Quality < MinimumQuality )
+		{
+			LowQualityTetrahedra.Add( i );
+		}
+		QualityBefore = FMath::Min( QualityBefore, Quality );
+	}
+	if( LowQualityTetrahedra.Num() == 0 )
+	{
+		return false;
+	}
+
+	// The topology is built by the first local operation
+	if( !IsTopologyValid( ModelData ) )
+	{
+		BuildTopology( ModelData );
+	}
+	FTendrModelTopology& Topology = ModelData.Topology;
+
+	// Tetrahedra of the working copy (Source is the tetrahedron of the model data, INDEX_NONE for those made by flips), and the tetrahedra on
+	// both sides of each face (INDEX_NONE on the boundary or if not loaded yet) with the tetrahedron of the model data across the face of a
+	// loaded tetrahedron until it is loaded too
+	struct FFlipFace
+	{
+		int32 Tetrahedra[ 2 ];
+		int32 Unloaded;
+	};
+	TArray<FFlipTetrahedron> Tetrahedra;
+	TMap<FIntVector, FFlipFace> FaceTetrahedra;
+	auto FnFaceKey = [ &Tetrahedra ]( int32 Tetrahedron, int32 k ) -> FIntVector
+	{
+		const uint32* Corners = Tetrahedra[ Tetrahedron ].Corners;
+		return TriangleKey( Corners[ ( k + 1 ) % 4 ], Corners[ ( k + 2 ) % 4 ], Corners[ ( k + 3 ) % 4 ] );
+	};
+	auto FnLinkFace = [ &FaceTetrahedra ]( const FIntVector& Key, int32 Tetrahedron ) -> FFlipFace&
+	{
+		FFlipFace* Face = FaceTetrahedra.Find( Key );
+		if( Face == nullptr )
+		{
+			FFlipFace NewFace;
+			NewFace.Tetrahedra[ 0 ] = Tetrahedron;
+			NewFace.Tetrahedra[ 1 ] = INDEX_NONE;
+			NewFace.Unloaded = INDEX_NONE;
+			return FaceTetrahedra.Add( Key, NewFace );
+		}
+		Face->Tetrahedra[ ( Face->Tetrahedra[ 0 ] == INDEX_NONE ) ? 0 : 1 ] = Tetrahedron;
+		return *Face;
+	};
+	auto FnLink = [ &FnLinkFace, &FnFaceKey ]( int32 Tetrahedron )
+	{
+		for(int k = 0; k < 4; ++k)
+		{
+			FnLinkFace( FnFaceKey( Tetrahedron, k ), Tetrahedron );
+		}
+	};
+	auto FnUnlink = [ &FaceTetrahedra, &FnFaceKey ]( int32 Tetrahedron )
+	{
+		for(int k = 0; k < 4; ++k)
+		{
+			FFlipFace& Face = FaceTetrahedra.FindChecked( FnFaceKey( Tetrahedron, k ) );
+			Face.Tetrahedra[ ( Face.Tetrahedra[ 0 ] == Tetrahedron ) ? 0 : 1 ] = INDEX_NONE;
+		}
+	};
+
+	// Loads a tetrahedron of the model data into the working copy, its neighbours are found in the topology
+	auto FnLoad = [ & ]( int32 Source ) -> int32
+	{
+		FFlipTetrahedron Tetrahedron;
+		GetTetrahedronCorners( ModelData, Source, Tetrahedron.Corners );
+		Tetrahedron.Quality = FnQuality( Tetrahedron.Corners );
+		Tetrahedron.RestQuality = FnRestQuality( Tetrahedron.Corners );
+		Tetrahedron.Source = Source;
+		Tetrahedron.bAlive = true;
+		const int32 Index = Tetrahedra.Add( Tetrahedron );
+
+		for(int k = 0; k < 4; ++k)
+		{
+			const uint32 Face = ModelData.TetrahedronFaceIndices[ Source * 4 + k ] & FaceIndexMask;
+			const uint32 Other = Topology.FaceTetrahedra[ Face * 2 + ( ( Topology.FaceTetrahedra[ Face * 2 ] == (uint32)Source ) ? 1 : 0 ) ];
+			FFlipFace& FlipFace = FnLinkFace( FaceKey( ModelData, Face ), Index );
+			FlipFace.Unloaded = ( FlipFace.Unloaded == INDEX_NONE && FlipFace.Tetrahedra[ 1 ] == INDEX_NONE && Other != InvalidIndex ) ? (int32)Other : INDEX_NONE;
+		}
+		return Index;
+	};
+	auto FnNeighbour = [ &FaceTetrahedra, &FnLoad ]( int32 Tetrahedron, uint32 A, uint32 B, uint32 C ) -> int32
+	{
+		const FFlipFace& Face = FaceTetrahedra.FindChecked( TriangleKey( A, B, C ) );
+		const int32 Other = Face.Tetrahedra[ ( Face.Tetrahedra[ 0 ] == Tetrahedron ) ? 1 : 0 ];
+		return ( Other == INDEX_NONE && Face.Unloaded != INDEX_NONE ) ? FnLoad( Face.Unloaded ) : Other;
+	};
+	auto FnOtherCorner = [ &Tetrahedra ]( int32 Tetrahedron, uint32 A, uint32 B, uint32 C ) -> uint32
+	{
+		const uint32* Corners = Tetrahedra[ Tetrahedron ].Corners;
+		for(int k = 0; k < 3; ++k)
+		{
+			if( Corners[ k ] != A && Corners[ k ] != B && Corners[ k ] != C )
+			{
+				return Corners[ k ];
+			}
+		}
+		return Corners[ 3 ];
+	};
+
+	TArray<int32> Queue;
+	for(int i = 0; i < LowQualityTetrahedra.Num(); ++i)
+	{
+		Queue.Add( FnLoad( LowQualityTetrahedra[ i ] ) );
+	}
+	Queue.Sort( [ &Tetrahedra ]( int32 A, int32 B ) { return Tetrahedra[ A ].Quality < Tetrahedra[ B ].Quality; } );
+	const int32 NumLowQualityTetrahedra = Queue.Num();
+
+	// Number of neighbours of a vertex (sparse), the connectivity is only updated at the end
+	TMap<uint32, int32> NeighbourChanges;
+	auto FnNumNeighbours = [ &ModelData, &NeighbourChanges ]( uint32 Vertex ) -> int32
+	{
+		int32 NumNeighbours = 0;
+		while( NumNeighbours < FTendrVertexConnectivityData::MaxNeighbours && ModelData.Connectivity[ Vertex ].NeighbourIndices[ NumNeighbours ] != InvalidIndex )
+		{
+			++NumNeighbours;
+		}
+		return NumNeighbours + NeighbourChanges.FindRef( Vertex );
+	};
+
+	//
+	// Flips
+	//
+	// A 2-3 flip replaces two tetrahedra that share a face by three around the edge between their other corners, a 3-2 flip does the reverse
+	// for the three tetrahedra around an edge. The surface is never changed. A flip must be valid in the rest shape without making its rest
+	// quality worse than the threshold, the flip that improves the worst deformed quality of the tetrahedra it replaces the most is taken.
+	//
+	int32 NumFlips = 0;
+	for(int q = 0; q < Queue.Num() && NumFlips < NumLowQualityTetrahedra * QUALITY_FLIPS_MAX; ++q)
+	{
+		const int32 Current = Queue[ q ];
+		if( !Tetrahedra[ Current ].bAlive || Tetrahedra[ Current ].Quality >= MinimumQuality )
+		{
+			continue;
+		}
+
+		int32 BestReplaced[ 3 ];
+		int32 NumBestReplaced = 0;
+		uint32 BestCorners[ 3 ][ 4 ];
+		int32 NumBestCorners = 0;
+		float BestQuality = 0;
+
+		// Considers replacing tetrahedra by new ones (positively oriented in the rest shape)
+		auto FnConsider = [ & ]( const int32* Replaced, int32 NumReplaced, uint32 ( *Corners )[ 4 ], int32 NumCorners )
+		{
+			float OldQuality = 180;
+			float OldRestQuality = 180;
+			for(int i = 0; i < NumReplaced; ++i)
+			{
+				OldQuality = FMath::Min( OldQuality, Tetrahedra[ Replaced[ i ] ].Quality );
+				OldRestQuality = FMath::Min( OldRestQuality, Tetrahedra[ Replaced[ i ] ].RestQuality );
+			}
+			float NewQuality = 180;
+			float NewRestQuality = 180;
+			for(int i = 0; i < NumCorners; ++i)
+			{
+				NewQuality = FMath::Min( NewQuality, FnQuality( Corners[ i ] ) );
+				NewRestQuality = FMath::Min( NewRestQuality, FnRestQuality( Corners[ i ] ) );
+			}
+			if( NewQuality > OldQuality && NewQuality > BestQuality && NewRestQuality > 0 && NewRestQuality >= FMath::Min( MinimumQuality, OldRestQuality ) )
+			{
+				BestQuality = NewQuality;
+				NumBestReplaced = NumReplaced;
+				NumBestCorners = NumCorners;
+				FMemory::Memcpy( BestReplaced, Replaced, NumReplaced * sizeof( int32 ) );
+				FMemory::Memcpy( BestCorners, Corners, NumCorners * sizeof( Corners[ 0 ] ) );
+			}
+		};
+
+		// Copied, loading the neighbours grows the working copy
+		uint32 Corners[ 4 ];
+		FMemory::Memcpy( Corners, Tetrahedra[ Current ].Corners, sizeof( Corners ) );
+
+		// 2-3 flips across the faces, the edge between the opposite corners must pass through the face
+		for(int k = 0; k < 4; ++k)
+		{
+			const uint32 a = Corners[ ( k + 1 ) % 4 ];
+			const uint32 b = Corners[ ( k + 2 ) % 4 ];
+			const uint32 c = Corners[ ( k + 3 ) % 4 ];
+			const uint32 d = Corners[ k ];
+			const int32 Other = FnNeighbour( Current, a, b, c );
+			if( Other == INDEX_NONE )
+			{
+				continue;
+			}
+			const uint32 e = FnOtherCorner( Other, a, b, c );
+			if( FnNumNeighbours( d ) >= FTendrVertexConnectivityData::MaxNeighbours || FnNumNeighbours( e ) >= FTendrVertexConnectivityData::MaxNeighbours )
+			{
+				continue;
+			}
+
+			uint32 NewCorners[ 3 ][ 4 ] = { { a, b, d, e }, { b, c, d, e }, { c, a, d, e } };
+			const float Volumes[ 3 ] = { FnRestVolume( a, b, d, e ), FnRestVolume( b, c, d, e ), FnRestVolume( c, a, d, e ) };
+			if( !( ( Volumes[ 0 ] > 0 && Volumes[ 1 ] > 0 && Volumes[ 2 ] > 0 ) || ( Volumes[ 0 ] < 0 && Volumes[ 1 ] < 0 && Volumes[ 2 ] < 0 ) ) )
+			{
+				continue;
+			}
+			if( Volumes[ 0 ] < 0 )
+			{
+				for(int i = 0; i < 3; ++i)
+				{
+					Swap( NewCorners[ i ][ 0 ], NewCorners[ i ][ 1 ] );
+				}
+			}
+
+			const int32 Replaced[ 2 ] = { Current, Other };
+			FnConsider( Replaced, 2, NewCorners, 3 );
+		}
+
+		// 3-2 flips around the edges with three tetrahedra, the edge must pass through the triangle of their other corners
+		for(int i = 0; i < 4; ++i)
+		{
+			for(int j = i + 1; j < 4; ++j)
+			{
+				int32 Others[ 2 ];
+				int32 NumOthers = 0;
+				for(int m = 0; m < 4; ++m)
+				{
+					if( m != i && m != j )
+					{
+						Others[ NumOthers++ ] = m;
+					}
+				}
+				const uint32 a = Corners[ i ];
+				const uint32 b = Corners[ j ];
+				const uint32 c = Corners[ Others[ 0 ] ];
+				const uint32 d = Corners[ Others[ 1 ] ];
+
+				const int32 Second = FnNeighbour( Current, a, b, d );
+				if( Second == INDEX_NONE )
+				{
+					continue;
+				}
+				const uint32 e = FnOtherCorner( Second, a, b, d );
+				const int32 Third = FnNeighbour( Second, a, b, e );
+				if( Third == INDEX_NONE || FnOtherCorner( Third, a, b, e ) != c )
+				{
+					continue;
+				}
+
+				uint32 NewCorners[ 2 ][ 4 ] = { { c, d, e, a }, { c, d, e, b } };
+				const float Volumes[ 2 ] = { FnRestVolume( c, d, e, a ), FnRestVolume( c, d, e, b ) };
+				if( !( ( Volumes[ 0 ] > 0 && Volumes[ 1 ] < 0 ) || ( Volumes[ 0 ] < 0 && Volumes[ 1 ] > 0 ) ) )
+				{
+					continue;
+				}
+				Swap( NewCorners[ ( Volumes[ 0 ] < 0 ) ? 0 : 1 ][ 0 ], NewCorners[ ( Volumes[ 0 ] < 0 ) ? 0 : 1 ][ 1 ] );
+
+				const int32 Replaced[ 3 ] = { Current, Second, Third };
+				FnConsider( Replaced, 3, NewCorners, 2 );
+			}
+		}
+
+		if( NumBestReplaced == 0 )
+		{
+			continue;
+		}
+
+		// Flip, the new edge of a 2-3 flip is between the corners that are not shared, the removed edge of a 3-2 flip is between the shared ones
+		for(int i = 0; i < NumBestReplaced; ++i)
+		{
+			FnUnlink( BestReplaced[ i ] );
+			Tetrahedra[ BestReplaced[ i ] ].bAlive = false;
+		}
+		for(int i = 0; i < NumBestCorners; ++i)
+		{
+			FFlipTetrahedron Tetrahedron;
+			FMemory::Memcpy( Tetrahedron.Corners, BestCorners[ i ], sizeof( Tetrahedron.Corners ) );
+			Tetrahedron.Quality = FnQuality( Tetrahedron.Corners );
+			Tetrahedron.RestQuality = FnRestQuality( Tetrahedron.Corners );
+			Tetrahedron.Source = INDEX_NONE;
+			Tetrahedron.bAlive = true;
+			const int32 Index = Tetrahedra.Add( Tetrahedron );
+			FnLink( Index );
+			if( Tetrahedron.Quality < MinimumQuality )
+			{
+				Queue.Add( Index );
+			}
+		}
+		if( NumBestCorners == 3 )
+		{
+			NeighbourChanges.FindOrAdd( BestCorners[ 0 ][ 2 ] ) += 1;
+			NeighbourChanges.FindOrAdd( BestCorners[ 0 ][ 3 ] ) += 1;
+		}
+		else
+		{
+			NeighbourChanges.FindOrAdd( BestCorners[ 0 ][ 3 ] ) -= 1;
+			NeighbourChanges.FindOrAdd( BestCorners[ 1 ][ 3 ] ) -= 1;
+		}
+		++NumFlips;
+	}
+
+	// The flipped tetrahedra of the model data are removed and the tetrahedra made by flips that are left are added, the quality after is
+	// that of the working copy (the tetrahedra that are not loaded are unchanged and not below the minimum quality)
+	TArray<uint32> RemovedTetrahedra;
+	TArray<int32> NewTetrahedra;
+	float QualityAfter = 180;
+	for(int i = 0; i < Tetrahedra.Num(); ++i)
+	{
+		if( Tetrahedra[ i ].Source != INDEX_NONE && !Tetrahedra[ i ].bAlive )
+		{
+			RemovedTetrahedra.Add( Tetrahedra[ i ].Source );
+		}
+		else if( Tetrahedra[ i ].Source == INDEX_NONE && Tetrahedra[ i ].bAlive )
+		{
+			NewTetrahedra.Add( i );
+		}
+		if( Tetrahedra[ i ].bAlive )
+		{
+			QualityAfter = FMath::Min( QualityAfter, Tetrahedra[ i ].Quality );
+		}
+	}
+	if( RemovedTetrahedra.Num() == 0 )
+	{
+		return false;
+	}
+	RemovedTetrahedra.Sort();
+
+	// First vertex (coarse) of every vertex (sparse), the new faces are all inside
+	const TArray<uint32>& SparseToCoarse = Topology.SparseToCoarse;
+
+	//
+	// Faces and edges
+	//
+	// The flipped region is the same before and after, so its boundary faces and edges are kept and the faces and edges inside it that are
+	// not used by the new tetrahedra are removed.
+	//
+	TMap<FIntVector, uint32> Faces;
+	TSet<FIntVector> UsedFaces;
+	TSet<FIntVector> RemovedFaces;
+	TArray<uint32> FreeFaces;
+	TArray<uint64> RemovedEdges;
+	TArray<uint64> AddedEdges;
+	{
+		auto FnAddEdges = []( const uint32* Corners, TSet<uint64>& Edges )
+		{
+			for(int a = 0; a < 4; ++a)
+			{
+				for(int b = a + 1; b < 4; ++b)
+				{
+					Edges.Add( ( (uint64)FMath::Min( Corners[ a ], Corners[ b ] ) << 32 ) | (uint64)FMath::Max( Corners[ a ], Corners[ b ] ) );
+				}
+			}
+		};
+
+		TSet<uint64> OldEdges;
+		TSet<uint64> NewEdges;
+		for(int i = 0; i < RemovedTetrahedra.Num(); ++i)
+		{
+			for(int k = 0; k < 4; ++k)
+			{
+				const uint32 Face = ModelData.TetrahedronFaceIndices[ RemovedTetrahedra[ i ] * 4 + k ] & FaceIndexMask;
+				Faces.Add( TriangleKey( ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 0 ] ],
+										ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 1 ] ],
+										ModelData.MappingCoarseToSparse[ ModelData.Indices[ Face * 3 + 2 ] ] ), Face );
+			}
+			uint32 Corners[ 4 ];
+			GetTetrahedronCorners( ModelData, RemovedTetrahedra[ i ], Corners );
+			FnAddEdges( Corners, OldEdges );
+		}
+		for(int i = 0; i < NewTetrahedra.Num(); ++i)
+		{
+			for(int k = 0; k < 4; ++k)
+			{
+				UsedFaces.Add( FnFaceKey( NewTetrahedra[ i ], k ) );
+			}
+			FnAddEdges( Tetrahedra[ NewTetrahedra[ i ] ].Corners, NewEdges );
+		}
+
+		for(auto It = Faces.CreateConstIterator(); It; ++It)
+		{
+			if( !UsedFaces.Contains( It.Key() ) )
+			{
+				RemovedFaces.Add( It.Key() );
+				FreeFaces.Add( It.Value() );
+			}
+		}
+		FreeFaces.Sort();
+
+		for(auto It = OldEdges.CreateConstIterator(); It; ++It)
+		{
+			if( !NewEdges.Contains( *It ) )
+			{
+				RemovedEdges.Add( *It );
+			}
+		}
+		for(auto It = NewEdges.CreateConstIterator(); It; ++It)
+		{
+			if( !OldEdges.Contains( *It ) )
+			{
+				AddedEdges.Add( *It );
+			}
+		}
+		RemovedEdges.Sort();
+		AddedEdges.Sort();
+	}
+
+	//
+	// Update
+	//
+
+	// Tetrahedra, reusing the slots of the removed ones
+	OutDelta.RemovedTetrahedra = RemovedTetrahedra;
+	for(int i = 0; i < RemovedTetrahedra.Num(); ++i)
+	{
+		UnlinkTetrahedron( ModelData, RemovedTetrahedra[ i ] );
+	}
+
+	int32 NextFreeFace = 0;
+	for(int i = 0; i < NewTetrahedra.Num(); ++i)
+	{
+		uint32 Tetrahedron;
+		if( i < RemovedTetrahedra.Num() )
+		{
+			Tetrahedron = RemovedTetrahedra[ i ];
+		}
+		else
+		{
+			Tetrahedron = ModelData.TetrahedronFaceIndices.AddUninitialized( 4 ) / 4;
+			if( bTetrahedronVertexIndices )
+			{
+				ModelData.TetrahedronVertexIndices.AddUninitialized( 4 );
+			}
+		}
+		OutDelta.AddedTetrahedra.Add( Tetrahedron );
+
+		SetTetrahedron( ModelData, Tetrahedron, Tetrahedra[ NewTetrahedra[ i ] ].Corners, SparseToCoarse, Faces, RemovedFaces, FreeFaces, NextFreeFace, OutDelta );
+	}
+
+	GrowTopology( ModelData );
+	for(int i = 0; i < OutDelta.AddedTetrahedra.Num(); ++i)
+	{
+		LinkTetrahedron( ModelData, OutDelta.AddedTetrahedra[ i ] );
+	}
+
+	// Slots left over (there are more 3-2 than 2-3 flips) are filled by the last tetrahedra, which are removed and added again, so the array shrinks
+	if( NewTetrahedra.Num() < RemovedTetrahedra.Num() )
+	{
+		const int32 NewNumTetrahedra = NumTetrahedra - ( RemovedTetrahedra.Num() - NewTetrahedra.Num() );
+		int32 Last = NumTetrahedra;
+		int32 LastRemoved = RemovedTetrahedra.Num() - 1;
+		for(int i = NewTetrahedra.Num(); i < RemovedTetrahedra.Num() && (int32)RemovedTetrahedra[ i ] < NewNumTetrahedra; ++i)
+		{
+			--Last;
+			while( LastRemoved >= 0 && (int32)RemovedTetrahedra[ LastRemoved ] == Last )
+			{
+				--Last;
+				--LastRemoved;
+			}
+			check( Last >= NewNumTetrahedra );
+
+			UnlinkTetrahedron( ModelData, Last );
+			for(int k = 0; k < 4; ++k)
+			{
+				ModelData.TetrahedronFaceIndices[ RemovedTetrahedra[ i ] * 4 + k ] = ModelData.TetrahedronFaceIndices[ Last * 4 + k ];
+				if( bTetrahedronVertexIndices )
+				{
+					ModelData.TetrahedronVertexIndices[ RemovedTetrahedra[ i ] * 4 + k ] = ModelData.TetrahedronVertexIndices[ Last * 4 + k ];
+				}
+			}
+			LinkTetrahedron( ModelData, RemovedTetrahedra[ i ] );
+			OutDelta.RemovedTetrahedra.Add( Last );
+			OutDelta.AddedTetrahedra.Add( RemovedTetrahedra[ i ] );
+		}
+		ModelData.TetrahedronFaceIndices.SetNum( NewNumTetrahedra * 4 );
+		if( bTetrahedronVertexIndices )
+		{
+			ModelData.TetrahedronVertexIndices.SetNum( NewNumTetrahedra * 4 );
+		}
+	}
+
+	// Faces, any slots left are made degenerate
+	OutDelta.RemovedFaces = FreeFaces;
+	for(int i = NextFreeFace; i < FreeFaces.Num(); ++i)
+	{
+		ModelData.Indices[ FreeFaces[ i ] * 3 + 1 ] = ModelData.Indices[ FreeFaces[ i ] * 3 + 0 ];
+		ModelData.Indices[ FreeFaces[ i ] * 3 + 2 ] = ModelData.Indices[ FreeFaces[ i ] * 3 + 0 ];
+	}
+
+	// Edges and connectivity
+	UpdateEdges( ModelData, RemovedEdges, AddedEdges, OutDelta );
+
+	Topology.NumTetrahedra = ModelData.TetrahedronFaceIndices.Num() / 4;
+
+	UE_LOG( TendrModelTetraLog, Verbose, TEXT( "ImproveQuality = Tetrahedra [%d low quality, %d flips, %d removed, %d added], Quality [%.2f before, %.2f after]" ),
+			NumLowQualityTetrahedra,
+			NumFlips,
+			RemovedTetrahedra.Num(),
+			NewTetrahedra.Num(),
+			QualityBefore,
+			QualityAfter
+			);
+
+	return true;
+}
+
+void UTendrModelTetraGeneratorComponent::CancelBuild()
+{
+	bBuildCancelled = true;
+}
+
+bool UTendrModelTetraGeneratorComponent::UpdateBuildProgress( const FString& Stage, float Fraction )
+{
+	if( bBuildSlowTask )
+	{
+		GWarn->StatusUpdate( FMath::RoundToInt( Fraction * 100 ), 100, FText::FromString( FString::Printf( TEXT( "Building Tendr model (%s)" ), *Stage ) ) );
+		if( GWarn->ReceivedUserCancel() )
+		{
+			bBuildCancelled = true;
+		}
+	}
+
+	if( ProgressFunction && !ProgressFunction( Stage, Fraction ) )
+	{
+		bBuildCancelled = true;
+	}
+
+	return !bBuildCancelled;
+}
+
+bool UTendrModelTetraGeneratorComponent::ConnectivityAddNeighbour( FTendrModelData& ModelData, uint32 Src, uint32 Dst, uint32& MaxNeighbours )
+{
+	uint32 * SrcIndices = ModelData.Connectivity[ Src ].NeighbourIndices;
+
+	// Ensure index is not already added
+	for(uint8 i = 0; i < FTendrVertexConnectivityData::MaxNeighbours; ++i)
+	{
+		if(SrcIndices[ i ] == Dst)
+		{
+			// Already added, return
+			return true;
+		}
+		else if(SrcIndices[ i ] == InvalidIndex)
+		{
+			// Reached the end, insert here
+			MaxNeighbours = MaxNeighbours > i ? MaxNeighbours : i;
+			SrcIndices[ i ] = Dst;
+			return true;
+		}
+	}
+
+	// Could not add, neighbour array full
+	UE_LOG( TendrModelTetraLog, Log, TEXT( "FTendrVertexConnectivity: Neighbour overflow" ) );
+	return false;
+}
+
+void UTendrModelTetraGeneratorComponent::ConnectivityRemoveNeighbour( FTendrModelData& ModelData, uint32 Src, uint32 Dst )
+{
+	uint32 * SrcIndices = ModelData.Connectivity[ Src ].NeighbourIndices;
+
+	for(uint8 i = 0; i < FTendrVertexConnectivityData::MaxNeighbours && SrcIndices[ i ] != InvalidIndex; ++i)
+	{
+		if(SrcIndices[ i ] == Dst)
+		{
+			// Move the following neighbours down to keep the indices contiguous
+			for(; i + 1 < FTendrVertexConnectivityData::MaxNeighbours && SrcIndices[ i + 1 ] != InvalidIndex; ++i)
+			{
+				SrcIndices[ i ] = SrcIndices[ i + 1 ];
+			}
+			SrcIndices[ i ] = InvalidIndex;
+			return;
+		}
+	}
+}
+
+void UTendrModelTetraGeneratorComponent::UpdateEdges( FTendrModelData& ModelData, const TArray<uint64>& RemovedEdges, const TArray<uint64>& AddedEdges, FTendrModelDelta& OutDelta )
+{
+	// Edges, merged into the sorted edge list in a single pass
+	const int32 NumEdges = ModelData.EdgeRestLengths.Num();
+	TArray<uint32> EdgeIndices;
+	TArray<float> EdgeRestLengths;
+	EdgeIndices.Reserve( ( NumEdges + AddedEdges.Num() ) * 2 );
+	EdgeRestLengths.Reserve( NumEdges + AddedEdges.Num() );
+
+	int32 NextAdded = 0;
+	int32 NextRemoved = 0;
+	for(int i = 0; i <= NumEdges; ++i)
+	{
+		const uint64 Edge = ( i < NumEdges ) ? ( ( (uint64)ModelData.EdgeIndices[ i * 2 + 0 ] << 32 ) | (uint64)ModelData.EdgeIndices[ i * 2 + 1 ] ) : MAX_uint64;
+		for(; NextAdded < AddedEdges.Num() && AddedEdges[ NextAdded ] < Edge; ++NextAdded)
+		{
+			const uint32 a = (uint32)( AddedEdges[ NextAdded ] >> 32 );
+			const uint32 b = (uint32)( AddedEdges[ NextAdded ] & 0xFFFFFFFF );
+			EdgeIndices.Add( a );
+			EdgeIndices.Add( b );
+			EdgeRestLengths.Add( FVector::Dist( FVector( ModelData.VerticesPhysics[ a ] ), FVector( ModelData.VerticesPhysics[ b ] ) ) );
+		}
+		if( i == NumEdges )
+		{
+			break;
+		}
+
+		for(; NextRemoved < RemovedEdges.Num() && RemovedEdges[ NextRemoved ] < Edge; ++NextRemoved);
+		if( NextRemoved < RemovedEdges.Num() && RemovedEdges[ NextRemoved ] == Edge )
+		{
+			continue;
+		}
+		EdgeIndices.Add( ModelData.EdgeIndices[ i * 2 + 0 ] );
+		EdgeIndices.Add( ModelData.EdgeIndices[ i * 2 + 1 ] );
+		EdgeRestLengths.Add( ModelData.EdgeRestLengths[ i ] );
+	}
+
+	ModelData.EdgeIndices = MoveTemp( EdgeIndices );
+	ModelData.EdgeRestLengths = MoveTemp( EdgeRestLengths );
+
+	// Connectivity
+	TSet<uint32> ChangedConnectivity;
+	uint32 MaxNeighbours = 0;
+	for(int i = 0; i < RemovedEdges.Num(); ++i)
+	{
+		const uint32 a = (uint32)( RemovedEdges[ i ] >> 32 );
+		const uint32 b = (uint32)( RemovedEdges[ i ] & 0xFFFFFFFF );
+		ConnectivityRemoveNeighbour( ModelData, a, b );
+		ConnectivityRemoveNeighbour( ModelData, b, a );
+		ChangedConnectivity.Add( a );
+		ChangedConnectivity.Add( b );
+		OutDelta.RemovedEdges.Add( a );
+		OutDelta.RemovedEdges.Add( b );
+	}
+	for(int i = 0; i < AddedEdges.Num(); ++i)
+	{
+		const uint32 a = (uint32)( AddedEdges[ i ] >> 32 );
+		const uint32 b = (uint32)( AddedEdges[ i ] & 0xFFFFFFFF );
+		ConnectivityAddNeighbour( ModelData, a, b, MaxNeighbours );
+		ConnectivityAddNeighbour( ModelData, b, a, MaxNeighbours );
+		ChangedConnectivity.Add( a );
+		ChangedConnectivity.Add( b );
+		OutDelta.AddedEdges.Add( a );
+		OutDelta.AddedEdges.Add( b );
+	}
+	OutDelta.ChangedConnectivity = ChangedConnectivity.Array();
+	OutDelta.ChangedConnectivity.Sort();
+}
+
+void UTendrModelTetraGeneratorComponent::OptimizeVertexCache( TArray<uint32>& Indices, uint32 NumVertices )
+{
+	TENDR_TRACE_SCOPE( "OptimizeVertexCache" );
+
+	const int32 NumTriangles = Indices.Num() / 3;
+
+	// Triangles of each vertex, of which the first NumLiveTriangles have not been drawn yet
+	TArray<int32> AdjacencyOffsets;
+	TArray<int32> Adjacency;
+	TArray<int32> NumLiveTriangles;
+	AdjacencyOffsets.Init( 0, NumVertices + 1 );
+	NumLiveTriangles.Init( 0, NumVertices );
+	Adjacency.SetNumUninitialized( Indices.Num() );
+	for(int i = 0; i < Indices.Num(); ++i)
+	{
+		++AdjacencyOffsets[ Indices[ i ] + 1 ];
+	}
+	for(uint32 v = 0; v < NumVertices; ++v)
+	{
+		AdjacencyOffsets[ v + 1 ] += AdjacencyOffsets[ v ];
+	}
+	for(int i = 0; i < Indices.Num(); ++i)
+	{
+		uint32 v = Indices[ i ];
+		Adjacency[ AdjacencyOffsets[ v ] + NumLiveTriangles[ v ]++ ] = i / 3;
+	}
+
+	TArray<int32> CachePositions;
+	TArray<float> VertexScores;
+	CachePositions.Init( -1, NumVertices );
+	VertexScores.SetNumUninitialized( NumVertices );
+	for(uint32 v = 0; v < NumVertices; ++v)
+	{
+		VertexScores[ v ] = VertexCacheScore( -1, NumLiveTriangles[ v ] );
+	}
+
+	TArray<bool> Drawn;
+	Drawn.Init( false, NumTriangles );
+
+	TArray<uint32> Output;
+	Output.Reserve( Indices.Num() );
+
+	// Cache with room for the vertices of the next triangle
+	uint32 Cache[ VERTEX_CACHE_SIZE + 3 ];
+	int32 CacheSize = 0;
+
+	int32 BestTriangle = -1;
+	int32 NextTriangle = 0;
+	for(int n = 0; n < NumTriangles; ++n)
+	{
+		if( BestTriangle < 0 )
+		{
+			// No triangles left around the cached vertices, continue with the next triangle in input order
+			while( Drawn[ NextTriangle ] )
+			{
+				++NextTriangle;
+			}
+			BestTriangle = NextTriangle;
+		}
+
+		// Draw the triangle
+		uint32 Triangle[ 3 ] = { Indices[ BestTriangle * 3 + 0 ], Indices[ BestTriangle * 3 + 1 ], Indices[ BestTriangle * 3 + 2 ] };
+		Output.Add( Triangle[ 0 ] );
+		Output.Add( Triangle[ 1 ] );
+		Output.Add( Triangle[ 2 ] );
+		Drawn[ BestTriangle ] = true;
+
+		// Remove it from the live triangles of its vertices
+		for(int k = 0; k < 3; ++k)
+		{
+			int32* Live = &Adjacency[ AdjacencyOffsets[ Triangle[ k ] ] ];
+			int32& NumLive = NumLiveTriangles[ Triangle[ k ] ];
+			for(int j = 0; j < NumLive; ++j)
+			{
+				if( Live[ j ] == BestTriangle )
+				{
+					Live[ j ] = Live[ --NumLive ];
+					break;
+				}
+			}
+		}
+
+		// Move its vertices to the front of the cache, pushing out the least recently used vertices
+		uint32 NewCache[ VERTEX_CACHE_SIZE + 3 ];
+		int32 NewCacheSize = 0;
+		for(int k = 0; k < 3; ++k)
+		{
+			NewCache[ NewCacheSize++ ] = Triangle[ k ];
+		}
+		for(int j = 0; j < CacheSize; ++j)
+		{
+			uint32 v = Cache[ j ];
+			if( v != Triangle[ 0 ] && v != Triangle[ 1 ] && v != Triangle[ 2 ] )
+			{
+				NewCache[ NewCacheSize++ ] = v;
+			}
+		}
+		for(int j = VERTEX_CACHE_SIZE; j < NewCacheSize; ++j)
+		{
+			CachePositions[ NewCache[ j ] ] = -1;
+			VertexScores[ NewCache[ j ] ] = VertexCacheScore( -1, NumLiveTriangles[ NewCache[ j ] ] );
+		}
+		CacheSize = FMath::Min( NewCacheSize, VERTEX_CACHE_SIZE );
+		for(int j = 0; j < CacheSize; ++j)
+		{
+			uint32 v = NewCache[ j ];
+			Cache[ j ] = v;
+			CachePositions[ v ] = j;
+			VertexScores[ v ] = VertexCacheScore( j, NumLiveTriangles[ v ] );
+		}
+
+		// Pick the best scoring triangle around the cached vertices
+		BestTriangle = -1;
+		float BestScore = -1.0f;
+		for(int j = 0; j < CacheSize; ++j)
+		{
+			uint32 v = Cache[ j ];
+			const int32* Live = &Adjacency[ AdjacencyOffsets[ v ] ];
+			for(int l = 0; l < NumLiveTriangles[ v ]; ++l)
+			{
+				int32 t = Live[ l ];
+				float Score = VertexScores[ Indices[ t * 3 + 0 ] ] + VertexScores[ Indices[ t * 3 + 1 ] ] + VertexScores[ Indices[ t * 3 + 2 ] ];
+				if( Score > BestScore )
+				{
+					BestScore = Score;
+					BestTriangle = t;
+				}
+			}
+		}
+	}
+
+	Indices = MoveTemp( Output );
+}
+
+void UTendrModelTetraGeneratorComponent::OptimizeOverdraw( TArray<uint32>& Indices, const FTendrModelData& ModelData )
+{
+	TENDR_TRACE_SCOPE( "OptimizeOverdraw" );
+
+	const int32 NumTriangles = Indices.Num() / 3;
+	if( NumTriangles == 0 )
+	{
+		return;
+	}
+
+	//
+	// Simulated FIFO vertex cache, a vertex is cached if it was added less than VERTEX_CACHE_SIZE misses ago
+	//
+	TArray<int32> CacheTimestamps;
+	CacheTimestamps.Init( 0, ModelData.MappingSurfaceToCoarse.Num() );
+	int32 CacheTime = VERTEX_CACHE_SIZE + 1;
+
+	auto FnCacheMisses = [ &Indices, &CacheTimestamps, &CacheTime ]( int32 Triangle )
+	{
+		int32 Misses = 0;
+		for(int k = 0; k < 3; ++k)
+		{
+			uint32 v = Indices[ Triangle * 3 + k ];
+			if( CacheTime - CacheTimestamps[ v ] > VERTEX_CACHE_SIZE )
+			{
+				CacheTimestamps[ v ] = CacheTime++;
+				++Misses;
+			}
+		}
+		return Misses;
+	};
+	auto FnCacheFlush = [ &CacheTime ]()
+	{
+		CacheTime += VERTEX_CACHE_SIZE + 1;
+	};
+
+	//
+	// Clusters
+	//
+	// Hard boundaries are where the vertex cache optimization started over (all vertices missed), so these clusters can be reordered freely.
+	// Each of these is split further wherever the cache miss rate so far is not (much) worse than that of the entire cluster.
+	//
+	TArray<int32> HardClusters;
+	for(int i = 0; i < NumTriangles; ++i)
+	{
+		if( FnCacheMisses( i ) == 3 )
+		{
+			HardClusters.Add( i );
+		}
+	}
+	HardClusters.Add( NumTriangles );
+
+	TArray<int32> Clusters;
+	for(int c = 0; c + 1 < HardClusters.Num(); ++c)
+	{
+		const int32 Start = HardClusters[ c ];
+		const int32 End = HardClusters[ c + 1 ];
+
+		FnCacheFlush();
+		int32 ClusterMisses = 0;
+		for(int i = Start; i < End; ++i)
+		{
+			ClusterMisses += FnCacheMisses( i );
+		}
+		const float Threshold = OVERDRAW_CLUSTER_THRESHOLD * ClusterMisses / ( End - Start );
+
+		FnCacheFlush();
+		Clusters.Add( Start );
+		int32 RunningMisses = 0;
+		int32 RunningTriangles = 0;
+		for(int i = Start; i < End; ++i)
+		{
+			RunningMisses += FnCacheMisses( i );
+			++RunningTriangles;
+
+			if( i + 1 < End && RunningMisses <= Threshold * RunningTriangles )
+			{
+				FnCacheFlush();
+				Clusters.Add( i + 1 );
+				RunningMisses = 0;
+				RunningTriangles = 0;
+			}
+		}
+	}
+	Clusters.Add( NumTriangles );
+
+	//
+	// Sort the clusters by how much they face away from the center of the model, so these are drawn first and occlude the rest
+	//
+	struct FCluster
+	{
+		int32 Start;
+		int32 End;
+		FVector Centroid;
+		FVector Normal;
+		float Area;
+		float Key;
+	};
+
+	TArray<FCluster> SortClusters;
+	SortClusters.SetNumUninitialized( Clusters.Num() - 1 );
+
+	FVector ModelCentroid( 0, 0, 0 );
+	float ModelArea = 0;
+	for(int c = 0; c < SortClusters.Num(); ++c)
+	{
+		FCluster& Cluster = SortClusters[ c ];
+		Cluster.Start = Clusters[ c ];
+		Cluster.End = Clusters[ c + 1 ];
+		Cluster.Centroid = FVector( 0, 0, 0 );
+		Cluster.Normal = FVector( 0, 0, 0 );
+
+		// Area weighted centroid and normal
+		Cluster.Area = 0;
+		for(int i = Cluster.Start; i < Cluster.End; ++i)
+		{
+			FVector A( ModelData.Vertices[ ModelData.MappingSurfaceToCoarse[ Indices[ i * 3 + 0 ] ] ] );
+			FVector B( ModelData.Vertices[ ModelData.MappingSurfaceToCoarse[ Indices[ i * 3 + 1 ] ] ] );
+			FVector C( ModelData.Vertices[ ModelData.MappingSurfaceToCoarse[ Indices[ i * 3 + 2 ] ] ] );
+
+			FVector Normal = ( B - A ) ^ ( C - A );
+			float TriangleArea = Normal.Size();
+
+			Cluster.Centroid += ( A + B + C ) * ( TriangleArea / 3.0f );
+			Cluster.Normal += Normal;
+			Cluster.Area += TriangleArea;
+		}
+
+		ModelCentroid += Cluster.Centroid;
+		ModelArea += Cluster.Area;
+
+		if( Cluster.Area > 0 )
+		{
+			Cluster.Centroid /= Cluster.Area;
+		}
+		Cluster.Normal.Normalize();
+	}
+	if( ModelArea > 0 )
+	{
+		ModelCentroid /= ModelArea;
+	}
+
+	// The sign of the area weighted sum of all keys is that of the winding order, so outward facing clusters always get the highest key
+	float KeySum = 0;
+	for(int c = 0; c < SortClusters.Num(); ++c)
+	{
+		FCluster& Cluster = SortClusters[ c ];
+		Cluster.Key = ( Cluster.Centroid - ModelCentroid ) | Cluster.Normal;
+		KeySum += Cluster.Key * Cluster.Area;
+	}
+	const float KeySign = ( KeySum < 0 ) ? -1.0f : 1.0f;
+
+	SortClusters.StableSort( [ KeySign ]( const FCluster& A, const FCluster& B )
+	{
+		return A.Key * KeySign > B.Key * KeySign;
+	} );
+
+	TArray<uint32> Output;
+	Output.Reserve( Indices.Num() );
+	for(int c = 0; c < SortClusters.Num(); ++c)
+	{
+		for(int i = SortClusters[ c ].Start * 3; i < SortClusters[ c ].End * 3; ++i)
+		{
+			Output.Add( Indices[ i ] );
+		}
+	}
+
+	UE_LOG( TendrModelTetraLog, Log, TEXT( "Overdraw pass: %u surface triangle clusters have been sorted" ), SortClusters.Num() );
+
+	Indices = MoveTemp( Output );
+}
+
+void UTendrModelTetraGeneratorComponent::OptimizeVertexFetch( FTendrModelData& ModelData )
+{
+	TENDR_TRACE_SCOPE( "OptimizeVertexFetch" );
+
+	const int32 NumCoarse = ModelData.Vertices.Num();
+
+	// Surface vertices in order of first use, followed by the other coarse vertices in their current order
+	TArray<uint32> CoarseOrder;
+	TArray<uint32> SurfaceRemap;
+	CoarseOrder.Reserve( NumCoarse );
+	SurfaceRemap.Init( InvalidIndex, ModelData.MappingSurfaceToCoarse.Num() );
+	for(int i = 0; i < ModelData.SurfaceIndices.Num(); ++i)
+	{
+		uint32& Index = ModelData.SurfaceIndices[ i ];
+		if( SurfaceRemap[ Index ] == InvalidIndex )
+		{
+			SurfaceRemap[ Index ] = CoarseOrder.Add( ModelData.MappingSurfaceToCoarse[ Index ] );
+		}
+		Index = SurfaceRemap[ Index ];
+	}
+
+	TArray<uint32> CoarseRemap;
+	CoarseRemap.Init( InvalidIndex, NumCoarse );
+	for(int i = 0; i < CoarseOrder.Num(); ++i)
+	{
+		CoarseRemap[ CoarseOrder[ i ] ] = i;
+	}
+	for(int i = 0; i < NumCoarse; ++i)
+	{
+		if( CoarseRemap[ i ] == InvalidIndex )
+		{
+			CoarseRemap[ i ] = CoarseOrder.Add( i );
+		}
+	}
+
+	// Reorder all coarse vertex data
+	PermuteArray( ModelData.Vertices, CoarseOrder );
+	for(uint32 t = 0; t < MAX_TEXCOORDS; ++t)
+	{
+		PermuteArray( ModelData.TexCoords[ t ], CoarseOrder );
+	}
+	PermuteArray( ModelData.Tangents, CoarseOrder );
+	PermuteArray( ModelData.VerticesSurfaceIndicators, CoarseOrder );
+	PermuteArray( ModelData.MappingCoarseToSparse, CoarseOrder );
+
+	for(int i = 0; i < ModelData.Indices.Num(); ++i)
+	{
+		ModelData.Indices[ i ] = CoarseRemap[ ModelData.Indices[ i ] ];
+	}
+
+	// Surface vertex i is now coarse vertex i
+	for(int i = 0; i < ModelData.MappingSurfaceToCoarse.Num(); ++i)
+	{
+		ModelData.MappingSurfaceToCoarse[ i ] = i;
+	}
 }
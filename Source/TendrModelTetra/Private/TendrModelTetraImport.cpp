@@ -0,0 +1,1026 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TendrModelTetraPlugin                                                     //
+//                                                                           //
+// A Tendr model generator plugin for use with Unreal Engine in combination  //
+// with the Tendr Dynamics soft-body physics plugin.                         //
+//                                                                           //
+// Version 1.0                                                               //
+// January, 2015                                                             //
+//                                                                           //
+// Copyright (C) 2014-2015, Tendr Dynamics B.V.                              //
+//                                                                           //
+// Visit http://tendrdynamics.com for more information.                      //
+//                                                                           //
+// This file is governed by copyrights as described in the LICENSE file.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TendrModelTetraPluginPrivatePCH.h"
+#include "TendrModelTetraImport.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Configuration
+//
+
+//
+// Number of bytes of a text file parsed per work item
+//
+#define IMPORT_TEXT_CHUNK_SIZE ( 1 << 20 )
+
+//
+// Number of elements (vertices, triangles or faces) of a binary file parsed per work item
+//
+#define IMPORT_BINARY_CHUNK_SIZE ( 1 << 16 )
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Memory mapped file
+//
+
+class FTendrMappedFile
+{
+public:
+	FTendrMappedFile()
+		: Data( nullptr )
+		, Size( 0 )
+		, bMapped( false )
+	{
+	}
+
+	~FTendrMappedFile()
+	{
+		if( bMapped )
+		{
+#if PLATFORM_WINDOWS
+			UnmapViewOfFile( Data );
+#elif PLATFORM_LINUX || PLATFORM_MAC
+			munmap( (void*)Data, Size );
+#endif
+		}
+	}
+
+	/** Maps a file read-only (or reads it where mapping is not available), returns false if it could not be opened **/
+	bool Open( const FString& Filename )
+	{
+#if PLATFORM_WINDOWS
+		HANDLE File = CreateFileW( *Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if( File == INVALID_HANDLE_VALUE )
+		{
+			return false;
+		}
+		LARGE_INTEGER FileSize;
+		bool bOpened = GetFileSizeEx( File, &FileSize ) != 0;
+		Size = FileSize.QuadPart;
+		if( bOpened && Size > 0 )
+		{
+			// The view keeps the mapping open
+			HANDLE Mapping = CreateFileMappingW( File, nullptr, PAGE_READONLY, 0, 0, nullptr );
+			Data = Mapping ? (const uint8*)MapViewOfFile( Mapping, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+			bMapped = Data != nullptr;
+			bOpened = bMapped;
+			if( Mapping )
+			{
+				CloseHandle( Mapping );
+			}
+		}
+		CloseHandle( File );
+		return bOpened;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+		int File = open( TCHAR_TO_UTF8( *Filename ), O_RDONLY );
+		if( File < 0 )
+		{
+			return false;
+		}
+		struct stat FileStat;
+		bool bOpened = fstat( File, &FileStat ) == 0;
+		Size = FileStat.st_size;
+		if( bOpened && Size > 0 )
+		{
+			void* Mapped = mmap( nullptr, Size, PROT_READ, MAP_PRIVATE, File, 0 );
+			bMapped = Mapped != MAP_FAILED;
+			bOpened = bMapped;
+			if( bMapped )
+			{
+				// The chunks are read concurrently, so read ahead over the whole file
+				madvise( Mapped, Size, MADV_WILLNEED );
+				Data = (const uint8*)Mapped;
+			}
+		}
+		close( File );
+		return bOpened;
+#else
+		if( !FFileHelper::LoadFileToArray( Buffer, *Filename ) )
+		{
+			return false;
+		}
+		Data = Buffer.GetData();
+		Size = Buffer.Num();
+		return true;
+#endif
+	}
+
+	const uint8* Data;
+	int64 Size;
+
+private:
+	bool bMapped;
+	TArray<uint8> Buffer;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Text parsing
+//
+
+static inline bool IsSpace( ANSICHAR C )
+{
+	return C == ' ' || C == '\t' || C == '\r';
+}
+
+static inline bool IsDigit( ANSICHAR C )
+{
+	return C >= '0' && C <= '9';
+}
+
+static inline void SkipSpace( const ANSICHAR*& Cursor, const ANSICHAR* End )
+{
+	while( Cursor < End && IsSpace( *Cursor ) )
+	{
+		++Cursor;
+	}
+}
+
+static inline void SkipToken( const ANSICHAR*& Cursor, const ANSICHAR* End )
+{
+	while( Cursor < End && !IsSpace( *Cursor ) )
+	{
+		++Cursor;
+	}
+}
+
+//
+// Parses a decimal number (without locale, hexadecimal, infinity or NaN) after spaces, returns false if there is none.
+// Up to 18 significant digits are accumulated as an integer, which is scaled exactly for exponents of at most 22.
+//
+static bool ParseFloat( const ANSICHAR*& Cursor, const ANSICHAR* End, float& OutValue )
+{
+	static const double PowersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const ANSICHAR* P = Cursor;
+	SkipSpace( P, End );
+
+	bool bNegative = false;
+	if( P < End && ( *P == '-' || *P == '+' ) )
+	{
+		bNegative = *P == '-';
+		++P;
+	}
+
+	uint64 Mantissa = 0;
+	int32 Exponent = 0;
+	int32 NumDigits = 0;
+	for(; P < End && IsDigit( *P ); ++P, ++NumDigits)
+	{
+		if( Mantissa < 100000000000000000ull )
+		{
+			Mantissa = Mantissa * 10 + ( *P - '0' );
+		}
+		else
+		{
+			++Exponent;
+		}
+	}
+	if( P < End && *P == '.' )
+	{
+		for(++P; P < End && IsDigit( *P ); ++P, ++NumDigits)
+		{
+			if( Mantissa < 100000000000000000ull )
+			{
+				Mantissa = Mantissa * 10 + ( *P - '0' );
+				--Exponent;
+			}
+		}
+	}
+	if( NumDigits == 0 )
+	{
+		return false;
+	}
+
+	if( P < End && ( *P == 'e' || *P == 'E' ) )
+	{
+		const ANSICHAR* E = P + 1;
+		bool bNegativeExponent = false;
+		if( E < End && ( *E == '-' || *E == '+' ) )
+		{
+			bNegativeExponent = *E == '-';
+			++E;
+		}
+		if( E < End && IsDigit( *E ) )
+		{
+			int32 ExplicitExponent = 0;
+			for(; E < End && IsDigit( *E ); ++E)
+			{
+				ExplicitExponent = FMath::Min( ExplicitExponent * 10 + ( *E - '0' ), 100000 );
+			}
+			Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+			P = E;
+		}
+	}
+
+	double Value = (double)Mantissa;
+	if( Mantissa != 0 )
+	{
+		if( Exponent >= 0 )
+		{
+			Value = Exponent <= 22 ? Value * PowersOfTen[ Exponent ] : Value * pow( 10.0, Exponent );
+		}
+		else
+		{
+			Value = Exponent >= -22 ? Value / PowersOfTen[ -Exponent ] : Value * pow( 10.0, Exponent );
+		}
+	}
+
+	OutValue = (float)( bNegative ? -Value : Value );
+	Cursor = P;
+	return true;
+}
+
+//
+// Parses a decimal integer after spaces, returns false if there is none
+//
+static bool ParseInteger( const ANSICHAR*& Cursor, const ANSICHAR* End, int64& OutValue )
+{
+	const ANSICHAR* P = Cursor;
+	SkipSpace( P, End );
+
+	bool bNegative = false;
+	if( P < End && ( *P == '-' || *P == '+' ) )
+	{
+		bNegative = *P == '-';
+		++P;
+	}
+	if( P == End || !IsDigit( *P ) )
+	{
+		return false;
+	}
+
+	int64 Value = 0;
+	for(; P < End && IsDigit( *P ); ++P)
+	{
+		Value = FMath::Min( Value * 10 + ( *P - '0' ), (int64)MAX_int32 );
+	}
+
+	OutValue = bNegative ? -Value : Value;
+	Cursor = P;
+	return true;
+}
+
+//
+// Splits text into chunks of whole lines of about IMPORT_TEXT_CHUNK_SIZE bytes, returns the start of each chunk followed by the end of the text
+//
+static TArray<const ANSICHAR*> GetTextChunks( const ANSICHAR* Begin, const ANSICHAR* End )
+{
+	TArray<const ANSICHAR*> Chunks;
+	Chunks.Add( Begin );
+	while( End - Chunks.Last() > IMPORT_TEXT_CHUNK_SIZE )
+	{
+		const ANSICHAR* Split = Chunks.Last() + IMPORT_TEXT_CHUNK_SIZE;
+		const ANSICHAR* LineEnd = (const ANSICHAR*)memchr( Split, '\n', End - Split );
+		if( LineEnd == nullptr )
+		{
+			break;
+		}
+		Chunks.Add( LineEnd + 1 );
+	}
+	Chunks.Add( End );
+	return Chunks;
+}
+
+//
+// Calls a function with the start and end of every line from Begin to End (the line ends are found with memchr, which is vectorized by the C runtimes)
+//
+template<typename FnLine>
+static void ForEachLine( const ANSICHAR* Begin, const ANSICHAR* End, FnLine Line )
+{
+	while( Begin < End )
+	{
+		const ANSICHAR* LineEnd = (const ANSICHAR*)memchr( Begin, '\n', End - Begin );
+		LineEnd = LineEnd ? LineEnd : End;
+		Line( Begin, LineEnd );
+		Begin = LineEnd + 1;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// File formats
+//
+// Each reader returns the positions and the triangles (indices into the positions) as they are in the file, or an error.
+//
+
+//
+// Binary STL, a header of 80 bytes and the number of triangles, followed by 50 bytes per triangle (normal, three corners and an attribute)
+//
+static bool ReadStl( const FTendrMappedFile& File, TArray<FVector>& OutPositions, TArray<uint32>& OutIndices, FString& OutError )
+{
+	const int64 HeaderSize = 84;
+	const int64 TriangleSize = 50;
+
+	uint32 NumTriangles = 0;
+	if( File.Size >= HeaderSize )
+	{
+		FMemory::Memcpy( &NumTriangles, File.Data + 80, sizeof( uint32 ) );
+	}
+	if( File.Size < HeaderSize || File.Size != HeaderSize + NumTriangles * TriangleSize )
+	{
+		OutError = ( File.Size >= 5 && FMemory::Memcmp( File.Data, "solid", 5 ) == 0 ) ? TEXT( "ASCII STL files are not supported" ) : TEXT( "Invalid binary STL file size" );
+		return false;
+	}
+
+	OutPositions.SetNumUninitialized( NumTriangles * 3 );
+	OutIndices.SetNumUninitialized( NumTriangles * 3 );
+	const int32 NumChunks = FMath::DivideAndRoundUp( (int32)NumTriangles, IMPORT_BINARY_CHUNK_SIZE );
+	ParallelFor( NumChunks, [ & ]( int32 Chunk )
+	{
+		const int32 First = Chunk * IMPORT_BINARY_CHUNK_SIZE;
+		const int32 Last = FMath::Min( First + IMPORT_BINARY_CHUNK_SIZE, (int32)NumTriangles );
+		for(int32 i = First; i < Last; ++i)
+		{
+			FMemory::Memcpy( &OutPositions[ i * 3 ], File.Data + HeaderSize + i * TriangleSize + 12, 3 * sizeof( FVector ) );
+			OutIndices[ i * 3 + 0 ] = i * 3 + 0;
+			OutIndices[ i * 3 + 1 ] = i * 3 + 1;
+			OutIndices[ i * 3 + 2 ] = i * 3 + 2;
+		}
+	} );
+	return true;
+}
+
+//
+// Binary PLY (either byte order), the x, y and z properties of the vertex element and the vertex_indices (or vertex_index) list of the face
+// element, other elements and properties are skipped
+//
+struct FPlyProperty
+{
+	FString Name;
+
+	// Type of the value, or of the items if this is a list
+	int32 Type;
+
+	// Type of the number of items if this is a list, or INDEX_NONE
+	int32 CountType;
+};
+
+struct FPlyElement
+{
+	FString Name;
+	int64 Count;
+	TArray<FPlyProperty> Properties;
+};
+
+static const ANSICHAR* PlyTypeNames[] = { "char", "uchar", "short", "ushort", "int", "uint", "float", "double", "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64" };
+static const int32 PlyTypeSizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+static inline double ReadPlyValue( const uint8* Data, int32 Type, bool bSwap )
+{
+	uint8 Bytes[ 8 ];
+	const int32 Size = PlyTypeSizes[ Type ];
+	for(int32 b = 0; b < Size; ++b)
+	{
+		Bytes[ b ] = Data[ bSwap ? Size - 1 - b : b ];
+	}
+	switch( Type )
+	{
+	case 0: return *(const int8*)Bytes;
+	case 1: return *(const uint8*)Bytes;
+	case 2: return *(const int16*)Bytes;
+	case 3: return *(const uint16*)Bytes;
+	case 4: return *(const int32*)Bytes;
+	case 5: return *(const uint32*)Bytes;
+	case 6: return *(const float*)Bytes;
+	default: return *(const double*)Bytes;
+	}
+}
+
+//
+// Returns the end of the first NumProperties properties of the element at Data, or nullptr if they do not fit before End
+//
+static inline const uint8* SkipPlyProperties( const FPlyElement& Element, int32 NumProperties, const uint8* Data, const uint8* End, bool bSwap )
+{
+	for(int32 p = 0; p < NumProperties; ++p)
+	{
+		const FPlyProperty& Property = Element.Properties[ p ];
+		int64 Count = 1;
+		if( Property.CountType != INDEX_NONE )
+		{
+			if( Data + PlyTypeSizes[ Property.CountType ] > End )
+			{
+				return nullptr;
+			}
+			Count = (int64)ReadPlyValue( Data, Property.CountType, bSwap );
+			Data += PlyTypeSizes[ Property.CountType ];
+		}
+		if( Count < 0 || Count * PlyTypeSizes[ Property.Type ] > End - Data )
+		{
+			return nullptr;
+		}
+		Data += Count * PlyTypeSizes[ Property.Type ];
+	}
+	return Data;
+}
+
+//
+// Returns the end of the element at Data, or nullptr if it does not fit before End
+//
+static inline const uint8* SkipPlyElement( const FPlyElement& Element, const uint8* Data, const uint8* End, bool bSwap )
+{
+	return SkipPlyProperties( Element, Element.Properties.Num(), Data, End, bSwap );
+}
+
+static bool ReadPly( const FTendrMappedFile& File, TArray<FVector>& OutPositions, TArray<uint32>& OutIndices, FString& OutError )
+{
+	const ANSICHAR* Text = (const ANSICHAR*)File.Data;
+	const ANSICHAR* TextEnd = Text + File.Size;
+	if( File.Size < 4 || FMemory::Memcmp( Text, "ply", 3 ) != 0 || !( Text[ 3 ] == '\n' || Text[ 3 ] == '\r' ) )
+	{
+		OutError = TEXT( "Not a PLY file" );
+		return false;
+	}
+
+	//
+	// Header
+	//
+	TArray<FPlyElement> Elements;
+	bool bSwap = false;
+	const uint8* Data = nullptr;
+	for(const ANSICHAR* Line = Text; Line < TextEnd && Data == nullptr;)
+	{
+		const ANSICHAR* LineEnd = (const ANSICHAR*)memchr( Line, '\n', TextEnd - Line );
+		if( LineEnd == nullptr )
+		{
+			break;
+		}
+
+		TArray<FString> Tokens;
+		FString( (int32)( LineEnd - Line ), Line ).ParseIntoArrayWS( Tokens );
+		Line = LineEnd + 1;
+		if( Tokens.Num() == 0 )
+		{
+			continue;
+		}
+
+		if( Tokens[ 0 ] == TEXT( "format" ) && Tokens.Num() >= 2 )
+		{
+			if( Tokens[ 1 ] != TEXT( "binary_little_endian" ) && Tokens[ 1 ] != TEXT( "binary_big_endian" ) )
+			{
+				OutError = TEXT( "ASCII PLY files are not supported" );
+				return false;
+			}
+			bSwap = ( Tokens[ 1 ] == TEXT( "binary_big_endian" ) ) == PLATFORM_LITTLE_ENDIAN;
+		}
+		else if( Tokens[ 0 ] == TEXT( "element" ) && Tokens.Num() >= 3 )
+		{
+			FPlyElement& Element = Elements[ Elements.AddDefaulted() ];
+			Element.Name = Tokens[ 1 ];
+			Element.Count = FCString::Atoi64( *Tokens[ 2 ] );
+		}
+		else if( Tokens[ 0 ] == TEXT( "property" ) && Elements.Num() > 0 )
+		{
+			const bool bList = Tokens.Num() >= 5 && Tokens[ 1 ] == TEXT( "list" );
+			if( Tokens.Num() < ( bList ? 5 : 3 ) )
+			{
+				OutError = TEXT( "Invalid PLY property" );
+				return false;
+			}
+
+			auto FnType = [ & ]( const FString& Name )
+			{
+				for(int32 t = 0; t < (int32)ARRAY_COUNT( PlyTypeNames ); ++t)
+				{
+					if( Name == ANSI_TO_TCHAR( PlyTypeNames[ t ] ) )
+					{
+						return (int32)( t % ARRAY_COUNT( PlyTypeSizes ) );
+					}
+				}
+				return (int32)INDEX_NONE;
+			};
+
+			FPlyProperty Property;
+			Property.Name = Tokens.Last();
+			Property.Type = FnType( Tokens[ bList ? 3 : 1 ] );
+			Property.CountType = bList ? FnType( Tokens[ 2 ] ) : INDEX_NONE;
+			if( Property.Type == INDEX_NONE || ( bList && Property.CountType == INDEX_NONE ) )
+			{
+				OutError = FString::Printf( TEXT( "Unknown PLY property type of %s" ), *Property.Name );
+				return false;
+			}
+			Elements.Last().Properties.Add( Property );
+		}
+		else if( Tokens[ 0 ] == TEXT( "end_header" ) )
+		{
+			Data = (const uint8*)Line;
+		}
+	}
+	if( Data == nullptr )
+	{
+		OutError = TEXT( "Missing end of PLY header" );
+		return false;
+	}
+
+	//
+	// Elements
+	//
+	const uint8* End = File.Data + File.Size;
+	int64 NumVertices = 0;
+	bool bFaces = false;
+	for(const FPlyElement& Element : Elements)
+	{
+		if( Element.Name == TEXT( "vertex" ) )
+		{
+			int32 Stride = 0;
+			int32 Offsets[ 3 ] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+			int32 Types[ 3 ] = { 0, 0, 0 };
+			for(const FPlyProperty& Property : Element.Properties)
+			{
+				if( Property.CountType != INDEX_NONE )
+				{
+					OutError = TEXT( "PLY vertices with list properties are not supported" );
+					return false;
+				}
+				const int32 Axis = Property.Name == TEXT( "x" ) ? 0 : Property.Name == TEXT( "y" ) ? 1 : Property.Name == TEXT( "z" ) ? 2 : INDEX_NONE;
+				if( Axis != INDEX_NONE )
+				{
+					Offsets[ Axis ] = Stride;
+					Types[ Axis ] = Property.Type;
+				}
+				Stride += PlyTypeSizes[ Property.Type ];
+			}
+			if( Offsets[ 0 ] == INDEX_NONE || Offsets[ 1 ] == INDEX_NONE || Offsets[ 2 ] == INDEX_NONE )
+			{
+				OutError = TEXT( "PLY vertices without x, y and z" );
+				return false;
+			}
+			if( Element.Count < 0 || Element.Count > MAX_int32 || Element.Count * Stride > End - Data )
+			{
+				OutError = TEXT( "Truncated PLY vertices" );
+				return false;
+			}
+
+			NumVertices = Element.Count;
+			OutPositions.SetNumUninitialized( NumVertices );
+			ParallelFor( FMath::DivideAndRoundUp( (int32)NumVertices, IMPORT_BINARY_CHUNK_SIZE ), [ & ]( int32 Chunk )
+			{
+				const int32 First = Chunk * IMPORT_BINARY_CHUNK_SIZE;
+				const int32 Last = FMath::Min( First + IMPORT_BINARY_CHUNK_SIZE, (int32)NumVertices );
+				for(int32 i = First; i < Last; ++i)
+				{
+					const uint8* Vertex = Data + (int64)i * Stride;
+					OutPositions[ i ] = FVector(
+						ReadPlyValue( Vertex + Offsets[ 0 ], Types[ 0 ], bSwap ),
+						ReadPlyValue( Vertex + Offsets[ 1 ], Types[ 1 ], bSwap ),
+						ReadPlyValue( Vertex + Offsets[ 2 ], Types[ 2 ], bSwap ) );
+				}
+			} );
+			Data += Element.Count * Stride;
+		}
+		else if( Element.Name == TEXT( "face" ) && !bFaces )
+		{
+			int32 IndexProperty = INDEX_NONE;
+			for(int32 p = 0; p < Element.Properties.Num(); ++p)
+			{
+				const FPlyProperty& Property = Element.Properties[ p ];
+				if( Property.CountType != INDEX_NONE && ( Property.Name == TEXT( "vertex_indices" ) || Property.Name == TEXT( "vertex_index" ) ) )
+				{
+					IndexProperty = p;
+				}
+			}
+			if( IndexProperty == INDEX_NONE )
+			{
+				OutError = TEXT( "PLY faces without vertex_indices" );
+				return false;
+			}
+			const FPlyProperty& Indices = Element.Properties[ IndexProperty ];
+
+			// The faces have variable sizes, find where each chunk starts and how many triangles come before it
+			const int32 NumChunks = (int32)FMath::Min( ( Element.Count + IMPORT_BINARY_CHUNK_SIZE - 1 ) / IMPORT_BINARY_CHUNK_SIZE, (int64)MAX_int32 );
+			TArray<const uint8*> ChunkData;
+			TArray<int64> ChunkTriangles;
+			ChunkData.SetNumUninitialized( NumChunks );
+			ChunkTriangles.SetNumUninitialized( NumChunks + 1 );
+			int64 NumTriangles = 0;
+			for(int64 f = 0; f < Element.Count; ++f)
+			{
+				if( f % IMPORT_BINARY_CHUNK_SIZE == 0 )
+				{
+					ChunkData[ f / IMPORT_BINARY_CHUNK_SIZE ] = Data;
+					ChunkTriangles[ f / IMPORT_BINARY_CHUNK_SIZE ] = NumTriangles;
+				}
+				// The properties before the indices can be lists too
+				const uint8* Face = SkipPlyProperties( Element, IndexProperty, Data, End, bSwap );
+				Data = SkipPlyElement( Element, Data, End, bSwap );
+				if( Data == nullptr )
+				{
+					OutError = TEXT( "Truncated PLY faces" );
+					return false;
+				}
+				NumTriangles += FMath::Max( (int64)ReadPlyValue( Face, Indices.CountType, bSwap ) - 2, (int64)0 );
+			}
+			ChunkTriangles[ NumChunks ] = NumTriangles;
+			if( NumTriangles * 3 > MAX_int32 )
+			{
+				OutError = TEXT( "Too many PLY faces" );
+				return false;
+			}
+
+			OutIndices.SetNumUninitialized( NumTriangles * 3 );
+			ParallelFor( NumChunks, [ & ]( int32 Chunk )
+			{
+				const uint8* Face = ChunkData[ Chunk ];
+				uint32* Triangle = OutIndices.GetData() + ChunkTriangles[ Chunk ] * 3;
+				const int64 Last = FMath::Min( (int64)( Chunk + 1 ) * IMPORT_BINARY_CHUNK_SIZE, Element.Count );
+				for(int64 f = (int64)Chunk * IMPORT_BINARY_CHUNK_SIZE; f < Last; ++f)
+				{
+					const uint8* Next = SkipPlyElement( Element, Face, End, bSwap );
+					Face = SkipPlyProperties( Element, IndexProperty, Face, End, bSwap );
+
+					// Triangle fan of the face
+					const int32 Count = (int32)ReadPlyValue( Face, Indices.CountType, bSwap );
+					const uint8* Index = Face + PlyTypeSizes[ Indices.CountType ];
+					const int32 IndexSize = PlyTypeSizes[ Indices.Type ];
+					for(int32 k = 2; k < Count; ++k)
+					{
+						*Triangle++ = (uint32)(int64)ReadPlyValue( Index, Indices.Type, bSwap );
+						*Triangle++ = (uint32)(int64)ReadPlyValue( Index + ( k - 1 ) * IndexSize, Indices.Type, bSwap );
+						*Triangle++ = (uint32)(int64)ReadPlyValue( Index + k * IndexSize, Indices.Type, bSwap );
+					}
+					Face = Next;
+				}
+			} );
+			bFaces = true;
+		}
+		else
+		{
+			for(int64 i = 0; i < Element.Count && Data != nullptr; ++i)
+			{
+				Data = SkipPlyElement( Element, Data, End, bSwap );
+			}
+			if( Data == nullptr )
+			{
+				OutError = FString::Printf( TEXT( "Truncated PLY element %s" ), *Element.Name );
+				return false;
+			}
+		}
+	}
+
+	if( !bFaces )
+	{
+		OutError = TEXT( "PLY file without faces" );
+		return false;
+	}
+	return true;
+}
+
+//
+// ASCII OBJ, the v and f lines (positive and relative indices, with texture and normal indices ignored), other lines are skipped
+//
+static bool ReadObj( const FTendrMappedFile& File, TArray<FVector>& OutPositions, TArray<uint32>& OutIndices, FString& OutError )
+{
+	const ANSICHAR* Text = (const ANSICHAR*)File.Data;
+	const TArray<const ANSICHAR*> Chunks = GetTextChunks( Text, Text + File.Size );
+	const int32 NumChunks = Chunks.Num() - 1;
+
+	auto FnKeyword = []( const ANSICHAR*& Line, const ANSICHAR* LineEnd, ANSICHAR Keyword )
+	{
+		SkipSpace( Line, LineEnd );
+		if( LineEnd - Line >= 2 && Line[ 0 ] == Keyword && IsSpace( Line[ 1 ] ) )
+		{
+			Line += 2;
+			return true;
+		}
+		return false;
+	};
+
+	// Number of vertices and triangles of each chunk
+	TArray<int64> ChunkVertices;
+	TArray<int64> ChunkTriangles;
+	ChunkVertices.SetNumZeroed( NumChunks + 1 );
+	ChunkTriangles.SetNumZeroed( NumChunks + 1 );
+	ParallelFor( NumChunks, [ & ]( int32 Chunk )
+	{
+		ForEachLine( Chunks[ Chunk ], Chunks[ Chunk + 1 ], [ & ]( const ANSICHAR* Line, const ANSICHAR* LineEnd )
+		{
+			if( FnKeyword( Line, LineEnd, 'v' ) )
+			{
+				++ChunkVertices[ Chunk ];
+			}
+			else if( FnKeyword( Line, LineEnd, 'f' ) )
+			{
+				int32 Count = 0;
+				for(SkipSpace( Line, LineEnd ); Line < LineEnd; SkipSpace( Line, LineEnd ))
+				{
+					SkipToken( Line, LineEnd );
+					++Count;
+				}
+				ChunkTriangles[ Chunk ] += FMath::Max( Count - 2, 0 );
+			}
+		} );
+	} );
+
+	int64 NumVertices = 0;
+	int64 NumTriangles = 0;
+	for(int32 Chunk = 0; Chunk <= NumChunks; ++Chunk)
+	{
+		const int64 Vertices = ChunkVertices[ Chunk ];
+		const int64 Triangles = ChunkTriangles[ Chunk ];
+		ChunkVertices[ Chunk ] = NumVertices;
+		ChunkTriangles[ Chunk ] = NumTriangles;
+		NumVertices += Vertices;
+		NumTriangles += Triangles;
+	}
+	if( NumVertices > MAX_int32 || NumTriangles * 3 > MAX_int32 )
+	{
+		OutError = TEXT( "Too many OBJ vertices or faces" );
+		return false;
+	}
+
+	// Vertices and triangles, relative indices are resolved with the number of vertices before the line
+	FThreadSafeCounter NumInvalid;
+	OutPositions.SetNumUninitialized( NumVertices );
+	OutIndices.SetNumUninitialized( NumTriangles * 3 );
+	ParallelFor( NumChunks, [ & ]( int32 Chunk )
+	{
+		int64 Vertex = ChunkVertices[ Chunk ];
+		uint32* Triangle = OutIndices.GetData() + ChunkTriangles[ Chunk ] * 3;
+		ForEachLine( Chunks[ Chunk ], Chunks[ Chunk + 1 ], [ & ]( const ANSICHAR* Line, const ANSICHAR* LineEnd )
+		{
+			if( FnKeyword( Line, LineEnd, 'v' ) )
+			{
+				FVector& Position = OutPositions[ (int32)Vertex++ ];
+				if( !ParseFloat( Line, LineEnd, Position.X ) || !ParseFloat( Line, LineEnd, Position.Y ) || !ParseFloat( Line, LineEnd, Position.Z ) )
+				{
+					Position = FVector::ZeroVector;
+					NumInvalid.Increment();
+				}
+			}
+			else if( FnKeyword( Line, LineEnd, 'f' ) )
+			{
+				uint32 First = 0;
+				uint32 Previous = 0;
+				int32 Count = 0;
+				for(SkipSpace( Line, LineEnd ); Line < LineEnd; SkipSpace( Line, LineEnd ), ++Count)
+				{
+					int64 Index = 0;
+					if( !ParseInteger( Line, LineEnd, Index ) || Index == 0 )
+					{
+						NumInvalid.Increment();
+					}
+					SkipToken( Line, LineEnd );
+
+					// Indices out of range are caught by welding
+					const uint32 Current = (uint32)( Index > 0 ? Index - 1 : Vertex + Index );
+					if( Count >= 2 )
+					{
+						*Triangle++ = First;
+						*Triangle++ = Previous;
+						*Triangle++ = Current;
+					}
+					First = Count == 0 ? Current : First;
+					Previous = Current;
+				}
+			}
+		} );
+	} );
+
+	if( NumInvalid.GetValue() > 0 )
+	{
+		OutError = FString::Printf( TEXT( "%d invalid OBJ vertices or face indices" ), NumInvalid.GetValue() );
+		return false;
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Welding
+//
+// The positions in use are sorted by their bits with a least significant digit radix sort (16 bits per pass, passes over digits that are
+// the same for all positions are skipped), so coincident positions end up next to each other. Each welded vertex gets the position of the
+// first of its positions in the file, and they are numbered in that order.
+//
+static bool WeldPositions( const TArray<FVector>& Positions, TArray<uint32>& Indices, FTendrVertexArray& OutVertices, FString& OutError )
+{
+	const int32 NumPositions = Positions.Num();
+	const int32 NumDigits = 65536;
+
+	for(uint32 Index : Indices)
+	{
+		if( Index >= (uint32)NumPositions )
+		{
+			OutError = FString::Printf( TEXT( "Vertex index %u out of range (%d vertices)" ), Index, NumPositions );
+			return false;
+		}
+	}
+
+	// Keys of the positions in use (in order of the positions), negative zero is the same as zero
+	struct FWeldKey
+	{
+		uint32 Bits[ 3 ];
+		int32 Position;
+	};
+	TArray<bool> Used;
+	Used.SetNumZeroed( NumPositions );
+	for(uint32 Index : Indices)
+	{
+		Used[ Index ] = true;
+	}
+	TArray<FWeldKey> Keys;
+	TArray<FWeldKey> SortedKeys;
+	Keys.Reserve( NumPositions );
+	for(int32 i = 0; i < NumPositions; ++i)
+	{
+		if( Used[ i ] )
+		{
+			FWeldKey Key;
+			for(int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				const float Value = Positions[ i ][ Axis ] + 0.0f;
+				FMemory::Memcpy( &Key.Bits[ Axis ], &Value, sizeof( float ) );
+			}
+			Key.Position = i;
+			Keys.Add( Key );
+		}
+	}
+	SortedKeys.SetNumUninitialized( Keys.Num() );
+
+	TArray<int32> Offsets;
+	Offsets.SetNumUninitialized( NumDigits );
+	for(int32 Pass = 0; Pass < 6; ++Pass)
+	{
+		const int32 Axis = 2 - Pass / 2;
+		const int32 Shift = ( Pass % 2 ) * 16;
+
+		FMemory::Memzero( Offsets.GetData(), NumDigits * sizeof( int32 ) );
+		for(const FWeldKey& Key : Keys)
+		{
+			++Offsets[ ( Key.Bits[ Axis ] >> Shift ) & ( NumDigits - 1 ) ];
+		}
+		if( Keys.Num() == 0 || Offsets[ ( Keys[ 0 ].Bits[ Axis ] >> Shift ) & ( NumDigits - 1 ) ] == Keys.Num() )
+		{
+			continue;
+		}
+
+		int32 Offset = 0;
+		for(int32 d = 0; d < NumDigits; ++d)
+		{
+			const int32 Count = Offsets[ d ];
+			Offsets[ d ] = Offset;
+			Offset += Count;
+		}
+		for(const FWeldKey& Key : Keys)
+		{
+			SortedKeys[ Offsets[ ( Key.Bits[ Axis ] >> Shift ) & ( NumDigits - 1 ) ]++ ] = Key;
+		}
+		Exchange( Keys, SortedKeys );
+	}
+
+	// First position of each group of coincident positions (the sort is stable)
+	TArray<int32> PositionToWelded;
+	PositionToWelded.Init( INDEX_NONE, NumPositions );
+	for(int32 k = 0, First = 0; k < Keys.Num(); ++k)
+	{
+		if( FMemory::Memcmp( Keys[ k ].Bits, Keys[ First ].Bits, sizeof( Keys[ k ].Bits ) ) != 0 )
+		{
+			First = k;
+		}
+		PositionToWelded[ Keys[ k ].Position ] = Keys[ First ].Position;
+	}
+
+	OutVertices.Reset( Keys.Num() );
+	for(int32 i = 0; i < NumPositions; ++i)
+	{
+		if( PositionToWelded[ i ] == i )
+		{
+			PositionToWelded[ i ] = OutVertices.Add( FVector4( Positions[ i ], 0 ) );
+		}
+		else if( PositionToWelded[ i ] != INDEX_NONE )
+		{
+			PositionToWelded[ i ] = PositionToWelded[ PositionToWelded[ i ] ];
+		}
+	}
+
+	// Triangles with coincident corners are dropped
+	int32 NumTriangles = 0;
+	for(int32 t = 0; t < Indices.Num() / 3; ++t)
+	{
+		const uint32 A = PositionToWelded[ Indices[ t * 3 + 0 ] ];
+		const uint32 B = PositionToWelded[ Indices[ t * 3 + 1 ] ];
+		const uint32 C = PositionToWelded[ Indices[ t * 3 + 2 ] ];
+		if( A != B && B != C && C != A )
+		{
+			Indices[ NumTriangles * 3 + 0 ] = A;
+			Indices[ NumTriangles * 3 + 1 ] = B;
+			Indices[ NumTriangles * 3 + 2 ] = C;
+			++NumTriangles;
+		}
+	}
+	Indices.SetNum( NumTriangles * 3 );
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// FTendrModelTetraImport
+//
+
+bool FTendrModelTetraImport::IsSupported( const FString& Filename )
+{
+	const FString Extension = FPaths::GetExtension( Filename );
+	return Extension == TEXT( "stl" ) || Extension == TEXT( "ply" ) || Extension == TEXT( "obj" );
+}
+
+bool FTendrModelTetraImport::Import( const FString& Filename, FTendrVertexArray& OutVertices, FTendrIndexArray& OutIndices, FString& OutError )
+{
+	TENDR_TRACE_SCOPE( "Import" );
+
+	FTendrMappedFile File;
+	if( !File.Open( Filename ) )
+	{
+		OutError = FString::Printf( TEXT( "Could not open %s" ), *Filename );
+		return false;
+	}
+
+	TArray<FVector> Positions;
+	OutIndices.Reset();
+	const FString Extension = FPaths::GetExtension( Filename );
+	bool bRead;
+	{
+		TENDR_TRACE_SCOPE( "Parse" );
+
+		bRead = Extension == TEXT( "stl" ) ? ReadStl( File, Positions, OutIndices, OutError ) :
+				Extension == TEXT( "ply" ) ? ReadPly( File, Positions, OutIndices, OutError ) :
+				Extension == TEXT( "obj" ) ? ReadObj( File, Positions, OutIndices, OutError ) : false;
+	}
+	if( !bRead )
+	{
+		OutError = OutError.IsEmpty() ? FString::Printf( TEXT( "Unsupported file type of %s" ), *Filename ) : OutError;
+		return false;
+	}
+
+	{
+		TENDR_TRACE_SCOPE( "Weld" );
+
+		if( !WeldPositions( Positions, OutIndices, OutVertices, OutError ) )
+		{
+			return false;
+		}
+	}
+	if( OutIndices.Num() == 0 )
+	{
+		OutError = FString::Printf( TEXT( "No triangles in %s" ), *Filename );
+		return false;
+	}
+
+	UE_LOG( TendrModelTetraLog, Log, TEXT( "Imported %s (%d positions, %d vertices, %d triangles)" ), *Filename, Positions.Num(), OutVertices.Num(), OutIndices.Num() / 3 );
+	return true;
+}
+
+void FTendrModelTetraImport::ComputeTangents( const FTendrVertexArray& Vertices, const FTendrIndexArray& Indices, FTendrTangentArray& OutTangents )
+{
+	TArray<FVector> Normals;
+	Normals.SetNumZeroed( Vertices.Num() );
+	for(int32 t = 0; t < Indices.Num() / 3; ++t)
+	{
+		const FVector A( Vertices[ Indices[ t * 3 + 0 ] ] );
+		const FVector B( Vertices[ Indices[ t * 3 + 1 ] ] );
+		const FVector C( Vertices[ Indices[ t * 3 + 2 ] ] );
+
+		// Area weighted (the length of the cross product is twice the area), in the winding of the file
+		const FVector Normal = FVector::CrossProduct( B - A, C - A );
+		Normals[ Indices[ t * 3 + 0 ] ] += Normal;
+		Normals[ Indices[ t * 3 + 1 ] ] += Normal;
+		Normals[ Indices[ t * 3 + 2 ] ] += Normal;
+	}
+
+	OutTangents.SetNumUninitialized( Vertices.Num() );
+	for(int32 i = 0; i < Vertices.Num(); ++i)
+	{
+		const FVector TangentZ = Normals[ i ].IsNearlyZero() ? FVector::UpVector : Normals[ i ].GetSafeNormal();
+		const FVector TangentX = FVector::CrossProduct( FMath::Abs( TangentZ.Z ) < 0.999f ? FVector::UpVector : FVector::ForwardVector, TangentZ ).GetSafeNormal();
+		OutTangents[ i ].TangentX = FPackedRGB10A2N( FVector4( TangentX, 0 ) );
+		OutTangents[ i ].TangentZ = FPackedRGB10A2N( FVector4( TangentZ, 1 ) );
+	}
+}
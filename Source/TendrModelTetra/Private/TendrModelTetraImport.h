@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TendrModelTetraPlugin                                                     //
+//                                                                           //
+// A Tendr model generator plugin for use with Unreal Engine in combination  //
+// with the Tendr Dynamics soft-body physics plugin.                         //
+//                                                                           //
+// Version 1.0                                                               //
+// January, 2015                                                             //
+//                                                                           //
+// Copyright (C) 2014-2015, Tendr Dynamics B.V.                              //
+//                                                                           //
+// Visit http://tendrdynamics.com for more information.                      //
+//                                                                           //
+// This file is governed by copyrights as described in the LICENSE file.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//
+// Importers for triangle meshes in binary STL, binary PLY and ASCII OBJ files, for building models without the editor (see
+// UTendrModelTetraBatchCommandlet). Files are memory mapped and parsed in parallel chunks, polygons are split into triangle fans
+// and coincident vertices are welded by sorting their positions.
+//
+class FTendrModelTetraImport
+{
+public:
+	/** Returns whether a file can be imported, by its extension **/
+	static bool IsSupported( const FString& Filename );
+
+	/** Reads the triangles of a file as welded vertices (only those in use) and indices, returns false and sets OutError if it could not be read **/
+	static bool Import( const FString& Filename, FTendrVertexArray& OutVertices, FTendrIndexArray& OutIndices, FString& OutError );
+
+	/** Computes smooth tangents (area weighted normals) from the triangles, for input that has none **/
+	static void ComputeTangents( const FTendrVertexArray& Vertices, const FTendrIndexArray& Indices, FTendrTangentArray& OutTangents );
+};
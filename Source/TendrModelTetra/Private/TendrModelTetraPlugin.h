@@ -18,9 +18,9 @@
 
 #pragma once
 //
-// Global Tendr model generator version
+// Global Tendr model generator version (see TendrModelData.h)
 //
-const FTendrModelGeneratorVersion PluginModelGeneratorVersion = (uint32)0x00000004;
+const FTendrModelGeneratorVersion PluginModelGeneratorVersion = (uint32)0x0000000A;
 
 //
 // Global logging declarations
@@ -22,6 +22,7 @@
 	#include "UnrealEd.h"
 #endif
 #include "ModuleManager.h"
+#include "ParallelFor.h"
 
 #include "StaticMeshResources.h"
 #include "DynamicMeshBuilder.h"
@@ -31,3 +32,4 @@
 #include "TendrModelTetraGeneratorActor.h"
 #include "TendrModelTetraGeneratorComponent.h"
 #include "TendrModelTetraPlugin.h"
+#include "TendrModelTetraTrace.h"
@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TendrModelTetraPlugin                                                     //
+//                                                                           //
+// A Tendr model generator plugin for use with Unreal Engine in combination  //
+// with the Tendr Dynamics soft-body physics plugin.                         //
+//                                                                           //
+// Version 1.0                                                               //
+// January, 2015                                                             //
+//                                                                           //
+// Copyright (C) 2014-2015, Tendr Dynamics B.V.                              //
+//                                                                           //
+// Visit http://tendrdynamics.com for more information.                      //
+//                                                                           //
+// This file is governed by copyrights as described in the LICENSE file.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TendrModelTetraPluginPrivatePCH.h"
+
+#if TENDR_TRACE
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Configuration
+//
+
+//
+// Number of events kept per thread (power of two), older events are overwritten
+//
+#define TRACE_BUFFER_SIZE ( 1 << 16 )
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Per-thread event buffers
+//
+
+struct FTendrTraceEvent
+{
+	const ANSICHAR* Name;
+	uint64 Cycles;
+	uint32 Session;
+	bool bBegin;
+};
+
+struct FTendrTraceBuffer
+{
+	FTendrTraceEvent Events[ TRACE_BUFFER_SIZE ];
+
+	// Number of events recorded, the ring holds the last TRACE_BUFFER_SIZE of them (only written by the owning thread)
+	volatile int32 Count;
+
+	// Session of the events recorded by the owning thread
+	uint32 Session;
+
+	uint32 ThreadId;
+	FTendrTraceBuffer* Next;
+};
+
+//
+// Buffers of all threads that have recorded events, they are kept alive for the lifetime of the module
+// because pooled threads hold on to them
+//
+static FTendrTraceBuffer* volatile TraceBuffers = nullptr;
+
+//
+// Last session handed out
+//
+static volatile int32 TraceLastSession = 0;
+
+//
+// Thread local storage slot of the buffer of the calling thread
+//
+static uint32 TraceBufferSlot = FPlatformTLS::AllocTlsSlot();
+
+static FTendrTraceBuffer* GetTraceBuffer()
+{
+	FTendrTraceBuffer* Buffer = (FTendrTraceBuffer*)FPlatformTLS::GetTlsValue( TraceBufferSlot );
+	if( Buffer == nullptr )
+	{
+		Buffer = new FTendrTraceBuffer;
+		Buffer->Count = 0;
+		Buffer->Session = 0;
+		Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+		FPlatformTLS::SetTlsValue( TraceBufferSlot, Buffer );
+
+		// Push onto the buffer list without locking, this only happens once per thread
+		FTendrTraceBuffer* Head;
+		do
+		{
+			Head = TraceBuffers;
+			Buffer->Next = Head;
+		}
+		while( FPlatformAtomics::InterlockedCompareExchangePointer( (void**)&TraceBuffers, Buffer, Head ) != Head );
+	}
+	return Buffer;
+}
+
+//
+// Copies the events of a session from the ring buffer of a thread (which may be recording) in order, leaving out the events that may have
+// been overwritten while copying and the end events of which the begin event is no longer in the ring
+//
+static void GetTraceEvents( const FTendrTraceBuffer* Buffer, uint32 Session, TArray<FTendrTraceEvent>& OutEvents )
+{
+	OutEvents.Reset();
+
+	// Events before Count are complete, those overwritten by the recording thread in the meantime are discarded after copying
+	const int32 Count = Buffer->Count;
+	FPlatformMisc::MemoryBarrier();
+	const int32 First = FMath::Max( 0, Count - TRACE_BUFFER_SIZE );
+	TArray<FTendrTraceEvent> Copied;
+	Copied.SetNumUninitialized( Count - First );
+	for(int32 i = First; i < Count; ++i)
+	{
+		Copied[ i - First ] = Buffer->Events[ i & ( TRACE_BUFFER_SIZE - 1 ) ];
+	}
+	FPlatformMisc::MemoryBarrier();
+	const int32 CountAfter = Buffer->Count;
+	const int32 FirstValid = ( CountAfter < Count ) ? Count : FMath::Max( First, CountAfter - TRACE_BUFFER_SIZE + 1 );
+
+	int32 Depth = 0;
+	for(int32 i = FirstValid; i < Count; ++i)
+	{
+		const FTendrTraceEvent& Event = Copied[ i - First ];
+		if( Event.Session != Session )
+		{
+			continue;
+		}
+		if( !Event.bBegin )
+		{
+			if( Depth == 0 )
+			{
+				continue;
+			}
+			--Depth;
+		}
+		else
+		{
+			++Depth;
+		}
+		OutEvents.Add( Event );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// FTendrTrace
+//
+
+void FTendrTrace::Event( const ANSICHAR* Name, bool bBegin )
+{
+	FTendrTraceBuffer* Buffer = GetTraceBuffer();
+	if( Buffer->Session == 0 )
+	{
+		return;
+	}
+
+	FTendrTraceEvent& Event = Buffer->Events[ Buffer->Count & ( TRACE_BUFFER_SIZE - 1 ) ];
+	Event.Name = Name;
+	Event.Cycles = FPlatformTime::Cycles64();
+	Event.Session = Buffer->Session;
+	Event.bBegin = bBegin;
+
+	// Publish the event only after it has been written
+	FPlatformMisc::MemoryBarrier();
+	Buffer->Count = Buffer->Count + 1;
+}
+
+void FTendrTrace::TetgenEvent( const char* Name, int IsBegin )
+{
+	Event( Name, IsBegin != 0 );
+}
+
+uint32 FTendrTrace::NewSession()
+{
+	return (uint32)FPlatformAtomics::InterlockedIncrement( &TraceLastSession );
+}
+
+uint32 FTendrTrace::GetSession()
+{
+	return GetTraceBuffer()->Session;
+}
+
+uint32 FTendrTrace::SetSession( uint32 Session )
+{
+	FTendrTraceBuffer* Buffer = GetTraceBuffer();
+	const uint32 PreviousSession = Buffer->Session;
+	Buffer->Session = Session;
+	return PreviousSession;
+}
+
+bool FTendrTrace::ExportChromeJson( const FString& Filename, uint32 Session )
+{
+	struct FThreadEvents
+	{
+		uint32 ThreadId;
+		TArray<FTendrTraceEvent> Events;
+	};
+
+	TArray<FThreadEvents> Threads;
+	for(FTendrTraceBuffer* Buffer = TraceBuffers; Buffer != nullptr; Buffer = Buffer->Next)
+	{
+		FThreadEvents& Thread = Threads[ Threads.AddDefaulted() ];
+		Thread.ThreadId = Buffer->ThreadId;
+		GetTraceEvents( Buffer, Session, Thread.Events );
+	}
+
+	// Timestamps are relative to the earliest recorded event
+	uint64 StartCycles = MAX_uint64;
+	for(const FThreadEvents& Thread : Threads)
+	{
+		for(const FTendrTraceEvent& Event : Thread.Events)
+		{
+			StartCycles = FMath::Min( StartCycles, Event.Cycles );
+		}
+	}
+
+	const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1.0e6;
+
+	// Begin and end events of each thread, the viewer pairs them up per thread
+	FString Json = TEXT( "{\"traceEvents\":[" );
+	bool bFirst = true;
+	for(const FThreadEvents& Thread : Threads)
+	{
+		for(const FTendrTraceEvent& Event : Thread.Events)
+		{
+			Json += FString::Printf( TEXT( "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}" ),
+				bFirst ? TEXT( "" ) : TEXT( "," ),
+				ANSI_TO_TCHAR( Event.Name ),
+				Event.bBegin ? TEXT( "B" ) : TEXT( "E" ),
+				( Event.Cycles - StartCycles ) * MicrosecondsPerCycle,
+				Thread.ThreadId );
+			bFirst = false;
+		}
+	}
+	Json += TEXT( "\n]}\n" );
+
+	return FFileHelper::SaveStringToFile( Json, *Filename );
+}
+
+void FTendrTrace::Reset()
+{
+	// Only the owning thread writes the count of its buffer
+	GetTraceBuffer()->Count = 0;
+}
+
+#endif
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TendrModelTetraPlugin                                                     //
+//                                                                           //
+// A Tendr model generator plugin for use with Unreal Engine in combination  //
+// with the Tendr Dynamics soft-body physics plugin.                         //
+//                                                                           //
+// Version 1.0                                                               //
+// January, 2015                                                             //
+//                                                                           //
+// Copyright (C) 2014-2015, Tendr Dynamics B.V.                              //
+//                                                                           //
+// Visit http://tendrdynamics.com for more information.                      //
+//                                                                           //
+// This file is governed by copyrights as described in the LICENSE file.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//
+// Enables the trace event sink for profiling the generator stages, exported as Chrome trace JSON
+// (scoped events compile to nothing when disabled)
+//
+#ifndef TENDR_TRACE
+#define TENDR_TRACE 0
+#endif
+
+#if TENDR_TRACE
+
+//
+// Lock-free trace event sink, every thread records its events into its own ring buffer. Events are tagged with the session (build) of
+// the recording thread, so concurrent builds can each export their own events.
+//
+class FTendrTrace
+{
+public:
+	/** Records the begin or end of a named scope on the calling thread, the name must be a string literal **/
+	static void Event( const ANSICHAR* Name, bool bBegin );
+
+	/** Tetgen trace event callback **/
+	static void TetgenEvent( const char* Name, int IsBegin );
+
+	/** Returns a new session for the events of one build **/
+	static uint32 NewSession();
+
+	/** Returns the session of the events recorded by the calling thread, or 0 if it records none **/
+	static uint32 GetSession();
+
+	/** Sets the session of the events recorded by the calling thread (0 records none), returns the previous one **/
+	static uint32 SetSession( uint32 Session );
+
+	/** Writes the recorded events of a session (on all threads) to a Chrome trace JSON file, may run while other threads record **/
+	static bool ExportChromeJson( const FString& Filename, uint32 Session );
+
+	/** Discards the recorded events of the calling thread **/
+	static void Reset();
+};
+
+//
+// Records the events of the calling thread in a session for the lifetime of the object
+//
+struct FTendrTraceSessionScope
+{
+	FTendrTraceSessionScope( uint32 Session )
+		: PreviousSession( FTendrTrace::SetSession( Session ) )
+	{
+	}
+
+	~FTendrTraceSessionScope()
+	{
+		FTendrTrace::SetSession( PreviousSession );
+	}
+
+	uint32 PreviousSession;
+};
+
+//
+// Records a named scope for the lifetime of the object
+//
+struct FTendrTraceScope
+{
+	FTendrTraceScope( const ANSICHAR* InName )
+		: Name( InName )
+	{
+		FTendrTrace::Event( Name, true );
+	}
+
+	~FTendrTraceScope()
+	{
+		FTendrTrace::Event( Name, false );
+	}
+
+	const ANSICHAR* Name;
+};
+
+#define TENDR_TRACE_SCOPE( Name ) FTendrTraceScope PREPROCESSOR_JOIN( TendrTraceScope, __LINE__ )( Name )
+
+#else
+
+#define TENDR_TRACE_SCOPE( Name )
+
+#endif
@@ -116,6 +116,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <mutex>
 #ifdef CPU86
 #include <float.h>
 #endif /* CPU86 */
@@ -372,6 +373,10 @@ cgalEpick cgal_pred_obj;
 	Square( a1, _j, _1 ); \
 	Two_Two_Sum( _j, _1, _l, _2, x5, x4, x3, x2 )
 
+/* The machine constants below are computed once by exactinit(), by the     */
+/*   first thread that calls it, and are only read afterwards.               */
+static std::once_flag constantsonce;
+
 /* splitter = 2^ceiling(p / 2) + 1.  Used to split floats in half.           */
 static REAL splitter;
 static REAL epsilon;         /* = 2^(-p).  Used to estimate roundoff errors. */
@@ -384,14 +389,24 @@ static REAL isperrboundA, isperrboundB, isperrboundC;
 
 // Options to choose types of geometric computtaions. 
 // Added by H. Si, 2012-08-23.
-static int  _use_inexact_arith; // -X option.
-static int  _use_static_filter; // Default option, disable it by -X1
+// They are kept per thread, so meshes can be generated concurrently (the
+//   static filters depend on the bounding box), see setpredicatefilters().
+static thread_local int  _use_inexact_arith; // -X option.
+static thread_local int  _use_static_filter; // Default option, disable it by -X1
 
 // Static filters for orient3d() and insphere(). 
 // They are pre-calcualted and set in exactinit().
 // Added by H. Si, 2012-08-23.
-static REAL o3dstaticfilter;
-static REAL ispstaticfilter;
+static thread_local REAL o3dstaticfilter;
+static thread_local REAL ispstaticfilter;
+
+// Counters of the predicate evaluations of the calling thread, or NULL if
+//   none are kept. See setpredicatestats().
+static thread_local predicatestats *_predstats = NULL;
+
+#define predstat(p, s) \
+	( ( _predstats != NULL ) ? \
+	(void)_predstats->resolved[ predicatestats::p ][ predicatestats::s ]++ : (void)0 )
 
 
 
@@ -541,7 +556,7 @@ int test_double( int verbose )
 
 /*****************************************************************************/
 /*                                                                           */
-/*  exactinit()   Initialize the variables used for exact arithmetic.        */
+/*  exactinitconstants()   Initialize the constants for exact arithmetic.    */
 /*                                                                           */
 /*  `epsilon' is the largest power of two such that 1.0 + epsilon = 1.0 in   */
 /*  floating-point arithmetic.  `epsilon' bounds the relative roundoff       */
@@ -558,49 +573,11 @@ int test_double( int verbose )
 /*                                                                           */
 /*****************************************************************************/
 
-void exactinit( int verbose, int noexact, int nofilter, REAL maxx, REAL maxy,
-				REAL maxz )
+static void exactinitconstants( int verbose )
 {
 	REAL half;
 	REAL check, lastcheck;
 	int every_other;
-#ifdef LINUX
-	int cword;
-#endif /* LINUX */
-
-#ifdef CPU86
-#ifdef SINGLE
-	_control87( _PC_24, _MCW_PC ); /* Set FPU control word for single precision. */
-#else /* not SINGLE */
-	_control87( _PC_53, _MCW_PC ); /* Set FPU control word for double precision. */
-#endif /* not SINGLE */
-#endif /* CPU86 */
-#ifdef LINUX
-#ifdef SINGLE
-	/*  cword = 4223; */
-	cword = 4210;                 /* set FPU control word for single precision */
-#else /* not SINGLE */
-	/*  cword = 4735; */
-	cword = 4722;                 /* set FPU control word for double precision */
-#endif /* not SINGLE */
-	_FPU_SETCW( cword );
-#endif /* LINUX */
-
-	if(verbose)
-	{
-		printf( "  Initializing robust predicates.\n" );
-	}
-
-#ifdef USE_CGAL_PREDICATES
-	if(cgal_pred_obj.Has_static_filters)
-	{
-		printf( "  Use static filter.\n" );
-	}
-	else
-	{
-		printf( "  No static filter.\n" );
-	}
-#endif // USE_CGAL_PREDICATES
 
 #ifdef SINGLE
 	test_float( verbose );
@@ -645,6 +622,62 @@ void exactinit( int verbose, int noexact, int nofilter, REAL maxx, REAL maxy,
 	isperrboundA = ( 16.0 + 224.0 * epsilon ) * epsilon;
 	isperrboundB = ( 5.0 + 72.0 * epsilon ) * epsilon;
 	isperrboundC = ( 71.0 + 1408.0 * epsilon ) * epsilon * epsilon;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  exactinit()   Initialize the variables used for exact arithmetic.        */
+/*                                                                           */
+/*  The machine constants are computed once, by the first call of any        */
+/*  thread.  The FPU precision, the options and the static filters (which    */
+/*  depend on the bounding box) are set for the calling thread on every      */
+/*  call, see setpredicatefilters().                                         */
+/*                                                                           */
+/*****************************************************************************/
+
+void exactinit( int verbose, int noexact, int nofilter, REAL maxx, REAL maxy,
+				REAL maxz )
+{
+	REAL half;
+#ifdef LINUX
+	int cword;
+#endif /* LINUX */
+
+#ifdef CPU86
+#ifdef SINGLE
+	_control87( _PC_24, _MCW_PC ); /* Set FPU control word for single precision. */
+#else /* not SINGLE */
+	_control87( _PC_53, _MCW_PC ); /* Set FPU control word for double precision. */
+#endif /* not SINGLE */
+#endif /* CPU86 */
+#ifdef LINUX
+#ifdef SINGLE
+	/*  cword = 4223; */
+	cword = 4210;                 /* set FPU control word for single precision */
+#else /* not SINGLE */
+	/*  cword = 4735; */
+	cword = 4722;                 /* set FPU control word for double precision */
+#endif /* not SINGLE */
+	_FPU_SETCW( cword );
+#endif /* LINUX */
+
+	if(verbose)
+	{
+		printf( "  Initializing robust predicates.\n" );
+	}
+
+#ifdef USE_CGAL_PREDICATES
+	if(cgal_pred_obj.Has_static_filters)
+	{
+		printf( "  Use static filter.\n" );
+	}
+	else
+	{
+		printf( "  No static filter.\n" );
+	}
+#endif // USE_CGAL_PREDICATES
+
+	std::call_once( constantsonce, exactinitconstants, verbose );
 
 	// Set TetGen options.  Added by H. Si, 2012-08-23.
 	_use_inexact_arith = noexact;
@@ -672,6 +705,60 @@ void exactinit( int verbose, int noexact, int nofilter, REAL maxx, REAL maxy,
 
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  setpredicatestats()   Select the counters of the calling thread.         */
+/*                                                                           */
+/*  Every predicate evaluation of the calling thread is counted in `stats'   */
+/*  at the stage that resolves it, until it is set to NULL again.  Returns   */
+/*  the counters that were selected before.                                  */
+/*                                                                           */
+/*****************************************************************************/
+
+predicatestats *setpredicatestats( predicatestats *stats )
+{
+	predicatestats *previous = _predstats;
+	_predstats = stats;
+	return previous;
+}
+
+predicatestats *getpredicatestats( )
+{
+	return _predstats;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  setpredicatefilters()   Select the options and static filters of the    */
+/*                          calling thread.                                  */
+/*                                                                           */
+/*  exactinit() sets them for the calling thread only, other threads that    */
+/*  evaluate predicates for the same mesh must select them as well.  Returns */
+/*  the ones that were selected before in `previous' (if not NULL).          */
+/*                                                                           */
+/*****************************************************************************/
+
+void setpredicatefilters( const predicatefilters *filters,
+						  predicatefilters *previous )
+{
+	if(previous != NULL)
+	{
+		getpredicatefilters( previous );
+	}
+	_use_inexact_arith = filters->noexact;
+	_use_static_filter = filters->usestaticfilter;
+	o3dstaticfilter = filters->o3dstaticfilter;
+	ispstaticfilter = filters->ispstaticfilter;
+}
+
+void getpredicatefilters( predicatefilters *filters )
+{
+	filters->noexact = _use_inexact_arith;
+	filters->usestaticfilter = _use_static_filter;
+	filters->o3dstaticfilter = o3dstaticfilter;
+	filters->ispstaticfilter = ispstaticfilter;
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  grow_expansion()   Add a scalar to an expansion.                         */
@@ -1992,6 +2079,7 @@ REAL orient3dadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL permanent )
 	errbound = o3derrboundB * permanent;
 	if(( det >= errbound ) || ( -det >= errbound ))
 	{
+		predstat( ORIENT3D, ADAPTB );
 		return det;
 	}
 
@@ -2009,6 +2097,7 @@ REAL orient3dadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL permanent )
 		&& ( adytail == 0.0 ) && ( bdytail == 0.0 ) && ( cdytail == 0.0 )
 		&& ( adztail == 0.0 ) && ( bdztail == 0.0 ) && ( cdztail == 0.0 ))
 	{
+		predstat( ORIENT3D, ADAPTC );
 		return det;
 	}
 
@@ -2024,6 +2113,7 @@ REAL orient3dadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL permanent )
 		+ cdztail * ( adx * bdy - ady * bdx ) );
 	if(( det >= errbound ) || ( -det >= errbound ))
 	{
+		predstat( ORIENT3D, ADAPTC );
 		return det;
 	}
 
@@ -2352,6 +2442,7 @@ REAL orient3dadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL permanent )
 		finswap = finnow; finnow = finother; finother = finswap;
 	}
 
+	predstat( ORIENT3D, EXACT );
 	return finnow[ finlength - 1 ];
 }
 
@@ -2401,14 +2492,18 @@ REAL orient3d( REAL *pa, REAL *pb, REAL *pc, REAL *pd )
 
 	if(_use_inexact_arith)
 	{
+		predstat( ORIENT3D, UNFILTERED );
 		return det;
 	}
 
 	if(_use_static_filter)
 	{
 		//if (fabs(det) > o3dstaticfilter) return det;
-		if(det > o3dstaticfilter) return det;
-		if(det < -o3dstaticfilter) return det;
+		if(( det > o3dstaticfilter ) || ( det < -o3dstaticfilter ))
+		{
+			predstat( ORIENT3D, STATICFILTER );
+			return det;
+		}
 	}
 
 
@@ -2420,6 +2515,7 @@ REAL orient3d( REAL *pa, REAL *pb, REAL *pc, REAL *pd )
 	errbound = o3derrboundA * permanent;
 	if(( det > errbound ) || ( -det > errbound ))
 	{
+		predstat( ORIENT3D, DYNAMICFILTER );
 		return det;
 	}
 
@@ -4213,6 +4309,7 @@ REAL insphereadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe,
 	errbound = isperrboundB * permanent;
 	if(( det >= errbound ) || ( -det >= errbound ))
 	{
+		predstat( INSPHERE, ADAPTB );
 		return det;
 	}
 
@@ -4233,6 +4330,7 @@ REAL insphereadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe,
 		&& ( cextail == 0.0 ) && ( ceytail == 0.0 ) && ( ceztail == 0.0 )
 		&& ( dextail == 0.0 ) && ( deytail == 0.0 ) && ( deztail == 0.0 ))
 	{
+		predstat( INSPHERE, ADAPTC );
 		return det;
 	}
 
@@ -4271,9 +4369,11 @@ REAL insphereadapt( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe,
 		* ( dez * ab3 + aez * bd3 + bez * da3 ) ) );
 	if(( det >= errbound ) || ( -det >= errbound ))
 	{
+		predstat( INSPHERE, ADAPTC );
 		return det;
 	}
 
+	predstat( INSPHERE, EXACT );
 	return insphereexact( pa, pb, pc, pd, pe );
 }
 
@@ -4352,12 +4452,17 @@ REAL insphere( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe )
 
 	if(_use_inexact_arith)
 	{
+		predstat( INSPHERE, UNFILTERED );
 		return det;
 	}
 
 	if(_use_static_filter)
 	{
-		if(fabs( det ) > ispstaticfilter) return det;
+		if(fabs( det ) > ispstaticfilter)
+		{
+			predstat( INSPHERE, STATICFILTER );
+			return det;
+		}
 		//if (det > ispstaticfilter) return det;
 		//if (det < minus_ispstaticfilter) return det;
 
@@ -4404,6 +4509,7 @@ REAL insphere( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe )
 	errbound = isperrboundA * permanent;
 	if(( det > errbound ) || ( -det > errbound ))
 	{
+		predstat( INSPHERE, DYNAMICFILTER );
 		return det;
 	}
 
@@ -4786,6 +4892,7 @@ REAL orient4dadapt( REAL* pa, REAL* pb, REAL* pc, REAL* pd, REAL* pe,
 	errbound = isperrboundB * permanent;
 	if(( det >= errbound ) || ( -det >= errbound ))
 	{
+		predstat( ORIENT4D, ADAPTB );
 		return det;
 	}
 
@@ -4812,6 +4919,7 @@ REAL orient4dadapt( REAL* pa, REAL* pb, REAL* pc, REAL* pd, REAL* pe,
 		&& ( aeheighttail == 0.0 ) && ( beheighttail == 0.0 )
 		&& ( ceheighttail == 0.0 ) && ( deheighttail == 0.0 ))
 	{
+		predstat( ORIENT4D, ADAPTC );
 		return det;
 	}
 
@@ -4846,9 +4954,11 @@ REAL orient4dadapt( REAL* pa, REAL* pb, REAL* pc, REAL* pd, REAL* pe,
 		+ ceheighttail * ( dez * ab3 + aez * bd3 + bez * da3 ) ) );
 	if(( det >= errbound ) || ( -det >= errbound ))
 	{
+		predstat( ORIENT4D, ADAPTC );
 		return det;
 	}
 
+	predstat( ORIENT4D, EXACT );
 	return orient4dexact( pa, pb, pc, pd, pe,
 						  aheight, bheight, cheight, dheight, eheight );
 }
@@ -4952,6 +5062,7 @@ REAL orient4d( REAL* pa, REAL* pb, REAL* pc, REAL* pd, REAL* pe,
 	errbound = isperrboundA * permanent;
 	if(( det > errbound ) || ( -det > errbound ))
 	{
+		predstat( ORIENT4D, DYNAMICFILTER );
 		return det;
 	}
 
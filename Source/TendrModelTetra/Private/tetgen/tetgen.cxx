@@ -17,6 +17,9 @@
 
 #include "tetgen.h"
 
+#include <atomic>
+#include <mutex>
+
 extern void myprintf( const char* format, ... );
 
 #pragma warning( disable : 4703 )
@@ -780,6 +783,15 @@ bool tetgenbehavior::parse_commandline( int argc, char **argv )
 						optscheme = ( argv[ i ][ j + 1 ] - '0' );
 						j++;
 					}
+					if(( argv[ i ][ j + 1 ] == '/' ) || ( argv[ i ][ j + 1 ] == ',' ))
+					{
+						j++;
+						if(( argv[ i ][ j + 1 ] >= '0' ) && ( argv[ i ][ j + 1 ] <= '1' ))
+						{
+							optparallel = ( argv[ i ][ j + 1 ] - '0' );
+							j++;
+						}
+					}
 				}
 			}
 			else if(argv[ i ][ j ] == 'T')
@@ -1250,6 +1262,29 @@ void tetgenmesh::arraypool::restart( )
 	objects = 0l;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// setmemorystats()    Select the memorystats of the calling thread.         //
+//                                                                           //
+// Pools created by the calling thread charge their memory to 'stats' until  //
+// it is set to NULL again.  Returns the memorystats selected before.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+static thread_local memorystats *_memstats = NULL;
+
+memorystats *setmemorystats( memorystats *stats )
+{
+	memorystats *previous = _memstats;
+	_memstats = stats;
+	return previous;
+}
+
+memorystats *getmemorystats( )
+{
+	return _memstats;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // poolinit()    Initialize an arraypool for allocation of objects.          //
@@ -1271,6 +1306,7 @@ void tetgenmesh::arraypool::poolinit( int sizeofobject, int log2objperblk )
 
 	// No memory has been allocated.
 	totalmemory = 0l;
+	memstats = getmemorystats( );
 	// The top array has not been allocated yet.
 	toparray = (char **)NULL;
 	toparraylen = 0;
@@ -1310,6 +1346,10 @@ tetgenmesh::arraypool::~arraypool( )
 		// Free the top array.
 		free( (void *)toparray );
 	}
+	if(memstats != NULL)
+	{
+		memstats->release( totalmemory );
+	}
 
 	// The top array is no longer allocated.
 	toparray = (char **)NULL;
@@ -1346,7 +1386,15 @@ char* tetgenmesh::arraypool::getblock( int objectindex )
 		// Allocate the top array big enough to hold 'topindex', and NULL out
 		//   its contents.
 		newsize = topindex + 128;
+		if(memstats != NULL)
+		{
+			memstats->charge( newsize * ( uintptr_t ) sizeof( char * ) );
+		}
 		toparray = (char **)malloc( (size_t)( newsize * sizeof( char * ) ) );
+		if(toparray == (char **)NULL)
+		{
+			terminatetetgen( NULL, 1 );
+		}
 		toparraylen = newsize;
 		for(i = 0; i < newsize; i++)
 		{
@@ -1365,7 +1413,15 @@ char* tetgenmesh::arraypool::getblock( int objectindex )
 		}
 		// Allocate the new array, copy the contents, NULL out the rest, and
 		//   free the old array.
+		if(memstats != NULL)
+		{
+			memstats->charge( ( newsize - toparraylen ) * sizeof( char * ) );
+		}
 		newarray = (char **)malloc( (size_t)( newsize * sizeof( char * ) ) );
+		if(newarray == (char **)NULL)
+		{
+			terminatetetgen( NULL, 1 );
+		}
 		for(i = 0; i < toparraylen; i++)
 		{
 			newarray[ i ] = toparray[ i ];
@@ -1386,7 +1442,15 @@ char* tetgenmesh::arraypool::getblock( int objectindex )
 	if(block == (char *)NULL)
 	{
 		// Allocate a block at this index.
+		if(memstats != NULL)
+		{
+			memstats->charge( objectsperblock * objectbytes );
+		}
 		block = (char *)malloc( (size_t)( objectsperblock * objectbytes ) );
+		if(block == (char *)NULL)
+		{
+			terminatetetgen( NULL, 1 );
+		}
 		toparray[ topindex ] = block;
 		// Account for the memory.
 		totalmemory += objectsperblock * objectbytes;
@@ -1455,6 +1519,19 @@ int tetgenmesh::arraypool::newindex( void **newptr )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// poollock    The mutex serializing alloc() and dealloc() of the pools      //
+//             shared by the views of a mesh (see memorypool::lock).         //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+class tetgenmesh::poollock
+{
+public:
+	std::mutex mutex;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // memorypool()   The constructors of memorypool.                            //
@@ -1474,6 +1551,9 @@ tetgenmesh::memorypool::memorypool( )
 	items = maxitems = 0l;
 	unallocateditems = 0;
 	pathitemsleft = 0;
+	totalmemory = 0l;
+	memstats = (memorystats *)NULL;
+	lock = (poollock *)NULL;
 }
 
 tetgenmesh::memorypool::memorypool( int bytecount, int itemcount, int wsize,
@@ -1496,6 +1576,10 @@ tetgenmesh::memorypool::~memorypool( )
 		free( firstblock );
 		firstblock = nowblock;
 	}
+	if(memstats != NULL)
+	{
+		memstats->release( totalmemory );
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1542,12 +1626,20 @@ void tetgenmesh::memorypool::poolinit( int bytecount, int itemcount, int wordsiz
 	// Allocate a block of items.  Space for `itemsperblock' items and one
 	//   pointer (to point to the next block) are allocated, as well as space
 	//   to ensure alignment of the items. 
+	totalmemory = 0l;
+	memstats = getmemorystats( );
+	lock = (poollock *)NULL;
+	if(memstats != NULL)
+	{
+		memstats->charge( itemsperblock * itembytes + sizeof(void *) + alignbytes );
+	}
 	firstblock = (void **)malloc( itemsperblock * itembytes + sizeof(void *)
 								  +alignbytes );
 	if(firstblock == (void **)NULL)
 	{
 		terminatetetgen( NULL, 1 );
 	}
+	totalmemory = itemsperblock * itembytes + sizeof(void *) + alignbytes;
 	// Set the next block pointer to NULL.
 	*( firstblock ) = (void *)NULL;
 	restart( );
@@ -1588,9 +1680,21 @@ void tetgenmesh::memorypool::restart( )
 //                                                                           //
 // alloc()   Allocate space for an item.                                     //
 //                                                                           //
+// allocitem() does the allocation, the caller must hold 'lock' (if any).    //
+//                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
 void* tetgenmesh::memorypool::alloc( )
+{
+	if(lock != NULL)
+	{
+		std::lock_guard<std::mutex> guard( lock->mutex );
+		return allocitem( );
+	}
+	return allocitem( );
+}
+
+void* tetgenmesh::memorypool::allocitem( )
 {
 	void *newitem;
 	void **newblock;
@@ -1612,12 +1716,18 @@ void* tetgenmesh::memorypool::alloc( )
 			if(*nowblock == (void *)NULL)
 			{
 				// Allocate a new block of items, pointed to by the previous block.
+				if(memstats != NULL)
+				{
+					memstats->charge( itemsperblock * itembytes + sizeof(void *) +
+									  alignbytes );
+				}
 				newblock = (void **)malloc( itemsperblock * itembytes + sizeof(void *)
 											+alignbytes );
 				if(newblock == (void **)NULL)
 				{
 					terminatetetgen( NULL, 1 );
 				}
+				totalmemory += itemsperblock * itembytes + sizeof(void *) + alignbytes;
 				*nowblock = (void *)newblock;
 				// The next block pointer is NULL.
 				*newblock = (void *)NULL;
@@ -1655,6 +1765,15 @@ void* tetgenmesh::memorypool::alloc( )
 
 void tetgenmesh::memorypool::dealloc( void *dyingitem )
 {
+	if(lock != NULL)
+	{
+		std::lock_guard<std::mutex> guard( lock->mutex );
+		*( (void **)dyingitem ) = deaditemstack;
+		deaditemstack = dyingitem;
+		items--;
+		return;
+	}
+
 	// Push freshly killed item onto stack.
 	*( (void **)dyingitem ) = deaditemstack;
 	deaditemstack = dyingitem;
@@ -1868,6 +1987,8 @@ void tetgenmesh::makepoint2submap( memorypool* pool, int*& idx2faclist,
 
 void tetgenmesh::tetrahedrondealloc( tetrahedron *dyingtetrahedron )
 {
+	tetrahedron **parytet;
+
 	// Set tetrahedron's vertices to NULL. This makes it possible to detect
 	//   dead tetrahedra when traversing the list of all tetrahedra.
 	dyingtetrahedron[ 4 ] = (tetrahedron)NULL;
@@ -1882,6 +2003,16 @@ void tetgenmesh::tetrahedrondealloc( tetrahedron *dyingtetrahedron )
 		tet2subpool->dealloc( (shellface *)dyingtetrahedron[ 9 ] );
 	}
 
+	if(view != NULL)
+	{
+		// A view checks if the tets of its batch are still alive, so a tet
+		//   is not reused by another view before the batch is done (it is
+		//   freed by mergeview()).
+		view->deadtets->newindex( (void **)&parytet );
+		*parytet = dyingtetrahedron;
+		return;
+	}
+
 	tetrahedrons->dealloc( (void *)dyingtetrahedron );
 }
 
@@ -2088,9 +2219,22 @@ void tetgenmesh::makeshellface( memorypool *pool, face *newface )
 
 void tetgenmesh::makepoint( point* pnewpoint, enum verttype vtype )
 {
+	long mark;
 	int i;
 
-	*pnewpoint = (point)points->alloc( );
+	if(points->lock != NULL)
+	{
+		// The pool is shared by the views of the mesh, take the marker with
+		//   the point.
+		std::lock_guard<std::mutex> guard( points->lock->mutex );
+		*pnewpoint = (point)points->allocitem( );
+		mark = points->items;
+	}
+	else
+	{
+		*pnewpoint = (point)points->alloc( );
+		mark = points->items;
+	}
 
 	// Initialize the point attributes.
 	for(i = 0; i < numpointattrib; i++)
@@ -2114,7 +2258,7 @@ void tetgenmesh::makepoint( point* pnewpoint, enum verttype vtype )
 		}
 	}
 	// Initialize the point marker (starting from in->firstnumber).
-	setpointmark( *pnewpoint, (int)( points->items ) - ( !in->firstnumber ) );
+	setpointmark( *pnewpoint, (int)( mark ) - ( !in->firstnumber ) );
 	// Clear all flags.
 	( (int *)( *pnewpoint ) )[ pointmarkindex + 1 ] = 0;
 	// Initialize (set) the point type. 
@@ -2445,6 +2589,193 @@ void tetgenmesh::initializepools( )
 	cavetetvertlist = new arraypool( sizeof( point ), 10 );
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// parallelloop()    Run a loop of independent work items.                   //
+//                                                                           //
+// The work items are handed to the user-supplied 'b->parallelfor' callback, //
+// which may run them concurrently. Without it, they are run in order.       //
+//                                                                           //
+// With TETGEN_TRACE, each work item is recorded as a "parallelitem" scope   //
+// on the thread running it.  Concurrent work items use the predicate        //
+// filters of the calling thread (the thread running them may be building    //
+// another mesh).  If predicates are counted ('b->predstats'), each          //
+// concurrent work item counts into counters of its own, which are added to  //
+// those of the calling thread when it is done.  The filters and counters of //
+// the thread running a work item are restored when it is done (see          //
+// predicatefiltersscope).  The pools of concurrent work items are not       //
+// accounted in 'b->memstats'.                                               //
+//                                                                           //
+// An error raised by terminatetetgen() in a concurrent work item is caught  //
+// on the thread running it (the callback may not propagate it), the work    //
+// items not started yet are skipped, and the first error is raised again on //
+// the calling thread after the loop.                                        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+struct wrappedloop
+{
+	tetgenbehavior *b;
+	tetgenbehavior::LoopBody body;
+	void *ctx;
+	predicatestats *stats;    // The counters of the calling thread, or NULL.
+	std::mutex statslock;
+	predicatefilters filters;
+	std::atomic<int> failed;
+	int error;
+};
+
+static void wrappedloopbody( void* ctx, int i )
+{
+	wrappedloop *loop = (wrappedloop *)ctx;
+	predicatestats itemstats;
+	int expected, error;
+	TETGEN_TRACE_SCOPE( loop->b, "parallelitem" );
+
+	if(loop->failed.load( std::memory_order_relaxed ))
+	{
+		return; // A previous work item failed, the loop is unwound.
+	}
+
+	error = 0;
+	{
+		predicatefiltersscope filtersscope( &( loop->filters ) );
+		predicatestatsscope statsscope( loop->stats != NULL ? &itemstats : NULL );
+		try
+		{
+			loop->body( loop->ctx, i );
+		}
+		catch(int x)
+		{
+			error = x;
+		}
+		catch(...)
+		{
+			error = 1; // E.g., std::bad_alloc.
+		}
+	}
+
+	if(loop->stats != NULL)
+	{
+		std::lock_guard<std::mutex> lock( loop->statslock );
+		loop->stats->add( itemstats );
+	}
+
+	if(error != 0)
+	{
+		// Keep the first error.
+		expected = 0;
+		if(loop->failed.compare_exchange_strong( expected, 1 ))
+		{
+			loop->error = error;
+		}
+	}
+}
+
+void tetgenmesh::parallelloop( int count, tetgenbehavior::LoopBody body,
+							   void* ctx )
+{
+	wrappedloop loop;
+	int concurrent;
+	int i;
+
+	if(count <= 0)
+	{
+		return;
+	}
+
+	TETGEN_TRACE_SCOPE( b, "parallelloop" );
+
+	concurrent = ( b->parallelfor != NULL ) && ( count > 1 );
+
+	loop.b = b;
+	loop.body = body;
+	loop.ctx = ctx;
+	loop.stats = concurrent ? getpredicatestats( ) : NULL;
+	loop.failed = 0;
+	loop.error = 0;
+	getpredicatefilters( &( loop.filters ) );
+#ifdef TETGEN_TRACE
+	if(b->traceevent != NULL)
+	{
+		body = wrappedloopbody;
+		ctx = &loop;
+	}
+#endif // #ifdef TETGEN_TRACE
+	if(concurrent)
+	{
+		body = wrappedloopbody;
+		ctx = &loop;
+	}
+
+	if(concurrent)
+	{
+		// The calling thread may run work items as well.
+		memorystatsscope memscope( NULL );
+		b->parallelfor( count, body, ctx );
+	}
+	else
+	{
+		for(i = 0; i < count; i++)
+		{
+			body( ctx, i );
+		}
+	}
+
+	if(loop.failed)
+	{
+		terminatetetgen( this, loop.error );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// pollprogress()    Report the progress of a stage and check for a request  //
+//                   to cancel.                                              //
+//                                                                           //
+// It is cheap enough to be called for every work item of a main loop: the   //
+// user-supplied 'b->progress' callback is only called on every 256th poll,  //
+// and on the first poll of each stage.                                      //
+// The run is also cancelled once the memory budget 'b->memstats' has been   //
+// exceeded.  Returns the termination code (11 if the user cancelled, 12 if  //
+// the budget was exceeded) once the run is cancelled, else 0.  The caller   //
+// must then free any memory it owns and call terminatetetgen() with it.     //
+// Memory owned by the mesh is freed by its destructor.                      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::pollprogress( const char *stage, REAL fraction )
+{
+	if(progresscancel)
+	{
+		return progresscancel;
+	}
+
+	if(( b->memstats != NULL ) && ( b->memstats->exceededstage != NULL ))
+	{
+		progresscancel = 12;
+		return progresscancel;
+	}
+
+	if(b->progress == NULL)
+	{
+		return 0;
+	}
+
+	if((( progresspolls++ & 255l ) == 0l) || ( stage != progressstage ))
+	{
+		progressstage = stage;
+		if(fraction < 0.0) fraction = 0.0;
+		if(fraction > 1.0) fraction = 1.0;
+		if(b->progress( b->progresshandle, stage, fraction ) != 0)
+		{
+			progresscancel = 11;
+		}
+	}
+
+	return progresscancel;
+}
+
 ////                                                                       ////
 ////                                                                       ////
 //// mempool_cxx //////////////////////////////////////////////////////////////
@@ -5644,6 +5975,7 @@ void tetgenmesh::flip23( triface* fliptets, int hullflag, flipconstraints *fc )
 	pe = oppo( fliptets[ 1 ] );
 
 	flip23count++;
+	opstat( tetgenopstats::FLIP23, fliplevel );
 
 	// Get the outer boundary faces.
 	for(i = 0; i < 3; i++)
@@ -6067,6 +6399,7 @@ void tetgenmesh::flip32( triface* fliptets, int hullflag, flipconstraints *fc )
 	pe = org( fliptets[ 0 ] );
 
 	flip32count++;
+	opstat( tetgenopstats::FLIP32, fliplevel );
 
 	// Get the outer boundary faces.
 	for(i = 0; i < 3; i++)
@@ -6508,6 +6841,7 @@ void tetgenmesh::flip41( triface* fliptets, int hullflag, flipconstraints *fc )
 	pp = org( fliptets[ 0 ] ); // The removing vertex.
 
 	flip41count++;
+	opstat( tetgenopstats::FLIP41, fliplevel );
 
 	// Get the outer boundary faces.
 	for(i = 0; i < 3; i++)
@@ -6892,11 +7226,17 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 	int edgepivot;
 	int n1, nn;
 	int t1ver;
+	int prevfliplevel;
 	int i, j;
 
 	pa = org( abtets[ 0 ] );
 	pb = dest( abtets[ 0 ] );
 
+	opstat( tetgenopstats::FLIPNMLEVEL, level );
+	opstat( tetgenopstats::FLIPNMSTAR, n );
+	prevfliplevel = fliplevel;
+	fliplevel = level + 1;
+
 	if(n > 3)
 	{
 		// Try to reduce the size of the Star(ab) by flipping a face in it. 
@@ -7078,6 +7418,7 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 					if(nn == 2)
 					{
 						// The edge has been flipped.
+						fliplevel = prevfliplevel;
 						return nn;
 					}
 					else
@@ -7125,6 +7466,7 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 					{
 						// The flips are not reversed. The current Star(ab) can not be
 						//   further reduced. Return its current size (# of tets).
+						fliplevel = prevfliplevel;
 						return nn;
 					}
 					// unflip is set. 
@@ -7216,11 +7558,19 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 					spintet = flipedge;
 					while(1)
 					{
+						if(( view != NULL ) && !tetinblock( spintet ))
+						{
+							// A view only flips the tets in its block.
+							view->deferred = 1;
+							n1 = 0;
+							break;
+						}
 						n1++;
 						j += ( elemcounter( spintet ) );
 						fnextself( spintet );
 						if(spintet.tet == flipedge.tet) break;
 					}
+					if(n1 == 0) continue;
 					if(n1 < 3)
 					{
 						// This is only possible when the mesh contains inverted
@@ -7308,6 +7658,7 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 						if(nn == 2)
 						{
 							// The edge has been flipped.
+							fliplevel = prevfliplevel;
 							return nn;
 						}
 						else
@@ -7388,6 +7739,7 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 						{
 							// The flips are not reversed. The current Star(ab) can not be
 							//   further reduced. Return its size (# of tets).
+							fliplevel = prevfliplevel;
 							return nn;
 						}
 						// unflip is set. 
@@ -7615,6 +7967,7 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 							{
 								increaseelemcounter( abtets[ j ] );
 							}
+							fliplevel = prevfliplevel;
 							return 3;
 						}
 					} // if (level == 0)
@@ -7646,12 +7999,14 @@ int tetgenmesh::flipnm( triface* abtets, int n, int level, int abedgepivot,
 						}
 					}
 				} // if (fc->collectnewtets)
+				fliplevel = prevfliplevel;
 				return 2;
 			}
 		} // if (reducflag)
 	} // if (n == 3)
 
 	// The current (reduced) Star size.
+	fliplevel = prevfliplevel;
 	return n;
 }
 
@@ -7920,6 +8275,43 @@ int tetgenmesh::insertpoint( point insertpt, triface *searchtet, face *splitsh,
 
 	ivf->iloc = (int)loc; // The return value.
 
+	if(view != NULL)
+	{
+		// A view only changes the tets in its block (see meshview). Check the
+		//   tets containing the point, each shares a face or an edge in the
+		//   block with the previous one.
+		j = 1;
+		if(( loc == INTETRAHEDRON ) || ( loc == ONFACE ))
+		{
+			j = tetinblock( *searchtet );
+			if(j && ( loc == ONFACE ))
+			{
+				fsym( *searchtet, spintet );
+				j = tetinblock( spintet );
+			}
+		}
+		else if(loc == ONEDGE)
+		{
+			j = inblock( org( *searchtet ) ) && inblock( dest( *searchtet ) );
+			spintet = *searchtet;
+			while(j)
+			{
+				j = tetinblock( spintet );
+				fnextself( spintet );
+				if(spintet.tet == searchtet->tet) break;
+			}
+		}
+		else if(loc == OUTSIDE)
+		{
+			j = 0; // The hull is not changed by a view.
+		}
+		if(!j)
+		{
+			ivf->iloc = (int)OUTSIDEBLOCK;
+			return 0;
+		}
+	}
+
 	if(b->weighted)
 	{
 		if(loc != OUTSIDE)
@@ -8246,6 +8638,23 @@ int tetgenmesh::insertpoint( point insertpt, triface *searchtet, face *splitsh,
 					marktest( *cavetet ); // Only test it once.
 				} // if (!marktested(*cavetet))
 
+				if(enqflag && ( view != NULL ))
+				{
+					// The cavity of a view may include a hull tet at a face in its
+					//   block (it is cut by the validation, see below).
+					pts = (point *)cavetet->tet;
+					if(!( inblock( pts[ 4 ] ) && inblock( pts[ 5 ] ) && inblock( pts[ 6 ] ) &&
+						( ( pts[ 7 ] == dummypoint ) || inblock( pts[ 7 ] ) ) ))
+					{
+						// The cavity leaves the block. 'cavetet' is marked, let it be
+						//   unmarked.
+						cavebdrylist->newindex( (void **)&parytet );
+						*parytet = *cavetet;
+						insertpoint_abort( splitseg, ivf );
+						ivf->iloc = (int)OUTSIDEBLOCK;
+						return 0;
+					}
+				}
 				if(enqflag)
 				{
 					// Found a tet in the cavity. Put other three faces in check list.
@@ -9031,6 +9440,48 @@ int tetgenmesh::insertpoint( point insertpt, triface *searchtet, face *splitsh,
 		return 1;
 	}
 
+	if(view != NULL)
+	{
+		// The final cavity of a view is in its block (the hull is not changed).
+		for(i = 0; i < caveoldtetlist->objects; i++)
+		{
+			cavetet = (triface *)fastlookup( caveoldtetlist, i );
+			if(!tetinblock( *cavetet ))
+			{
+				insertpoint_abort( splitseg, ivf );
+				ivf->iloc = (int)OUTSIDEBLOCK;
+				return 0;
+			}
+		}
+	}
+
+	if(( view != NULL ) && checksubsegflag)
+	{
+		// The tets at the segments of C(p) are connected to them again. They
+		//   must have all but one vertices in the block, so no other view
+		//   reads them.
+		for(i = 0; i < cavetetseglist->objects; i++)
+		{
+			paryseg = (face *)fastlookup( cavetetseglist, i );
+			sstpivot1( *paryseg, neightet );
+			spintet = neightet;
+			while(1)
+			{
+				j = inblock( org( spintet ) ) + inblock( dest( spintet ) ) +
+					inblock( apex( spintet ) ) + inblock( oppo( spintet ) );
+				if(j < ( ishulltet( spintet ) ? 2 : 3 )) break;
+				fnextself( spintet );
+				if(spintet.tet == neightet.tet) break;
+			}
+			if(j < ( ishulltet( spintet ) ? 2 : 3 ))
+			{
+				insertpoint_abort( splitseg, ivf );
+				ivf->iloc = (int)OUTSIDEBLOCK;
+				return 0;
+			}
+		}
+	}
+
 	// Before re-mesh C(p). Process the segments and subfaces which are on the
 	//   boundary of C(p). Make sure that each such segment or subface is
 	//   connecting to a tet outside C(p). So we can re-connect them to the
@@ -9170,6 +9621,8 @@ int tetgenmesh::insertpoint( point insertpt, triface *searchtet, face *splitsh,
 		} // i
 	} // if (checksubfaceflag)
 
+	opstat( tetgenopstats::CAVITYSIZE, caveoldtetlist->objects );
+
 	// Create new tetrahedra to fill the cavity.
 
 	for(i = 0; i < cavebdrylist->objects; i++)
@@ -9219,6 +9672,10 @@ int tetgenmesh::insertpoint( point insertpt, triface *searchtet, face *splitsh,
 
 	// Set a handle for speeding point location.
 	recenttet = newtet;
+	if(locgrid != NULL)
+	{
+		locgrid[ locgridcell( insertpt ) ] = newtet.tet;
+	}
 	//setpoint2tet(insertpt, encode(newtet));
 	setpoint2tet( insertpt, (tetrahedron)( newtet.tet ) );
 
@@ -9721,6 +10178,8 @@ void tetgenmesh::transfernodes( )
 	int mtrindex;
 	int i, j;
 
+	TETGEN_TRACE_SCOPE( b, "transfernodes" );
+
 	// Read the points.
 	coordindex = 0;
 	attribindex = 0;
@@ -10122,17 +10581,26 @@ void tetgenmesh::brio_multiscale_sort( point* vertexarray, int arraysize,
 //                                                                           //
 // randomnation()    Generate a random number between 0 and 'choices' - 1.   //
 //                                                                           //
+// The second form advances the given 'seed' instead of 'randomseed', it can //
+// be used by concurrent work items which each own a seed.                   //
+//                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
 unsigned long tetgenmesh::randomnation( unsigned int choices )
+{
+	return randomnation( choices, &randomseed );
+}
+
+unsigned long tetgenmesh::randomnation( unsigned int choices,
+										unsigned long *seed )
 {
 	unsigned long newrandom;
 
 	if(choices >= 714025l)
 	{
-		newrandom = ( randomseed * 1366l + 150889l ) % 714025l;
-		randomseed = ( newrandom * 1366l + 150889l ) % 714025l;
-		newrandom = newrandom * ( choices / 714025l ) + randomseed;
+		newrandom = ( *seed * 1366l + 150889l ) % 714025l;
+		*seed = ( newrandom * 1366l + 150889l ) % 714025l;
+		newrandom = newrandom * ( choices / 714025l ) + *seed;
 		if(newrandom >= choices)
 		{
 			return newrandom - choices;
@@ -10144,8 +10612,8 @@ unsigned long tetgenmesh::randomnation( unsigned int choices )
 	}
 	else
 	{
-		randomseed = ( randomseed * 1366l + 150889l ) % 714025l;
-		return randomseed % choices;
+		*seed = ( *seed * 1366l + 150889l ) % 714025l;
+		return *seed % choices;
 	}
 }
 
@@ -10158,11 +10626,15 @@ unsigned long tetgenmesh::randomnation( unsigned int choices )
 // sample.  The choice is made by determining which one's origin is closest  //
 // to the point we are searching for.                                        //
 //                                                                           //
+// If 'b->gridlocate' is set, the tet kept in the grid cell of the point is  //
+// used instead of the random sample (see locgridbuild()).                   //
+//                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
 void tetgenmesh::randomsample( point searchpt, triface *searchtet )
 {
 	tetrahedron *firsttet, *tetptr;
+	triface gridtet;
 	point torg;
 	void **sampleblock;
 	uintptr_t alignptr;
@@ -10215,6 +10687,24 @@ void tetgenmesh::randomsample( point searchpt, triface *searchtet )
 		searchdist = longest;
 	}
 
+	if(b->gridlocate)
+	{
+		// Take the tet kept in the grid cell of the point. Only if there is no
+		//   such tet, use random samples.
+		if(locgridsample( searchpt, &gridtet ))
+		{
+			torg = org( gridtet );
+			dist = ( searchpt[ 0 ] - torg[ 0 ] ) * ( searchpt[ 0 ] - torg[ 0 ] ) +
+				( searchpt[ 1 ] - torg[ 1 ] ) * ( searchpt[ 1 ] - torg[ 1 ] ) +
+				( searchpt[ 2 ] - torg[ 2 ] ) * ( searchpt[ 2 ] - torg[ 2 ] );
+			if(dist < searchdist)
+			{
+				*searchtet = gridtet;
+			}
+			return;
+		}
+	}
+
 	// Select "good" candidate using k random samples, taking the closest one.
 	//   The number of random samples taken is proportional to the fourth root
 	//   of the number of tetrahedra in the mesh. 
@@ -10272,6 +10762,184 @@ void tetgenmesh::randomsample( point searchpt, triface *searchtet )
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// locgridbuild()    Build the uniform grid of tets for point location.      //
+//                                                                           //
+// The grid covers the bounding box of the points, with about four tets per  //
+// cell. Every cell keeps one tet, initially a tet whose origin lies in the  //
+// cell. Afterwards the cells are updated by locate() and insertpoint(). A   //
+// kept tet may be deleted later, this is detected by locgridsample().       //
+//                                                                           //
+// The tets are collected directly from the blocks of the pool (the same as  //
+// randomsample() does) so that a traversal of the pool is not disturbed.    //
+// The grid is rebuilt when the number of tets has grown by eight times.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::locgridbuild( )
+{
+	tetrahedron *firsttet, *tetptr;
+	void **tetblock;
+	uintptr_t alignptr;
+	REAL len[ 3 ], vol;
+	long tetblocks, blockitems, cellnum, i, j;
+
+	if(locgrid != NULL)
+	{
+		totalworkmemory -= ( locgridcells * sizeof( tetrahedron * ) );
+		delete[ ] locgrid;
+	}
+
+	len[ 0 ] = xmax - xmin;
+	len[ 1 ] = ymax - ymin;
+	len[ 2 ] = zmax - zmin;
+	for(i = 0; i < 3; i++)
+	{
+		// Avoid a flat box.
+		if(len[ i ] < longest * 1.0e-3) len[ i ] = longest * 1.0e-3;
+	}
+	vol = len[ 0 ] * len[ 1 ] * len[ 2 ];
+
+	cellnum = tetrahedrons->items / 4l;
+	if(cellnum < 1l) cellnum = 1l;
+	locgridsize = pow( vol / (REAL)cellnum, 1.0 / 3.0 );
+	locgridmin[ 0 ] = xmin;
+	locgridmin[ 1 ] = ymin;
+	locgridmin[ 2 ] = zmin;
+	locgridcells = 1l;
+	for(i = 0; i < 3; i++)
+	{
+		locgriddim[ i ] = (int)( len[ i ] / locgridsize ) + 1;
+		locgridcells *= locgriddim[ i ];
+	}
+
+	if(b->verbose > 2)
+	{
+		myprintf( "      Building a %d x %d x %d grid for point location.\n",
+				locgriddim[ 0 ], locgriddim[ 1 ], locgriddim[ 2 ] );
+	}
+
+	locgrid = new tetrahedron*[ locgridcells ];
+	for(i = 0; i < locgridcells; i++)
+	{
+		locgrid[ i ] = NULL;
+	}
+
+	tetblocks = ( tetrahedrons->maxitems + b->tetrahedraperblock - 1 )
+		/ b->tetrahedraperblock;
+	tetblock = tetrahedrons->firstblock;
+	for(i = 0; i < tetblocks; i++)
+	{
+		alignptr = (uintptr_t)( tetblock + 1 );
+		firsttet = (tetrahedron *)
+			( alignptr + (uintptr_t)tetrahedrons->alignbytes
+			- ( alignptr % (uintptr_t)tetrahedrons->alignbytes ) );
+		blockitems = b->tetrahedraperblock;
+		if(i == tetblocks - 1)
+		{
+			// This is the last block.
+			blockitems = tetrahedrons->maxitems - ( i * b->tetrahedraperblock );
+		}
+		for(j = 0; j < blockitems; j++)
+		{
+			tetptr = (tetrahedron *)( firsttet + ( j * tetrahedrons->itemwords ) );
+			if(tetptr[ 4 ] != NULL)
+			{
+				locgrid[ locgridcell( (point)tetptr[ 4 ] ) ] = tetptr;
+			}
+		}
+		tetblock = (void **)*tetblock;
+	}
+
+	totalworkmemory += ( locgridcells * sizeof( tetrahedron * ) );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// locgridcell()    Return the grid cell which contains a point.             //
+//                                                                           //
+// Points outside the bounding box are clamped to the boundary cells.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+long tetgenmesh::locgridcell( point pt )
+{
+	int idx[ 3 ], i;
+
+	for(i = 0; i < 3; i++)
+	{
+		idx[ i ] = (int)floor( ( pt[ i ] - locgridmin[ i ] ) / locgridsize );
+		if(idx[ i ] < 0) idx[ i ] = 0;
+		if(idx[ i ] >= locgriddim[ i ]) idx[ i ] = locgriddim[ i ] - 1;
+	}
+
+	return ( (long)idx[ 2 ] * locgriddim[ 1 ] + idx[ 1 ] ) * locgriddim[ 0 ] + idx[ 0 ];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// locgridsample()    Find a starting tet for point location in the grid.    //
+//                                                                           //
+// Returns the tet kept in the cell of 'searchpt', or if it is empty or the  //
+// tet has been deleted, in one of the 26 neighbor cells. Returns 0 if no    //
+// live tet is found. The grid is (re)built if necessary.                    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::locgridsample( point searchpt, triface *searchtet )
+{
+	tetrahedron *tetptr;
+	long cell;
+	int idx[ 3 ], nidx[ 3 ];
+	int i, j, k, l;
+
+	if(( locgrid == NULL ) || ( locgridcells * 32l < tetrahedrons->items ))
+	{
+		locgridbuild( );
+	}
+
+	cell = locgridcell( searchpt );
+	tetptr = locgrid[ cell ];
+	if(( tetptr != NULL ) && ( tetptr[ 4 ] != NULL ))
+	{
+		searchtet->tet = tetptr;
+		searchtet->ver = 11; // torg = org(t);
+		return 1;
+	}
+
+	idx[ 0 ] = (int)( cell % locgriddim[ 0 ] );
+	idx[ 1 ] = (int)( ( cell / locgriddim[ 0 ] ) % locgriddim[ 1 ] );
+	idx[ 2 ] = (int)( cell / ( (long)locgriddim[ 0 ] * locgriddim[ 1 ] ) );
+	for(i = -1; i <= 1; i++)
+	{
+		for(j = -1; j <= 1; j++)
+		{
+			for(k = -1; k <= 1; k++)
+			{
+				nidx[ 0 ] = idx[ 0 ] + k;
+				nidx[ 1 ] = idx[ 1 ] + j;
+				nidx[ 2 ] = idx[ 2 ] + i;
+				for(l = 0; l < 3; l++)
+				{
+					if(( nidx[ l ] < 0 ) || ( nidx[ l ] >= locgriddim[ l ] )) break;
+				}
+				if(l < 3) continue;
+				tetptr = locgrid[ ( (long)nidx[ 2 ] * locgriddim[ 1 ] + nidx[ 1 ] ) *
+					locgriddim[ 0 ] + nidx[ 0 ] ];
+				if(( tetptr != NULL ) && ( tetptr[ 4 ] != NULL ))
+				{
+					searchtet->tet = tetptr;
+					searchtet->ver = 11;
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // locate()    Find a tetrahedron containing a given point.                  //
@@ -10301,6 +10969,7 @@ enum tetgenmesh::locateresult
 		enum { ORGMOVE, DESTMOVE, APEXMOVE } nextmove;
 		REAL ori, oriorg, oridest, oriapex;
 		enum locateresult loc = OUTSIDE;
+		long steps = 0l;
 		int t1ver;
 		int s;
 
@@ -10336,6 +11005,7 @@ enum tetgenmesh::locateresult
 		while(true)
 		{
 
+			steps++;
 			toppo = oppo( *searchtet );
 
 			// Check if the vertex is we seek.
@@ -10519,6 +11189,17 @@ enum tetgenmesh::locateresult
 					break;
 				}
 			}
+			if(view != NULL)
+			{
+				// A view only enters a tet with two vertices in its block, the
+				//   other views do not change such a tet.
+				if(inblock( org( *searchtet ) ) + inblock( dest( *searchtet ) ) +
+					inblock( apex( *searchtet ) ) < 2)
+				{
+					loc = OUTSIDEBLOCK;
+					break;
+				}
+			}
 			// Move to the adjacent tetrahedron (maybe a hull tetrahedron).
 			fsymself( *searchtet );
 			if(oppo( *searchtet ) == dummypoint)
@@ -10534,6 +11215,17 @@ enum tetgenmesh::locateresult
 
 		} // while (true)
 
+		locatecount++;
+		locatesteps += steps;
+		if(steps > locatemaxsteps) locatemaxsteps = steps;
+		opstat( tetgenopstats::LOCATEWALK, steps );
+
+		if(( locgrid != NULL ) && ( loc != OUTSIDE ))
+		{
+			// Keep this tet for locating nearby points.
+			locgrid[ locgridcell( searchpt ) ] = searchtet->tet;
+		}
+
 		return loc;
 	}
 
@@ -10960,6 +11652,8 @@ void tetgenmesh::incrementaldelaunay( clock_t& tv )
 	int ngroup = 0;
 	int i, j;
 
+	TETGEN_TRACE_SCOPE( b, "incrementaldelaunay" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Delaunizing vertices...\n" );
@@ -11127,18 +11821,24 @@ void tetgenmesh::incrementaldelaunay( clock_t& tv )
 
 	for(i = 4; i < in->numberofpoints; i++)
 	{
+		if(pollprogress( "incrementaldelaunay", (REAL)i / (REAL)in->numberofpoints ))
+		{
+			delete[ ] permutarray;
+			terminatetetgen( this, progresscancel );
+		}
 		if(pointtype( permutarray[ i ] ) == UNUSEDVERTEX)
 		{
 			setpointtype( permutarray[ i ], VOLVERTEX );
 		}
-		if(b->brio_hilbert || b->no_sort)
+		if(( b->brio_hilbert || b->no_sort ) && !b->gridlocate)
 		{ // -b or -b/1
 			// Start the last updated tet.
 			searchtet.tet = recenttet.tet;
 		}
 		else
 		{ // -b0
-			// Randomly choose the starting tet for point location.
+			// Randomly choose the starting tet for point location. With a grid,
+			//   the closer one of the grid tet and the last updated tet is used.
 			searchtet.tet = NULL;
 		}
 		ivf.iloc = (int)OUTSIDE;
@@ -14139,11 +14839,36 @@ void tetgenmesh::meshsurface( )
 	int end1, end2;
 	int shmark, i, j;
 
+	TETGEN_TRACE_SCOPE( b, "meshsurface" );
+
+	// For a triangle soup ('in->trianglelist').
+	tetgenio::facet trifacet;
+	tetgenio::polygon tripolygon;
+	int trivertexlist[ 3 ];
+	int numberoffacets;
+
 	if(!b->quiet)
 	{
 		myprintf( "Creating surface mesh ...\n" );
 	}
 
+	if(in->trianglelist != NULL)
+	{
+		// Each triangle is read as a facet with one polygon. The corners are
+		//   copied, so the (caller-owned) list is not modified.
+		tripolygon.vertexlist = trivertexlist;
+		tripolygon.numberofvertices = 3;
+		trifacet.polygonlist = &tripolygon;
+		trifacet.numberofpolygons = 1;
+		trifacet.holelist = NULL;
+		trifacet.numberofholes = 0;
+		numberoffacets = in->numberoftriangles;
+	}
+	else
+	{
+		numberoffacets = in->numberoffacets;
+	}
+
 	// Create a map from indices to points.
 	makeindex2pointmap( idx2verlist );
 
@@ -14152,11 +14877,22 @@ void tetgenmesh::meshsurface( )
 	conlist = new arraypool( 2 * sizeof( point * ), 8 );
 
 	// Loop the facet list, triangulate each facet.
-	for(shmark = 1; shmark <= in->numberoffacets; shmark++)
+	for(shmark = 1; shmark <= numberoffacets; shmark++)
 	{
 
 		// Get a facet F.
-		f = &in->facetlist[ shmark - 1 ];
+		if(in->trianglelist != NULL)
+		{
+			for(i = 0; i < 3; i++)
+			{
+				trivertexlist[ i ] = in->trianglelist[ ( shmark - 1 ) * 3 + i ];
+			}
+			f = &trifacet;
+		}
+		else
+		{
+			f = &in->facetlist[ shmark - 1 ];
+		}
 
 		// Process the duplicated points first, they are marked with type
 		//   DUPLICATEDVERTEX.  If p and q are duplicated, and p'index > q's,
@@ -14620,6 +15356,524 @@ void tetgenmesh::detectinterfaces( )
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// bvhbuild()    Build a bounding volume hierarchy of a set of triangles.    //
+//                                                                           //
+// 'tribox' holds the bounding box (xmin, ymin, zmin, xmax, ymax, zmax) of   //
+// each triangle. On return, 'bvhtris' lists the triangles such that each    //
+// leaf of the hierarchy owns a contiguous range of it. 'nodes' must have    //
+// room for 2 * numtris nodes. Return the number of nodes used.              //
+//                                                                           //
+// Each node is split at the median of the triangle centers along the axis   //
+// of its longest extent. So the tree is balanced and its depth is at most   //
+// log2(numtris) + 1.                                                        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::bvhbuild( REAL* tribox, int* bvhtris, int numtris,
+						  bvhnode* nodes )
+{
+	const int leafsize = 4;
+	int stack[ 128 ];
+	int stacksize;
+	int numnodes;
+	bvhnode *node;
+	REAL *box, key, pivot, len, maxlen;
+	int lo, hi, i, j, k, mid, axis, tmp;
+
+	for(i = 0; i < numtris; i++)
+	{
+		bvhtris[ i ] = i;
+	}
+
+	nodes[ 0 ].first = 0;
+	nodes[ 0 ].count = numtris;
+	numnodes = 1;
+	stack[ 0 ] = 0;
+	stacksize = 1;
+
+	while(stacksize > 0)
+	{
+		node = &nodes[ stack[ --stacksize ] ];
+
+		// Calculate the bounding box of this node.
+		for(k = 0; k < 3; k++)
+		{
+			node->bmin[ k ] = tribox[ bvhtris[ node->first ] * 6 + k ];
+			node->bmax[ k ] = tribox[ bvhtris[ node->first ] * 6 + 3 + k ];
+		}
+		for(i = node->first + 1; i < node->first + node->count; i++)
+		{
+			box = &( tribox[ bvhtris[ i ] * 6 ] );
+			for(k = 0; k < 3; k++)
+			{
+				if(box[ k ] < node->bmin[ k ]) node->bmin[ k ] = box[ k ];
+				if(box[ 3 + k ] > node->bmax[ k ]) node->bmax[ k ] = box[ 3 + k ];
+			}
+		}
+
+		if(node->count <= leafsize)
+		{
+			node->left = -1;
+			continue;
+		}
+
+		// Choose the axis of the longest extent.
+		axis = 0;
+		maxlen = node->bmax[ 0 ] - node->bmin[ 0 ];
+		for(k = 1; k < 3; k++)
+		{
+			len = node->bmax[ k ] - node->bmin[ k ];
+			if(len > maxlen)
+			{
+				maxlen = len;
+				axis = k;
+			}
+		}
+
+		// Partition the triangles at their median center (quickselect). The
+		//   center is scaled by 2 (min + max), which keeps the same order.
+		mid = node->first + node->count / 2;
+		lo = node->first;
+		hi = node->first + node->count - 1;
+		while(lo < hi)
+		{
+			box = &( tribox[ bvhtris[ ( lo + hi ) / 2 ] * 6 ] );
+			pivot = box[ axis ] + box[ 3 + axis ];
+			i = lo;
+			j = hi;
+			while(i <= j)
+			{
+				while(1)
+				{
+					box = &( tribox[ bvhtris[ i ] * 6 ] );
+					key = box[ axis ] + box[ 3 + axis ];
+					if(key >= pivot) break;
+					i++;
+				}
+				while(1)
+				{
+					box = &( tribox[ bvhtris[ j ] * 6 ] );
+					key = box[ axis ] + box[ 3 + axis ];
+					if(key <= pivot) break;
+					j--;
+				}
+				if(i <= j)
+				{
+					tmp = bvhtris[ i ];
+					bvhtris[ i ] = bvhtris[ j ];
+					bvhtris[ j ] = tmp;
+					i++;
+					j--;
+				}
+			}
+			if(mid <= j)
+			{
+				hi = j;
+			}
+			else if(mid >= i)
+			{
+				lo = i;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		node->left = numnodes;
+		nodes[ numnodes ].first = node->first;
+		nodes[ numnodes ].count = mid - node->first;
+		nodes[ numnodes + 1 ].first = mid;
+		nodes[ numnodes + 1 ].count = node->first + node->count - mid;
+		stack[ stacksize++ ] = numnodes;
+		stack[ stacksize++ ] = numnodes + 1;
+		numnodes += 2;
+	}
+
+	return numnodes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// selfinterchunk()    Find the intersecting triangles of a chunk.           //
+//                                                                           //
+// The triangles of the chunk are queried in the hierarchy. A pair of tri-   //
+// angles (i, j) is only collected by triangle i if i < j and their bounding //
+// boxes overlap. The collected pairs are then tested as a batch by the      //
+// exact test tri_tri_inter().  Chunks share no writable data, so they can   //
+// be processed concurrently.                                                //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::selfinterchunk( void* jobptr, int chunk )
+{
+	selfinterjob *job = (selfinterjob *)jobptr;
+	bvhnode *node;
+	REAL *pointlist = job->m->in->pointlist;
+	REAL *box, *tbox;
+	int *candidates, *newcandidates, *pairs;
+	int numcandidates, maxcandidates, numpairs;
+	int stack[ 128 ];
+	int stacksize;
+	int first, last, i, j, k, n;
+	int *ci, *cj;
+	REAL *pi[ 3 ], *pj[ 3 ];
+	REAL s1, s2;
+	int sharedj[ 3 ] = { 0, 0, 0 };
+	int shared, unsharedj;
+	enum interresult intersect;
+
+	first = chunk * job->chunksize;
+	last = first + job->chunksize;
+	if(last > job->numtris)
+	{
+		last = job->numtris;
+	}
+
+	// Collect the candidate pairs.
+	maxcandidates = 4 * ( last - first ) + 16;
+	candidates = new int[ maxcandidates * 2 ];
+	numcandidates = 0;
+
+	for(i = first; i < last; i++)
+	{
+		box = &( job->tribox[ i * 6 ] );
+		stack[ 0 ] = 0;
+		stacksize = 1;
+		while(stacksize > 0)
+		{
+			node = &( job->bvhnodes[ stack[ --stacksize ] ] );
+			if(( node->bmin[ 0 ] > box[ 3 ] ) || ( node->bmax[ 0 ] < box[ 0 ] ) ||
+			   ( node->bmin[ 1 ] > box[ 4 ] ) || ( node->bmax[ 1 ] < box[ 1 ] ) ||
+			   ( node->bmin[ 2 ] > box[ 5 ] ) || ( node->bmax[ 2 ] < box[ 2 ] ))
+			{
+				continue;
+			}
+			if(node->left >= 0)
+			{
+				stack[ stacksize++ ] = node->left;
+				stack[ stacksize++ ] = node->left + 1;
+				continue;
+			}
+			for(n = node->first; n < node->first + node->count; n++)
+			{
+				j = job->bvhtris[ n ];
+				if(j <= i) continue;
+				tbox = &( job->tribox[ j * 6 ] );
+				if(( tbox[ 0 ] > box[ 3 ] ) || ( tbox[ 3 ] < box[ 0 ] ) ||
+				   ( tbox[ 1 ] > box[ 4 ] ) || ( tbox[ 4 ] < box[ 1 ] ) ||
+				   ( tbox[ 2 ] > box[ 5 ] ) || ( tbox[ 5 ] < box[ 2 ] ))
+				{
+					continue;
+				}
+				if(numcandidates == maxcandidates)
+				{
+					newcandidates = new int[ maxcandidates * 4 ];
+					memcpy( newcandidates, candidates, sizeof( int ) * maxcandidates * 2 );
+					delete[ ] candidates;
+					candidates = newcandidates;
+					maxcandidates *= 2;
+				}
+				candidates[ numcandidates * 2 ] = i;
+				candidates[ numcandidates * 2 + 1 ] = j;
+				numcandidates++;
+			}
+		}
+	}
+
+	// Test the candidate pairs. The result is compacted in place.
+	numpairs = 0;
+	for(k = 0; k < numcandidates; k++)
+	{
+		ci = &( job->tricorners[ candidates[ k * 2 ] * 3 ] );
+		cj = &( job->tricorners[ candidates[ k * 2 + 1 ] * 3 ] );
+		for(n = 0; n < 3; n++)
+		{
+			pi[ n ] = &( pointlist[ ci[ n ] * 3 ] );
+			pj[ n ] = &( pointlist[ cj[ n ] * 3 ] );
+		}
+
+		// Most candidates are neighbors sharing one or two corners. Then the
+		//   exact test falls into its slow (adaptive) path, since some of its
+		//   orientations are zero. Decide the easy cases with the (non-zero)
+		//   orientations of the unshared corners. Corners are compared by
+		//   coordinates, since duplicated input vertices share positions.
+		shared = 0;
+		unsharedj = -1;
+		for(n = 0; n < 3; n++)
+		{
+			for(j = 0; j < 3; j++)
+			{
+				if(( pi[ n ][ 0 ] == pj[ j ][ 0 ] ) && ( pi[ n ][ 1 ] == pj[ j ][ 1 ] ) &&
+				   ( pi[ n ][ 2 ] == pj[ j ][ 2 ] ))
+				{
+					break;
+				}
+			}
+			if(j < 3)
+			{
+				shared++;
+				sharedj[ j ] = 1;
+			}
+		}
+		if(shared == 2)
+		{
+			// They share an edge. They intersect only if they are coplanar.
+			for(j = 0; j < 3; j++)
+			{
+				if(!sharedj[ j ]) unsharedj = j;
+			}
+			if(orient3d( pi[ 0 ], pi[ 1 ], pi[ 2 ], pj[ unsharedj ] ) != 0.0)
+			{
+				sharedj[ 0 ] = sharedj[ 1 ] = sharedj[ 2 ] = 0;
+				continue;
+			}
+		}
+		else if(shared == 1)
+		{
+			// They share a vertex. They are disjoint elsewhere if the other
+			//   two corners of one lie strictly on one side of the other.
+			s1 = s2 = 0.0;
+			n = 0;
+			for(j = 0; j < 3; j++)
+			{
+				if(!sharedj[ j ])
+				{
+					if(n == 0) s1 = orient3d( pi[ 0 ], pi[ 1 ], pi[ 2 ], pj[ j ] );
+					else s2 = orient3d( pi[ 0 ], pi[ 1 ], pi[ 2 ], pj[ j ] );
+					n++;
+				}
+			}
+			if(s1 * s2 > 0.0)
+			{
+				sharedj[ 0 ] = sharedj[ 1 ] = sharedj[ 2 ] = 0;
+				continue;
+			}
+		}
+		sharedj[ 0 ] = sharedj[ 1 ] = sharedj[ 2 ] = 0;
+
+		intersect = (enum interresult)job->m->tri_tri_inter(
+			pi[ 0 ], pi[ 1 ], pi[ 2 ], pj[ 0 ], pj[ 1 ], pj[ 2 ] );
+		if(intersect == INTERSECT || intersect == SHAREFACE)
+		{
+			candidates[ numpairs * 2 ] = candidates[ k * 2 ];
+			candidates[ numpairs * 2 + 1 ] = candidates[ k * 2 + 1 ];
+			numpairs++;
+		}
+	}
+
+	pairs = NULL;
+	if(numpairs > 0)
+	{
+		pairs = new int[ numpairs * 2 ];
+		memcpy( pairs, candidates, sizeof( int ) * numpairs * 2 );
+	}
+	delete[ ] candidates;
+
+	job->chunkpairs[ chunk ] = pairs;
+	job->chunkpaircount[ chunk ] = numpairs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// detectselfinters()    Detect intersecting triangles of the input PLC.     //
+//                                                                           //
+// Unlike detectinterfaces(), this routine works directly on the facets of   //
+// 'in', i.e., no surface mesh is needed. It is meant to be a fast check of  //
+// the input before it is meshed.  The triangles are put into a bounding     //
+// volume hierarchy, then the triangles are split into chunks which are      //
+// queried in parallel (see parallelloop()).  Each pair of triangles whose   //
+// bounding boxes overlap is tested exactly by tri_tri_inter().              //
+//                                                                           //
+// Return the number of intersecting (or duplicated) pairs of triangles. If  //
+// 'pairlist' is not NULL, it returns the facet indices of these pairs.      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::detectselfinters( int** pairlist )
+{
+	selfinterjob job;
+	tetgenio::facet *f;
+	tetgenio::polygon *p;
+	REAL *box, *pt;
+	int numtris, numchunks, internum;
+	int i, j, k, n, t;
+
+	TETGEN_TRACE_SCOPE( b, "detectselfinters" );
+
+	// For a triangle soup ('in->trianglelist').
+	tetgenio::facet trifacet;
+	tetgenio::polygon tripolygon;
+	int numberoffacets;
+
+	if(b->verbose)
+	{
+		myprintf( "  Detecting self-intersecting input triangles.\n" );
+	}
+
+	// Count the triangles (fans of the polygons).
+	numtris = 0;
+	if(in->trianglelist != NULL)
+	{
+		// Each triangle is read as a facet with one polygon.
+		tripolygon.numberofvertices = 3;
+		trifacet.polygonlist = &tripolygon;
+		trifacet.numberofpolygons = 1;
+		numberoffacets = in->numberoftriangles;
+		numtris = numberoffacets;
+	}
+	else
+	{
+		numberoffacets = in->numberoffacets;
+		for(i = 0; i < numberoffacets; i++)
+		{
+			f = &( in->facetlist[ i ] );
+			for(j = 0; j < f->numberofpolygons; j++)
+			{
+				p = &( f->polygonlist[ j ] );
+				if(p->numberofvertices > 2)
+				{
+					numtris += p->numberofvertices - 2;
+				}
+			}
+		}
+	}
+
+	if(pairlist != NULL)
+	{
+		*pairlist = NULL;
+	}
+	if(numtris < 2)
+	{
+		return 0;
+	}
+
+	job.m = this;
+	job.numtris = numtris;
+	job.tricorners = new int[ numtris * 3 ];
+	job.tri2facet = new int[ numtris ];
+	job.tribox = new REAL[ numtris * 6 ];
+
+	t = 0;
+	for(i = 0; i < numberoffacets; i++)
+	{
+		if(in->trianglelist != NULL)
+		{
+			tripolygon.vertexlist = (int *)&( in->trianglelist[ i * 3 ] );
+			f = &trifacet;
+		}
+		else
+		{
+			f = &( in->facetlist[ i ] );
+		}
+		for(j = 0; j < f->numberofpolygons; j++)
+		{
+			p = &( f->polygonlist[ j ] );
+			for(n = 2; n < p->numberofvertices; n++)
+			{
+				job.tricorners[ t * 3 ] = p->vertexlist[ 0 ] - in->firstnumber;
+				job.tricorners[ t * 3 + 1 ] = p->vertexlist[ n - 1 ] - in->firstnumber;
+				job.tricorners[ t * 3 + 2 ] = p->vertexlist[ n ] - in->firstnumber;
+				job.tri2facet[ t ] = i;
+				box = &( job.tribox[ t * 6 ] );
+				for(k = 0; k < 3; k++)
+				{
+					if(( job.tricorners[ t * 3 + k ] < 0 ) ||
+					   ( job.tricorners[ t * 3 + k ] >= in->numberofpoints ))
+					{
+						myprintf( "Error:  Facet %d has an invalid vertex index.\n",
+								  i + in->firstnumber );
+						delete[ ] job.tricorners;
+						delete[ ] job.tri2facet;
+						delete[ ] job.tribox;
+						terminatetetgen( this, 10 );
+					}
+				}
+				pt = &( in->pointlist[ job.tricorners[ t * 3 ] * 3 ] );
+				box[ 0 ] = box[ 3 ] = pt[ 0 ];
+				box[ 1 ] = box[ 4 ] = pt[ 1 ];
+				box[ 2 ] = box[ 5 ] = pt[ 2 ];
+				for(k = 1; k < 3; k++)
+				{
+					pt = &( in->pointlist[ job.tricorners[ t * 3 + k ] * 3 ] );
+					if(pt[ 0 ] < box[ 0 ]) box[ 0 ] = pt[ 0 ];
+					if(pt[ 1 ] < box[ 1 ]) box[ 1 ] = pt[ 1 ];
+					if(pt[ 2 ] < box[ 2 ]) box[ 2 ] = pt[ 2 ];
+					if(pt[ 0 ] > box[ 3 ]) box[ 3 ] = pt[ 0 ];
+					if(pt[ 1 ] > box[ 4 ]) box[ 4 ] = pt[ 1 ];
+					if(pt[ 2 ] > box[ 5 ]) box[ 5 ] = pt[ 2 ];
+				}
+				t++;
+			}
+		}
+	}
+
+	job.bvhtris = new int[ numtris ];
+	job.bvhnodes = new bvhnode[ numtris * 2 ];
+	bvhbuild( job.tribox, job.bvhtris, numtris, job.bvhnodes );
+
+	job.chunksize = 1024;
+	numchunks = ( numtris + job.chunksize - 1 ) / job.chunksize;
+	job.chunkpairs = new int*[ numchunks ];
+	job.chunkpaircount = new int[ numchunks ];
+
+	parallelloop( numchunks, selfinterchunk, &job );
+
+	// Gather the pairs (in the order of the chunks).
+	internum = 0;
+	for(i = 0; i < numchunks; i++)
+	{
+		internum += job.chunkpaircount[ i ];
+	}
+	if(( pairlist != NULL ) && ( internum > 0 ))
+	{
+		*pairlist = new int[ internum * 2 ];
+	}
+	n = 0;
+	for(i = 0; i < numchunks; i++)
+	{
+		for(k = 0; k < job.chunkpaircount[ i ]; k++)
+		{
+			j = job.chunkpairs[ i ][ k * 2 ];
+			t = job.chunkpairs[ i ][ k * 2 + 1 ];
+			if(b->verbose)
+			{
+				myprintf( "  Facet #%d intersects facet #%d.\n",
+						  job.tri2facet[ j ] + in->firstnumber,
+						  job.tri2facet[ t ] + in->firstnumber );
+			}
+			if(pairlist != NULL)
+			{
+				( *pairlist )[ n * 2 ] = job.tri2facet[ j ] + in->firstnumber;
+				( *pairlist )[ n * 2 + 1 ] = job.tri2facet[ t ] + in->firstnumber;
+			}
+			n++;
+		}
+		if(job.chunkpairs[ i ] != NULL)
+		{
+			delete[ ] job.chunkpairs[ i ];
+		}
+	}
+
+	if(b->verbose)
+	{
+		myprintf( "  Found %d pairs of intersecting triangles (%d triangles).\n",
+				  internum, numtris );
+	}
+
+	delete[ ] job.chunkpairs;
+	delete[ ] job.chunkpaircount;
+	delete[ ] job.bvhnodes;
+	delete[ ] job.bvhtris;
+	delete[ ] job.tribox;
+	delete[ ] job.tri2facet;
+	delete[ ] job.tricorners;
+
+	return internum;
+}
+
 ////                                                                       ////
 ////                                                                       ////
 //// surface_cxx //////////////////////////////////////////////////////////////
@@ -18613,6 +19867,8 @@ void tetgenmesh::constraineddelaunay( clock_t& tv )
 	face searchseg, *paryseg;
 	int s, i;
 
+	TETGEN_TRACE_SCOPE( b, "constraineddelaunay" );
+
 	// Statistics.
 	long bakfillregioncount;
 	long bakcavitycount, bakcavityexpcount;
@@ -19075,6 +20331,12 @@ int tetgenmesh::removeedgebyflips( triface *flipedge, flipconstraints* fc )
 	spintet = *flipedge;
 	while(1)
 	{
+		if(( view != NULL ) && !tetinblock( spintet ))
+		{
+			// A view only flips the tets in its block.
+			view->deferred = 1;
+			return 0;
+		}
 		n++;
 		fnextself( spintet );
 		if(spintet.tet == flipedge->tet) break;
@@ -20270,6 +21532,13 @@ int tetgenmesh::recoversegments( arraypool *misseglist, int fullsearch,
 	// Loop until 'subsegstack' is empty.
 	while(subsegstack->objects > 0l)
 	{
+		// Stop if cancelled, recoverboundary() unwinds.
+		if(pollprogress( "recoverboundary", 0.5 * ( 1.0 - (REAL)subsegstack->objects /
+			(REAL)( subsegs->items + 1l ) ) ))
+		{
+			break;
+		}
+
 		// seglist is used as a stack.
 		subsegstack->objects--;
 		paryseg = (face *)fastlookup( subsegstack, subsegstack->objects );
@@ -20615,6 +21884,12 @@ int tetgenmesh::recoversubfaces( arraypool *misshlist, int steinerflag )
 	// Loop until 'subfacstack' is empty.
 	while(subfacstack->objects > 0l)
 	{
+		// Stop if cancelled, recoverboundary() unwinds.
+		if(pollprogress( "recoverboundary", 0.5 + 0.5 * ( 1.0 - (REAL)subfacstack->objects /
+			(REAL)( subfaces->items + 1l ) ) ))
+		{
+			break;
+		}
 
 		subfacstack->objects--;
 		parysh = (face *)fastlookup( subfacstack, subfacstack->objects );
@@ -22536,6 +23811,7 @@ int tetgenmesh::suppressbdrysteinerpoint( point steinerpt )
 
 int tetgenmesh::suppresssteinerpoints( )
 {
+	TETGEN_TRACE_SCOPE( b, "suppresssteinerpoints" );
 
 	if(!b->quiet)
 	{
@@ -22547,6 +23823,7 @@ int tetgenmesh::suppresssteinerpoints( )
 	int bak_fliplinklevel = b->fliplinklevel;
 	b->fliplinklevel = 100000; // Unlimited flip level.
 	int suppcount = 0, remcount = 0;
+	long volcount;
 	int i;
 
 	// Try to suppress boundary Steiner points.
@@ -22559,9 +23836,12 @@ int tetgenmesh::suppresssteinerpoints( )
 			if(( pointtype( rempt ) == FREESEGVERTEX ) ||
 				( pointtype( rempt ) == FREEFACETVERTEX ))
 			{
+				volcount = st_volref_count;
 				if(suppressbdrysteinerpoint( rempt ))
 				{
 					suppcount++;
+					opstat( tetgenopstats::STEINERINSERTED,
+							st_volref_count - volcount );
 				}
 			}
 		}
@@ -22588,6 +23868,11 @@ int tetgenmesh::suppresssteinerpoints( )
 					if(removevertexbyflips( rempt ))
 					{
 						remcount++;
+						opstat( tetgenopstats::STEINERREMOVED, 1 );
+					}
+					else
+					{
+						opstat( tetgenopstats::STEINERREMOVED, 0 );
 					}
 				}
 			}
@@ -22734,6 +24019,8 @@ void tetgenmesh::recoverboundary( clock_t& tv )
 	int nit; // The number of iterations.
 	int s, i;
 
+	TETGEN_TRACE_SCOPE( b, "recoverboundary" );
+
 	// Counters.
 	long bak_segref_count, bak_facref_count, bak_volref_count;
 
@@ -22752,6 +24039,7 @@ void tetgenmesh::recoverboundary( clock_t& tv )
 	checksubsegflag = 1;
 
 	misseglist = new arraypool( sizeof( face ), 8 );
+	misshlist = new arraypool( sizeof( face ), 8 );
 	bdrysteinerptlist = new arraypool( sizeof( point ), 8 );
 
 	// In random order.
@@ -22965,11 +24253,17 @@ void tetgenmesh::recoverboundary( clock_t& tv )
 		myprintf( "  Recovering facets.\n" );
 	}
 
+	if(progresscancel)
+	{
+		delete bdrysteinerptlist;
+		delete misseglist;
+		delete misshlist;
+		terminatetetgen( this, progresscancel );
+	}
+
 	// Subfaces will be introduced.
 	checksubfaceflag = 1;
 
-	misshlist = new arraypool( sizeof( face ), 8 );
-
 	// Randomly order the subfaces.
 	subfaces->traversalinit( );
 	for(i = 0; i < subfaces->items; i++)
@@ -23062,6 +24356,14 @@ void tetgenmesh::recoverboundary( clock_t& tv )
 		}
 	}
 
+	if(progresscancel)
+	{
+		delete bdrysteinerptlist;
+		delete misseglist;
+		delete misshlist;
+		terminatetetgen( this, progresscancel );
+	}
+
 
 	if(st_facref_count > 0)
 	{
@@ -23137,6 +24439,8 @@ void tetgenmesh::carveholes( )
 	int t1ver;
 	int i, j, k;
 
+	TETGEN_TRACE_SCOPE( b, "carveholes" );
+
 	if(!b->quiet)
 	{
 		if(b->convex)
@@ -23913,6 +25217,8 @@ void tetgenmesh::reconstructmesh( )
 	int t1ver;
 	int idx, i, j, k;
 
+	TETGEN_TRACE_SCOPE( b, "reconstructmesh" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Reconstructing mesh ...\n" );
@@ -25255,6 +26561,8 @@ void tetgenmesh::insertconstrainedpoints( tetgenio *addio )
 	int index, attribindex, mtrindex;
 	int arylen, i, j;
 
+	TETGEN_TRACE_SCOPE( b, "insertconstrainedpoints" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Inserting constrained points ...\n" );
@@ -25491,6 +26799,8 @@ void tetgenmesh::meshcoarsening( )
 {
 	arraypool *remptlist;
 
+	TETGEN_TRACE_SCOPE( b, "meshcoarsening" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Mesh coarsening ...\n" );
@@ -26283,6 +27593,8 @@ void tetgenmesh::repairencsegs( int chkencflag )
 	point encpt = NULL;
 	int qflag = 0;
 
+	TETGEN_TRACE_SCOPE( b, "repairencsegs" );
+
 	// Loop until the pool 'badsubsegs' is empty. Note that steinerleft == -1
 	//   if an unlimited number of Steiner points is allowed.
 	while(( badsubsegs->items > 0 ) && ( steinerleft != 0 ))
@@ -26838,6 +28150,8 @@ void tetgenmesh::repairencfacs( int chkencflag )
 	int qflag = 0;
 	REAL ccent[ 3 ], uv[ tetgenio::pointparam::maxuvs ];
 
+	TETGEN_TRACE_SCOPE( b, "repairencfacs" );
+
 	// Loop until the pool 'badsubfacs' is empty. Note that steinerleft == -1
 	//   if an unlimited number of Steiner points is allowed.
 	while(( badsubfacs->items > 0 ) && ( steinerleft != 0 ))
@@ -26915,7 +28229,7 @@ int tetgenmesh::checktet4split( triface *chktet, int &qflag, REAL *ccent )
 	REAL vda[ 3 ], vdb[ 3 ], vdc[ 3 ];
 	REAL vab[ 3 ], vbc[ 3 ], vca[ 3 ];
 	REAL N[ 4 ][ 3 ], L[ 4 ], cosd[ 6 ], elen[ 6 ];
-	REAL maxcosd, vol, volbnd, smlen = 0, rd;
+	REAL maxcosd, vol, volbnd, smlen = 0, rd, size;
 	REAL A[ 4 ][ 4 ], rhs[ 4 ], D;
 	int indx[ 4 ];
 	int i, j;
@@ -27015,6 +28329,23 @@ int tetgenmesh::checktet4split( triface *chktet, int &qflag, REAL *ccent )
 		}
 	}
 
+	if(in->meshsize != NULL)
+	{
+		// Check the user-defined mesh size at the circumcenter.
+		rhs[ 0 ] = 0.5 * dot( vda, vda );
+		rhs[ 1 ] = 0.5 * dot( vdb, vdb );
+		rhs[ 2 ] = 0.5 * dot( vdc, vdc );
+		lu_solve( A, 3, indx, rhs, 0 );
+		for(i = 0; i < 3; i++) ccent[ i ] = pd[ i ] + rhs[ i ];
+		rd = sqrt( dot( rhs, rhs ) );
+		size = ( *( in->meshsize ) )( in->sizehandle, ccent );
+		if(( size > 0 ) && ( rd > size ))
+		{
+			qflag = 1; // Enforce mesh size.
+			return 1;
+		}
+	}
+
 	if(in->tetunsuitable != NULL)
 	{
 		// Execute the user-defined meshing sizing evaluation.
@@ -27210,6 +28541,13 @@ int tetgenmesh::splittetrahedron( triface* splittet, int qflag, REAL *ccent,
 
 	REAL rv = 0.; // Insertion radius of 'newpt'.
 
+	if(( view != NULL ) && !inblock( ccent ))
+	{
+		// A view only inserts points in its block.
+		view->deferred = refinejob::SPLITLATER;
+		return 0;
+	}
+
 	makepoint( &newpt, FREEVOLVERTEX );
 	for(i = 0; i < 3; i++) newpt[ i ] = ccent[ i ];
 	// UV: TODO (only called for internal vertices?)
@@ -27239,6 +28577,12 @@ int tetgenmesh::splittetrahedron( triface* splittet, int qflag, REAL *ccent,
 		}
 		// \fi
 		pointdealloc( newpt );  // Do not insert this vertex.
+		if(view != NULL)
+		{
+			// The polygon is split by the mesh of the view.
+			view->deferred = refinejob::SPLITSERIAL;
+			return 0;
+		}
 		if(b->nobisect) return 0; // -Y option.
 		// There must be a polygon that blocks the visibility.
 		// Search a subpolygon that contains the proj(c).
@@ -27284,7 +28628,13 @@ int tetgenmesh::splittetrahedron( triface* splittet, int qflag, REAL *ccent,
 		return splitflag;
 	}
 
-
+	if(ivf.iloc == (int)OUTSIDEBLOCK)
+	{
+		// The walk of a view left its block.
+		pointdealloc( newpt );
+		view->deferred = refinejob::SPLITLATER;
+		return 0;
+	}
 
 	// Use Bowyer-Watson algorithm. Preserve subsegments and subfaces;
 	ivf.bowywat = 3;
@@ -27324,6 +28674,23 @@ int tetgenmesh::splittetrahedron( triface* splittet, int qflag, REAL *ccent,
 	{
 		// Point is not inserted.
 		pointdealloc( newpt );
+		if(view != NULL)
+		{
+			// A cavity which leaves the block is tried again later, the
+			//   encroached segments and subfaces are split by the mesh.
+			if(ivf.iloc == (int)OUTSIDEBLOCK)
+			{
+				view->deferred = refinejob::SPLITLATER;
+			}
+			else if(( ivf.iloc == (int)ENCSEGMENT ) || ( ivf.iloc == (int)ENCSUBFACE ) ||
+				( ivf.iloc == (int)NEARVERTEX ))
+			{
+				view->deferred = refinejob::SPLITSERIAL;
+			}
+			encseglist->restart( );
+			encshlist->restart( );
+			return 0;
+		}
 		// Check if there are encroached segments/subfaces.
 		if(ivf.iloc == (int)ENCSEGMENT)
 		{
@@ -27461,7 +28828,14 @@ void tetgenmesh::repairbadtets( int chkencflag )
 	triface *bface;
 	REAL ccent[ 3 ];
 	int qflag = 0;
+	long checkcount = 0l;
+
+	TETGEN_TRACE_SCOPE( b, "repairbadtets" );
 
+	if(b->parallelfor != NULL)
+	{
+		repairbadtetsbatched( chkencflag );
+	}
 
 	// Loop until the pool 'badsubfacs' is empty. Note that steinerleft == -1
 	//   if an unlimited number of Steiner points is allowed.
@@ -27474,6 +28848,14 @@ void tetgenmesh::repairbadtets( int chkencflag )
 			// Skip a deleted element.
 			if(bface->ver >= 0)
 			{
+				// The fraction done is estimated from the queued tets left.
+				if(pollprogress( "repairbadtets", (REAL)checkcount /
+					(REAL)( checkcount + badtetrahedrons->items ) ))
+				{
+					terminatetetgen( this, progresscancel );
+				}
+				checkcount++;
+				opstat( tetgenopstats::BADTETQUEUE, badtetrahedrons->items );
 				// A queued tet may have been deleted.
 				if(!isdeadtet( *bface ))
 				{
@@ -27530,6 +28912,724 @@ void tetgenmesh::repairbadtets( int chkencflag )
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// checktet4splitchunk()    Run checktet4split() on a chunk of a batch.      //
+//                                                                           //
+// checktet4split() only reads the mesh. Note that a user-defined function   //
+// 'in->tetunsuitable' must be thread-safe if 'b->parallelfor' is set.       //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::checktet4splitchunk( void* arg, int chunk )
+{
+	refinejob *job = (refinejob *)arg;
+	int i, last;
+
+	i = chunk * job->chunksize;
+	last = i + job->chunksize;
+	if(last > job->numtets) last = job->numtets;
+
+	for(; i < last; i++)
+	{
+		job->splitflags[ i ] = job->m->checktet4split( &( job->tets[ i ] ),
+													   job->qflags[ i ],
+													   &( job->ccents[ 3 * i ] ) );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// initblockjob()    Allocate the grid and the views of a blockjob.          //
+//                                                                           //
+// The views are created on demand by takeview() and reused by the later     //
+// batches. freeblockjob() deletes them, but not the pools and the tables    //
+// they share with this mesh.                                                //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::initblockjob( blockjob *bj, int maxitems )
+{
+	bj->order = new int[ maxitems ];
+	bj->blockstart = new int[ maxitems + 1 ];
+	bj->blocks = new int[ 3 * maxitems ];
+	bj->numblocks = 0;
+	bj->lock = new poollock;
+	bj->views = new arraypool( sizeof( tetgenmesh * ), 6 );
+	bj->idleviews = new arraypool( sizeof( tetgenmesh * ), 6 );
+}
+
+void tetgenmesh::freeblockjob( blockjob *bj )
+{
+	tetgenmesh *vm;
+	int i;
+
+	for(i = 0; i < bj->views->objects; i++)
+	{
+		vm = *(tetgenmesh **)fastlookup( bj->views, i );
+		// Only free the private lists of the view.
+		vm->in = vm->addin = NULL;
+		vm->bgm = NULL;
+		vm->tetrahedrons = vm->subfaces = vm->subsegs = vm->points = NULL;
+		vm->tet2segpool = vm->tet2subpool = NULL;
+		vm->badsubfacs = vm->badsubsegs = NULL;
+		vm->dummypoint = NULL;
+		vm->idx2facetlist = NULL;
+		vm->facetverticeslist = NULL;
+		vm->segmentendpointslist = NULL;
+		vm->highordertable = NULL;
+		vm->locgrid = NULL;
+		delete vm;
+	}
+
+	delete bj->views;
+	delete bj->idleviews;
+	delete bj->lock;
+	delete[ ] bj->order;
+	delete[ ] bj->blockstart;
+	delete[ ] bj->blocks;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// binitems()    Bin the items of a batch into the blocks of a grid.         //
+//                                                                           //
+// Each item has 4 vertices in 'verts'. An item is binned to a block if all  //
+// its vertices are in it (see inblock()), the others are not binned. The    //
+// blocks are cubes of length 'size'. The origin of the grid is the corner   //
+// of the bounding box, shifted by a quarter of a block for each 'batch', so //
+// an item which is not binned by one batch may be by the next.              //
+//                                                                           //
+// The binned items are sorted by block in 'bj->order', in the order of the  //
+// batch. Returns the number of (non-empty) blocks.                          //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::binitems( blockjob *bj, point *verts, int numitems, REAL size,
+						  int batch )
+{
+	REAL bmin[ 3 ], bmax[ 3 ];
+	int *cells, *counts;
+	int dim[ 3 ], idx[ 3 ];
+	int numcells, cell, start;
+	int i, j, k;
+
+	bmin[ 0 ] = xmin;
+	bmin[ 1 ] = ymin;
+	bmin[ 2 ] = zmin;
+	bmax[ 0 ] = xmax;
+	bmax[ 1 ] = ymax;
+	bmax[ 2 ] = zmax;
+	for(k = 0; k < 3; k++)
+	{
+		bj->origin[ k ] = bmin[ k ] - size * (REAL)( batch % 4 ) / 4.0;
+		dim[ k ] = (int)floor( ( bmax[ k ] - bj->origin[ k ] ) / size ) + 1;
+	}
+	bj->size = size;
+	numcells = dim[ 0 ] * dim[ 1 ] * dim[ 2 ];
+
+	cells = new int[ numitems ];
+	counts = new int[ numcells + 1 ];
+	for(cell = 0; cell <= numcells; cell++) counts[ cell ] = 0;
+
+	// Find the block of each item. The same expression as inblock() is used.
+	for(i = 0; i < numitems; i++)
+	{
+		cells[ i ] = -1;
+		for(j = 0; j < 4; j++)
+		{
+			for(k = 0; k < 3; k++)
+			{
+				idx[ k ] = (int)floor( ( verts[ 4 * i + j ][ k ] - bj->origin[ k ] ) / size );
+				if(( idx[ k ] < 0 ) || ( idx[ k ] >= dim[ k ] )) break;
+			}
+			if(k < 3) break;
+			cell = ( idx[ 0 ] * dim[ 1 ] + idx[ 1 ] ) * dim[ 2 ] + idx[ 2 ];
+			if(( j > 0 ) && ( cell != cells[ i ] )) break;
+			cells[ i ] = cell;
+		}
+		if(j < 4)
+		{
+			cells[ i ] = -1; // Not binned.
+		}
+		else
+		{
+			counts[ cell + 1 ]++;
+		}
+	}
+
+	// Sort the binned items by block (a counting sort).
+	for(cell = 0; cell < numcells; cell++)
+	{
+		counts[ cell + 1 ] += counts[ cell ];
+	}
+	for(i = 0; i < numitems; i++)
+	{
+		if(cells[ i ] >= 0)
+		{
+			bj->order[ counts[ cells[ i ] ]++ ] = i;
+		}
+	}
+
+	// Now counts[cell] is the end of the items of a cell.
+	bj->numblocks = 0;
+	start = 0;
+	for(cell = 0; cell < numcells; cell++)
+	{
+		if(counts[ cell ] > start)
+		{
+			bj->blockstart[ bj->numblocks ] = start;
+			bj->blocks[ 3 * bj->numblocks ] = cell / ( dim[ 1 ] * dim[ 2 ] );
+			bj->blocks[ 3 * bj->numblocks + 1 ] = ( cell / dim[ 2 ] ) % dim[ 1 ];
+			bj->blocks[ 3 * bj->numblocks + 2 ] = cell % dim[ 2 ];
+			bj->numblocks++;
+			start = counts[ cell ];
+		}
+	}
+	bj->blockstart[ bj->numblocks ] = start;
+
+	delete[ ] cells;
+	delete[ ] counts;
+
+	return bj->numblocks;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// gridsize()    The length of the blocks of a batch.                        //
+//                                                                           //
+// The blocks are 12 times 'len', a mean size of the items of the batch, but //
+// there are at most 34 along an axis.                                       //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+REAL tetgenmesh::gridsize( REAL len )
+{
+	REAL size, maxlen;
+
+	size = 12.0 * len;
+	maxlen = xmax - xmin;
+	if(ymax - ymin > maxlen) maxlen = ymax - ymin;
+	if(zmax - zmin > maxlen) maxlen = zmax - zmin;
+	if(size < maxlen / 32.0) size = maxlen / 32.0;
+
+	return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// lockpools()    Set the lock of the pools shared by the views, or NULL.    //
+//                                                                           //
+// The views allocate and free tetrahedra, points, and the connections to    //
+// the subfaces and subsegments. Their memory is charged under the lock as   //
+// well (see memorystats).                                                   //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::lockpools( poollock *lock )
+{
+	tetrahedrons->lock = lock;
+	points->lock = lock;
+	if(subfaces != NULL)
+	{
+		subfaces->lock = lock;
+		subsegs->lock = lock;
+	}
+	if(tet2segpool != NULL)
+	{
+		tet2segpool->lock = lock;
+		tet2subpool->lock = lock;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// takeview()    Take an idle view of this mesh for a block, or create one.  //
+//                                                                           //
+// A new view copies this mesh, it gets its own working lists, queues, and   //
+// counters, which are not accounted (they are used by the thread running    //
+// the block). The counters are merged by mergeview(). releaseview() returns //
+// the view to the idle views of the job.                                    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+tetgenmesh *tetgenmesh::takeview( blockjob *bj, int blk )
+{
+	tetgenmesh *vm = NULL, **pvm;
+	int i;
+
+	{
+		std::lock_guard<std::mutex> guard( bj->lock->mutex );
+		if(bj->idleviews->objects > 0)
+		{
+			bj->idleviews->objects--;
+			vm = *(tetgenmesh **)fastlookup( bj->idleviews, bj->idleviews->objects );
+		}
+	}
+
+	if(vm == NULL)
+	{
+		memorystatsscope memscope( NULL );
+
+		vm = new tetgenmesh( *this );
+		vm->view = new meshview( );
+		vm->view->behavior = *b;
+		vm->view->behavior.opstats = ( b->opstats != NULL ) ? &( vm->view->opstats ) : NULL;
+		vm->view->behavior.parallelfor = NULL;
+		vm->view->behavior.progress = NULL;
+		vm->b = &( vm->view->behavior );
+		vm->locgrid = NULL;
+		vm->locgridcells = 0l;
+		vm->steinerleft = -1;
+		vm->flipstack = NULL;
+
+		vm->badtetrahedrons = new memorypool( sizeof( triface ), 1024, sizeof( void * ), 0 );
+		vm->badsubfacs = vm->badsubsegs = NULL;
+		vm->encseglist = new arraypool( sizeof( face ), 8 );
+		vm->encshlist = new arraypool( sizeof( badface ), 8 );
+		vm->flippool = new memorypool( sizeof( badface ), 1024, sizeof( void * ), 0 );
+		vm->unflipqueue = new arraypool( sizeof( badface ), 10 );
+		vm->cavetetlist = new arraypool( sizeof( triface ), 10 );
+		vm->cavebdrylist = new arraypool( sizeof( triface ), 10 );
+		vm->caveoldtetlist = new arraypool( sizeof( triface ), 10 );
+		vm->cavetetvertlist = new arraypool( sizeof( point ), 10 );
+		if(caveshlist != NULL)
+		{
+			vm->caveshlist = new arraypool( sizeof( face ), 8 );
+			vm->caveshbdlist = new arraypool( sizeof( face ), 8 );
+			vm->cavesegshlist = new arraypool( sizeof( face ), 4 );
+			vm->cavetetshlist = new arraypool( sizeof( face ), 8 );
+			vm->cavetetseglist = new arraypool( sizeof( face ), 8 );
+			vm->caveencshlist = new arraypool( sizeof( face ), 8 );
+			vm->caveencseglist = new arraypool( sizeof( face ), 8 );
+		}
+		if(subsegstack != NULL)
+		{
+			vm->subsegstack = new arraypool( sizeof( face ), 10 );
+			vm->subfacstack = new arraypool( sizeof( face ), 10 );
+			vm->subvertstack = new arraypool( sizeof( point ), 8 );
+		}
+
+		// The counters are added to this mesh by mergeview().
+		vm->st_volref_count = 0l;
+		vm->flip14count = vm->flip26count = vm->flipn2ncount = 0l;
+		vm->flip23count = vm->flip32count = vm->flip44count = vm->flip41count = 0l;
+		vm->flip22count = vm->flip31count = 0l;
+		vm->locatecount = vm->locatesteps = vm->locatemaxsteps = 0l;
+		vm->tetprism_vol_sum = 0.0;
+
+		std::lock_guard<std::mutex> guard( bj->lock->mutex );
+		bj->views->newindex( (void **)&pvm );
+		*pvm = vm;
+	}
+
+	for(i = 0; i < 3; i++)
+	{
+		vm->view->origin[ i ] = bj->origin[ i ];
+		vm->view->block[ i ] = bj->blocks[ 3 * blk + i ];
+	}
+	vm->view->size = bj->size;
+
+	return vm;
+}
+
+void tetgenmesh::releaseview( blockjob *bj, tetgenmesh *vm )
+{
+	tetgenmesh **pvm;
+
+	std::lock_guard<std::mutex> guard( bj->lock->mutex );
+	bj->idleviews->newindex( (void **)&pvm );
+	*pvm = vm;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// mergeview()    Merge the results of a view into this mesh.                //
+//                                                                           //
+// It is called by the thread running tetrahedralize() after the blocks of a //
+// batch are done. The counters and histograms of the view are added, its    //
+// queued tets are queued in 'badtetrahedrons', its deferred faces are       //
+// pushed into 'flipstack' (if they still exist), and the tets it deleted    //
+// are returned to the pool.                                                 //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::mergeview( tetgenmesh *vm )
+{
+	triface *bface, *quetet;
+	badface *dface;
+	tetrahedron **parytet;
+	int i;
+
+	st_volref_count += vm->st_volref_count;
+	if(steinerleft > 0)
+	{
+		steinerleft -= vm->st_volref_count;
+	}
+	flip14count += vm->flip14count;
+	flip26count += vm->flip26count;
+	flipn2ncount += vm->flipn2ncount;
+	flip23count += vm->flip23count;
+	flip32count += vm->flip32count;
+	flip44count += vm->flip44count;
+	flip41count += vm->flip41count;
+	flip22count += vm->flip22count;
+	flip31count += vm->flip31count;
+	locatecount += vm->locatecount;
+	locatesteps += vm->locatesteps;
+	if(vm->locatemaxsteps > locatemaxsteps)
+	{
+		locatemaxsteps = vm->locatemaxsteps;
+	}
+	tetprism_vol_sum += vm->tetprism_vol_sum;
+
+	vm->st_volref_count = 0l;
+	vm->flip14count = vm->flip26count = vm->flipn2ncount = 0l;
+	vm->flip23count = vm->flip32count = vm->flip44count = vm->flip41count = 0l;
+	vm->flip22count = vm->flip31count = 0l;
+	vm->locatecount = vm->locatesteps = vm->locatemaxsteps = 0l;
+	vm->tetprism_vol_sum = 0.0;
+
+	if(b->opstats != NULL)
+	{
+		b->opstats->add( vm->view->opstats );
+		vm->view->opstats.clear( );
+	}
+
+	// Queue the tets queued by the view (they are still marked).
+	vm->badtetrahedrons->traversalinit( );
+	bface = (triface *)vm->badtetrahedrons->traverse( );
+	while(bface != NULL)
+	{
+		if(!isdeadtet( *bface ) && marktest2ed( *bface ))
+		{
+			quetet = (triface *)badtetrahedrons->alloc( );
+			*quetet = *bface;
+		}
+		bface = (triface *)vm->badtetrahedrons->traverse( );
+	}
+	vm->badtetrahedrons->restart( );
+
+	// Push the faces left by the view if they still exist.
+	for(i = 0; i < vm->view->deferredfaces->objects; i++)
+	{
+		dface = (badface *)fastlookup( vm->view->deferredfaces, i );
+		if(!isdeadtet( dface->tt ) && ( org( dface->tt ) == dface->forg ) &&
+			( dest( dface->tt ) == dface->fdest ) &&
+			( apex( dface->tt ) == dface->fapex ))
+		{
+			flippush( flipstack, &( dface->tt ) );
+		}
+	}
+	vm->view->deferredfaces->restart( );
+
+	// Free the tets deleted by the view.
+	for(i = 0; i < vm->view->deadtets->objects; i++)
+	{
+		parytet = (tetrahedron **)fastlookup( vm->view->deadtets, i );
+		tetrahedrons->dealloc( (void *)*parytet );
+	}
+	vm->view->deadtets->restart( );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// refineblock()    Split the binned tets of a block by a view.              //
+//                                                                           //
+// The view splits the tets in the order of the batch. A tet left to the     //
+// calling thread keeps its state (SPLITLATER or SPLITSERIAL), the split     //
+// tets become NOSPLIT. refineblockitem() is the work item of                //
+// parallelloop().                                                           //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::refineblockitem( void* arg, int blk )
+{
+	refinejob *job = (refinejob *)arg;
+
+	job->m->refineblock( job, blk );
+}
+
+void tetgenmesh::refineblock( refinejob *job, int blk )
+{
+	blockjob *bj = &( job->blocks );
+	tetgenmesh *vm;
+	int i, k;
+
+	vm = takeview( bj, blk );
+	for(k = bj->blockstart[ blk ]; k < bj->blockstart[ blk + 1 ]; k++)
+	{
+		i = bj->order[ k ];
+		if(job->splitflags[ i ] == refinejob::SPLIT)
+		{
+			job->splitflags[ i ] = vm->splitbatchtet( job, i );
+		}
+	}
+	releaseview( bj, vm );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// splitbatchtet()    Split a tet of a batch if it still exists.             //
+//                                                                           //
+// A tet which was destroyed by a previous split (its memory may have been   //
+// reused) is skipped, the new tets of that cavity have been queued by the   //
+// insertion. Returns the new state of the tet: NOSPLIT, or the state set by //
+// a view which leaves the tet to the calling thread (see                    //
+// splittetrahedron()).                                                      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::splitbatchtet( refinejob *job, int i )
+{
+	point *ppt;
+	int j;
+
+	if(isdeadtet( job->tets[ i ] ))
+	{
+		return refinejob::NOSPLIT;
+	}
+	ppt = (point *)& ( job->tets[ i ].tet[ 4 ] );
+	for(j = 0; j < 4; j++)
+	{
+		if(ppt[ j ] != job->verts[ 4 * i + j ])
+		{
+			return refinejob::NOSPLIT; // The tet was destroyed and its memory reused.
+		}
+	}
+
+	if(view != NULL)
+	{
+		view->deferred = refinejob::NOSPLIT;
+	}
+	if(splittetrahedron( &( job->tets[ i ] ), job->qflags[ i ],
+		&( job->ccents[ 3 * i ] ), job->chkencflag ) || ( view == NULL ))
+	{
+		return refinejob::NOSPLIT;
+	}
+	return view->deferred;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// repairbadtetsbatched()    Repair bad quality tetrahedra in batches.       //
+//                                                                           //
+// Queued tets are taken from 'badtetrahedrons' in batches. The split tests  //
+// (radius-edge ratio, dihedral angle, volume, and the circumcenter) of a    //
+// batch are done by the 'b->parallelfor' callback.                          //
+//                                                                           //
+// If enough tets of a batch are to be split, they are binned into the       //
+// blocks of a grid (see binitems()), whose blocks are large compared to the //
+// cavities. The blocks are refined concurrently, each by a view of the mesh //
+// which only changes the tets whose vertices are all in its block (see      //
+// meshview). The cavities of different blocks are thus disjoint, and a view //
+// leaves a tet to the calling thread if its new point or its cavity is not  //
+// in the block, and a face if its flip changes a tet outside it. The views  //
+// are merged in order, then the faces they left are flipped by              //
+// lawsonflip3d().                                                           //
+//                                                                           //
+// The tets which were not binned, or whose cavities left their blocks, are  //
+// queued again if the views inserted any points, so they may be binned by   //
+// the next batch (its grid is shifted). Otherwise they are split in order   //
+// by the calling thread, as are the tets whose split needs an encroached    //
+// segment or subface to be split first. So the same quality constraints are //
+// enforced as by the serial loop in repairbadtets(), and each batch makes   //
+// progress. The mesh is valid, but its order and numbering depend on the    //
+// scheduling of the blocks.                                                 //
+//                                                                           //
+// The blocks are only used if there is no background mesh, no weights, only //
+// the tets are checked ('chkencflag' is 4), and the Steiner points left     //
+// suffice. An error is raised again on the calling thread by                //
+// parallelloop(), the arrays of the batch and the views are freed before it //
+// is passed on.                                                             //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::repairbadtetsbatched( int chkencflag )
+{
+	refinejob job;
+	triface *bface;
+	point *ppt;
+	REAL logsum, len;
+	long checkcount = 0l, inserted;
+	int maxbatch, numsplit, deferred;
+	int batch = 0;
+	int i, j;
+
+	maxbatch = 8192;
+	job.m = this;
+	job.tets = new triface[ maxbatch ];
+	job.verts = new point[ 4 * maxbatch ];
+	job.ccents = new REAL[ 3 * maxbatch ];
+	job.qflags = new int[ maxbatch ];
+	job.splitflags = new int[ maxbatch ];
+	job.chunksize = 256;
+	job.chkencflag = chkencflag;
+	initblockjob( &( job.blocks ), maxbatch );
+
+	try
+	{
+		while(( badtetrahedrons->items > 0 ) && ( steinerleft != 0 ))
+		{
+			// Take a batch of queued tets.
+			job.numtets = 0;
+			badtetrahedrons->traversalinit( );
+			bface = (triface *)badtetrahedrons->traverse( );
+			while(( bface != NULL ) && ( job.numtets < maxbatch ))
+			{
+				// Skip a deleted element.
+				if(bface->ver >= 0)
+				{
+					// A queued tet may have been deleted or processed.
+					if(!isdeadtet( *bface ) && marktest2ed( *bface ))
+					{
+						unmarktest2( *bface );
+						job.tets[ job.numtets ] = *bface;
+						ppt = (point *)& ( bface->tet[ 4 ] );
+						for(j = 0; j < 4; j++)
+						{
+							job.verts[ 4 * job.numtets + j ] = ppt[ j ];
+						}
+						job.numtets++;
+					}
+					bface->ver = -1; // Signal it as a deleted element.
+					badtetrahedrons->dealloc( (void *)bface );
+				}
+				bface = (triface *)badtetrahedrons->traverse( );
+			}
+
+			parallelloop( ( job.numtets + job.chunksize - 1 ) / job.chunksize,
+						  checktet4splitchunk, &job );
+
+			// The blocks are sized by the mean circumradius (the geometric mean).
+			numsplit = 0;
+			logsum = 0.0;
+			for(i = 0; i < job.numtets; i++)
+			{
+				if(job.splitflags[ i ] == refinejob::SPLIT)
+				{
+					len = distance( &( job.ccents[ 3 * i ] ), job.verts[ 4 * i ] );
+					if(len > 0.0) logsum += log( len );
+					numsplit++;
+				}
+			}
+
+			job.blocks.numblocks = 0;
+			if(( numsplit >= 256 ) && ( bgm == NULL ) && !b->weighted &&
+				( chkencflag == 4 ) && (( steinerleft < 0 ) || ( steinerleft >= numsplit )))
+			{
+				binitems( &( job.blocks ), job.verts, job.numtets,
+						  gridsize( exp( logsum / numsplit ) ), batch );
+			}
+
+			if(job.blocks.numblocks > 0)
+			{
+				inserted = st_volref_count;
+				lockpools( job.blocks.lock );
+				try
+				{
+					parallelloop( job.blocks.numblocks, refineblockitem, &job );
+				}
+				catch(int)
+				{
+					lockpools( NULL );
+					throw;
+				}
+				lockpools( NULL );
+				for(i = 0; i < job.blocks.views->objects; i++)
+				{
+					mergeview( *(tetgenmesh **)fastlookup( job.blocks.views, i ) );
+				}
+				inserted = st_volref_count - inserted;
+
+				if(flipstack != NULL)
+				{
+					flipconstraints fc;
+					fc.chkencflag = chkencflag;
+					fc.enqflag = 2;
+					lawsonflip3d( &fc );
+					unflipqueue->restart( );
+				}
+
+				// Queue the tets left by the views again if they made progress,
+				//   else they are split below.
+				deferred = 0;
+				for(i = 0; i < job.numtets; i++)
+				{
+					if(( job.splitflags[ i ] == refinejob::SPLIT ) ||
+						( job.splitflags[ i ] == refinejob::SPLITLATER ))
+					{
+						deferred++;
+						if(inserted == 0l) continue;
+						job.splitflags[ i ] = refinejob::NOSPLIT;
+						if(isdeadtet( job.tets[ i ] )) continue;
+						ppt = (point *)& ( job.tets[ i ].tet[ 4 ] );
+						for(j = 0; j < 4; j++)
+						{
+							if(ppt[ j ] != job.verts[ 4 * i + j ]) break;
+						}
+						if(j == 4)
+						{
+							enqueuetetrahedron( &( job.tets[ i ] ) );
+						}
+					}
+				}
+				if(b->verbose > 2)
+				{
+					myprintf( "      %d blocks split %ld of %d tets, %d left.\n",
+							  job.blocks.numblocks, inserted, numsplit, deferred );
+				}
+			}
+
+			// Split the tets left to the calling thread in order.
+			for(i = 0; ( i < job.numtets ) && ( steinerleft != 0 ); i++)
+			{
+				// The fraction done is estimated from the queued tets left.
+				if(pollprogress( "repairbadtets", (REAL)( checkcount + i ) /
+					(REAL)( checkcount + job.numtets + badtetrahedrons->items ) ))
+				{
+					break;
+				}
+				opstat( tetgenopstats::BADTETQUEUE,
+						job.numtets - i + badtetrahedrons->items );
+				if(job.splitflags[ i ] != refinejob::NOSPLIT)
+				{
+					splitbatchtet( &job, i );
+				}
+			}
+			checkcount += job.numtets;
+			batch++;
+
+			if(progresscancel)
+			{
+				break;
+			}
+		}
+	}
+	catch(int)
+	{
+		freeblockjob( &( job.blocks ) );
+		delete[ ] job.tets;
+		delete[ ] job.verts;
+		delete[ ] job.ccents;
+		delete[ ] job.qflags;
+		delete[ ] job.splitflags;
+		throw;
+	}
+
+	freeblockjob( &( job.blocks ) );
+	delete[ ] job.tets;
+	delete[ ] job.verts;
+	delete[ ] job.ccents;
+	delete[ ] job.qflags;
+	delete[ ] job.splitflags;
+
+	if(progresscancel)
+	{
+		terminatetetgen( this, progresscancel );
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // delaunayrefinement()    Refine the mesh by Delaunay refinement.           //
@@ -27544,6 +29644,8 @@ void tetgenmesh::delaunayrefinement( )
 	long steinercount;
 	int chkencflag;
 
+	TETGEN_TRACE_SCOPE( b, "delaunayrefinement" );
+
 	long bak_segref_count, bak_facref_count, bak_volref_count;
 	long bak_flipcount = flip23count + flip32count + flip44count;
 
@@ -27757,6 +29859,26 @@ void tetgenmesh::delaunayrefinement( )
 ////                                                                       ////
 ////                                                                       ////
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// deferface()    Leave a face to be flipped by the mesh of a view.          //
+//                                                                           //
+// A view does not flip a face if the flip changes a tet outside its block.  //
+// The face is queued again by mergeview() (if it still exists).             //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::deferface( triface *flipface )
+{
+	badface *bface;
+
+	view->deferredfaces->newindex( (void **)&bface );
+	bface->tt = *flipface;
+	bface->forg = org( *flipface );
+	bface->fdest = dest( *flipface );
+	bface->fapex = apex( *flipface );
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // lawsonflip3d()    A three-dimensional Lawson's algorithm.                 //
@@ -27806,6 +29928,12 @@ long tetgenmesh::lawsonflip3d( flipconstraints *fc )
 			fsym( fliptets[ 0 ], fliptets[ 1 ] );
 			if(ishulltet( fliptets[ 1 ] ))
 			{
+				if(nonconvex && ( view != NULL ))
+				{
+					// A view does not change the hull, leave it to the mesh.
+					deferface( &( fliptets[ 0 ] ) );
+					continue;
+				}
 				if(nonconvex)
 				{
 					// Check if 'fliptets[0]' it is a hull sliver.
@@ -27891,6 +30019,13 @@ long tetgenmesh::lawsonflip3d( flipconstraints *fc )
 				pd = oppo( fliptets[ 0 ] );
 				pe = oppo( fliptets[ 1 ] );
 
+				if(( view != NULL ) && !( tetinblock( fliptets[ 0 ] ) && inblock( pe ) ))
+				{
+					// The flip would change a tet outside the block of the view.
+					deferface( &( fliptets[ 0 ] ) );
+					continue;
+				}
+
 				// Use the length of the edge [d,e] as a reference to determine
 				//   a nearly degenerated new tet.
 				len3 = distance( pd, pe );
@@ -27983,6 +30118,14 @@ long tetgenmesh::lawsonflip3d( flipconstraints *fc )
 									ori = 0;
 								}
 							} // if (nonconvex)
+							if(( ori == 0 ) && ( view != NULL ) &&
+								!inblock( apex( fliptets[ 3 ] ) ))
+							{
+								// The flip would change a tet outside the block.
+								esymself( fliptets[ 0 ] ); // [a,b,c,d]
+								deferface( &( fliptets[ 0 ] ) );
+								continue;
+							}
 							if(ori == 0)
 							{
 								// A 4-to-4 flip is found. (Two hull tets may be involved.)
@@ -28097,6 +30240,8 @@ void tetgenmesh::recoverdelaunay( )
 	flipconstraints fc;
 	int i, j;
 
+	TETGEN_TRACE_SCOPE( b, "recoverdelaunay" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Recovering Delaunayness...\n" );
@@ -28322,23 +30467,137 @@ int tetgenmesh::gettetrahedron( point pa, point pb, point pc, point pd,
 	return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// improvetetbyflips()    Remove a large dihedral angle of a tet by flips.   //
+//                                                                           //
+// 'bface->tt' is the queued tet. The new tets with large dihedral angles    //
+// are queued in 'newqueue'. Returns optjob::IMPROVED if an edge is flipped, //
+// otherwise optjob::KEPT. A view returns optjob::LEFT if it did not flip an //
+// edge because the flips change tets outside its block.                     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::improvetetbyflips( badface *bface, flipconstraints *fc,
+								   arraypool *newqueue )
+{
+	badface *parybface;
+	triface *parytet;
+	point *ppt;
+	REAL *cosdd, ncosdd[ 6 ], maxdd;
+	int remflag;
+	int n, i, j;
+
+	if(view != NULL)
+	{
+		view->deferred = 0;
+	}
+
+	//assert(!ishulltet(bface->tt));
+	// There are bad dihedral angles in this tet.
+	if(bface->tt.ver != 11)
+	{
+		// The dihedral angles are permuted.
+		// Here we simply re-compute them. Slow!!.
+		ppt = (point *)& ( bface->tt.tet[ 4 ] );
+		tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
+						&bface->key, NULL );
+		bface->forg = ppt[ 0 ];
+		bface->fdest = ppt[ 1 ];
+		bface->fapex = ppt[ 2 ];
+		bface->foppo = ppt[ 3 ];
+		bface->tt.ver = 11;
+	}
+	if(bface->key == 0)
+	{
+		// Re-comput the quality values. Due to smoothing operations.
+		ppt = (point *)& ( bface->tt.tet[ 4 ] );
+		tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
+						&bface->key, NULL );
+	}
+	cosdd = bface->cent;
+	remflag = 0;
+	for(i = 0; ( i < 6 ) && !remflag; i++)
+	{
+		if(cosdd[ i ] < cosmaxdihed)
+		{
+			// Found a large dihedral angle.
+			bface->tt.ver = edge2ver[ i ]; // Go to the edge.
+			fc->cosdihed_in = cosdd[ i ];
+			fc->cosdihed_out = 0.0; // 90 degree.
+			n = removeedgebyflips( &( bface->tt ), fc );
+			if(n == 2)
+			{
+				// Edge is flipped.
+				remflag = 1;
+				if(fc->cosdihed_out < cosmaxdihed)
+				{
+					// Queue new bad tets for further improvements.
+					for(j = 0; j < cavetetlist->objects; j++)
+					{
+						parytet = (triface *)fastlookup( cavetetlist, j );
+						if(!isdeadtet( *parytet ))
+						{
+							ppt = (point *)& ( parytet->tet[ 4 ] );
+							// Do not test a hull tet.
+							if(ppt[ 3 ] != dummypoint)
+							{
+								tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], ncosdd,
+												&maxdd, NULL );
+								if(maxdd < cosmaxdihed)
+								{
+									// There are bad dihedral angles in this tet.
+									newqueue->newindex( (void **)&parybface );
+									parybface->tt.tet = parytet->tet;
+									parybface->tt.ver = 11;
+									parybface->forg = ppt[ 0 ];
+									parybface->fdest = ppt[ 1 ];
+									parybface->fapex = ppt[ 2 ];
+									parybface->foppo = ppt[ 3 ];
+									parybface->key = maxdd;
+									for(n = 0; n < 6; n++)
+									{
+										parybface->cent[ n ] = ncosdd[ n ];
+									}
+								}
+							} // if (ppt[3] != dummypoint) 
+						}
+					} // j
+				} // if (fc.cosdihed_out < cosmaxdihed)
+				cavetetlist->restart( );
+			}
+		}
+	} // i
+
+	if(remflag)
+	{
+		return optjob::IMPROVED;
+	}
+	if(( view != NULL ) && view->deferred)
+	{
+		return optjob::LEFT;
+	}
+	return optjob::KEPT;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // improvequalitybyflips()    Improve the mesh quality by flips.             //
 //                                                                           //
+// With '-O//1' (and 'b->parallelfor') the queued tets are flipped in        //
+// batches by improvequalitybatched().                                       //
+//                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
 long tetgenmesh::improvequalitybyflips( )
 {
 	arraypool *flipqueue, *nextflipqueue, *swapqueue;
 	badface *bface, *parybface;
-	triface *parytet;
-	point *ppt;
 	flipconstraints fc;
-	REAL *cosdd, ncosdd[ 6 ], maxdd;
 	long totalremcount, remcount;
-	int remflag;
-	int n, i, j, k;
+	int k;
+
+	TETGEN_TRACE_SCOPE( b, "improvequalitybyflips" );
 
 	//assert(unflipqueue->objects > 0l);
 	flipqueue = new arraypool( sizeof( badface ), 10 );
@@ -28366,140 +30625,89 @@ long tetgenmesh::improvequalitybyflips( )
 	flipqueue = unflipqueue;
 	unflipqueue = swapqueue;
 
-	while(flipqueue->objects > 0l)
+	try
 	{
-
-		remcount = 0l;
-
 		while(flipqueue->objects > 0l)
 		{
-			if(b->verbose > 1)
-			{
-				myprintf( "    Improving mesh qualiy by flips [%d]#:  %ld.\n",
-						autofliplinklevel, flipqueue->objects );
-			}
 
-			for(k = 0; k < flipqueue->objects; k++)
+			remcount = 0l;
+
+			while(flipqueue->objects > 0l)
 			{
-				bface = (badface *)fastlookup( flipqueue, k );
-				if(gettetrahedron( bface->forg, bface->fdest, bface->fapex,
-					bface->foppo, &bface->tt ))
+				if(b->verbose > 1)
+				{
+					myprintf( "    Improving mesh qualiy by flips [%d]#:  %ld.\n",
+							autofliplinklevel, flipqueue->objects );
+				}
+
+				if(b->optparallel && ( b->parallelfor != NULL ))
 				{
-					//assert(!ishulltet(bface->tt));
-					// There are bad dihedral angles in this tet.
-					if(bface->tt.ver != 11)
-					{
-						// The dihedral angles are permuted.
-						// Here we simply re-compute them. Slow!!.
-						ppt = (point *)& ( bface->tt.tet[ 4 ] );
-						tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
-										&bface->key, NULL );
-						bface->forg = ppt[ 0 ];
-						bface->fdest = ppt[ 1 ];
-						bface->fapex = ppt[ 2 ];
-						bface->foppo = ppt[ 3 ];
-						bface->tt.ver = 11;
-					}
-					if(bface->key == 0)
-					{
-						// Re-comput the quality values. Due to smoothing operations.
-						ppt = (point *)& ( bface->tt.tet[ 4 ] );
-						tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
-										&bface->key, NULL );
-					}
-					cosdd = bface->cent;
-					remflag = 0;
-					for(i = 0; ( i < 6 ) && !remflag; i++)
-					{
-						if(cosdd[ i ] < cosmaxdihed)
-						{
-							// Found a large dihedral angle.
-							bface->tt.ver = edge2ver[ i ]; // Go to the edge.
-							fc.cosdihed_in = cosdd[ i ];
-							fc.cosdihed_out = 0.0; // 90 degree.
-							n = removeedgebyflips( &( bface->tt ), &fc );
-							if(n == 2)
+					remcount += improvequalitybatched( flipqueue, nextflipqueue,
+													   unflipqueue, &fc, 0 );
+				}
+				else
+				{
+					for(k = 0; k < flipqueue->objects; k++)
+					{
+						bface = (badface *)fastlookup( flipqueue, k );
+						if(gettetrahedron( bface->forg, bface->fdest, bface->fapex,
+							bface->foppo, &bface->tt ))
+						{
+							if(improvetetbyflips( bface, &fc, nextflipqueue ) ==
+								optjob::IMPROVED)
 							{
-								// Edge is flipped.
-								remflag = 1;
-								if(fc.cosdihed_out < cosmaxdihed)
-								{
-									// Queue new bad tets for further improvements.
-									for(j = 0; j < cavetetlist->objects; j++)
-									{
-										parytet = (triface *)fastlookup( cavetetlist, j );
-										if(!isdeadtet( *parytet ))
-										{
-											ppt = (point *)& ( parytet->tet[ 4 ] );
-											// Do not test a hull tet.
-											if(ppt[ 3 ] != dummypoint)
-											{
-												tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], ncosdd,
-																&maxdd, NULL );
-												if(maxdd < cosmaxdihed)
-												{
-													// There are bad dihedral angles in this tet.
-													nextflipqueue->newindex( (void **)&parybface );
-													parybface->tt.tet = parytet->tet;
-													parybface->tt.ver = 11;
-													parybface->forg = ppt[ 0 ];
-													parybface->fdest = ppt[ 1 ];
-													parybface->fapex = ppt[ 2 ];
-													parybface->foppo = ppt[ 3 ];
-													parybface->key = maxdd;
-													for(n = 0; n < 6; n++)
-													{
-														parybface->cent[ n ] = ncosdd[ n ];
-													}
-												}
-											} // if (ppt[3] != dummypoint) 
-										}
-									} // j
-								} // if (fc.cosdihed_out < cosmaxdihed)
-								cavetetlist->restart( );
 								remcount++;
 							}
-						}
-					} // i          
-					if(!remflag)
-					{
-						// An unremoved bad tet. Queue it again. 
-						unflipqueue->newindex( (void **)&parybface );
-						*parybface = *bface;
-					}
-				} // if (gettetrahedron(...))
-			} // k
+							else
+							{
+								// An unremoved bad tet. Queue it again. 
+								unflipqueue->newindex( (void **)&parybface );
+								*parybface = *bface;
+							}
+						} // if (gettetrahedron(...))
+					} // k
+				}
 
-			flipqueue->restart( );
+				flipqueue->restart( );
 
-			// Swap the two flip queues.
-			swapqueue = flipqueue;
-			flipqueue = nextflipqueue;
-			nextflipqueue = swapqueue;
-		} // while (flipqueues->objects > 0)
+				// Swap the two flip queues.
+				swapqueue = flipqueue;
+				flipqueue = nextflipqueue;
+				nextflipqueue = swapqueue;
+			} // while (flipqueues->objects > 0)
 
-		if(b->verbose > 1)
-		{
-			myprintf( "    Removed %ld bad tets.\n", remcount );
-		}
-		totalremcount += remcount;
+			if(b->verbose > 1)
+			{
+				myprintf( "    Removed %ld bad tets.\n", remcount );
+			}
+			totalremcount += remcount;
 
-		if(unflipqueue->objects > 0l)
-		{
-			//if (autofliplinklevel >= b->optmaxfliplevel) {
-			if(autofliplinklevel >= b->optlevel)
+			if(unflipqueue->objects > 0l)
 			{
-				break;
+				//if (autofliplinklevel >= b->optmaxfliplevel) {
+				if(autofliplinklevel >= b->optlevel)
+				{
+					break;
+				}
+				autofliplinklevel += b->fliplinklevelinc;
+				//b->flipstarsize = 10 + (1 << (b->optlevel - 1));
 			}
-			autofliplinklevel += b->fliplinklevelinc;
-			//b->flipstarsize = 10 + (1 << (b->optlevel - 1));
-		}
 
-		// Swap the two flip queues.
-		swapqueue = flipqueue;
-		flipqueue = unflipqueue;
-		unflipqueue = swapqueue;
-	} // while (flipqueues->objects > 0)
+			// Swap the two flip queues.
+			swapqueue = flipqueue;
+			flipqueue = unflipqueue;
+			unflipqueue = swapqueue;
+		} // while (flipqueues->objects > 0)
+	}
+	catch(int)
+	{
+		autofliplinklevel = bakautofliplinklevel;
+		b->fliplinklevel = bakfliplinklevel;
+		b->flipstarsize = bakmaxflipstarsize;
+		delete flipqueue;
+		delete nextflipqueue;
+		throw;
+	}
 
 	// Restore original flip edge options.
 	autofliplinklevel = bakautofliplinklevel;
@@ -28531,6 +30739,9 @@ long tetgenmesh::improvequalitybyflips( )
 // 'opm' is a structure contains the parameters of the objective function.   //
 // It is needed by the evaluation of the function value.                     //
 //                                                                           //
+// 'seed' (if it is not NULL) is used for the random search directions, and  //
+// 'randomseed' is left untouched. See improvequalitybyparallelsmoothing().  //
+//                                                                           //
 // The return value indicates weather the point is smoothed or not.          //
 //                                                                           //
 // ASSUMPTION: This routine assumes that all link faces are true faces, i.e, //
@@ -28539,7 +30750,7 @@ long tetgenmesh::improvequalitybyflips( )
 ///////////////////////////////////////////////////////////////////////////////
 
 int tetgenmesh::smoothpoint( point smtpt, arraypool *linkfacelist, int ccw,
-							 optparameters *opm )
+							 optparameters *opm, unsigned long *seed )
 {
 	triface *parytet, *parytet1, swaptet;
 	point pa, pb, pc;
@@ -28576,7 +30787,8 @@ int tetgenmesh::smoothpoint( point smtpt, arraypool *linkfacelist, int ccw,
 		for(i = 0; i < numdirs; i++)
 		{
 			// Randomly pick a link face (0 <= k <= objects - i - 1).
-			k = (int)randomnation( linkfacelist->objects - i );
+			k = (int)randomnation( linkfacelist->objects - i,
+								   ( seed != NULL ) ? seed : &randomseed );
 			parytet = (triface *)fastlookup( linkfacelist, k );
 			// Calculate a new position from 'p' to the center of this face.
 			pa = org( *parytet );
@@ -28750,6 +30962,13 @@ long tetgenmesh::improvequalitybysmoothing( optparameters *opm )
 	int smtflag;
 	int iter, i, j, k;
 
+	TETGEN_TRACE_SCOPE( b, "improvequalitybysmoothing" );
+
+	if(b->optparallel)
+	{
+		return improvequalitybyparallelsmoothing( opm );
+	}
+
 	//assert(unflipqueue->objects > 0l);
 	flipqueue = new arraypool( sizeof( badface ), 10 );
 
@@ -28901,6 +31120,412 @@ long tetgenmesh::improvequalitybysmoothing( optparameters *opm )
 	return totalsmtcount;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// smoothvertex()    Smooth one vertex of an independent set.                //
+//                                                                           //
+// It may run concurrently with other vertices of the same set (see          //
+// smoothchunk()), hence it only reads the mesh and writes the coordinates   //
+// of its own vertex. The star of a vertex contains no other vertex of the   //
+// set, so no work item sees the moves of the others. The initial value is   //
+// the worst tet in the star.                                                //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::smoothvertex( smoothjob *job, int i )
+{
+	tetgenmesh *m = this;
+	arraypool linkfacelist( sizeof( triface ), 8 );
+	optparameters opm = *( job->opm );
+	triface *parytet, *plinktet;
+	point smtpt, *ppt;
+	REAL maxcosd;
+	unsigned long seed;
+	int smtflag;
+	int k, j;
+
+	k = job->first + i;
+	smtpt = job->verts[ i ];
+
+	// Copy the link faces, smoothpoint() reorders them.
+	opm.initval = 2.0;
+	for(j = job->linkstart[ k ]; j < job->linkstart[ k + 1 ]; j++)
+	{
+		parytet = (triface *)fastlookup( job->linkfaces, j );
+		linkfacelist.newindex( (void **)&plinktet );
+		*plinktet = *parytet;
+		ppt = (point *)& ( parytet->tet[ 4 ] );
+		m->tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], NULL, &maxcosd,
+						   NULL );
+		if(maxcosd < -1) maxcosd = -1.0; // Rounding.
+		if(( maxcosd + 1.0 ) < opm.initval)
+		{
+			opm.initval = maxcosd + 1.0;
+		}
+	}
+
+	// Each vertex has its own sequence of search directions.
+	seed = ( job->seed + (unsigned long)m->pointmark( smtpt ) ) % 714025l;
+
+	opm.searchstep = 0.001; // Search step size
+	smtflag = m->smoothpoint( smtpt, &linkfacelist, 1, &opm, &seed );
+	if(smtflag)
+	{
+		while(opm.smthiter == opm.maxiter)
+		{
+			opm.searchstep *= 10.0; // Increase the step size.
+			opm.initval = opm.imprval;
+			opm.smthiter = 0; // reset
+			m->smoothpoint( smtpt, &linkfacelist, 1, &opm, &seed );
+		}
+	}
+
+	job->smoothed[ k ] = smtflag ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// smoothchunk()    Smooth a chunk of the vertices of an independent set.    //
+//                                                                           //
+// This is the work item of improvequalitybyparallelsmoothing().  Vertices   //
+// are smoothed in chunks, a single vertex is too little work for a work     //
+// item of the 'b->parallelfor' callback.                                    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::smoothchunk( void* arg, int chunk )
+{
+	smoothjob *job = (smoothjob *)arg;
+	int i, last;
+
+	i = chunk * job->chunksize;
+	last = i + job->chunksize;
+	if(last > job->numverts) last = job->numverts;
+
+	for(; i < last; i++)
+	{
+		job->m->smoothvertex( job, i );
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// improvequalitybyparallelsmoothing()    Smooth the slivers concurrently.   //
+//                                                                           //
+// Like improvequalitybysmoothing(), the free vertices of a sliver are tried //
+// in order until one of them is moved. Here it is done in four rounds, the  //
+// i-th round tries the i-th vertex of every sliver which is not improved.   //
+// The vertices of a round are greedily grouped in independent sets, i.e.,   //
+// no two vertices of a set share a tetrahedron. The sets are smoothed one   //
+// after another, chunks of the vertices of a set by the 'b->parallelfor'    //
+// callback. Stars are collected and slivers are queued by the calling       //
+// thread. The result does not depend on the number of threads.              //
+//                                                                           //
+// Smoothing does not change the mesh topology, hence the collected link     //
+// faces stay valid for the whole pass.  The flips and the sliver splits of  //
+// optimizemesh() are done by improvequalitybatched().  An error in a work   //
+// item is raised again by parallelloop() on the calling thread, the arrays  //
+// of the pass are freed before it is passed on.                             //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+long tetgenmesh::improvequalitybyparallelsmoothing( optparameters *opm )
+{
+	arraypool *flipqueue, *swapqueue;
+	arraypool *sliverlist, *candlist, *restlist, *marklist, *linkfaces;
+	smoothjob job;
+	triface *parytet, *plinktet;
+	badface *bface, *parybface;
+	point *ppt, *parypt, *verts, pt;
+	REAL maxdd;
+	int *linkstart, *smoothed;
+	long totalsmtcount, smtcount;
+	int maxcands, first, count;
+	int iter, round, i, j, k;
+
+	flipqueue = new arraypool( sizeof( badface ), 10 );
+	sliverlist = new arraypool( sizeof( badface ), 10 );
+	candlist = new arraypool( sizeof( point ), 10 );
+	restlist = new arraypool( sizeof( point ), 10 );
+	marklist = new arraypool( sizeof( point ), 10 );
+	linkfaces = new arraypool( sizeof( triface ), 10 );
+
+	// Swap the two flip queues.
+	swapqueue = flipqueue;
+	flipqueue = unflipqueue;
+	unflipqueue = swapqueue;
+
+	job.m = this;
+	job.opm = opm;
+	job.linkfaces = linkfaces;
+	job.chunksize = 16;
+
+	totalsmtcount = 0l;
+	iter = 0;
+
+	while(flipqueue->objects > 0l)
+	{
+
+		smtcount = 0l;
+
+		if(b->verbose > 1)
+		{
+			myprintf( "    Improving mesh quality by parallel smoothing [%d]#:  %ld.\n",
+					iter, flipqueue->objects );
+		}
+
+		// Collect the slivers.
+		for(k = 0; k < flipqueue->objects; k++)
+		{
+			bface = (badface *)fastlookup( flipqueue, k );
+			if(gettetrahedron( bface->forg, bface->fdest, bface->fapex,
+				bface->foppo, &bface->tt ))
+			{
+				if(!marktested( bface->tt ))
+				{
+					marktest( bface->tt );
+					sliverlist->newindex( (void **)&parybface );
+					*parybface = *bface;
+				}
+			}
+		} // k
+
+		flipqueue->restart( );
+
+		for(i = 0; i < sliverlist->objects; i++)
+		{
+			bface = (badface *)fastlookup( sliverlist, i );
+			unmarktest( bface->tt );
+		}
+
+		maxcands = 4 * (int)sliverlist->objects;
+		verts = new point[ maxcands > 0 ? maxcands : 1 ];
+		linkstart = new int[ maxcands + 1 ];
+		smoothed = new int[ maxcands > 0 ? maxcands : 1 ];
+		first = count = 0;
+		linkstart[ 0 ] = 0;
+
+		for(round = 0; round < 4; round++)
+		{
+			// Collect the round-th vertex of the slivers which are not improved
+			//   yet. A smoothed vertex is marked by pmarktest3(), a tried one by
+			//   pmarktest().
+			for(i = 0; i < sliverlist->objects; i++)
+			{
+				bface = (badface *)fastlookup( sliverlist, i );
+				ppt = (point *)& ( bface->tt.tet[ 4 ] );
+				for(j = 0; j < 4; j++)
+				{
+					if(pmarktest3ed( ppt[ j ] )) break;
+				}
+				if(j < 4) continue; // Already smoothed.
+				pt = ppt[ round ];
+				if(( pointtype( pt ) != FREEVOLVERTEX ) || pmarktested( pt ))
+				{
+					continue;
+				}
+				// Other smoothing operations may have improved it.
+				tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
+								&bface->key, NULL );
+				if(bface->key < cossmtdihed)
+				{
+					pmarktest( pt );
+					candlist->newindex( (void **)&parypt );
+					*parypt = pt;
+				}
+			} // i
+
+			while(candlist->objects > 0l)
+			{
+				// Select an independent set from the remaining vertices. A vertex
+				//   is taken if neither it nor a vertex of its star is marked.
+				for(i = 0; i < candlist->objects; i++)
+				{
+					pt = *(point *)fastlookup( candlist, i );
+					if(pmarktest2ed( pt ))
+					{
+						// Conflicts with a vertex of this set. Try it in the next one.
+						restlist->newindex( (void **)&parypt );
+						*parypt = pt;
+						continue;
+					}
+					getvertexstar( 1, pt, cavetetlist, cavetetvertlist, NULL );
+					for(j = 0; j < cavetetlist->objects; j++)
+					{
+						parytet = (triface *)fastlookup( cavetetlist, j );
+						linkfaces->newindex( (void **)&plinktet );
+						*plinktet = *parytet;
+					}
+					pmarktest2( pt );
+					marklist->newindex( (void **)&parypt );
+					*parypt = pt;
+					for(j = 0; j < cavetetvertlist->objects; j++)
+					{
+						ppt = (point *)fastlookup( cavetetvertlist, j );
+						if(!pmarktest2ed( *ppt ))
+						{
+							pmarktest2( *ppt );
+							marklist->newindex( (void **)&parypt );
+							*parypt = *ppt;
+						}
+					}
+					cavetetlist->restart( );
+					cavetetvertlist->restart( );
+					verts[ count ] = pt;
+					count++;
+					linkstart[ count ] = (int)linkfaces->objects;
+				} // i
+
+				for(i = 0; i < marklist->objects; i++)
+				{
+					parypt = (point *)fastlookup( marklist, i );
+					punmarktest2( *parypt );
+				}
+				marklist->restart( );
+
+				// Smooth the vertices of this set.
+				job.verts = &( verts[ first ] );
+				job.first = first;
+				job.linkstart = linkstart;
+				job.smoothed = smoothed;
+				job.numverts = count - first;
+				job.seed = randomnation( 714025l );
+				try
+				{
+					parallelloop( ( job.numverts + job.chunksize - 1 ) / job.chunksize,
+								  smoothchunk, &job );
+				}
+				catch(int)
+				{
+					delete[ ] verts;
+					delete[ ] linkstart;
+					delete[ ] smoothed;
+					delete flipqueue;
+					delete sliverlist;
+					delete candlist;
+					delete restlist;
+					delete marklist;
+					delete linkfaces;
+					throw;
+				}
+				for(k = first; k < count; k++)
+				{
+					if(smoothed[ k ])
+					{
+						pmarktest3( verts[ k ] );
+						smtcount++;
+					}
+				}
+				first = count;
+
+				swapqueue = candlist;
+				candlist = restlist;
+				restlist = swapqueue;
+				restlist->restart( );
+			} // while (candlist->objects > 0l)
+		} // round
+
+		// Queue the slivers which were not improved.
+		for(i = 0; i < sliverlist->objects; i++)
+		{
+			bface = (badface *)fastlookup( sliverlist, i );
+			ppt = (point *)& ( bface->tt.tet[ 4 ] );
+			tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
+							&bface->key, NULL );
+			if(( bface->key < cossmtdihed ) && !marktested( bface->tt ))
+			{
+				marktest( bface->tt ); // It is in unflipqueue.
+				unflipqueue->newindex( (void **)&parybface );
+				parybface->tt = bface->tt;
+				parybface->forg = ppt[ 0 ];
+				parybface->fdest = ppt[ 1 ];
+				parybface->fapex = ppt[ 2 ];
+				parybface->foppo = ppt[ 3 ];
+				parybface->tt.ver = 11;
+				parybface->key = 0.0;
+			}
+		}
+		sliverlist->restart( );
+
+		// Queue the new slivers in the stars of the smoothed vertices.
+		for(k = 0; k < count; k++)
+		{
+			punmarktest( verts[ k ] );
+			if(!smoothed[ k ]) continue;
+			punmarktest3( verts[ k ] );
+			for(j = linkstart[ k ]; j < linkstart[ k + 1 ]; j++)
+			{
+				parytet = (triface *)fastlookup( linkfaces, j );
+				if(!marktested( *parytet ))
+				{
+					ppt = (point *)& ( parytet->tet[ 4 ] );
+					tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], NULL,
+									&maxdd, NULL );
+					if(maxdd < cossmtdihed)
+					{
+						// A new sliver. Queue it.
+						marktest( *parytet ); // It is in unflipqueue.
+						unflipqueue->newindex( (void **)&parybface );
+						parybface->tt = *parytet;
+						parybface->forg = ppt[ 0 ];
+						parybface->fdest = ppt[ 1 ];
+						parybface->fapex = ppt[ 2 ];
+						parybface->foppo = ppt[ 3 ];
+						parybface->tt.ver = 11;
+						parybface->key = 0.0;
+					}
+				}
+			} // j
+		} // k
+		linkfaces->restart( );
+
+		delete[ ] verts;
+		delete[ ] linkstart;
+		delete[ ] smoothed;
+
+		// Unmark the tets in unflipqueue.
+		for(i = 0; i < unflipqueue->objects; i++)
+		{
+			bface = (badface *)fastlookup( unflipqueue, i );
+			unmarktest( bface->tt );
+		}
+
+		if(b->verbose > 1)
+		{
+			myprintf( "    Smooth %ld points.\n", smtcount );
+		}
+		totalsmtcount += smtcount;
+
+		if(smtcount == 0l)
+		{
+			// No point has been smoothed. 
+			break;
+		}
+		else
+		{
+			iter++;
+			if(iter == 2)
+			{
+				break;
+			}
+		}
+
+		// Swap the two flip queues.
+		swapqueue = flipqueue;
+		flipqueue = unflipqueue;
+		unflipqueue = swapqueue;
+	} // while
+
+	delete flipqueue;
+	delete sliverlist;
+	delete candlist;
+	delete restlist;
+	delete marklist;
+	delete linkfaces;
+
+	return totalsmtcount;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // splitsliver()    Split a sliver.                                          //
@@ -28936,6 +31561,12 @@ int tetgenmesh::splitsliver( triface *slitet, REAL cosd, int chkencflag )
 	while(1)
 	{
 		if(ishulltet( spintet )) break;
+		if(( view != NULL ) && !tetinblock( spintet ))
+		{
+			// A view only splits the tets in its block.
+			view->deferred = 1;
+			return 0;
+		}
 		n++;
 		fnextself( spintet );
 		if(spintet.tet == searchtet.tet) break;
@@ -29006,6 +31637,13 @@ int tetgenmesh::splitsliver( triface *slitet, REAL cosd, int chkencflag )
 		return 0;
 	}
 
+	if(( view != NULL ) && !inblock( smtpt ))
+	{
+		// A view only inserts points in its block.
+		view->deferred = 1;
+		delete[ ] abtets;
+		return 0;
+	}
 
 	// Insert the Steiner point.
 	makepoint( &steinerpt, FREEVOLVERTEX );
@@ -29044,25 +31682,126 @@ int tetgenmesh::splitsliver( triface *slitet, REAL cosd, int chkencflag )
 	{
 		// The Steiner point is too close to an existing vertex. Reject it.
 		pointdealloc( steinerpt );
+		if(( view != NULL ) && ( ivf.iloc == (int)OUTSIDEBLOCK ))
+		{
+			// The cavity left the block.
+			view->deferred = 1;
+		}
 		return 0;
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// removesliver()    Split a sliver at one of its large dihedral angles.     //
+//                                                                           //
+// 'bface->tt' is the queued tet. The new slivers are queued in 'newqueue'.  //
+// Returns optjob::IMPROVED if the sliver is split, optjob::DROPPED if it is //
+// no sliver (anymore), otherwise optjob::KEPT. A view returns optjob::LEFT  //
+// if it did not split the sliver because the split changes tets outside its //
+// block.                                                                    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int tetgenmesh::removesliver( badface *bface, int chkencflag,
+							  arraypool *newqueue )
+{
+	badface *parybface;
+	triface slitet, *parytet;
+	point *ppt;
+	REAL cosdd[ 6 ], maxcosd;
+	int deferred = 0;
+	int i, j;
+
+	if(( bface->key == 0 ) || ( bface->tt.ver != 11 ))
+	{
+		// Here we need to re-compute the quality. Since other smoothing
+		//   operation may have moved the vertices of this tet.
+		ppt = (point *)& ( bface->tt.tet[ 4 ] );
+		tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
+						&bface->key, NULL );
+	}
+	if(bface->key >= cosslidihed)
+	{
+		return optjob::DROPPED;
+	}
+
+	// It is a sliver. Try to split it.
+	slitet.tet = bface->tt.tet;
+	//cosdd = bface->cent;
+	for(j = 0; j < 6; j++)
+	{
+		if(bface->cent[ j ] < cosslidihed)
+		{
+			// Found a large dihedral angle.
+			slitet.ver = edge2ver[ j ]; // Go to the edge.
+			if(view != NULL)
+			{
+				view->deferred = 0;
+			}
+			if(splitsliver( &slitet, bface->cent[ j ], chkencflag ))
+			{
+				break;
+			}
+			if(( view != NULL ) && view->deferred)
+			{
+				deferred = 1;
+			}
+		}
+	} // j
+
+	if(j == 6)
+	{
+		return deferred ? optjob::LEFT : optjob::KEPT;
+	}
+
+	// A sliver is split. Queue new slivers.
+	badtetrahedrons->traversalinit( );
+	parytet = (triface *)badtetrahedrons->traverse( );
+	while(parytet != NULL)
+	{
+		unmarktest2( *parytet );
+		ppt = (point *)& ( parytet->tet[ 4 ] );
+		tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], cosdd,
+						&maxcosd, NULL );
+		if(maxcosd < cosslidihed)
+		{
+			// A new sliver. Queue it.
+			newqueue->newindex( (void **)&parybface );
+			parybface->forg = ppt[ 0 ];
+			parybface->fdest = ppt[ 1 ];
+			parybface->fapex = ppt[ 2 ];
+			parybface->foppo = ppt[ 3 ];
+			parybface->tt.tet = parytet->tet;
+			parybface->tt.ver = 11;
+			parybface->key = maxcosd;
+			for(i = 0; i < 6; i++)
+			{
+				parybface->cent[ i ] = cosdd[ i ];
+			}
+		}
+		parytet = (triface *)badtetrahedrons->traverse( );
+	}
+	badtetrahedrons->restart( );
+
+	return optjob::IMPROVED;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // removeslivers()    Remove slivers by adding Steiner points.               //
 //                                                                           //
+// With '-O//1' (and 'b->parallelfor') the slivers are split in batches by   //
+// improvequalitybatched().                                                  //
+//                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
 long tetgenmesh::removeslivers( int chkencflag )
 {
 	arraypool *flipqueue, *swapqueue;
 	badface *bface, *parybface;
-	triface slitet, *parytet;
-	point *ppt;
-	REAL cosdd[ 6 ], maxcosd;
 	long totalsptcount, sptcount;
-	int iter, i, j, k;
+	int iter, k, state;
 
 	//assert(unflipqueue->objects > 0l);
 	flipqueue = new arraypool( sizeof( badface ), 10 );
@@ -29086,78 +31825,41 @@ long tetgenmesh::removeslivers( int chkencflag )
 					iter, flipqueue->objects );
 		}
 
-		for(k = 0; ( k < flipqueue->objects ) && ( steinerleft != 0 ); k++)
+		if(b->optparallel && ( b->parallelfor != NULL ))
 		{
-			bface = (badface *)fastlookup( flipqueue, k );
-			if(gettetrahedron( bface->forg, bface->fdest, bface->fapex,
-				bface->foppo, &bface->tt ))
+			try
 			{
-				if(( bface->key == 0 ) || ( bface->tt.ver != 11 ))
-				{
-					// Here we need to re-compute the quality. Since other smoothing
-					//   operation may have moved the vertices of this tet.
-					ppt = (point *)& ( bface->tt.tet[ 4 ] );
-					tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], bface->cent,
-									&bface->key, NULL );
-				}
-				if(bface->key < cosslidihed)
+				sptcount += improvequalitybatched( flipqueue, unflipqueue, unflipqueue,
+												   NULL, chkencflag );
+			}
+			catch(int)
+			{
+				delete flipqueue;
+				throw;
+			}
+		}
+		else
+		{
+			for(k = 0; ( k < flipqueue->objects ) && ( steinerleft != 0 ); k++)
+			{
+				bface = (badface *)fastlookup( flipqueue, k );
+				if(gettetrahedron( bface->forg, bface->fdest, bface->fapex,
+					bface->foppo, &bface->tt ))
 				{
-					// It is a sliver. Try to split it.
-					slitet.tet = bface->tt.tet;
-					//cosdd = bface->cent;
-					for(j = 0; j < 6; j++)
-					{
-						if(bface->cent[ j ] < cosslidihed)
-						{
-							// Found a large dihedral angle.
-							slitet.ver = edge2ver[ j ]; // Go to the edge.
-							if(splitsliver( &slitet, bface->cent[ j ], chkencflag ))
-							{
-								sptcount++;
-								break;
-							}
-						}
-					} // j
-					if(j < 6)
+					state = removesliver( bface, chkencflag, unflipqueue );
+					if(state == optjob::IMPROVED)
 					{
-						// A sliver is split. Queue new slivers.
-						badtetrahedrons->traversalinit( );
-						parytet = (triface *)badtetrahedrons->traverse( );
-						while(parytet != NULL)
-						{
-							unmarktest2( *parytet );
-							ppt = (point *)& ( parytet->tet[ 4 ] );
-							tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], cosdd,
-											&maxcosd, NULL );
-							if(maxcosd < cosslidihed)
-							{
-								// A new sliver. Queue it.
-								unflipqueue->newindex( (void **)&parybface );
-								parybface->forg = ppt[ 0 ];
-								parybface->fdest = ppt[ 1 ];
-								parybface->fapex = ppt[ 2 ];
-								parybface->foppo = ppt[ 3 ];
-								parybface->tt.tet = parytet->tet;
-								parybface->tt.ver = 11;
-								parybface->key = maxcosd;
-								for(i = 0; i < 6; i++)
-								{
-									parybface->cent[ i ] = cosdd[ i ];
-								}
-							}
-							parytet = (triface *)badtetrahedrons->traverse( );
-						}
-						badtetrahedrons->restart( );
+						sptcount++;
 					}
-					else
+					else if(state == optjob::KEPT)
 					{
 						// Didn't split. Queue it again.
 						unflipqueue->newindex( (void **)&parybface );
 						*parybface = *bface;
-					} // if (j == 6)
-				} // if (bface->key < cosslidihed)
-			} // if (gettetrahedron(...))
-		} // k
+					}
+				} // if (gettetrahedron(...))
+			} // k
+		}
 
 		flipqueue->restart( );
 
@@ -29192,6 +31894,281 @@ long tetgenmesh::removeslivers( int chkencflag )
 	return totalsptcount;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// improveblock()    Improve the binned tets of a block by a view.           //
+//                                                                           //
+// The view flips (or splits) the tets in the order of the batch. A tet      //
+// which was changed by a previous one of the block is left to the calling   //
+// thread, which finds it again. improveblockitem() is the work item of      //
+// parallelloop().                                                           //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::improveblockitem( void* arg, int blk )
+{
+	optjob *job = (optjob *)arg;
+
+	job->m->improveblock( job, blk );
+}
+
+void tetgenmesh::improveblock( optjob *job, int blk )
+{
+	blockjob *bj = &( job->blocks );
+	tetgenmesh *vm;
+	flipconstraints fc;
+	badface *bface;
+	point *ppt;
+	int i, j, k;
+
+	vm = takeview( bj, blk );
+	// The flip options are changed by improvequalitybyflips().
+	vm->autofliplinklevel = autofliplinklevel;
+	vm->b->fliplinklevel = b->fliplinklevel;
+	vm->b->flipstarsize = b->flipstarsize;
+	if(job->fc != NULL)
+	{
+		fc = *( job->fc );
+	}
+
+	for(k = bj->blockstart[ blk ]; k < bj->blockstart[ blk + 1 ]; k++)
+	{
+		i = bj->order[ k ];
+		if(job->states[ i ] != optjob::LEFT) continue;
+		bface = (badface *)fastlookup( job->queue, job->first + i );
+		if(isdeadtet( bface->tt )) continue;
+		ppt = (point *)& ( bface->tt.tet[ 4 ] );
+		for(j = 0; j < 4; j++)
+		{
+			if(ppt[ j ] != job->verts[ 4 * i + j ]) break;
+		}
+		if(j < 4) continue;
+		if(job->fc != NULL)
+		{
+			job->states[ i ] = vm->improvetetbyflips( bface, &fc, vm->unflipqueue );
+		}
+		else
+		{
+			job->states[ i ] = vm->removesliver( bface, job->chkencflag,
+												 vm->unflipqueue );
+		}
+	}
+	releaseview( bj, vm );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// improvequalitybatched()    Flip or split the queued tets in batches.      //
+//                                                                           //
+// The tets in 'queue' are flipped by improvetetbyflips() with 'fc', or if   //
+// 'fc' is NULL, their slivers are split by removesliver(). The new bad tets //
+// are queued in 'newqueue', the tets which are not improved in 'keptqueue'. //
+// Returns the number of improved tets.                                      //
+//                                                                           //
+// The tets are taken in batches like by repairbadtetsbatched(). If enough   //
+// of them are found, they are binned into the blocks of a grid, whose       //
+// blocks are large compared to the edge stars. The blocks are improved      //
+// concurrently, each by a view of the mesh which only flips (or splits) the //
+// tets whose vertices are all in its block, so the changes of different     //
+// blocks are disjoint. The tets which were not binned, and those left by a  //
+// view, are then improved in order by the calling thread. So each tet gets  //
+// the same flips (or splits) as by the serial loop, but the resulting mesh  //
+// depends on the scheduling of the blocks.                                  //
+//                                                                           //
+// Slivers are only split by blocks if the Steiner points left suffice. An   //
+// error is raised again on the calling thread by parallelloop(), the arrays //
+// of the batch and the views are freed before it is passed on.              //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+long tetgenmesh::improvequalitybatched( arraypool *queue, arraypool *newqueue,
+										arraypool *keptqueue, flipconstraints *fc,
+										int chkencflag )
+{
+	optjob job;
+	tetgenmesh *vm;
+	badface *bface, *parybface;
+	point *ppt;
+	REAL logsum, len;
+	long impcount = 0l;
+	int maxbatch, numfound, state;
+	int batch = 0;
+	int i, j;
+
+	TETGEN_TRACE_SCOPE( b, "improvequalitybatched" );
+
+	maxbatch = 8192;
+	job.m = this;
+	job.queue = queue;
+	job.fc = fc;
+	job.chkencflag = chkencflag;
+	job.verts = new point[ 4 * maxbatch ];
+	job.states = new int[ maxbatch ];
+	initblockjob( &( job.blocks ), maxbatch );
+
+	try
+	{
+		for(job.first = 0; job.first < queue->objects; job.first += job.numtets)
+		{
+			if(( fc == NULL ) && ( steinerleft == 0 ))
+			{
+				break;
+			}
+
+			// Find the tets of a batch.
+			job.numtets = (int)( queue->objects - job.first );
+			if(job.numtets > maxbatch) job.numtets = maxbatch;
+			numfound = 0;
+			logsum = 0.0;
+			for(i = 0; i < job.numtets; i++)
+			{
+				bface = (badface *)fastlookup( queue, job.first + i );
+				if(gettetrahedron( bface->forg, bface->fdest, bface->fapex,
+					bface->foppo, &bface->tt ))
+				{
+					ppt = (point *)& ( bface->tt.tet[ 4 ] );
+					for(j = 0; j < 4; j++)
+					{
+						job.verts[ 4 * i + j ] = ppt[ j ];
+					}
+					len = distance( ppt[ 0 ], ppt[ 1 ] );
+					if(len > 0.0) logsum += log( len );
+					numfound++;
+					job.states[ i ] = optjob::LEFT;
+				}
+				else
+				{
+					// The tet is gone, its vertices are only binned.
+					job.verts[ 4 * i ] = bface->forg;
+					job.verts[ 4 * i + 1 ] = bface->fdest;
+					job.verts[ 4 * i + 2 ] = bface->fapex;
+					job.verts[ 4 * i + 3 ] = bface->foppo;
+					job.states[ i ] = optjob::MISSING;
+				}
+			}
+
+			job.blocks.numblocks = 0;
+			if(( numfound >= 256 ) && (( fc != NULL ) || ( steinerleft < 0 ) ||
+				( steinerleft >= numfound )))
+			{
+				binitems( &( job.blocks ), job.verts, job.numtets,
+						  gridsize( exp( logsum / numfound ) ), batch );
+			}
+
+			if(job.blocks.numblocks > 0)
+			{
+				lockpools( job.blocks.lock );
+				try
+				{
+					parallelloop( job.blocks.numblocks, improveblockitem, &job );
+				}
+				catch(int)
+				{
+					lockpools( NULL );
+					throw;
+				}
+				lockpools( NULL );
+				for(i = 0; i < job.blocks.views->objects; i++)
+				{
+					vm = *(tetgenmesh **)fastlookup( job.blocks.views, i );
+					mergeview( vm );
+					// Queue the new bad tets of the view.
+					for(j = 0; j < vm->unflipqueue->objects; j++)
+					{
+						newqueue->newindex( (void **)&parybface );
+						*parybface = *(badface *)fastlookup( vm->unflipqueue, j );
+					}
+					vm->unflipqueue->restart( );
+				}
+				if(b->verbose > 2)
+				{
+					for(i = j = 0; i < job.numtets; i++)
+					{
+						if(job.states[ i ] == optjob::LEFT) j++;
+					}
+					myprintf( "      %d blocks tried %d tets, %d left.\n",
+							  job.blocks.numblocks, numfound - j, j );
+				}
+			}
+
+			// Improve the tets left to the calling thread in order.
+			for(i = 0; i < job.numtets; i++)
+			{
+				if(( fc == NULL ) && ( steinerleft == 0 ))
+				{
+					break;
+				}
+				bface = (badface *)fastlookup( queue, job.first + i );
+				state = job.states[ i ];
+				if(state == optjob::LEFT)
+				{
+					if(!gettetrahedron( bface->forg, bface->fdest, bface->fapex,
+						bface->foppo, &bface->tt ))
+					{
+						continue;
+					}
+					if(fc != NULL)
+					{
+						state = improvetetbyflips( bface, fc, newqueue );
+					}
+					else
+					{
+						state = removesliver( bface, chkencflag, newqueue );
+					}
+				}
+				if(state == optjob::IMPROVED)
+				{
+					impcount++;
+				}
+				else if(state == optjob::KEPT)
+				{
+					// Queue it again.
+					keptqueue->newindex( (void **)&parybface );
+					*parybface = *bface;
+				}
+			}
+			batch++;
+		}
+	}
+	catch(int)
+	{
+		freeblockjob( &( job.blocks ) );
+		delete[ ] job.verts;
+		delete[ ] job.states;
+		throw;
+	}
+
+	freeblockjob( &( job.blocks ) );
+	delete[ ] job.verts;
+	delete[ ] job.states;
+
+	return impcount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// tetqualitychunk()    Evaluate the dihedral angles of a chunk of tets.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::tetqualitychunk( void* arg, int chunk )
+{
+	qualityjob *job = (qualityjob *)arg;
+	point *ppt;
+	int i, last;
+
+	i = chunk * job->chunksize;
+	last = i + job->chunksize;
+	if(last > job->numtets) last = job->numtets;
+
+	for(; i < last; i++)
+	{
+		ppt = (point *)& ( job->tets[ i ][ 4 ] );
+		job->m->tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], NULL,
+								&( job->maxdd[ i ] ), NULL );
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // optimizemesh()    Optimize mesh for specified objective functions.        //
@@ -29213,6 +32190,8 @@ void tetgenmesh::optimizemesh( )
 	int iter;
 	int n;
 
+	TETGEN_TRACE_SCOPE( b, "optimizemesh" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Optimizing mesh...\n" );
@@ -29236,39 +32215,84 @@ void tetgenmesh::optimizemesh( )
 
 	int attrnum = numelemattrib - 1;
 
-	// Put all bad tetrahedra into array.
-	tetrahedrons->traversalinit( );
-	checktet.tet = tetrahedrontraverse( );
-	while(checktet.tet != NULL)
+	if(b->optparallel)
 	{
-		if(b->convex)
-		{ // -c
-			// Skip this tet if it lies in the exterior.
-			if(elemattribute( checktet.tet, attrnum ) == -1.0)
+		// Evaluate the tets concurrently, then queue the bad ones in the same
+		//   order as below.
+		qualityjob job;
+		job.m = this;
+		job.tets = new tetrahedron*[ tetrahedrons->items ];
+		job.numtets = 0;
+		tetrahedrons->traversalinit( );
+		checktet.tet = tetrahedrontraverse( );
+		while(checktet.tet != NULL)
+		{
+			if(!b->convex || ( elemattribute( checktet.tet, attrnum ) != -1.0 ))
 			{
-				checktet.tet = tetrahedrontraverse( );
-				continue;
+				job.tets[ job.numtets++ ] = checktet.tet;
 			}
+			checktet.tet = tetrahedrontraverse( );
 		}
-		ppt = (point *)& ( checktet.tet[ 4 ] );
-		tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], ncosdd, &maxdd, NULL );
-		if(maxdd < cosmaxdihed)
+		job.maxdd = new REAL[ job.numtets > 0 ? job.numtets : 1 ];
+		job.chunksize = 4096;
+		parallelloop( ( job.numtets + job.chunksize - 1 ) / job.chunksize,
+					  tetqualitychunk, &job );
+		for(n = 0; n < job.numtets; n++)
 		{
-			// There are bad dihedral angles in this tet.
-			unflipqueue->newindex( (void **)&parybface );
-			parybface->tt.tet = checktet.tet;
-			parybface->tt.ver = 11;
-			parybface->forg = ppt[ 0 ];
-			parybface->fdest = ppt[ 1 ];
-			parybface->fapex = ppt[ 2 ];
-			parybface->foppo = ppt[ 3 ];
-			parybface->key = maxdd;
-			for(n = 0; n < 6; n++)
+			if(job.maxdd[ n ] < cosmaxdihed)
 			{
-				parybface->cent[ n ] = ncosdd[ n ];
+				// There are bad dihedral angles in this tet.
+				ppt = (point *)& ( job.tets[ n ][ 4 ] );
+				unflipqueue->newindex( (void **)&parybface );
+				parybface->tt.tet = job.tets[ n ];
+				parybface->tt.ver = 11;
+				parybface->forg = ppt[ 0 ];
+				parybface->fdest = ppt[ 1 ];
+				parybface->fapex = ppt[ 2 ];
+				parybface->foppo = ppt[ 3 ];
+				tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], parybface->cent,
+								&parybface->key, NULL );
 			}
 		}
+		delete[ ] job.tets;
+		delete[ ] job.maxdd;
+	}
+	else
+	{
+		// Put all bad tetrahedra into array.
+		tetrahedrons->traversalinit( );
 		checktet.tet = tetrahedrontraverse( );
+		while(checktet.tet != NULL)
+		{
+			if(b->convex)
+			{ // -c
+				// Skip this tet if it lies in the exterior.
+				if(elemattribute( checktet.tet, attrnum ) == -1.0)
+				{
+					checktet.tet = tetrahedrontraverse( );
+					continue;
+				}
+			}
+			ppt = (point *)& ( checktet.tet[ 4 ] );
+			tetalldihedral( ppt[ 0 ], ppt[ 1 ], ppt[ 2 ], ppt[ 3 ], ncosdd, &maxdd, NULL );
+			if(maxdd < cosmaxdihed)
+			{
+				// There are bad dihedral angles in this tet.
+				unflipqueue->newindex( (void **)&parybface );
+				parybface->tt.tet = checktet.tet;
+				parybface->tt.ver = 11;
+				parybface->forg = ppt[ 0 ];
+				parybface->fdest = ppt[ 1 ];
+				parybface->fapex = ppt[ 2 ];
+				parybface->foppo = ppt[ 3 ];
+				parybface->key = maxdd;
+				for(n = 0; n < 6; n++)
+				{
+					parybface->cent[ n ] = ncosdd[ n ];
+				}
+			}
+			checktet.tet = tetrahedrontraverse( );
+		}
 	}
 
 	totalremcount = improvequalitybyflips( );
@@ -29291,6 +32315,10 @@ void tetgenmesh::optimizemesh( )
 
 		while(iter < optpasses)
 		{
+			if(pollprogress( "optimizemesh", (REAL)iter / (REAL)optpasses ))
+			{
+				terminatetetgen( this, progresscancel );
+			}
 			smtcount = sptcount = remcount = 0l;
 			if(b->optscheme & 2)
 			{
@@ -31041,6 +34069,12 @@ void tetgenmesh::memorystatistics( )
 	printfcomma( totalmeshmemory + totalt2shmemory + totalalgomemory +
 				 totalworkmemory );
 	myprintf( "\n" );
+	if(b->memstats != NULL)
+	{
+		myprintf( "  Pool memory, live and peak (bytes):  " );
+		printfcomma( (unsigned long)b->memstats->live ); myprintf( ", " );
+		printfcomma( (unsigned long)b->memstats->peak ); myprintf( "\n" );
+	}
 
 	myprintf( "\n" );
 }
@@ -31071,7 +34105,8 @@ void tetgenmesh::statistics( )
 	}
 	else if(b->plc)
 	{
-		myprintf( "  Input facets: %d\n", in->numberoffacets );
+		myprintf( "  Input facets: %d\n", in->trianglelist != NULL ?
+				  in->numberoftriangles : in->numberoffacets );
 		myprintf( "  Input segments: %ld\n", insegments );
 		if(in->numberofedges > 0)
 		{
@@ -31148,6 +34183,18 @@ void tetgenmesh::statistics( )
 
 	if(b->verbose > 0)
 	{
+		if(locatecount > 0l)
+		{
+			myprintf( "  Point location: %ld walks, %.1f tets per walk (max %ld).\n",
+					locatecount, (REAL)locatesteps / (REAL)locatecount,
+					locatemaxsteps );
+			if(locgrid != NULL)
+			{
+				myprintf( "  Point location grid: %d x %d x %d cells.\n",
+						locgriddim[ 0 ], locgriddim[ 1 ], locgriddim[ 2 ] );
+			}
+			myprintf( "\n" );
+		}
 		if(b->plc || b->refine)
 		{ // -p or -r
 			if(tetrahedrons->items > 0l)
@@ -31189,6 +34236,8 @@ void tetgenmesh::jettisonnodes( )
 	int oldidx, newidx;
 	int remcount;
 
+	TETGEN_TRACE_SCOPE( b, "jettisonnodes" );
+
 	if(!b->quiet)
 	{
 		myprintf( "Jettisoning redundant points.\n" );
@@ -31454,6 +34503,8 @@ void tetgenmesh::outnodes( tetgenio* out )
 	int pointnumber, firstindex;
 	int index, i;
 
+	TETGEN_TRACE_SCOPE( b, "outnodes" );
+
 	if(out == (tetgenio *)NULL)
 	{
 		strcpy( outnodefilename, b->outfilename );
@@ -31706,7 +34757,7 @@ void tetgenmesh::outmetrics( tetgenio* out )
 	char outmtrfilename[ FILENAMESIZE ];
 	point ptloop;
 	int mtrindex = 0;
-	int i;
+	int tidx, i;
 	int msize = ( sizeoftensor - useinsertradius );
 	if(msize == 0)
 	{
@@ -31838,13 +34889,16 @@ void tetgenmesh::outmetrics( tetgenio* out )
 		{
 			decode( point2tet( ptloop ), parenttet );
 		}
+		// A point that is not in the mesh (e.g. an unused vertex with '-J')
+		//   has no parent tet.
+		tidx = ( parenttet.tet != NULL ) ? elemindex( parenttet.tet ) : -1;
 		if(out == (tetgenio *)NULL)
 		{
-			fprintf( outfile, "%d  %d\n", pointindex, elemindex( parenttet.tet ) );
+			fprintf( outfile, "%d  %d\n", pointindex, tidx );
 		}
 		else
 		{
-			out->point2tetlist[ i ] = elemindex( parenttet.tet );
+			out->point2tetlist[ i ] = tidx;
 		}
 		pointindex++;
 		i++;
@@ -31885,6 +34939,8 @@ void tetgenmesh::outelements( tetgenio* out )
 	int eextras;
 	int i;
 
+	TETGEN_TRACE_SCOPE( b, "outelements" );
+
 	if(out == (tetgenio *)NULL)
 	{
 		strcpy( outelefilename, b->outfilename );
@@ -31921,7 +34977,7 @@ void tetgenmesh::outelements( tetgenio* out )
 	else
 	{
 		// Allocate memory for output tetrahedra.
-		out->tetrahedronlist = new int[ ntets * ( b->order == 1 ? 4 : 10 ) ];
+		out->tetrahedronlist = out->newoutputlist( tetgenio::TETRAHEDRONLIST, ntets * ( b->order == 1 ? 4 : 10 ) );
 		if(out->tetrahedronlist == (int *)NULL)
 		{
 			myprintf( "Error:  Out of memory.\n" );
@@ -32101,7 +35157,7 @@ void tetgenmesh::outfaces( tetgenio* out )
 	else
 	{
 		// Allocate memory for 'trifacelist'.
-		out->trifacelist = new int[ faces * 3 ];
+		out->trifacelist = out->newoutputlist( tetgenio::TRIFACELIST, faces * 3 );
 		if(out->trifacelist == (int *)NULL)
 		{
 			myprintf( "Error:  Out of memory.\n" );
@@ -32114,7 +35170,7 @@ void tetgenmesh::outfaces( tetgenio* out )
 		// Allocate memory for 'trifacemarkerlist' if necessary.
 		if(!b->nobound)
 		{
-			out->trifacemarkerlist = new int[ faces ];
+			out->trifacemarkerlist = out->newoutputlist( tetgenio::TRIFACEMARKERLIST, faces );
 			if(out->trifacemarkerlist == (int *)NULL)
 			{
 				myprintf( "Error:  Out of memory.\n" );
@@ -32124,7 +35180,7 @@ void tetgenmesh::outfaces( tetgenio* out )
 		if(b->neighout > 1)
 		{
 			// '-nn' switch.
-			out->face2tetlist = new int[ faces * 2 ];
+			out->face2tetlist = out->newoutputlist( tetgenio::FACE2TETLIST, faces * 2 );
 			if(out->face2tetlist == (int *)NULL)
 			{
 				myprintf( "Error:  Out of memory.\n" );
@@ -32139,7 +35195,14 @@ void tetgenmesh::outfaces( tetgenio* out )
 	if(b->neighout > 1)
 	{ // -nn option
 		// Output the tetrahedron-to-face map.
-		tet2facelist = new int[ ntets * 4 ];
+		if(out == (tetgenio *)NULL)
+		{
+			tet2facelist = new int[ ntets * 4 ];
+		}
+		else
+		{
+			tet2facelist = out->newoutputlist( tetgenio::TET2FACELIST, ntets * 4 );
+		}
 	}
 
 	// Determine the first index (0 or 1).
@@ -32376,7 +35439,7 @@ void tetgenmesh::outhullfaces( tetgenio* out )
 	else
 	{
 		// Allocate memory for 'trifacelist'.
-		out->trifacelist = new int[ hullsize * 3 ];
+		out->trifacelist = out->newoutputlist( tetgenio::TRIFACELIST, hullsize * 3 );
 		if(out->trifacelist == (int *)NULL)
 		{
 			myprintf( "Error:  Out of memory.\n" );
@@ -32498,7 +35561,7 @@ void tetgenmesh::outsubfaces( tetgenio* out )
 	else
 	{
 		// Allocate memory for 'trifacelist'.
-		out->trifacelist = new int[ subfaces->items * 3 ];
+		out->trifacelist = out->newoutputlist( tetgenio::TRIFACELIST, subfaces->items * 3 );
 		if(out->trifacelist == (int *)NULL)
 		{
 			terminatetetgen( this, 1 );
@@ -32510,7 +35573,7 @@ void tetgenmesh::outsubfaces( tetgenio* out )
 		if(!b->nobound)
 		{
 			// Allocate memory for 'trifacemarkerlist'.
-			out->trifacemarkerlist = new int[ subfaces->items ];
+			out->trifacemarkerlist = out->newoutputlist( tetgenio::TRIFACEMARKERLIST, subfaces->items );
 			if(out->trifacemarkerlist == (int *)NULL)
 			{
 				terminatetetgen( this, 1 );
@@ -32519,7 +35582,7 @@ void tetgenmesh::outsubfaces( tetgenio* out )
 		if(b->neighout > 1)
 		{
 			// '-nn' switch.
-			out->face2tetlist = new int[ subfaces->items * 2 ];
+			out->face2tetlist = out->newoutputlist( tetgenio::FACE2TETLIST, subfaces->items * 2 );
 			if(out->face2tetlist == (int *)NULL)
 			{
 				terminatetetgen( this, 1 );
@@ -32745,7 +35808,7 @@ void tetgenmesh::outedges( tetgenio* out )
 	{
 		// Allocate memory for 'edgelist'.
 		out->numberofedges = meshedges;
-		out->edgelist = new int[ meshedges * 2 ];
+		out->edgelist = out->newoutputlist( tetgenio::EDGELIST, meshedges * 2 );
 		if(out->edgelist == (int *)NULL)
 		{
 			myprintf( "Error:  Out of memory.\n" );
@@ -32757,11 +35820,11 @@ void tetgenmesh::outedges( tetgenio* out )
 		}
 		if(!b->nobound)
 		{
-			out->edgemarkerlist = new int[ meshedges ];
+			out->edgemarkerlist = out->newoutputlist( tetgenio::EDGEMARKERLIST, meshedges );
 		}
 		if(b->neighout > 1)
 		{ // '-nn' switch.
-			out->edge2tetlist = new int[ meshedges ];
+			out->edge2tetlist = out->newoutputlist( tetgenio::EDGE2TETLIST, meshedges );
 		}
 	}
 
@@ -32769,7 +35832,14 @@ void tetgenmesh::outedges( tetgenio* out )
 	{ // -nn option
 		// Output the tetrahedron-to-edge map.
 		long tsize = tetrahedrons->items - hullsize;
-		tet2edgelist = new int[ tsize * 6 ];
+		if(out == (tetgenio *)NULL)
+		{
+			tet2edgelist = new int[ tsize * 6 ];
+		}
+		else
+		{
+			tet2edgelist = out->newoutputlist( tetgenio::TET2EDGELIST, tsize * 6 );
+		}
 	}
 
 	// Determine the first index (0 or 1).
@@ -32912,7 +35982,16 @@ void tetgenmesh::outedges( tetgenio* out )
 		{ // -f option
 			// Build the face-to-edge map (use the tet-to-edge map).
 			long fsize = ( tsize * 4l + hullsize ) / 2l;
-			int *face2edgelist = new int[ fsize * 3 ];
+			int *face2edgelist;
+
+			if(out == (tetgenio *)NULL)
+			{
+				face2edgelist = new int[ fsize * 3 ];
+			}
+			else
+			{
+				face2edgelist = out->newoutputlist( tetgenio::FACE2EDGELIST, fsize * 3 );
+			}
 
 			tetrahedrons->traversalinit( );
 			tetloop.tet = tetrahedrontraverse( );
@@ -33078,7 +36157,7 @@ void tetgenmesh::outsubsegments( tetgenio* out )
 	else
 	{
 		// Allocate memory for 'edgelist'.
-		out->edgelist = new int[ subsegs->items * ( b->order == 1 ? 2 : 3 ) ];
+		out->edgelist = out->newoutputlist( tetgenio::EDGELIST, subsegs->items * ( b->order == 1 ? 2 : 3 ) );
 		if(out->edgelist == (int *)NULL)
 		{
 			terminatetetgen( this, 1 );
@@ -33087,14 +36166,14 @@ void tetgenmesh::outsubsegments( tetgenio* out )
 		{
 			out->o2edgelist = new int[ subsegs->items ];
 		}
-		out->edgemarkerlist = new int[ subsegs->items ];
+		out->edgemarkerlist = out->newoutputlist( tetgenio::EDGEMARKERLIST, subsegs->items );
 		if(out->edgemarkerlist == (int *)NULL)
 		{
 			terminatetetgen( this, 1 );
 		}
 		if(b->neighout > 1)
 		{
-			out->edge2tetlist = new int[ subsegs->items ];
+			out->edge2tetlist = out->newoutputlist( tetgenio::EDGE2TETLIST, subsegs->items );
 		}
 		out->numberofedges = subsegs->items;
 		elist = out->edgelist;
@@ -33258,7 +36337,7 @@ void tetgenmesh::outneighbors( tetgenio* out )
 	else
 	{
 		// Allocate memory for 'neighborlist'.
-		out->neighborlist = new int[ ntets * 4 ];
+		out->neighborlist = out->newoutputlist( tetgenio::NEIGHBORLIST, ntets * 4 );
 		if(out->neighborlist == (int *)NULL)
 		{
 			myprintf( "Error:  Out of memory.\n" );
@@ -33311,6 +36390,436 @@ void tetgenmesh::outneighbors( tetgenio* out )
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// outputchunk()    Output a chunk of tets, see outmeshfused().              //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::outputchunk( void* arg, int chunk )
+{
+	outputjob *job = (outputjob *)arg;
+
+	job->m->outputtets( job, chunk );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// outputtets()    Output the elements, faces, edges, and neighbors of a     //
+//                 chunk of tets.                                            //
+//                                                                           //
+// A face is owned by the tet with the smaller index (or by the only tet if  //
+// it is a hull face). An edge is owned by the tet with the smallest index   //
+// in its star. This is the order of outfaces() and outedges(), hence the    //
+// output lists are identical to theirs.                                     //
+//                                                                           //
+// Pass 0 writes the tets and their neighbors, and counts the faces and the  //
+// edges owned by the chunk. Pass 1 writes the owned faces and edges from    //
+// 'job->facestart[chunk]' and 'job->edgestart[chunk]' on. Pass 2 writes the //
+// face-to-edge map, which needs the complete tet-to-edge map.               //
+//                                                                           //
+// Only the slots of the tets of this chunk and of the faces and edges they  //
+// own are written, so the chunks of a pass can be done concurrently.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::outputtets( outputjob *job, int chunk )
+{
+	tetgenio *out = job->out;
+	triface tface, tsymface, worktet, spintet;
+	face checkmark;
+	point p1, p2;
+	int *ilist;
+	int firstindex, shift;
+	int facenumber, edgenumber, hullcount;
+	int ishulledge, marker;
+	int tidx, eextras;
+	int t1ver;
+	int i, j, last;
+
+	firstindex = job->firstindex;
+	shift = job->shift;
+	eextras = numelemattrib;
+
+	i = chunk * job->chunksize;
+	last = i + job->chunksize;
+	if(last > job->numtets) last = job->numtets;
+
+	facenumber = edgenumber = hullcount = 0;
+	if(job->pass > 0)
+	{
+		facenumber = job->facestart[ chunk ];
+		edgenumber = job->edgestart[ chunk ];
+	}
+
+	for(; i < last; i++)
+	{
+		tface.tet = job->tets[ i ];
+		if(job->pass == 0)
+		{
+			if(!b->reversetetori)
+			{
+				p1 = (point)tface.tet[ 4 ];
+				p2 = (point)tface.tet[ 5 ];
+			}
+			else
+			{
+				p1 = (point)tface.tet[ 5 ];
+				p2 = (point)tface.tet[ 4 ];
+			}
+			ilist = &( out->tetrahedronlist[ i * 4 ] );
+			ilist[ 0 ] = pointmark( p1 ) - shift;
+			ilist[ 1 ] = pointmark( p2 ) - shift;
+			ilist[ 2 ] = pointmark( (point)tface.tet[ 6 ] ) - shift;
+			ilist[ 3 ] = pointmark( (point)tface.tet[ 7 ] ) - shift;
+			for(j = 0; j < eextras; j++)
+			{
+				out->tetrahedronattributelist[ i * eextras + j ] =
+					elemattribute( tface.tet, j );
+			}
+			if(b->neighout)
+			{
+				ilist = &( out->neighborlist[ i * 4 ] );
+				for(tface.ver = 0; tface.ver < 4; tface.ver++)
+				{
+					fsym( tface, tsymface );
+					if(!ishulltet( tsymface ))
+					{
+						ilist[ tface.ver ] = elemindex( tsymface.tet );
+					}
+					else
+					{
+						ilist[ tface.ver ] = -1;
+					}
+				}
+			}
+		}
+
+		if(job->dofaces)
+		{
+			for(tface.ver = 0; tface.ver < 4; tface.ver++)
+			{
+				fsym( tface, tsymface );
+				if(!ishulltet( tsymface ) &&
+					( elemindex( tface.tet ) > elemindex( tsymface.tet ) ))
+				{
+					continue; // Owned by the neighbor.
+				}
+				if(job->pass == 1)
+				{
+					ilist = &( out->trifacelist[ facenumber * 3 ] );
+					ilist[ 0 ] = pointmark( org( tface ) ) - shift;
+					ilist[ 1 ] = pointmark( dest( tface ) ) - shift;
+					ilist[ 2 ] = pointmark( apex( tface ) ) - shift;
+					if(!b->nobound)
+					{
+						if(b->plc || b->refine)
+						{
+							tspivot( tface, checkmark );
+							marker = checkmark.sh != NULL ? shellmark( checkmark ) : 0;
+						}
+						else
+						{
+							marker = (int)ishulltet( tsymface );
+						}
+						out->trifacemarkerlist[ facenumber ] = marker;
+					}
+					if(b->neighout > 1)
+					{
+						// '-nn' switch. Output adjacent tets indices.
+						ilist = &( out->face2tetlist[ facenumber * 2 ] );
+						ilist[ 0 ] = elemindex( tface.tet );
+						ilist[ 1 ] = !ishulltet( tsymface ) ? elemindex( tsymface.tet ) : -1;
+						// Fill the tetrahedron-to-face map.
+						tidx = elemindex( tface.tet ) - firstindex;
+						job->tet2facelist[ tidx * 4 + tface.ver ] = facenumber + firstindex;
+						if(!ishulltet( tsymface ))
+						{
+							tidx = elemindex( tsymface.tet ) - firstindex;
+							job->tet2facelist[ tidx * 4 + ( tsymface.ver & 3 ) ] =
+								facenumber + firstindex;
+						}
+					}
+				}
+				else if(job->pass == 2)
+				{
+					// The three edges of this face are ordered such that the
+					//    first edge is opposite to the first vertex of this face.
+					tidx = elemindex( tface.tet ) - firstindex;
+					worktet = tface;
+					for(j = 0; j < 3; j++)
+					{
+						enextself( worktet ); // The edge opposite to vertex j.
+						out->face2edgelist[ facenumber * 3 + j ] =
+							job->tet2edgelist[ tidx * 6 + ver2edge[ worktet.ver ] ];
+					}
+				}
+				facenumber++;
+			}
+		}
+
+		if(job->doedges && ( job->pass < 2 ))
+		{
+			worktet.tet = tface.tet;
+			for(j = 0; j < 6; j++)
+			{
+				worktet.ver = edge2ver[ j ];
+				ishulledge = 0;
+				fnext( worktet, spintet );
+				do
+				{
+					if(!ishulltet( spintet ))
+					{
+						if(elemindex( spintet.tet ) < elemindex( worktet.tet )) break;
+					}
+					else
+					{
+						ishulledge = 1;
+					}
+					fnextself( spintet );
+				}
+				while(spintet.tet != worktet.tet);
+				if(spintet.tet != worktet.tet)
+				{
+					continue; // Owned by a tet with a smaller index.
+				}
+				if(ishulledge) hullcount++;
+				if(job->pass == 1)
+				{
+					out->edgelist[ edgenumber * 2 ] = pointmark( org( worktet ) ) - shift;
+					out->edgelist[ edgenumber * 2 + 1 ] = pointmark( dest( worktet ) ) - shift;
+					if(!b->nobound)
+					{
+						if(b->plc || b->refine)
+						{
+							// Check if the edge is a segment.
+							tsspivot1( worktet, checkmark );
+							marker = checkmark.sh != NULL ? shellmark( checkmark ) : 0;
+						}
+						else
+						{
+							marker = ishulledge ? 1 : 0;
+						}
+						out->edgemarkerlist[ edgenumber ] = marker;
+					}
+					if(b->neighout > 1)
+					{
+						out->edge2tetlist[ edgenumber ] = elemindex( tface.tet );
+						// Fill the tetrahedron-to-edge map.
+						spintet = worktet;
+						while(1)
+						{
+							if(!ishulltet( spintet ))
+							{
+								tidx = elemindex( spintet.tet ) - firstindex;
+								job->tet2edgelist[ tidx * 6 + ver2edge[ spintet.ver ] ] =
+									edgenumber + firstindex;
+							}
+							fnextself( spintet );
+							if(spintet.tet == worktet.tet) break;
+						}
+					}
+				}
+				edgenumber++;
+			}
+		}
+	}
+
+	if(job->pass == 0)
+	{
+		job->facestart[ chunk ] = facenumber;
+		job->edgestart[ chunk ] = edgenumber;
+		job->hulledges[ chunk ] = hullcount;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// outmeshfused()    Output elements, faces, edges, and neighbors to a       //
+//                   tetgenio object.                                        //
+//                                                                           //
+// It replaces the calls of outelements(), outfaces(), outedges(), and       //
+// outneighbors() (for -o1 only). Instead of one traversal of the tet pool   //
+// per list, the tets are collected and indexed once, then the lists are     //
+// filled by chunks of tets using the 'b->parallelfor' callback. The face    //
+// and edge offsets of the chunks are the prefix sums of their counts (see   //
+// outputtets()).                                                            //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void tetgenmesh::outmeshfused( tetgenio* out )
+{
+	outputjob job;
+	tetrahedron *tptr;
+	long ntets;
+	int numchunks;
+	int facesum, edgesum, hullsum, count;
+	int i;
+
+	TETGEN_TRACE_SCOPE( b, "outmeshfused" );
+
+	// The number of tets excluding hull tets.
+	ntets = tetrahedrons->items - hullsize;
+
+	job.m = this;
+	job.out = out;
+	job.numtets = (int)ntets;
+	job.chunksize = 1024;
+	job.dofaces = b->facesout && !b->nofacewritten;
+	job.doedges = b->edgesout && !b->nofacewritten;
+	job.tet2facelist = NULL;
+	job.tet2edgelist = NULL;
+
+	// Determine the first index (0 or 1).
+	job.firstindex = b->zeroindex ? 0 : in->firstnumber;
+	job.shift = 0; // Default no shift.
+	if(( in->firstnumber == 1 ) && ( job.firstindex == 0 ))
+	{
+		job.shift = 1; // Shift the output indices by 1.
+	}
+
+	if(!b->quiet)
+	{
+		myprintf( "Writing elements.\n" );
+	}
+
+	// Collect and index the tets. The index is needed for the ownership of
+	//   faces and edges, so it is assigned before the chunks are started.
+	job.tets = new tetrahedron*[ ntets > 0 ? ntets : 1 ];
+	tetrahedrons->traversalinit( );
+	tptr = tetrahedrontraverse( );
+	i = 0;
+	while(tptr != (tetrahedron *)NULL)
+	{
+		job.tets[ i ] = tptr;
+		setelemindex( tptr, job.firstindex + i );
+		if(b->metric)
+		{ // -m option
+			// Update the point-to-tet map (see outelements()).
+			for(int j = 0; j < 4; j++)
+			{
+				setpoint2tet( (point)( tptr[ 4 + j ] ), (tetrahedron)tptr );
+			}
+		}
+		i++;
+		tptr = tetrahedrontraverse( );
+	}
+
+	out->tetrahedronlist = out->newoutputlist( tetgenio::TETRAHEDRONLIST, ntets * 4 );
+	if(numelemattrib > 0)
+	{
+		out->tetrahedronattributelist = new REAL[ ntets * numelemattrib ];
+	}
+	out->numberoftetrahedra = ntets;
+	out->numberofcorners = 4;
+	out->numberoftetrahedronattributes = numelemattrib;
+	if(b->neighout)
+	{
+		out->neighborlist = out->newoutputlist( tetgenio::NEIGHBORLIST, ntets * 4 );
+	}
+
+	numchunks = ( job.numtets + job.chunksize - 1 ) / job.chunksize;
+	job.facestart = new int[ numchunks + 1 ];
+	job.edgestart = new int[ numchunks + 1 ];
+	job.hulledges = new int[ numchunks + 1 ];
+
+	job.pass = 0;
+	parallelloop( numchunks, outputchunk, &job );
+
+	// The offsets of the chunks.
+	facesum = edgesum = hullsum = 0;
+	for(i = 0; i < numchunks; i++)
+	{
+		count = job.facestart[ i ];
+		job.facestart[ i ] = facesum;
+		facesum += count;
+		count = job.edgestart[ i ];
+		job.edgestart[ i ] = edgesum;
+		edgesum += count;
+		hullsum += job.hulledges[ i ];
+	}
+	job.facestart[ numchunks ] = facesum;
+	job.edgestart[ numchunks ] = edgesum;
+
+	if(job.dofaces)
+	{
+		if(!b->quiet)
+		{
+			myprintf( "Writing faces.\n" );
+		}
+		out->numberoftrifaces = facesum;
+		out->trifacelist = out->newoutputlist( tetgenio::TRIFACELIST, facesum * 3 );
+		if(!b->nobound)
+		{
+			out->trifacemarkerlist = out->newoutputlist( tetgenio::TRIFACEMARKERLIST, facesum );
+		}
+		if(b->neighout > 1)
+		{ // '-nn' switch.
+			out->face2tetlist = out->newoutputlist( tetgenio::FACE2TETLIST, facesum * 2 );
+			job.tet2facelist = out->newoutputlist( tetgenio::TET2FACELIST, ntets * 4 );
+		}
+	}
+
+	if(job.doedges)
+	{
+		if(!b->quiet)
+		{
+			myprintf( "Writing edges.\n" );
+		}
+		meshedges = edgesum;
+		meshhulledges = hullsum;
+		out->numberofedges = edgesum;
+		out->edgelist = out->newoutputlist( tetgenio::EDGELIST, edgesum * 2 );
+		if(!b->nobound)
+		{
+			out->edgemarkerlist = out->newoutputlist( tetgenio::EDGEMARKERLIST, edgesum );
+		}
+		if(b->neighout > 1)
+		{ // '-nn' switch.
+			out->edge2tetlist = out->newoutputlist( tetgenio::EDGE2TETLIST, edgesum );
+			job.tet2edgelist = out->newoutputlist( tetgenio::TET2EDGELIST, ntets * 6 );
+		}
+	}
+
+	if(job.dofaces || job.doedges)
+	{
+		job.pass = 1;
+		parallelloop( numchunks, outputchunk, &job );
+	}
+
+	if(b->neighout > 1)
+	{ // -nn option
+		if(job.dofaces && job.doedges)
+		{
+			if(!b->quiet)
+			{
+				myprintf( "Writing face-to-edge map.\n" );
+			}
+			out->face2edgelist = out->newoutputlist( tetgenio::FACE2EDGELIST, facesum * 3 );
+			job.pass = 2;
+			parallelloop( numchunks, outputchunk, &job );
+		}
+		if(!b->quiet)
+		{
+			if(job.dofaces) myprintf( "Writing tetrahedron-to-face map.\n" );
+			if(job.doedges) myprintf( "Writing tetrahedron-to-edge map.\n" );
+		}
+		// Simply copy the addresses of the lists to the output.
+		out->tet2facelist = job.tet2facelist;
+		out->tet2edgelist = job.tet2edgelist;
+	}
+
+	if(b->neighout && !b->quiet)
+	{
+		myprintf( "Writing neighbors.\n" );
+	}
+
+	delete[ ] job.tets;
+	delete[ ] job.facestart;
+	delete[ ] job.edgestart;
+	delete[ ] job.hulledges;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // outvoronoi()    Output the Voronoi diagram to .v.node, .v.edge, v.face,   //
@@ -34368,8 +37877,12 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	tetgenmesh m;
 	clock_t tv[ 12 ], ts[ 5 ]; // Timing informations (defined in time.h)
 	REAL cps = (REAL)CLOCKS_PER_SEC;
+	int fused;
+	predicatestatsscope predscope( b->predstats );
+	memorystatsscope memscope( b->memstats );
 
 	tv[ 0 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "initialization";
 
 	m.b = b;
 	m.in = in;
@@ -34389,6 +37902,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 			   m.xmax - m.xmin, m.ymax - m.ymin, m.zmax - m.zmin );
 
 	tv[ 1 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "delaunay";
 
 	if(b->refine)
 	{ // -r
@@ -34400,6 +37914,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 2 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "surface";
 
 	if(!b->quiet)
 	{
@@ -34451,6 +37966,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 3 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "sizing";
 
 	if(( b->metric ) && ( m.bgm != NULL ))
 	{ // -m
@@ -34480,6 +37996,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 4 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "boundary recovery";
 
 	if(b->plc && !b->refine)
 	{ // -p
@@ -34539,6 +38056,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 5 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "coarsening";
 
 	if(b->coarsen)
 	{ // -R
@@ -34546,6 +38064,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 6 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "delaunay recovery";
 
 	if(!b->quiet)
 	{
@@ -34561,6 +38080,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 7 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "constrained points";
 
 	if(!b->quiet)
 	{
@@ -34579,6 +38099,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 8 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "refinement";
 
 	if(!b->quiet)
 	{
@@ -34597,6 +38118,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 9 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "optimization";
 
 	if(!b->quiet)
 	{
@@ -34612,6 +38134,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 
 	tv[ 10 ] = clock( );
+	if(b->memstats != NULL) b->memstats->stage = "output";
 
 	if(!b->quiet)
 	{
@@ -34655,7 +38178,15 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 		m.outnodes( out );
 	}
 
-	if(b->noelewritten)
+	// Elements, faces, edges, and neighbors are output in one pass.
+	fused = b->fuseoutput && ( out != (tetgenio *)NULL ) && ( b->order == 1 ) &&
+		!b->noelewritten && ( m.tetrahedrons->items > 0l );
+
+	if(fused)
+	{
+		m.outmeshfused( out );
+	}
+	else if(b->noelewritten)
 	{
 		if(!b->quiet)
 		{
@@ -34682,7 +38213,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	{
 		if(b->facesout)
 		{
-			if(m.tetrahedrons->items > 0l)
+			if(!fused && ( m.tetrahedrons->items > 0l ))
 			{
 				m.outfaces( out );  // Output all faces.
 			}
@@ -34718,7 +38249,10 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	{
 		if(b->edgesout)
 		{ // -e
-			m.outedges( out ); // output all mesh edges. 
+			if(!fused)
+			{
+				m.outedges( out ); // output all mesh edges. 
+			}
 		}
 		else
 		{
@@ -34753,7 +38287,7 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 		m.outmesh2vtk( b->outfilename );
 	}
 
-	if(b->neighout)
+	if(b->neighout && !fused)
 	{
 		m.outneighbors( out );
 	}
@@ -34792,6 +38326,55 @@ void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// detectselfintersections()    The interface for checking a PLC for self-   //
+//                              intersections before tetrahedralizing it.    //
+//                                                                           //
+// Only the bounding box of the input points is computed (to initialize the  //
+// robust predicates). No memorypools are allocated.                         //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int detectselfintersections( tetgenbehavior *b, tetgenio *in, int **pairlist )
+{
+	tetgenmesh m;
+	REAL bmin[ 3 ], bmax[ 3 ];
+	int i, k;
+	predicatestatsscope predscope( b->predstats );
+
+	if(pairlist != NULL)
+	{
+		*pairlist = NULL;
+	}
+	if(( in->numberofpoints == 0 ) ||
+	   ( ( in->numberoffacets == 0 ) && ( in->numberoftriangles == 0 ) ))
+	{
+		return 0;
+	}
+
+	m.b = b;
+	m.in = in;
+
+	for(k = 0; k < 3; k++)
+	{
+		bmin[ k ] = bmax[ k ] = in->pointlist[ k ];
+	}
+	for(i = 1; i < in->numberofpoints; i++)
+	{
+		for(k = 0; k < 3; k++)
+		{
+			if(in->pointlist[ i * 3 + k ] < bmin[ k ]) bmin[ k ] = in->pointlist[ i * 3 + k ];
+			if(in->pointlist[ i * 3 + k ] > bmax[ k ]) bmax[ k ] = in->pointlist[ i * 3 + k ];
+		}
+	}
+
+	exactinit( 0, b->noexact, b->nostaticfilter,
+			   bmax[ 0 ] - bmin[ 0 ], bmax[ 1 ] - bmin[ 1 ], bmax[ 2 ] - bmin[ 2 ] );
+
+	return m.detectselfinters( pairlist );
+}
+
 #ifndef TETLIBRARY
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -181,6 +181,20 @@ public:
 	// A callback function for mesh refinement.
 	typedef bool( *TetSizeFunc )( REAL*, REAL*, REAL*, REAL*, REAL*, REAL );
 
+	// A callback function returning the mesh size at a point.
+	typedef REAL( *MeshSizeFunc )( void*, REAL* );
+
+	// The integer output lists which can be allocated by 'outputalloc'.
+	enum outputlisttype
+	{
+		TETRAHEDRONLIST, NEIGHBORLIST, TET2FACELIST, TET2EDGELIST,
+		TRIFACELIST, TRIFACEMARKERLIST, FACE2TETLIST, FACE2EDGELIST,
+		EDGELIST, EDGEMARKERLIST, EDGE2TETLIST, NUMOUTPUTLISTS
+	};
+
+	// A callback function for allocating an output list.
+	typedef int*( *OutputAlloc )( void*, int, long );
+
 	// Items are numbered starting from 'firstnumber' (0 or 1), default is 0.
 	int firstnumber;
 
@@ -238,6 +252,16 @@ public:
 	int *facetmarkerlist;
 	int numberoffacets;
 
+	// 'trianglelist':  An alternative to 'facetlist' for a PLC which consists
+	//   of triangles only (a triangle soup).  The first triangle's three
+	//   corners are at indices [0], [1], and [2], followed by the remaining
+	//   triangles.  Each triangle is a facet (its marker is given by
+	//   'facetmarkerlist'), no facet and polygon structures are needed.  If
+	//   it is not NULL, 'facetlist' is ignored.  It is owned by the caller,
+	//   it is not freed by deinitialize().
+	const int *trianglelist;
+	int numberoftriangles;
+
 	// 'holelist':  An array of holes (in volume).  Each hole is given by a
 	//   seed (point) which lies strictly inside it. The first seed's x, y and z
 	//   coordinates are at indices [0], [1] and [2], followed by the
@@ -332,6 +356,45 @@ public:
 	// A callback function.
 	TetSizeFunc tetunsuitable;
 
+	// Variable and callback function for a mesh sizing field. If 'meshsize'
+	//   is set, it is evaluated at the circumcenter of each tet during the
+	//   refinement, which is split if its circumradius is larger than the
+	//   returned size (as for the sizes at points given by '-m'). A size of
+	//   zero or less means no constraint. The callback must be thread-safe
+	//   if 'parallelfor' is set.
+	void *sizehandle;
+	MeshSizeFunc meshsize;
+
+	// Variable and callback function for writing the mesh directly into
+	//   caller-owned buffers. If 'outputalloc' is set, the integer output
+	//   lists (see 'outputlisttype') are requested from it with the number
+	//   of ints instead of being allocated by "new". It may return NULL for a
+	//   list it does not take, which is then allocated as usual. The lists it
+	//   returns are owned by the caller and are not freed by deinitialize().
+	void *outputhandle;
+	OutputAlloc outputalloc;
+	int outputowned;     // Bit i is set if list i is owned by the caller.
+
+	// Allocate an integer output list, see 'outputalloc'.
+	int *newoutputlist( int type, long count )
+	{
+		int *list = (int *)NULL;
+
+		if(outputalloc != NULL)
+		{
+			list = outputalloc( outputhandle, type, count );
+		}
+		if(list != (int *)NULL)
+		{
+			outputowned |= ( 1 << type );
+		}
+		else
+		{
+			list = new int[ count ];
+		}
+		return list;
+	}
+
 	// Input & output routines.
 	bool load_node_call( FILE* infile, int markers, int uvflag, char* );
 	bool load_node( char* );
@@ -422,6 +485,9 @@ public:
 		facetmarkerlist = (int *)NULL;
 		numberoffacets = 0;
 
+		trianglelist = (const int *)NULL;
+		numberoftriangles = 0;
+
 		holelist = (REAL *)NULL;
 		numberofholes = 0;
 
@@ -446,6 +512,13 @@ public:
 
 		tetunsuitable = NULL;
 
+		sizehandle = NULL;
+		meshsize = NULL;
+
+		outputhandle = NULL;
+		outputalloc = NULL;
+		outputowned = 0;
+
 		geomhandle = NULL;
 		getvertexparamonedge = NULL;
 		getsteineronedge = NULL;
@@ -460,6 +533,20 @@ public:
 	{
 		int i, j;
 
+		// Lists allocated by 'outputalloc' are owned by the caller.
+		int **outputlists[ NUMOUTPUTLISTS ] = {
+			&tetrahedronlist, &neighborlist, &tet2facelist, &tet2edgelist,
+			&trifacelist, &trifacemarkerlist, &face2tetlist, &face2edgelist,
+			&edgelist, &edgemarkerlist, &edge2tetlist };
+		for(i = 0; i < NUMOUTPUTLISTS; i++)
+		{
+			if(outputowned & ( 1 << i ))
+			{
+				*outputlists[ i ] = (int *)NULL;
+			}
+		}
+		outputowned = 0;
+
 		if(pointlist != (REAL *)NULL)
 		{
 			delete[ ] pointlist;
@@ -621,6 +708,10 @@ public:
 
 }; // class tetgenio
 
+class predicatestats;
+class tetgenopstats;
+class memorystats;
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // tetgenbehavior                                                            //
@@ -670,6 +761,7 @@ public:
 	int facesout;                                                    // '-f', 0.
 	int edgesout;                                                    // '-e', 0.
 	int neighout;                                                    // '-n', 0.
+	int fuseoutput;                                                       // 0.
 	int voroout;                                                     // '-v', 0.
 	int meditview;                                                   // '-g', 0.
 	int vtkview;                                                     // '-k', 0.
@@ -698,11 +790,13 @@ public:
 	int reflevel;                                                    // '-D', 3.
 	int optlevel;                                                    // '-O', 2.
 	int optscheme;                                                   // '-O', 7.
+	int optparallel;                                               // '-O//', 0.
 	int delmaxfliplevel;                                                   // 1.
 	int order;                                                       // '-o', 1.
 	int reversetetori;                                              // '-o/', 0.
 	int steinerleft;                                                 // '-S', 0.
 	int no_sort;                                                           // 0.
+	int gridlocate;                                                        // 0.
 	int hilbert_order;                                           // '-b///', 52.
 	int hilbert_limit;                                             // '-b//'  8.
 	int brio_threshold;                                              // '-b' 64.
@@ -740,6 +834,45 @@ public:
 	//   (-p or -r) implies the object. 
 	enum objecttype { NODES, POLY, OFF, PLY, STL, MEDIT, VTK, MESH } object;
 
+	// A callback function for running a loop of independent work items
+	//   concurrently. It must call 'body(ctx, i)' exactly once for every 'i'
+	//   in [0, count) and return after all calls are finished. If it is NULL
+	//   (default), the loop is run serially by the calling thread.
+	typedef void( *LoopBody )( void*, int );
+	typedef void( *ParallelFor )( int, LoopBody, void* );
+	ParallelFor parallelfor;
+
+	// A callback function for recording the begin ('isbegin' = 1) and the
+	//   end ('isbegin' = 0) of a named stage. 'name' is a string literal.
+	//   It may be called from any thread running 'parallelfor' work items.
+	//   Events are only emitted when TetGen is compiled with TETGEN_TRACE.
+	typedef void( *TraceEvent )( const char*, int );
+	TraceEvent traceevent;
+
+	// A callback function for reporting the progress of a stage, called by
+	//   the thread running tetrahedralize() every few hundred work items with
+	//   'progresshandle', the stage name, and the fraction of the stage that
+	//   is done (in [0, 1]). Returning nonzero cancels the run, which is then
+	//   unwound by terminatetetgen() with code 11 after freeing its memory.
+	typedef int( *Progress )( void*, const char*, REAL );
+	Progress progress;
+	void *progresshandle;
+
+	// Counters of the robust predicate evaluations, accumulated over all
+	//   threads of the run. If it is NULL (default), nothing is counted.
+	predicatestats *predstats;
+
+	// Histograms of the topological operations of the mesh (flips, cavities,
+	//   point location walks, Steiner point suppression, the refinement
+	//   queue). If it is NULL (default), nothing is recorded.
+	tetgenopstats *opstats;
+
+	// The memory held by the memorypools and arraypools, and its budget. If
+	//   the budget is exceeded, the run is cancelled at the next progress poll
+	//   of a main loop and unwound by terminatetetgen() with code 12. If it is
+	//   NULL (default), the memory is not accounted.
+	memorystats *memstats;
+
 
 	void syntax( );
 	void usage( );
@@ -778,6 +911,7 @@ public:
 		facesout = 0;
 		edgesout = 0;
 		neighout = 0;
+		fuseoutput = 0;
 		voroout = 0;
 		meditview = 0;
 		vtkview = 0;
@@ -806,12 +940,14 @@ public:
 		fliplinklevelinc = 1;
 		reflevel = 3;
 		optscheme = 7;
+		optparallel = 0;
 		optlevel = 2;
 		delmaxfliplevel = 1;
 		order = 1;
 		reversetetori = 0;
 		steinerleft = -1;
 		no_sort = 0;
+		gridlocate = 0;
 		hilbert_order = 52; //-1;
 		hilbert_limit = 8;
 		brio_threshold = 64;
@@ -828,6 +964,13 @@ public:
 		epsilon = 1.0e-8;
 		coarsen_percent = 1.0;
 		object = NODES;
+		parallelfor = NULL;
+		traceevent = NULL;
+		progress = NULL;
+		progresshandle = NULL;
+		predstats = NULL;
+		opstats = NULL;
+		memstats = NULL;
 
 		commandline[ 0 ] = '\0';
 		infilename[ 0 ] = '\0';
@@ -839,6 +982,51 @@ public:
 
 }; // class tetgenbehavior
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// tetgentracescope                                                          //
+//                                                                           //
+// Records the begin and the end of a scope through 'b->traceevent'.  Scopes //
+// are compiled out unless TETGEN_TRACE is defined, so they cost nothing in  //
+// a normal build.                                                           //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef TETGEN_TRACE
+
+class tetgentracescope
+{
+public:
+	tetgentracescope( tetgenbehavior *b, const char *name )
+		: event( b->traceevent ), name( name )
+	{
+		if(event != NULL)
+		{
+			event( name, 1 );
+		}
+	}
+
+	~tetgentracescope( )
+	{
+		if(event != NULL)
+		{
+			event( name, 0 );
+		}
+	}
+
+private:
+	tetgenbehavior::TraceEvent event;
+	const char *name;
+};
+
+#define TETGEN_TRACE_SCOPE( b, name ) tetgentracescope tracescope( b, name )
+
+#else
+
+#define TETGEN_TRACE_SCOPE( b, name )
+
+#endif // #ifdef TETGEN_TRACE
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // Robust Geometric predicates                                               //
@@ -872,6 +1060,329 @@ REAL insphere( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe );
 REAL orient4d( REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe,
 			   REAL ah, REAL bh, REAL ch, REAL dh, REAL eh );
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// predicatestats                                                            //
+//                                                                           //
+// Counts how the predicates are resolved.  Every evaluation is counted once //
+// at the stage that decides its sign: without filtering (-X), by the static //
+// filter, by the dynamic filter (the error bound A), by the adaptive stages //
+// B or C, or by the exact expansion arithmetic.  The counters are kept per  //
+// thread, setpredicatestats() selects those of the calling thread.          //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+class predicatestats
+{
+public:
+	enum predicate { ORIENT3D, INSPHERE, ORIENT4D, NUMPREDICATES };
+	enum stage { UNFILTERED, STATICFILTER, DYNAMICFILTER, ADAPTB, ADAPTC, EXACT,
+				 NUMSTAGES };
+
+	unsigned long long resolved[ NUMPREDICATES ][ NUMSTAGES ];
+
+	void clear( )
+	{
+		memset( resolved, 0, sizeof( resolved ) );
+	}
+
+	void add( const predicatestats &other )
+	{
+		for(int p = 0; p < NUMPREDICATES; p++)
+		{
+			for(int s = 0; s < NUMSTAGES; s++)
+			{
+				resolved[ p ][ s ] += other.resolved[ p ][ s ];
+			}
+		}
+	}
+
+	// The number of evaluations of predicate 'p'.
+	unsigned long long calls( int p ) const
+	{
+		unsigned long long count = 0;
+		for(int s = 0; s < NUMSTAGES; s++)
+		{
+			count += resolved[ p ][ s ];
+		}
+		return count;
+	}
+
+	predicatestats( )
+	{
+		clear( );
+	}
+};
+
+// Sets the counters of the calling thread (NULL stops counting), returns the
+//   previous ones.
+predicatestats *setpredicatestats( predicatestats *stats );
+predicatestats *getpredicatestats( );
+
+// Options and static filters of the predicates set by exactinit(), they are
+//   kept per thread.
+class predicatefilters
+{
+public:
+	int noexact;
+	int usestaticfilter;
+	REAL o3dstaticfilter;
+	REAL ispstaticfilter;
+};
+
+// Sets the filters of the calling thread, returns the previous ones in
+//   'previous' (if not NULL).
+void setpredicatefilters( const predicatefilters *filters,
+						  predicatefilters *previous );
+void getpredicatefilters( predicatefilters *filters );
+
+// Selects the filters of the calling thread for the lifetime of the object
+//   (without 'filters', only restores the current ones when destroyed).
+class predicatefiltersscope
+{
+public:
+	predicatefiltersscope( )
+	{
+		getpredicatefilters( &previous );
+	}
+
+	predicatefiltersscope( const predicatefilters *filters )
+	{
+		setpredicatefilters( filters, &previous );
+	}
+
+	~predicatefiltersscope( )
+	{
+		setpredicatefilters( &previous, NULL );
+	}
+
+private:
+	predicatefilters previous;
+};
+
+// Selects the counters of the calling thread for the lifetime of the object.
+class predicatestatsscope
+{
+public:
+	predicatestatsscope( predicatestats *stats )
+	{
+		previous = setpredicatestats( stats );
+	}
+
+	~predicatestatsscope( )
+	{
+		setpredicatestats( previous );
+	}
+
+private:
+	predicatestats *previous;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// memorystats                                                               //
+//                                                                           //
+// Accounts the memory blocks of the memorypools and arraypools against a    //
+// budget.  A pool charges the memorystats of the thread which created it    //
+// (see setmemorystats()) for each block it allocates, and releases them     //
+// when it is deleted.  The pools are used by the thread running             //
+// tetrahedralize() only, except while they are shared by the views of a     //
+// mesh under a lock (see memorypool::lock).  The work items of              //
+// parallelloop() and the private lists of the views are not accounted.      //
+// Exceeding the budget does not fail the allocation, it cancels the run at  //
+// the next tetgenmesh::pollprogress(), so the memory of the cancelled stage //
+// can be freed.                                                             //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+class memorystats
+{
+public:
+	unsigned long long limit;               // Budget in bytes, 0 is unlimited.
+	unsigned long long live;              // Bytes currently held by the pools.
+	unsigned long long peak;                       // The largest 'live' value.
+	const char *stage;                // The running stage of tetrahedralize().
+	const char *exceededstage;     // The stage that exceeded 'limit', or NULL.
+
+	void charge( unsigned long long bytes )
+	{
+		live += bytes;
+		if(live > peak) peak = live;
+		if(( limit > 0 ) && ( live > limit ) && ( exceededstage == NULL ))
+		{
+			exceededstage = stage != NULL ? stage : "";
+		}
+	}
+
+	void release( unsigned long long bytes )
+	{
+		live -= bytes;
+	}
+
+	// Clears the usage, the budget is kept.
+	void clear( )
+	{
+		live = peak = 0;
+		stage = exceededstage = NULL;
+	}
+
+	memorystats( )
+	{
+		limit = 0;
+		clear( );
+	}
+};
+
+// Sets the memorystats charged by the pools created by the calling thread
+//   (NULL stops accounting), returns the previous ones.
+memorystats *setmemorystats( memorystats *stats );
+memorystats *getmemorystats( );
+
+// Selects the memorystats of the calling thread for the lifetime of the
+//   object.
+class memorystatsscope
+{
+public:
+	memorystatsscope( memorystats *stats )
+	{
+		previous = setmemorystats( stats );
+	}
+
+	~memorystatsscope( )
+	{
+		setmemorystats( previous );
+	}
+
+private:
+	memorystats *previous;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// tetgenopstats                                                             //
+//                                                                           //
+// Histograms of the topological operations of tetgenmesh, for tuning the    //
+// flip levels ('fliplinklevel', 'flipstarsize') and the Steiner point       //
+// algorithms.  The values 0 to 15 have a bucket each, larger values are     //
+// counted in buckets of powers of two, i.e., bucket 16 + k counts values in //
+// [16 * 2^k, 32 * 2^k).  The last bucket also counts all larger values.     //
+// The operations are done by the thread running tetrahedralize(), which     //
+// records them through tetgenmesh::opstat().  The views of a mesh refining  //
+// blocks concurrently record into their own histograms, which are added by  //
+// that thread after each batch (see tetgenmesh::mergeview()).               //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+class tetgenopstats
+{
+public:
+	// FLIP23, FLIP32, FLIP41: the link level of the flipnm() doing the flip
+	//   plus one, or 0 if it is not done by flipnm().
+	// FLIPNMLEVEL, FLIPNMSTAR: the link level and the size of Star(ab) of
+	//   each flipnm() call.
+	// CAVITYSIZE: the number of tets of the cavity C(p) of insertpoint().
+	// LOCATEWALK: the number of steps of a walk of locate().
+	// STEINERINSERTED: the number of Steiner points left in the volume by
+	//   the suppression of a boundary Steiner point.
+	// STEINERREMOVED: 1 if an interior Steiner point was removed, else 0.
+	// BADTETQUEUE: the number of queued bad tets at each checked tet.
+	enum histogram { FLIP23, FLIP32, FLIP41, FLIPNMLEVEL, FLIPNMSTAR,
+					 CAVITYSIZE, LOCATEWALK, STEINERINSERTED, STEINERREMOVED,
+					 BADTETQUEUE, NUMHISTOGRAMS };
+	enum { NUMBUCKETS = 48, NUMSAMPLES = 256 };
+
+	unsigned long long counts[ NUMHISTOGRAMS ][ NUMBUCKETS ];
+	unsigned long long records[ NUMHISTOGRAMS ];           // Number of values.
+	unsigned long long sums[ NUMHISTOGRAMS ];                 // Sum of values.
+	long maximums[ NUMHISTOGRAMS ];                          // Largest values.
+
+	// The bad tet queue length over time. Every 'samplestride'th value of
+	//   BADTETQUEUE is kept. When all samples are used, every other sample is
+	//   dropped and the stride is doubled.
+	long samples[ NUMSAMPLES ];
+	int numsamples;
+	long samplestride, sampletick;
+
+	static int bucket( long value )
+	{
+		int k;
+
+		if(value < 16l)
+		{
+			return value < 0l ? 0 : (int)value;
+		}
+		for(k = 16, value >>= 5; ( value > 0l ) && ( k < NUMBUCKETS - 1 );
+			value >>= 1)
+		{
+			k++;
+		}
+		return k;
+	}
+
+	// The smallest value counted in bucket 'k'.
+	static long bucketmin( int k )
+	{
+		return k < 16 ? (long)k : 16l << ( k - 16 );
+	}
+
+	void record( int h, long value )
+	{
+		counts[ h ][ bucket( value ) ]++;
+		records[ h ]++;
+		sums[ h ] += value;
+		if(value > maximums[ h ]) maximums[ h ] = value;
+
+		if(h == BADTETQUEUE)
+		{
+			if(++sampletick >= samplestride)
+			{
+				sampletick = 0l;
+				if(numsamples == NUMSAMPLES)
+				{
+					for(int i = 0; i < NUMSAMPLES / 2; i++)
+					{
+						samples[ i ] = samples[ 2 * i ];
+					}
+					numsamples = NUMSAMPLES / 2;
+					samplestride *= 2l;
+				}
+				samples[ numsamples++ ] = value;
+			}
+		}
+	}
+
+	// Adds the histograms of 'other', its samples are not kept.
+	void add( const tetgenopstats &other )
+	{
+		for(int h = 0; h < NUMHISTOGRAMS; h++)
+		{
+			for(int k = 0; k < NUMBUCKETS; k++)
+			{
+				counts[ h ][ k ] += other.counts[ h ][ k ];
+			}
+			records[ h ] += other.records[ h ];
+			sums[ h ] += other.sums[ h ];
+			if(other.maximums[ h ] > maximums[ h ]) maximums[ h ] = other.maximums[ h ];
+		}
+	}
+
+	void clear( )
+	{
+		memset( counts, 0, sizeof( counts ) );
+		memset( records, 0, sizeof( records ) );
+		memset( sums, 0, sizeof( sums ) );
+		memset( maximums, 0, sizeof( maximums ) );
+		numsamples = 0;
+		samplestride = 1l;
+		sampletick = 0l;
+	}
+
+	tetgenopstats( )
+	{
+		clear( );
+	}
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 // tetgenmesh                                                                //
@@ -1063,6 +1574,7 @@ public:
 		char **toparray;
 		long objects;
 		unsigned long totalmemory;
+		memorystats *memstats;              // Charged for the memory, or NULL.
 
 		void restart( );
 		void poolinit( int sizeofobject, int log2objperblk );
@@ -1101,8 +1613,16 @@ public:
 	//   to be traversed.  pathitemsleft is the number of items that remain to   //
 	//   be traversed in pathblock.                                              //
 	//                                                                           //
+	// If 'lock' is not NULL, alloc() and dealloc() are serialized by it, so the //
+	//   views of a mesh refining its blocks concurrently may share the pool     //
+	//   (see repairbadtetsbatched()). Traversal is never locked.                //
+	//                                                                           //
 	///////////////////////////////////////////////////////////////////////////////
 
+	// A mutex shared by the pools of a mesh while its views run (it is defined
+	//   in tetgen.cxx, this header only uses the C standard library).
+	class poollock;
+
 	class memorypool
 	{
 
@@ -1119,6 +1639,9 @@ public:
 		long items, maxitems;
 		int  unallocateditems;
 		int  pathitemsleft;
+		unsigned long totalmemory;
+		memorystats *memstats;              // Charged for the memory, or NULL.
+		poollock *lock;              // Serializes alloc() and dealloc(), or NULL.
 
 		memorypool( );
 		memorypool( int, int, int, int );
@@ -1127,6 +1650,7 @@ public:
 		void poolinit( int, int, int, int );
 		void restart( );
 		void *alloc( );
+		void *allocitem( );
 		void dealloc( void* );
 		void traversalinit( );
 		void *traverse( );
@@ -1329,12 +1853,13 @@ public:
 		TOUCHEDGE, TOUCHFACE, ACROSSVERT, ACROSSEDGE, ACROSSFACE
 	};
 
-	// Labels that signify the result of point location.
+	// Labels that signify the result of point location. OUTSIDEBLOCK: a view
+	//   of the mesh would leave its block (see repairbadtetsbatched()).
 	enum locateresult
 	{
 		UNKNOWN, OUTSIDE, INTETRAHEDRON, ONFACE, ONEDGE, ONVERTEX,
 		ENCVERTEX, ENCSEGMENT, ENCSUBFACE, NEARVERTEX, NONREGULAR,
-		INSTAR, BADELEMENT
+		INSTAR, BADELEMENT, OUTSIDEBLOCK
 	};
 
 	///////////////////////////////////////////////////////////////////////////////
@@ -1419,6 +1944,15 @@ public:
 	int useinsertradius;       // Save the insertion radius for Steiner points.
 	long samples;               // Number of random samples for point location.
 	unsigned long randomseed;                    // Current random number seed.
+	tetrahedron **locgrid;        // A uniform grid of tets for point location.
+	REAL locgridmin[ 3 ], locgridsize;           // Origin and cell size of it.
+	int locgriddim[ 3 ];                         // Number of cells in x, y, z.
+	long locgridcells;
+	class meshview;
+	meshview *view;              // Not NULL if this mesh is a view of a block.
+	long progresspolls;        // Number of progress polls (see 'b->progress').
+	int progresscancel;      // Termination code once cancelled (11, 12), or 0.
+	const char *progressstage;        // The stage of the last progress report.
 	REAL cosmaxdihed, cosmindihed;    // The cosine values of max/min dihedral.
 	REAL cossmtdihed;     // The cosine value of a bad dihedral to be smoothed.
 	REAL cosslidihed;      // The cosine value of the max dihedral of a sliver.
@@ -1442,6 +1976,8 @@ public:
 	long flip14count, flip26count, flipn2ncount;
 	long flip23count, flip32count, flip44count, flip41count;
 	long flip31count, flip22count;
+	long locatecount, locatesteps, locatemaxsteps;        // Walks of locate().
+	int fliplevel;             // Link level of the running flipnm() + 1, or 0.
 	unsigned long totalworkmemory;      // Total memory used by working arrays.
 
 
@@ -1650,6 +2186,10 @@ public:
 
 	void initializepools( );
 
+	void parallelloop( int count, tetgenbehavior::LoopBody body, void* ctx );
+	int  pollprogress( const char *stage, REAL fraction );
+	void opstat( int histogram, long value );
+
 	///////////////////////////////////////////////////////////////////////////////
 	//                                                                           //
 	// Advanced geometric predicates and calculations                            //
@@ -1841,7 +2381,11 @@ public:
 
 	// Point location.
 	unsigned long randomnation( unsigned int choices );
+	static unsigned long randomnation( unsigned int choices, unsigned long *seed );
 	void randomsample( point searchpt, triface *searchtet );
+	void locgridbuild( );
+	long locgridcell( point pt );
+	int  locgridsample( point searchpt, triface *searchtet );
 	enum locateresult locate( point searchpt, triface *searchtet,
 							  int chkencflag = 0 );
 
@@ -1880,6 +2424,35 @@ public:
 						REAL, REAL, REAL, REAL, REAL, REAL, int* internum );
 	void detectinterfaces( );
 
+	// Self-intersection detection of the input triangles (before meshing).
+	//   A node of the bounding volume hierarchy is a leaf if 'left' is -1,
+	//   otherwise its children are 'left' and 'left + 1'.
+	class bvhnode
+	{
+	public:
+		REAL bmin[ 3 ], bmax[ 3 ];
+		int left;
+		int first, count; // A range in the ordered triangle list.
+	};
+
+	class selfinterjob
+	{
+	public:
+		tetgenmesh *m;
+		int *tricorners;     // 3 indices (into in->pointlist) per triangle.
+		int *tri2facet;      // The facet each triangle belongs to.
+		REAL *tribox;        // 6 REALs (min, max) per triangle.
+		int *bvhtris;        // Triangles ordered by the leaves.
+		bvhnode *bvhnodes;
+		int numtris, chunksize;
+		int **chunkpairs;    // Intersecting pairs found by each chunk.
+		int *chunkpaircount;
+	};
+
+	int  bvhbuild( REAL* tribox, int* bvhtris, int numtris, bvhnode* nodes );
+	static void selfinterchunk( void* job, int chunk );
+	int  detectselfinters( int** pairlist );
+
 	///////////////////////////////////////////////////////////////////////////////
 	//                                                                           //
 	// Constrained Delaunay tetrahedralization                                   //
@@ -2098,6 +2671,90 @@ public:
 	int splittetrahedron( triface* splittet, int qflag, REAL *ccent, int );
 	void repairbadtets( int chkencflag );
 
+	// Concurrent blocks. The items of a batch (tets) are binned into the
+	//   blocks of a uniform grid, the blocks are then changed concurrently,
+	//   each by a view of the mesh. A view is a copy of the tetgenmesh which
+	//   shares its pools (under a lock) and its mesh, but has its own working
+	//   lists, queues, and counters. It only changes the tets whose vertices
+	//   are all in its block (see inblock()), so views never change the same
+	//   tets, nor read the tets changed by another view.
+	class meshview
+	{
+	public:
+		tetgenbehavior behavior; // A copy of 'b', recording into 'opstats'.
+		tetgenopstats opstats;
+		REAL origin[ 3 ], size;  // The corner of block (0,0,0) and its length.
+		int block[ 3 ];          // The indices of the block in x, y, z.
+		arraypool *deadtets;     // The tets deleted by the view.
+		arraypool *deferredfaces; // Faces left to lawsonflip3d() of the mesh.
+		int deferred;            // Set if a tet is left to the mesh.
+
+		meshview( )
+		{
+			deadtets = new arraypool( sizeof( tetrahedron* ), 10 );
+			deferredfaces = new arraypool( sizeof( badface ), 8 );
+			deferred = 0;
+		}
+
+		~meshview( )
+		{
+			delete deadtets;
+			delete deferredfaces;
+		}
+	};
+
+	class blockjob
+	{
+	public:
+		REAL origin[ 3 ], size;  // The grid of the batch.
+		int *order;          // The binned items sorted by block.
+		int *blockstart;     // First item of each block in 'order' (+1 at the end).
+		int *blocks;         // 3 ints per block, its indices in x, y, z.
+		int numblocks;
+		poollock *lock;      // Taken by the shared pools and for 'views'.
+		arraypool *views, *idleviews; // The views, created on demand.
+	};
+
+	inline int inblock( point pt );
+	inline int tetinblock( triface& t );
+	void initblockjob( blockjob *bj, int maxitems );
+	void freeblockjob( blockjob *bj );
+	REAL gridsize( REAL len );
+	int  binitems( blockjob *bj, point *verts, int numitems, REAL size, int batch );
+	void lockpools( poollock *lock );
+	tetgenmesh *takeview( blockjob *bj, int blk );
+	void releaseview( blockjob *bj, tetgenmesh *vm );
+	void mergeview( tetgenmesh *vm );
+
+	// Batched refinement. The split tests of a batch of queued tets are done
+	//   concurrently, then the tets are split by the views of their blocks.
+	//   The tets which are not in one block, or whose cavities leave it, are
+	//   queued again or split by the calling thread.
+	class refinejob
+	{
+	public:
+		tetgenmesh *m;
+		triface *tets;
+		point *verts;        // 4 vertices per tet, to detect a reused tet.
+		REAL *ccents;        // 3 REALs per tet, the split point.
+		int *qflags;
+		int *splitflags;     // The states of the tets, see below.
+		int numtets, chunksize;
+		int chkencflag;
+		blockjob blocks;
+
+		// NOSPLIT and SPLIT are the results of checktet4split(). SPLITLATER:
+		//   the cavity left the block, SPLITSERIAL: the split is done by the
+		//   calling thread (e.g., an encroached subface is split first).
+		enum { NOSPLIT, SPLIT, SPLITLATER, SPLITSERIAL };
+	};
+
+	static void checktet4splitchunk( void* job, int chunk );
+	static void refineblockitem( void* job, int blk );
+	void refineblock( refinejob *job, int blk );
+	int  splitbatchtet( refinejob *job, int i );
+	void repairbadtetsbatched( int chkencflag );
+
 	void delaunayrefinement( );
 
 	///////////////////////////////////////////////////////////////////////////////
@@ -2106,18 +2763,84 @@ public:
 	//                                                                           //
 	///////////////////////////////////////////////////////////////////////////////
 
+	void deferface( triface *flipface );
 	long lawsonflip3d( flipconstraints *fc );
 	void recoverdelaunay( );
 
 	int  gettetrahedron( point, point, point, point, triface * );
 	long improvequalitybyflips( );
 
-	int  smoothpoint( point smtpt, arraypool*, int ccw, optparameters *opm );
+	int  smoothpoint( point smtpt, arraypool*, int ccw, optparameters *opm,
+					  unsigned long *seed = NULL );
 	long improvequalitybysmoothing( optparameters *opm );
 
+	// Parallel optimization (-O//1). Vertices to be smoothed are grouped into
+	//   independent sets (no two of them share a tetrahedron), chunks of the
+	//   vertices of one set are smoothed concurrently. Link faces are collected
+	//   serially. The flips and the sliver splits are done by the views of
+	//   blocks (see optjob).
+	class smoothjob
+	{
+	public:
+		tetgenmesh *m;
+		optparameters *opm;  // Shared smoothing parameters (read-only).
+		point *verts;        // The vertices of the current set.
+		arraypool *linkfaces; // The link faces of all collected vertices.
+		int *linkstart;      // First link face of each vertex (+1 at the end).
+		int *smoothed;       // Output: 1 if a vertex was moved, otherwise 0.
+		int first;           // Index of verts[0] in 'linkstart'.
+		int numverts, chunksize; // The vertices of the current set.
+		unsigned long seed;  // Per-pass seed of the random search directions.
+	};
+
+	class qualityjob
+	{
+	public:
+		tetgenmesh *m;
+		tetrahedron **tets;
+		REAL *maxdd;         // Output: the max cosine of dihedral angles.
+		int numtets, chunksize;
+	};
+
+	// Batched flips and sliver splits. The queued tets of a batch are binned
+	//   like a refinement batch, the blocks are improved concurrently, each
+	//   by a view. The tets whose flips or cavities leave the block are left
+	//   to the calling thread.
+	class optjob
+	{
+	public:
+		tetgenmesh *m;
+		arraypool *queue;    // The queued tets (badfaces).
+		int first;           // The first tet of the batch in 'queue'.
+		point *verts;        // 4 vertices per tet, to detect a changed tet.
+		int *states;         // The states of the tets, see below.
+		int numtets;
+		flipconstraints *fc; // The tets are flipped, or split if it is NULL.
+		int chkencflag;
+		blockjob blocks;
+
+		// The results of improvetetbyflips() and removesliver(). DROPPED: the
+		//   tet is no sliver, LEFT: it is left to the calling thread, MISSING:
+		//   the tet does not exist.
+		enum { KEPT, IMPROVED, DROPPED, LEFT, MISSING };
+	};
+
+	void smoothvertex( smoothjob *job, int i );
+	static void smoothchunk( void* job, int chunk );
+	static void tetqualitychunk( void* job, int chunk );
+	long improvequalitybyparallelsmoothing( optparameters *opm );
+
+	int  improvetetbyflips( badface *bface, flipconstraints *fc, arraypool *newqueue );
 	int  splitsliver( triface *, REAL, int );
+	int  removesliver( badface *bface, int chkencflag, arraypool *newqueue );
 	long removeslivers( int );
 
+	static void improveblockitem( void* job, int blk );
+	void improveblock( optjob *job, int blk );
+	long improvequalitybatched( arraypool *queue, arraypool *newqueue,
+								arraypool *keptqueue, flipconstraints *fc,
+								int chkencflag );
+
 	void optimizemesh( );
 
 	///////////////////////////////////////////////////////////////////////////////
@@ -2159,6 +2882,31 @@ public:
 	void outedges( tetgenio* );
 	void outsubsegments( tetgenio* );
 	void outneighbors( tetgenio* );
+
+	// Fused output. Elements, faces, edges, and neighbors are written to a
+	//   tetgenio object in one pass over the tets, chunks of tets are done
+	//   concurrently. Each chunk first counts the faces and edges it owns,
+	//   the output offsets of the chunks are their prefix sums.
+	class outputjob
+	{
+	public:
+		tetgenmesh *m;
+		tetgenio *out;
+		tetrahedron **tets;
+		int *facestart;      // First face of each chunk (+1 at the end).
+		int *edgestart;      // First edge of each chunk (+1 at the end).
+		int *hulledges;      // The number of hull edges of each chunk.
+		int *tet2facelist;
+		int *tet2edgelist;
+		int numtets, chunksize;
+		int firstindex, shift;
+		int dofaces, doedges; // Output all faces (-f), all edges (-e).
+		int pass;            // 0: count, 1: fill, 2: face-to-edge map.
+	};
+
+	static void outputchunk( void* job, int chunk );
+	void outputtets( outputjob *job, int chunk );
+	void outmeshfused( tetgenio* );
 	void outvoronoi( tetgenio* );
 	void outsmesh( char* );
 	void outmesh2medit( char* );
@@ -2219,6 +2967,16 @@ public:
 		useinsertradius = 0;
 		samples = 0l;
 		randomseed = 1l;
+		locgrid = NULL;
+		locgridmin[ 0 ] = locgridmin[ 1 ] = locgridmin[ 2 ] = 0.0;
+		locgridsize = 0.0;
+		locgriddim[ 0 ] = locgriddim[ 1 ] = locgriddim[ 2 ] = 0;
+		locgridcells = 0l;
+		view = NULL;
+
+		progresspolls = 0l;
+		progresscancel = 0;
+		progressstage = NULL;
 		minfaceang = minfacetdihed = PI;
 		tetprism_vol_sum = 0.0;
 		longest = minedgelength = 0.0;
@@ -2236,6 +2994,8 @@ public:
 		flip14count = flip26count = flipn2ncount = 0l;
 		flip23count = flip32count = flip44count = flip41count = 0l;
 		flip22count = flip31count = 0l;
+		locatecount = locatesteps = locatemaxsteps = 0l;
+		fliplevel = 0;
 		totalworkmemory = 0l;
 
 
@@ -2337,6 +3097,16 @@ public:
 			delete[ ] highordertable;
 		}
 
+		if(locgrid != NULL)
+		{
+			delete[ ] locgrid;
+		}
+
+		if(view != NULL)
+		{
+			delete view;
+		}
+
 		initializetetgenmesh( );
 	}
 
@@ -2370,6 +3140,22 @@ public:
 void tetrahedralize( tetgenbehavior *b, tetgenio *in, tetgenio *out,
 					 tetgenio *addin = NULL, tetgenio *bgmin = NULL );
 
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// detectselfintersections()    Interface for checking the facets of a PLC   //
+//                              for self-intersections before meshing.       //
+//                                                                           //
+// 'in' is an object of 'tetgenio' which contains a PLC. Each polygon of its //
+// facets is split into a fan of triangles. Return the number of pairs of    //
+// intersecting (or duplicated) triangles. If 'pairlist' is not a NULL, it   //
+// returns an array of two facet indices (counted from 'in->firstnumber')    //
+// per pair. The array is allocated by "new" and must be freed by the caller.//
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+int detectselfintersections( tetgenbehavior *b, tetgenio *in,
+							 int **pairlist = NULL );
+
 #ifdef TETLIBRARY
 void tetrahedralize( char *switches, tetgenio *in, tetgenio *out,
 					 tetgenio *addin = NULL, tetgenio *bgmin = NULL );
@@ -2415,6 +3201,12 @@ inline void terminatetetgen( tetgenmesh *m, int x )
 	case 10:
 		printf( "An input error was detected. Program stopped.\n" );
 		break;
+	case 11:
+		printf( "The run was cancelled. Program stopped.\n" );
+		break;
+	case 12:
+		printf( "The memory budget was exceeded. Program stopped.\n" );
+		break;
 	} // switch (x)
 	exit( x );
 #endif // #ifdef TETLIBRARY
@@ -3585,6 +4377,37 @@ inline REAL tetgenmesh::norm2( REAL x, REAL y, REAL z )
 	return (x)* (x)+(y)* (y)+(z)* ( z );
 }
 
+// opstat() records a value of a histogram of 'b->opstats' (if any).
+inline void tetgenmesh::opstat( int histogram, long value )
+{
+	if(b->opstats != NULL)
+	{
+		b->opstats->record( histogram, value );
+	}
+}
+
+// inblock() tests if a point is in the block of this view ('dummypoint' is
+//   not in any block). tetinblock() tests if all vertices of a tet are.
+inline int tetgenmesh::inblock( point pt )
+{
+	REAL d;
+	int i;
+
+	if(pt == dummypoint) return 0;
+	for(i = 0; i < 3; i++)
+	{
+		d = ( pt[ i ] - view->origin[ i ] ) / view->size;
+		if(( d < view->block[ i ] ) || ( d >= view->block[ i ] + 1 )) return 0;
+	}
+	return 1;
+}
+
+inline int tetgenmesh::tetinblock( triface& t )
+{
+	return inblock( (point)t.tet[ 4 ] ) && inblock( (point)t.tet[ 5 ] ) &&
+		inblock( (point)t.tet[ 6 ] ) && inblock( (point)t.tet[ 7 ] );
+}
+
 
 #endif // #ifndef tetgenH
 
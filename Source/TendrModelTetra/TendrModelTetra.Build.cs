@@ -44,6 +44,15 @@ namespace UnrealBuildTool.Rules
 				}
                 );
 
+            // For the batch commandlet (parameters and summary)
+            PrivateDependencyModuleNames.AddRange(
+                new string[]
+				{
+					"Json",
+					"JsonUtilities"
+				}
+                );
+
             if( UEBuildConfiguration.bBuildEditor )
             {
                 // For editor-specific functionality (e.g. world settings)